@@ -125,9 +125,9 @@ pubnub_chamebl_t pbcc_get_message_timetoken(struct pbcc_context* pb)
     }
     
     elem.start = reply;
-    elem.end = pbjson_find_end_element(reply, reply + replylen) + 1;
-    pbjson_get_object_value(&elem, "data", &parsed);
-    json_rslt = pbjson_get_object_value(&parsed, "messageTimetoken", &elem);
+    elem.end = pbcc_find_end_element(pb, reply, reply + replylen) + 1;
+    pbcc_get_object_value(pb, &elem, "data", &parsed);
+    json_rslt = pbcc_get_object_value(pb, &parsed, "messageTimetoken", &elem);
     if (json_rslt != jonmpOK) {
         PUBNUB_LOG_ERROR("pbcc_get_message_timetoken(pbcc=%p) - Invalid response: "
                          "pbjson_get_object_value(\"messageTimetoken\") reported an error: %s\n",
@@ -167,9 +167,9 @@ pubnub_chamebl_t pbcc_get_action_timetoken(struct pbcc_context* pb)
     }
     
     elem.start = reply;
-    elem.end = pbjson_find_end_element(reply, reply + replylen) + 1;
-    pbjson_get_object_value(&elem, "data", &parsed);
-    json_rslt = pbjson_get_object_value(&parsed, "actionTimetoken", &elem);
+    elem.end = pbcc_find_end_element(pb, reply, reply + replylen) + 1;
+    pbcc_get_object_value(pb, &elem, "data", &parsed);
+    json_rslt = pbcc_get_object_value(pb, &parsed, "actionTimetoken", &elem);
     if (json_rslt != jonmpOK) {
         PUBNUB_LOG_ERROR("pbcc_get_action_timetoken(pbcc=%p) - Invalid response: "
                          "pbjson_get_object_value(\"actionTimetoken\") reported an error: %s\n",
@@ -269,8 +269,8 @@ enum pubnub_res pbcc_get_actions_more_prep(struct pbcc_context* pb)
     }
     
     elem.start = reply;
-    elem.end = pbjson_find_end_element(reply, reply + replylen) + 1;
-    json_rslt = pbjson_get_object_value(&elem, "more", &parsed);
+    elem.end = pbcc_find_end_element(pb, reply, reply + replylen) + 1;
+    json_rslt = pbcc_get_object_value(pb, &elem, "more", &parsed);
     if (jonmpKeyNotFound == json_rslt) {
         return PNR_GOT_ALL_ACTIONS;
     }
@@ -343,7 +343,7 @@ enum pubnub_res pbcc_parse_actions_api_response(struct pbcc_context* pb)
     pb->msg_ofs = 0;
     pb->msg_end = replylen + 1;
     
-    elem.end = pbjson_find_end_element(reply, reply + replylen);
+    elem.end = pbcc_find_end_element(pb, reply, reply + replylen);
     /* elem.end has to be just behind end curly brace */
     if ((*reply != '{') || (*(elem.end++) != '}')) {
         PUBNUB_LOG_ERROR("pbcc_parse_actions_api_response(pbcc=%p) - Invalid: "
@@ -354,9 +354,9 @@ enum pubnub_res pbcc_parse_actions_api_response(struct pbcc_context* pb)
         return PNR_FORMAT_ERROR;
     }
     elem.start = reply;
-    json_rslt = pbjson_get_object_value(&elem, "data", &parsed);
+    json_rslt = pbcc_get_object_value(pb, &elem, "data", &parsed);
     if (jonmpKeyNotFound == json_rslt) {
-        json_rslt = pbjson_get_object_value(&elem, "error", &parsed);
+        json_rslt = pbcc_get_object_value(pb, &elem, "error", &parsed);
         if (json_rslt != jonmpOK) {
             PUBNUB_LOG_ERROR("pbcc_parse_actions_api_response(pbcc=%p) - Invalid response: "
                              "pbjson_get_object_value(\"error\") reported an error: %s\n",
@@ -405,7 +405,7 @@ enum pubnub_res pbcc_parse_history_with_actions_response(struct pbcc_context* pb
     pb->msg_ofs = 0;
     pb->msg_end = replylen + 1;
     
-    elem.end = pbjson_find_end_element(reply, reply + replylen);
+    elem.end = pbcc_find_end_element(pb, reply, reply + replylen);
     /* elem.end has to be just behind end curly brace */
     if ((*reply != '{') || (*(elem.end++) != '}')) {
         PUBNUB_LOG_ERROR("pbcc_parse_history_with_actions_response(pbcc=%p) - Invalid: "
@@ -416,9 +416,9 @@ enum pubnub_res pbcc_parse_history_with_actions_response(struct pbcc_context* pb
         return PNR_FORMAT_ERROR;
     }
     elem.start = reply;
-    json_rslt = pbjson_get_object_value(&elem, "channels", &parsed);
+    json_rslt = pbcc_get_object_value(pb, &elem, "channels", &parsed);
     if (jonmpKeyNotFound == json_rslt) {
-        json_rslt = pbjson_get_object_value(&elem, "error_message", &parsed);
+        json_rslt = pbcc_get_object_value(pb, &elem, "error_message", &parsed);
         if (json_rslt != jonmpOK) {
             PUBNUB_LOG_ERROR("pbcc_parse_history_with_actions_response(pbcc=%p) - Invalid response: "
                              "pbjson_get_object_value(\"error_message\") reported an error: %s\n",
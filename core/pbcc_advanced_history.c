@@ -36,12 +36,12 @@ enum pubnub_res pbcc_parse_message_counts_response(struct pbcc_context* p)
     }
     el.start = reply;
     el.end   = reply + replylen;
-    jpresult = pbjson_get_object_value(&el, "error", &found);
+    jpresult = pbcc_get_object_value(p, &el, "error", &found);
     if (jonmpOK == jpresult) {
         if (pbjson_elem_equals_string(&found, "false")) {
             /* If found, object's 'end' field points to the first character
                behind its end */
-            jpresult = pbjson_get_object_value(&el, "channels", &found);
+            jpresult = pbcc_get_object_value(p, &el, "channels", &found);
             if (jonmpOK == jpresult) {
                 p->msg_ofs = (found.start + 1) - reply;
                 p->msg_end = (found.end - 1) - reply;
@@ -84,7 +84,7 @@ int pbcc_get_error_message(struct pbcc_context* p, pubnub_chamebl_t* o_msg)
     el.start    = p->http_reply;
     el.end      = p->http_reply + p->http_buf_len;
     /* If found, object's 'end' field points to the first character behind its end(quotation marks) */
-    jpresult = pbjson_get_object_value(&el, "error_message", &found);
+    jpresult = pbcc_get_object_value(p, &el, "error_message", &found);
     if (jonmpOK == jpresult) {
         o_msg->size = found.end - 2 - found.start;
         /* found.start, in this case, points to the quotation mark at the string beginning */
@@ -586,7 +586,7 @@ enum pubnub_res pbcc_parse_objects_api_response(struct pbcc_context* pb)
     pb->msg_ofs = 0;
     pb->msg_end = replylen + 1;
 
-    elem.end = pbjson_find_end_element(reply, reply + replylen);
+    elem.end = pbcc_find_end_element(pb, reply, reply + replylen);
     /* elem.end has to be just behind end curly brace */
     if ((*reply != '{') || (*(elem.end++) != '}')) {
         PUBNUB_LOG_ERROR("pbcc_parse_objects_api_response(pbcc=%p) - Invalid: "
@@ -597,9 +597,9 @@ enum pubnub_res pbcc_parse_objects_api_response(struct pbcc_context* pb)
         return PNR_FORMAT_ERROR;
     }
     elem.start = reply;
-    json_rslt = pbjson_get_object_value(&elem, "data", &parsed);
+    json_rslt = pbcc_get_object_value(pb, &elem, "data", &parsed);
     if (jonmpKeyNotFound == json_rslt) {
-        json_rslt = pbjson_get_object_value(&elem, "error", &parsed);
+        json_rslt = pbcc_get_object_value(pb, &elem, "error", &parsed);
         if (json_rslt != jonmpOK) {
             PUBNUB_LOG_ERROR("pbcc_parse_objects_api_response(pbcc=%p) - Invalid response: "
                              "pbjson_get_object_value(\"error\") reported an error: %s\n",
@@ -0,0 +1,34 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PBCC_REPLY_BUFFER_POOL
+#define INC_PBCC_REPLY_BUFFER_POOL
+
+#include "core/pubnub_reply_buffer_pool.h"
+
+#include <stddef.h>
+
+
+/** @file pbcc_reply_buffer_pool.h
+
+    The C core interface of the reply buffer pool. A buffer is
+    described by a pointer to it and its capacity (size of the
+    allocated block), both kept by the "owner" (C core context).
+ */
+
+
+/** Makes sure the buffer @p *buf, of capacity @p *cap, can hold @p n
+    octets. If it can't, it is replaced by a big enough buffer from
+    the pool (or heap), keeping its first @p keep octets, and the old
+    buffer is released to the pool. A NULL @p *buf has capacity 0.
+
+    @retval 0 OK
+    @retval -1 allocation failed, @p *buf and @p *cap unchanged
+ */
+int pbcc_reply_buffer_reserve(char** buf, size_t* cap, size_t n, size_t keep);
+
+/** Releases the buffer @p *buf, of capacity @p *cap, to the pool (or
+    heap) and sets @p *buf to NULL and @p *cap to 0.
+ */
+void pbcc_reply_buffer_release(char** buf, size_t* cap);
+
+
+#endif /* !defined INC_PBCC_REPLY_BUFFER_POOL */
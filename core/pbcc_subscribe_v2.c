@@ -53,7 +53,7 @@ enum pubnub_res pbcc_subscribe_v2_prep(struct pbcc_context* p,
 
     p->http_buf_len = snprintf(
         p->http_buf, sizeof p->http_buf, "/v2/subscribe/%s/", p->subscribe_key);
-    APPEND_URL_ENCODED_M(p, channel);
+    APPEND_URL_ENCODED_CHANNEL_M(p, channel);
     p->http_buf_len += snprintf(p->http_buf + p->http_buf_len,
                                 sizeof p->http_buf - p->http_buf_len,
                                 "/0?tt=%s&pnsdk=%s",
@@ -70,11 +70,24 @@ enum pubnub_res pbcc_subscribe_v2_prep(struct pbcc_context* p,
 }
 
 
+/** Returns whether the JSON element @p key (with the quotes) is the
+    one-character key @p c.
+ */
+static bool is_key(struct pbjson_elem const* key, char c)
+{
+    return (key->end - key->start == 3) && (key->start[1] == c);
+}
+
+
 enum pubnub_res pbcc_parse_subscribe_v2_response(struct pbcc_context* p)
 {
     enum pbjson_object_name_parse_result jpresult;
     struct pbjson_elem                   el;
+    struct pbjson_elem                   key;
+    struct pbjson_elem                   value;
     struct pbjson_elem                   found;
+    struct pbjson_elem                   msgs;
+    char const*                          pos;
     char*                                reply = p->http_reply;
 
     if (p->http_buf_len < MIN_SUBSCRIBE_V2_RESPONSE_LENGTH) {
@@ -84,10 +97,24 @@ enum pubnub_res pbcc_parse_subscribe_v2_response(struct pbcc_context* p)
         return PNR_FORMAT_ERROR;
     }
 
-    el.start = p->http_reply;
-    el.end   = p->http_reply + p->http_buf_len;
-    jpresult = pbjson_get_object_value(&el, "t", &found);
-    if (jonmpOK == jpresult) {
+    el.start    = p->http_reply;
+    el.end      = p->http_reply + p->http_buf_len;
+    found.start = msgs.start = NULL;
+    /* Find both the time token and the messages in one pass */
+    pos = el.start;
+    while ((NULL == found.start) || (NULL == msgs.start)) {
+        jpresult = pbjson_get_next_object_member(&el, &pos, &key, &value);
+        if (jpresult != jonmpOK) {
+            break;
+        }
+        if (is_key(&key, 't') && (NULL == found.start)) {
+            found = value;
+        }
+        else if (is_key(&key, 'm') && (NULL == msgs.start)) {
+            msgs = value;
+        }
+    }
+    if (found.start != NULL) {
         struct pbjson_elem titel;
         if (jonmpOK == pbjson_get_object_value(&found, "t", &titel)) {
             size_t len = titel.end - titel.start - 2;
@@ -128,12 +155,9 @@ enum pubnub_res pbcc_parse_subscribe_v2_response(struct pbcc_context* p)
 
     p->chan_ofs = p->chan_end = 0;
 
-    /* We should optimize this to not look from the start again.
-     */
-    jpresult = pbjson_get_object_value(&el, "m", &found);
-    if (jonmpOK == jpresult) {
-        p->msg_ofs = (unsigned)(found.start - reply + 1);
-        p->msg_end = (unsigned)(found.end - reply - 1);
+    if (msgs.start != NULL) {
+        p->msg_ofs = (unsigned)(msgs.start - reply + 1);
+        p->msg_end = (unsigned)(msgs.end - reply - 1);
     }
     else {
         PUBNUB_LOG_ERROR(
@@ -145,15 +169,86 @@ enum pubnub_res pbcc_parse_subscribe_v2_response(struct pbcc_context* p)
 }
 
 
-struct pubnub_v2_message pbcc_get_msg_v2(struct pbcc_context* p)
+/** The members of a v2 message (object) that we use. Those not
+    present in the message have a NULL `start`.
+ */
+struct v2_message_members {
+    struct pbjson_elem payload;
+    struct pbjson_elem channel;
+    struct pbjson_elem type;
+    struct pbjson_elem publish;
+    struct pbjson_elem match_or_group;
+    struct pbjson_elem metadata;
+};
+
+
+/** Gets the members of the v2 message (JSON object) @p el that we
+    use into @p members, in one pass over it. If a key is repeated,
+    the first one is used, just like pbjson_get_object_value() would.
+
+    @return Pointer to the end (closing curly brace) of the message
+    on success, NULL on failure
+ */
+static char const* get_v2_message_members(struct pbjson_elem const*  el,
+                                          struct v2_message_members* members)
 {
     enum pbjson_object_name_parse_result jpresult;
-    struct pbjson_elem                   el;
-    struct pbjson_elem                   found;
-    struct pubnub_v2_message             rslt;
-    char const*                          start;
-    char const*                          end;
-    char const*                          seeker;
+    struct pbjson_elem                   key;
+    struct pbjson_elem                   value;
+    char const*                          pos = el->start;
+
+    memset(members, 0, sizeof *members);
+    while (jonmpOK == (jpresult = pbjson_get_next_object_member(el, &pos, &key, &value))) {
+        struct pbjson_elem* member = NULL;
+
+        if (key.end - key.start != 3) {
+            continue;
+        }
+        switch (key.start[1]) {
+        case 'd':
+            member = &members->payload;
+            break;
+        case 'c':
+            member = &members->channel;
+            break;
+        case 'e':
+            member = &members->type;
+            break;
+        case 'p':
+            member = &members->publish;
+            break;
+        case 'b':
+            member = &members->match_or_group;
+            break;
+        case 'u':
+            member = &members->metadata;
+            break;
+        default:
+            break;
+        }
+        if ((member != NULL) && (NULL == member->start)) {
+            *member = value;
+        }
+    }
+    if (jpresult != jonmpKeyNotFound) {
+        PUBNUB_LOG_ERROR("Message in subscribe V2 response is not a valid "
+                         "JSON object, error=%d\n",
+                         jpresult);
+        return NULL;
+    }
+
+    return pos;
+}
+
+
+struct pubnub_v2_message pbcc_get_msg_v2(struct pbcc_context* p)
+{
+    struct pbjson_elem        el;
+    struct v2_message_members members;
+    struct pubnub_v2_message  rslt;
+    char const*               start;
+    char const*               end;
+    char const*               seeker;
 
     memset(&rslt, 0, sizeof rslt);
 
@@ -166,68 +261,61 @@ struct pubnub_v2_message pbcc_get_msg_v2(struct pbcc_context* p)
             "Message subscribe V2 response is not a JSON object\n");
         return rslt;
     }
-    end    = p->http_reply + p->msg_end;
-    seeker = pbjson_find_end_complex(start, end);
-    if (seeker == end) {
-        PUBNUB_LOG_ERROR(
-            "Message subscribe V2 response has no end of JSON object\n");
+    end      = p->http_reply + p->msg_end;
+    el.start = start;
+    el.end   = end;
+    seeker   = get_v2_message_members(&el, &members);
+    if (NULL == seeker) {
+        /* Skip the invalid message, if we can find its end */
+        seeker = pbjson_find_end_complex(start, end);
+        if (seeker == end) {
+            PUBNUB_LOG_ERROR(
+                "Message subscribe V2 response has no end of JSON object\n");
+            return rslt;
+        }
+        p->msg_ofs = (unsigned)(seeker - p->http_reply + 2);
         return rslt;
     }
-
     p->msg_ofs = (unsigned)(seeker - p->http_reply + 2);
-    el.start   = start;
-    el.end     = seeker;
-
-    /* @todo We should iterate over elements of JSON message object,
-       instead of looking from the start, again and again.
-    */
 
-    jpresult = pbjson_get_object_value(&el, "d", &found);
-    if (jonmpOK == jpresult) {
-        rslt.payload.ptr  = (char*)found.start;
-        rslt.payload.size = found.end - found.start;
+    if (members.payload.start != NULL) {
+        rslt.payload.ptr  = (char*)members.payload.start;
+        rslt.payload.size = members.payload.end - members.payload.start;
     }
     else {
         PUBNUB_LOG_ERROR("pbcc=%p: No message payload in subscribe V2 response "
-                         "found, error=%d\n",
-                         p,
-                         jpresult);
+                         "found\n",
+                         p);
         return rslt;
     }
 
-    jpresult = pbjson_get_object_value(&el, "c", &found);
-    if (jonmpOK == jpresult) {
-        rslt.channel.ptr  = (char*)found.start + 1;
-        rslt.channel.size = found.end - found.start - 2;
+    if (members.channel.start != NULL) {
+        rslt.channel.ptr  = (char*)members.channel.start + 1;
+        rslt.channel.size = members.channel.end - members.channel.start - 2;
     }
     else {
         PUBNUB_LOG_ERROR("pbcc=%p: No message channel in subscribe V2 response "
-                         "found, error=%d\n",
-                         p,
-                         jpresult);
+                         "found\n",
+                         p);
         return rslt;
     }
 
-    jpresult = pbjson_get_object_value(&el, "e", &found);
-    if (jonmpOK == jpresult) {
-        if (pbjson_elem_equals_string(&found, "1")) {
-            rslt.message_type = pbsbSignal;
-        }
-        else if (pbjson_elem_equals_string(&found, "3")) {
-            rslt.message_type = pbsbAction;
-        }
-        else {
-            rslt.message_type = pbsbPublished;
-        }
+    if (NULL == members.type.start) {
+        rslt.message_type = pbsbPublished;
+    }
+    else if (pbjson_elem_equals_string(&members.type, "1")) {
+        rslt.message_type = pbsbSignal;
+    }
+    else if (pbjson_elem_equals_string(&members.type, "3")) {
+        rslt.message_type = pbsbAction;
     }
     else {
         rslt.message_type = pbsbPublished;
     }
-    
-    jpresult = pbjson_get_object_value(&el, "p", &found);
-    if (jonmpOK == jpresult) {
+
+    if (members.publish.start != NULL) {
         struct pbjson_elem titel;
-        if (jonmpOK == pbjson_get_object_value(&found, "t", &titel)) {
+        if (jonmpOK == pbjson_get_object_value(&members.publish, "t", &titel)) {
             if ((*titel.start != '"') || (titel.end[-1] != '"')) {
                 PUBNUB_LOG_ERROR("Time token in response is not a string\n");
                 return rslt;
@@ -243,20 +331,42 @@ struct pubnub_v2_message pbcc_get_msg_v2(struct pbcc_context* p)
     }
     else {
         PUBNUB_LOG_ERROR("No message publish timetoken in subscribe V2 "
-                         "response found, error=%d\n",
-                         jpresult);
+                         "response found\n");
         return rslt;
     }
 
-    if (jonmpOK == pbjson_get_object_value(&el, "b", &found)) {
-        rslt.match_or_group.ptr  = (char*)found.start;
-        rslt.match_or_group.size = found.end - found.start;
+    if (members.match_or_group.start != NULL) {
+        rslt.match_or_group.ptr  = (char*)members.match_or_group.start;
+        rslt.match_or_group.size = members.match_or_group.end - members.match_or_group.start;
     }
 
-    if (jonmpOK == pbjson_get_object_value(&el, "u", &found)) {
-        rslt.metadata.ptr  = (char*)found.start;
-        rslt.metadata.size = found.end - found.start;
+    if (members.metadata.start != NULL) {
+        rslt.metadata.ptr  = (char*)members.metadata.start;
+        rslt.metadata.size = members.metadata.end - members.metadata.start;
     }
 
     return rslt;
 }
+
+
+size_t pbcc_get_msgs_v2(struct pbcc_context*      p,
+                        struct pubnub_v2_message* msgs,
+                        size_t                    max)
+{
+    size_t n = 0;
+
+    while (n < max) {
+        unsigned const ofs = p->msg_ofs;
+        msgs[n]            = pbcc_get_msg_v2(p);
+        if (NULL == msgs[n].payload.ptr) {
+            /* A malformed message was skipped, there may be more */
+            if ((p->msg_ofs != ofs) && (p->msg_ofs < p->msg_end)) {
+                continue;
+            }
+            break;
+        }
+        ++n;
+    }
+
+    return n;
+}
@@ -4,6 +4,8 @@
 
 #include "pubnub_subscribe_v2_message.h"
 
+#include <stddef.h>
+
 struct pbcc_context;
 
 /** Prepares the Subscribe_v2 operation (transaction), mostly by
@@ -33,5 +35,13 @@ enum pubnub_res pbcc_parse_subscribe_v2_response(struct pbcc_context* p);
   */
 struct pubnub_v2_message pbcc_get_msg_v2(struct pbcc_context* p);
 
+/** Gets (up to) @p max next v2 messages from the Pubnub C Core
+    context @p p into the array @p msgs, skipping malformed ones.
+    @return The number of messages put in @p msgs
+  */
+size_t pbcc_get_msgs_v2(struct pbcc_context*      p,
+                        struct pubnub_v2_message* msgs,
+                        size_t                    max);
+
 
 #endif /* !defined INC_PBCC_SUBSCRIBE_V2 */
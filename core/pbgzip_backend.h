@@ -0,0 +1,135 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PBGZIP_BACKEND
+#define INC_PBGZIP_BACKEND
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/** @file pbgzip_backend.h
+
+    The interface to the compression library used for gzip: to deflate
+    messages that are published with gzip, to inflate gzip replies and
+    for the CRC32 of the gzip footer. The gzip header and footer are
+    handled by us (in `pbgzip_compress.c` and `pbgzip_decompress.c`),
+    the library only deals with "raw" deflate data.
+
+    Like the PAL, the backend is chosen when linking, by linking one
+    of these modules:
+
+    - `pbgzip_backend_miniz.c`: the bundled miniz, the default
+
+    - `pbgzip_backend_zlib.c`: zlib, or zlib-ng (built in the zlib
+      compatible mode), which is much faster
+
+    - `pbgzip_backend_libdeflate.c`: libdeflate, which is the fastest
+      to deflate. It can't inflate data piece by piece, as it arrives,
+      so it uses miniz to inflate.
+
+    All the functions are thread-safe, as long as different threads
+    use different deflater/inflater objects.
+ */
+
+
+/** Returns the name of the backend, like "miniz" */
+char const* pbgzip_backend_name(void);
+
+/** Updates the CRC32 checksum @p crc (of the data before) with the
+    @p n octets at @p data, returning the checksum of all the data.
+    Start with a @p crc of 0.
+ */
+uint32_t pbgzip_backend_crc32(uint32_t crc, void const* data, size_t n);
+
+
+#if PUBNUB_USE_GZIP_COMPRESSION
+
+/** The highest compression level. The levels are as in zlib, with
+    this one being the best (and slowest) the backend can do.
+ */
+#define PBGZIP_BACKEND_MAX_LEVEL 10
+
+/** The most dictionary probes per match search one can ask for. Not
+    all backends can be told how many to do; those ignore this.
+ */
+#define PBGZIP_BACKEND_MAX_PROBES 4095
+
+/** The deflater (compressor) state, which is big (hundreds of KB),
+    so it is allocated from the heap and meant to be reused.
+ */
+struct pbgzip_deflater;
+
+/** Allocates a deflater. Returns NULL on failure. */
+struct pbgzip_deflater* pbgzip_backend_deflater_alloc(void);
+
+/** Frees the deflater @p d */
+void pbgzip_backend_deflater_free(struct pbgzip_deflater* d);
+
+/** Deflates (to "raw" deflate data) the @p in_len octets at @p in to
+    @p out, with the deflater @p d.
+
+    @param level Compression level, 0 (none) - #PBGZIP_BACKEND_MAX_LEVEL
+    @param max_probes Maximum number of dictionary probes per match
+    search, or negative to use what @p level says
+    @param out_len On input, the capacity of @p out, on output, the
+    length of the deflated data
+    @return 0: OK, -1: error, including the deflated data not fitting
+    in @p out
+ */
+int pbgzip_backend_deflate(struct pbgzip_deflater* d,
+                           int                     level,
+                           int                     max_probes,
+                           void const*             in,
+                           size_t                  in_len,
+                           void*                   out,
+                           size_t*                 out_len);
+
+#endif /* PUBNUB_USE_GZIP_COMPRESSION */
+
+
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+
+/** The inflater (decompressor) state */
+struct pbgzip_inflater;
+
+/** Results of pbgzip_backend_inflate() */
+enum pbgzip_inflate_status {
+    /** All the input was taken, more is needed */
+    pbgzInflateNeedsInput,
+    /** Output is full, more space is needed */
+    pbgzInflateNeedsOutput,
+    /** End of the deflated data */
+    pbgzInflateDone,
+    /** Bad deflated data */
+    pbgzInflateError
+};
+
+/** Allocates an inflater, ready to inflate. Returns NULL on failure. */
+struct pbgzip_inflater* pbgzip_backend_inflater_alloc(void);
+
+/** Resets the inflater @p i, to inflate new data */
+void pbgzip_backend_inflater_reset(struct pbgzip_inflater* i);
+
+/** Frees the inflater @p i */
+void pbgzip_backend_inflater_free(struct pbgzip_inflater* i);
+
+/** Inflates what it can of the @p *in_len octets of "raw" deflate
+    data at @p in, to @p out, after the @p out_ofs octets inflated so
+    far - which have to be there, as some backends use them as the
+    dictionary.
+
+    @param in_len On input, the length of @p in, on output, the number
+    of octets taken. Octets after the end of the deflated data are
+    not taken.
+    @param out_len On input, the space at @p out + @p out_ofs, on
+    output, the number of octets put there
+ */
+enum pbgzip_inflate_status pbgzip_backend_inflate(struct pbgzip_inflater* i,
+                                                  uint8_t const*          in,
+                                                  size_t*                 in_len,
+                                                  uint8_t*                out,
+                                                  size_t                  out_ofs,
+                                                  size_t*                 out_len);
+
+#endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
+
+#endif /* INC_PBGZIP_BACKEND */
@@ -0,0 +1,177 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "core/pbgzip_backend.h"
+#include "core/pubnub_assert.h"
+#include "core/pubnub_log.h"
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+#include "lib/miniz/miniz_tinfl.h"
+#endif
+
+#include <libdeflate.h>
+
+#include <stdlib.h>
+
+
+/** @file pbgzip_backend_libdeflate.c
+
+    The gzip backend on libdeflate, for deflate and CRC32. libdeflate
+    can only inflate all the data at once, but we inflate replies as
+    they are received, so we use miniz to inflate.
+ */
+
+
+/** libdeflate's best compression level */
+#define LIBDEFLATE_MAX_LEVEL 12
+
+
+char const* pbgzip_backend_name(void)
+{
+    return "libdeflate";
+}
+
+
+uint32_t pbgzip_backend_crc32(uint32_t crc, void const* data, size_t n)
+{
+    return libdeflate_crc32(crc, data, n);
+}
+
+
+#if PUBNUB_USE_GZIP_COMPRESSION
+
+struct pbgzip_deflater {
+    /** libdeflate has a compressor per compression level */
+    struct libdeflate_compressor* comp;
+    /** The (libdeflate) compression level of #comp */
+    int level;
+};
+
+
+struct pbgzip_deflater* pbgzip_backend_deflater_alloc(void)
+{
+    struct pbgzip_deflater* rslt = (struct pbgzip_deflater*)malloc(sizeof *rslt);
+    if (rslt != NULL) {
+        rslt->comp  = NULL;
+        rslt->level = -1;
+    }
+    return rslt;
+}
+
+
+void pbgzip_backend_deflater_free(struct pbgzip_deflater* d)
+{
+    if (d != NULL) {
+        libdeflate_free_compressor(d->comp);
+        free(d);
+    }
+}
+
+
+int pbgzip_backend_deflate(struct pbgzip_deflater* d,
+                           int                     level,
+                           int                     max_probes,
+                           void const*             in,
+                           size_t                  in_len,
+                           void*                   out,
+                           size_t*                 out_len)
+{
+    size_t packed;
+
+    PUBNUB_ASSERT_OPT(d != NULL);
+    PUBNUB_ASSERT_OPT(out_len != NULL);
+    /* libdeflate can't be told how many probes to do */
+    PUBNUB_UNUSED(max_probes);
+
+    if (level >= PBGZIP_BACKEND_MAX_LEVEL) {
+        level = LIBDEFLATE_MAX_LEVEL;
+    }
+    if (level != d->level) {
+        libdeflate_free_compressor(d->comp);
+        d->level = -1;
+        d->comp  = libdeflate_alloc_compressor(level);
+        if (NULL == d->comp) {
+            PUBNUB_LOG_ERROR("pbgzip_backend_deflate() - failed to allocate "
+                             "libdeflate compressor for level %d\n",
+                             level);
+            return -1;
+        }
+        d->level = level;
+    }
+    packed = libdeflate_deflate_compress(d->comp, in, in_len, out, *out_len);
+    if (0 == packed) {
+        PUBNUB_LOG_ERROR("pbgzip_backend_deflate() - compression failed : "
+                         "buffer to small\n");
+        return -1;
+    }
+    *out_len = packed;
+
+    return 0;
+}
+
+#endif /* PUBNUB_USE_GZIP_COMPRESSION */
+
+
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+
+struct pbgzip_inflater {
+    tinfl_decompressor decomp;
+};
+
+
+struct pbgzip_inflater* pbgzip_backend_inflater_alloc(void)
+{
+    struct pbgzip_inflater* rslt = (struct pbgzip_inflater*)malloc(sizeof *rslt);
+    if (rslt != NULL) {
+        tinfl_init(&rslt->decomp);
+    }
+    return rslt;
+}
+
+
+void pbgzip_backend_inflater_reset(struct pbgzip_inflater* i)
+{
+    PUBNUB_ASSERT_OPT(i != NULL);
+    tinfl_init(&i->decomp);
+}
+
+
+void pbgzip_backend_inflater_free(struct pbgzip_inflater* i)
+{
+    free(i);
+}
+
+
+enum pbgzip_inflate_status pbgzip_backend_inflate(struct pbgzip_inflater* i,
+                                                  uint8_t const*          in,
+                                                  size_t*                 in_len,
+                                                  uint8_t*                out,
+                                                  size_t                  out_ofs,
+                                                  size_t*                 out_len)
+{
+    tinfl_status status;
+
+    PUBNUB_ASSERT_OPT(i != NULL);
+
+    status = tinfl_decompress(&i->decomp,
+                              in,
+                              in_len,
+                              out,
+                              out + out_ofs,
+                              out_len,
+                              TINFL_FLAG_HAS_MORE_INPUT
+                                  | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+    switch (status) {
+    case TINFL_STATUS_DONE:
+        return pbgzInflateDone;
+    case TINFL_STATUS_NEEDS_MORE_INPUT:
+        return pbgzInflateNeedsInput;
+    case TINFL_STATUS_HAS_MORE_OUTPUT:
+        return pbgzInflateNeedsOutput;
+    default:
+        PUBNUB_LOG_ERROR("'Tinfl'-decompress status: %d!\n", status);
+        break;
+    }
+    return pbgzInflateError;
+}
+
+#endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
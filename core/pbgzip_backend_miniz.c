@@ -0,0 +1,173 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "core/pbgzip_backend.h"
+#include "core/pubnub_assert.h"
+#include "core/pubnub_log.h"
+#include "lib/pbcrc32.h"
+#if PUBNUB_USE_GZIP_COMPRESSION
+#include "lib/miniz/miniz_tdef.h"
+#endif
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+#include "lib/miniz/miniz_tinfl.h"
+#endif
+
+#include <stdlib.h>
+
+
+char const* pbgzip_backend_name(void)
+{
+    return "miniz";
+}
+
+
+uint32_t pbgzip_backend_crc32(uint32_t crc, void const* data, size_t n)
+{
+    return pbcrc32_update(crc, data, n);
+}
+
+
+#if PUBNUB_USE_GZIP_COMPRESSION
+
+struct pbgzip_deflater {
+    tdefl_compressor comp;
+};
+
+
+struct pbgzip_deflater* pbgzip_backend_deflater_alloc(void)
+{
+    return (struct pbgzip_deflater*)malloc(sizeof(struct pbgzip_deflater));
+}
+
+
+void pbgzip_backend_deflater_free(struct pbgzip_deflater* d)
+{
+    free(d);
+}
+
+
+/** Returns the flags for tdefl_init() for the compression @p level
+    and @p max_probes.
+ */
+static int compression_flags(int level, int max_probes)
+{
+    /* Raw deflate (negative window bits), default strategy */
+    mz_uint flags = tdefl_create_comp_flags_from_zip_params(level, -15, 0);
+
+    if ((max_probes >= 0) && (level > 0)) {
+        flags = (flags & ~(mz_uint)TDEFL_MAX_PROBES_MASK) | (mz_uint)max_probes;
+    }
+    return (int)flags;
+}
+
+
+int pbgzip_backend_deflate(struct pbgzip_deflater* d,
+                           int                     level,
+                           int                     max_probes,
+                           void const*             in,
+                           size_t                  in_len,
+                           void*                   out,
+                           size_t*                 out_len)
+{
+    size_t       in_size = in_len;
+    tdefl_status status;
+
+    PUBNUB_ASSERT_OPT(d != NULL);
+    PUBNUB_ASSERT_OPT(out_len != NULL);
+
+    tdefl_init(&d->comp, NULL, NULL, compression_flags(level, max_probes));
+    status = tdefl_compress(&d->comp, in, &in_size, out, out_len, TDEFL_FINISH);
+    switch (status) {
+    case TDEFL_STATUS_DONE:
+        if (in_size == in_len) {
+            return 0;
+        }
+        PUBNUB_LOG_ERROR("pbgzip_backend_deflate() - Hasn't compressed entire "
+                         "message: %lu bytes compressed, unpacked_size=%lu\n",
+                         (unsigned long)in_size,
+                         (unsigned long)in_len);
+        break;
+    case TDEFL_STATUS_BAD_PARAM:
+        PUBNUB_LOG_ERROR("pbgzip_backend_deflate() - compression failed : "
+                         "bad parameters\n");
+        break;
+    case TDEFL_STATUS_OKAY:
+    case TDEFL_STATUS_PUT_BUF_FAILED:
+        PUBNUB_LOG_ERROR("pbgzip_backend_deflate() - compression failed : "
+                         "buffer to small\n");
+        break;
+    default:
+        PUBNUB_LOG_ERROR("pbgzip_backend_deflate() - compression status: %d\n", status);
+        break;
+    }
+    return -1;
+}
+
+#endif /* PUBNUB_USE_GZIP_COMPRESSION */
+
+
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+
+struct pbgzip_inflater {
+    tinfl_decompressor decomp;
+};
+
+
+struct pbgzip_inflater* pbgzip_backend_inflater_alloc(void)
+{
+    struct pbgzip_inflater* rslt = (struct pbgzip_inflater*)malloc(sizeof *rslt);
+    if (rslt != NULL) {
+        tinfl_init(&rslt->decomp);
+    }
+    return rslt;
+}
+
+
+void pbgzip_backend_inflater_reset(struct pbgzip_inflater* i)
+{
+    PUBNUB_ASSERT_OPT(i != NULL);
+    tinfl_init(&i->decomp);
+}
+
+
+void pbgzip_backend_inflater_free(struct pbgzip_inflater* i)
+{
+    free(i);
+}
+
+
+enum pbgzip_inflate_status pbgzip_backend_inflate(struct pbgzip_inflater* i,
+                                                  uint8_t const*          in,
+                                                  size_t*                 in_len,
+                                                  uint8_t*                out,
+                                                  size_t                  out_ofs,
+                                                  size_t*                 out_len)
+{
+    tinfl_status status;
+
+    PUBNUB_ASSERT_OPT(i != NULL);
+
+    /* The output buffer is also the dictionary */
+    status = tinfl_decompress(&i->decomp,
+                              in,
+                              in_len,
+                              out,
+                              out + out_ofs,
+                              out_len,
+                              TINFL_FLAG_HAS_MORE_INPUT
+                                  | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+    switch (status) {
+    case TINFL_STATUS_DONE:
+        return pbgzInflateDone;
+    case TINFL_STATUS_NEEDS_MORE_INPUT:
+        return pbgzInflateNeedsInput;
+    case TINFL_STATUS_HAS_MORE_OUTPUT:
+        return pbgzInflateNeedsOutput;
+    default:
+        PUBNUB_LOG_ERROR("'Tinfl'-decompress status: %d!\n", status);
+        break;
+    }
+    return pbgzInflateError;
+}
+
+#endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
@@ -0,0 +1,258 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "core/pbgzip_backend.h"
+#include "core/pubnub_assert.h"
+#include "core/pubnub_log.h"
+
+#include <zlib.h>
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/** @file pbgzip_backend_zlib.c
+
+    The gzip backend on zlib. It works with zlib-ng, too, if it is
+    built in the zlib compatible mode (`ZLIB_COMPAT`), which is much
+    faster than zlib (and miniz).
+ */
+
+
+/** zlib takes lengths as `uInt`, so longer data is taken in pieces */
+#define ZLIB_MAX_PIECE ((size_t)1 << 30)
+
+
+char const* pbgzip_backend_name(void)
+{
+#if defined ZLIBNG_VERSION
+    return "zlib-ng";
+#else
+    return "zlib";
+#endif
+}
+
+
+uint32_t pbgzip_backend_crc32(uint32_t crc, void const* data, size_t n)
+{
+    Bytef const* p = (Bytef const*)data;
+
+    while (n > 0) {
+        size_t const piece = (n < ZLIB_MAX_PIECE) ? n : ZLIB_MAX_PIECE;
+        crc = (uint32_t)crc32(crc, p, (uInt)piece);
+        p += piece;
+        n -= piece;
+    }
+    return crc;
+}
+
+
+#if PUBNUB_USE_GZIP_COMPRESSION
+
+/** The zlib parameters of the compression levels - the same as its
+    own (in `deflate.c`), which we need for deflateTune(), to set the
+    maximum number of probes ("chain") for a level.
+ */
+static struct {
+    int good_length;
+    int max_lazy;
+    int nice_length;
+    int max_chain;
+} const m_config[] = {
+    /* 0 */ { 0, 0, 0, 0 },
+    /* 1 */ { 4, 4, 8, 4 },
+    /* 2 */ { 4, 5, 16, 8 },
+    /* 3 */ { 4, 6, 32, 32 },
+    /* 4 */ { 4, 4, 16, 16 },
+    /* 5 */ { 8, 16, 32, 32 },
+    /* 6 */ { 8, 16, 128, 128 },
+    /* 7 */ { 8, 32, 128, 256 },
+    /* 8 */ { 32, 128, 258, 1024 },
+    /* 9 */ { 32, 258, 258, 4096 }
+};
+
+
+struct pbgzip_deflater {
+    z_stream strm;
+    /** The compression level the stream was initialized with,
+        negative if it wasn't */
+    int level;
+    /** The maximum number of probes the stream was tuned to,
+        negative if as #level says */
+    int max_probes;
+};
+
+
+struct pbgzip_deflater* pbgzip_backend_deflater_alloc(void)
+{
+    struct pbgzip_deflater* rslt = (struct pbgzip_deflater*)malloc(sizeof *rslt);
+    if (rslt != NULL) {
+        memset(&rslt->strm, 0, sizeof rslt->strm);
+        rslt->level      = -1;
+        rslt->max_probes = -1;
+    }
+    return rslt;
+}
+
+
+void pbgzip_backend_deflater_free(struct pbgzip_deflater* d)
+{
+    if (d != NULL) {
+        if (d->level >= 0) {
+            deflateEnd(&d->strm);
+        }
+        free(d);
+    }
+}
+
+
+/** Prepares the stream of @p d for a new message, with the
+    compression @p level (of zlib) and @p max_probes.
+ */
+static int prepare(struct pbgzip_deflater* d, int level, int max_probes)
+{
+    if ((level == d->level) && (max_probes == d->max_probes)) {
+        return (Z_OK == deflateReset(&d->strm)) ? 0 : -1;
+    }
+    if (d->level >= 0) {
+        deflateEnd(&d->strm);
+        d->level = -1;
+    }
+    /* Raw deflate (negative window bits) */
+    if (Z_OK != deflateInit2(&d->strm, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY)) {
+        return -1;
+    }
+    d->level      = level;
+    d->max_probes = max_probes;
+    if ((max_probes >= 0) && (level > 0)) {
+        if (Z_OK != deflateTune(&d->strm,
+                                m_config[level].good_length,
+                                m_config[level].max_lazy,
+                                m_config[level].nice_length,
+                                max_probes)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+int pbgzip_backend_deflate(struct pbgzip_deflater* d,
+                           int                     level,
+                           int                     max_probes,
+                           void const*             in,
+                           size_t                  in_len,
+                           void*                   out,
+                           size_t*                 out_len)
+{
+    int rc;
+
+    PUBNUB_ASSERT_OPT(d != NULL);
+    PUBNUB_ASSERT_OPT(out_len != NULL);
+
+    if ((in_len > UINT_MAX) || (*out_len > UINT_MAX)) {
+        PUBNUB_LOG_ERROR("pbgzip_backend_deflate() - message too long\n");
+        return -1;
+    }
+    /* zlib's best is 9 */
+    if (level > 9) {
+        level = 9;
+    }
+    if (0 != prepare(d, level, max_probes)) {
+        PUBNUB_LOG_ERROR("pbgzip_backend_deflate() - failed to initialize zlib: %s\n",
+                         d->strm.msg ? d->strm.msg : "(no message)");
+        return -1;
+    }
+    d->strm.next_in   = (Bytef*)in;
+    d->strm.avail_in  = (uInt)in_len;
+    d->strm.next_out  = (Bytef*)out;
+    d->strm.avail_out = (uInt)*out_len;
+    rc                = deflate(&d->strm, Z_FINISH);
+    if (rc != Z_STREAM_END) {
+        PUBNUB_LOG_ERROR("pbgzip_backend_deflate() - compression failed: %d\n", rc);
+        return -1;
+    }
+    *out_len -= d->strm.avail_out;
+
+    return 0;
+}
+
+#endif /* PUBNUB_USE_GZIP_COMPRESSION */
+
+
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+
+struct pbgzip_inflater {
+    z_stream strm;
+};
+
+
+struct pbgzip_inflater* pbgzip_backend_inflater_alloc(void)
+{
+    struct pbgzip_inflater* rslt = (struct pbgzip_inflater*)malloc(sizeof *rslt);
+    if (rslt != NULL) {
+        memset(&rslt->strm, 0, sizeof rslt->strm);
+        /* Raw deflate (negative window bits) */
+        if (Z_OK != inflateInit2(&rslt->strm, -15)) {
+            free(rslt);
+            return NULL;
+        }
+    }
+    return rslt;
+}
+
+
+void pbgzip_backend_inflater_reset(struct pbgzip_inflater* i)
+{
+    PUBNUB_ASSERT_OPT(i != NULL);
+    inflateReset(&i->strm);
+}
+
+
+void pbgzip_backend_inflater_free(struct pbgzip_inflater* i)
+{
+    if (i != NULL) {
+        inflateEnd(&i->strm);
+        free(i);
+    }
+}
+
+
+enum pbgzip_inflate_status pbgzip_backend_inflate(struct pbgzip_inflater* i,
+                                                  uint8_t const*          in,
+                                                  size_t*                 in_len,
+                                                  uint8_t*                out,
+                                                  size_t                  out_ofs,
+                                                  size_t*                 out_len)
+{
+    uInt const avail_out = (uInt)((*out_len < UINT_MAX) ? *out_len : UINT_MAX);
+    int        rc;
+
+    PUBNUB_ASSERT_OPT(i != NULL);
+    PUBNUB_ASSERT_OPT(*in_len <= UINT_MAX);
+
+    /* zlib keeps its own dictionary */
+    i->strm.next_in   = (Bytef*)in;
+    i->strm.avail_in  = (uInt)*in_len;
+    i->strm.next_out  = out + out_ofs;
+    i->strm.avail_out = avail_out;
+    rc                = inflate(&i->strm, Z_NO_FLUSH);
+    *in_len -= i->strm.avail_in;
+    *out_len = avail_out - i->strm.avail_out;
+    switch (rc) {
+    case Z_STREAM_END:
+        return pbgzInflateDone;
+    case Z_OK:
+    case Z_BUF_ERROR:
+        return (0 == i->strm.avail_out) ? pbgzInflateNeedsOutput : pbgzInflateNeedsInput;
+    default:
+        PUBNUB_LOG_ERROR("zlib inflate() failed: %d (%s)\n",
+                         rc,
+                         i->strm.msg ? i->strm.msg : "no message");
+        break;
+    }
+    return pbgzInflateError;
+}
+
+#endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
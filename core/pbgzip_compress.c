@@ -2,14 +2,179 @@
 #include "pubnub_internal.h"
 
 #include "core/pubnub_assert.h"
-#include "lib/miniz/miniz_tdef.h"
-#include "lib/pbcrc32.h"
+#include "core/pubnub_atomic.h"
+#include "core/pbgzip_backend.h"
 #include "core/pubnub_log.h"
 
+#include <stdlib.h>
+
 #define GZIP_HEADER_LENGTH_BYTES 10
 #define GZIP_FOOTER_LENGTH_BYTES 8
 /* Percents 'off' message length after compression */
 #define PUBNUB_MINIMAL_ACCEPTABLE_COMPRESSION_RATIO 10
+/* The sample to estimate compressibility on is taken in chunks of
+   this many octets, spread over the message */
+#define ESTIMATE_SAMPLE_CHUNK 64
+
+
+/** A compressor in the pool */
+struct compressor {
+    struct compressor*      next;
+    struct pbgzip_deflater* deflater;
+};
+
+
+pubnub_mutex_static_decl_and_init(m_lock);
+static struct compressor* m_pool pubnub_guarded_by(m_lock);
+static unsigned m_pooled pubnub_guarded_by(m_lock);
+
+static pubnub_atomic_t m_sample_size = PUBNUB_GZIP_ESTIMATE_SAMPLE_SIZE;
+static pubnub_atomic_t m_min_savings = PUBNUB_GZIP_ESTIMATE_MIN_SAVINGS;
+
+static pubnub_atomic_t m_estimated;
+static pubnub_atomic_t m_skipped;
+static pubnub_atomic_t m_packed;
+static pubnub_atomic_t m_poor_ratio;
+
+
+/** Returns the binary logarithm of @p x (> 0), with 16 fractional
+    bits. Computes the fractional bits one by one, by squaring.
+ */
+static uint32_t log2_fixed(uint32_t x)
+{
+    uint32_t rslt = 0;
+    uint64_t m;
+    int      i;
+
+    while ((rslt < 31) && (x >= 2u << rslt)) {
+        ++rslt;
+    }
+    /* x / 2^rslt, in [1, 2), with 30 fractional bits */
+    m    = ((uint64_t)x << 30) >> rslt;
+    rslt <<= 16;
+    for (i = 15; i >= 0; --i) {
+        m = (m * m) >> 30;
+        if (m >= ((uint64_t)2 << 30)) {
+            m >>= 1;
+            rslt |= (uint32_t)1 << i;
+        }
+    }
+    return rslt;
+}
+
+
+/** Estimates the savings, in percent, of compressing the @p len
+    octets at @p data, from the entropy of the octets of a sample of
+    (at most) @p sample_size of them - which is about what Huffman
+    coding alone would achieve - and the gzip header and footer.
+ */
+static unsigned estimate_savings(uint8_t const* data, size_t len, size_t sample_size)
+{
+    uint32_t hist[256];
+    uint64_t sum = 0;
+    uint32_t n   = 0;
+    uint32_t entropy;
+    size_t   packed;
+    size_t   i;
+
+    memset(hist, 0, sizeof hist);
+    if (len <= sample_size) {
+        for (i = 0; i < len; ++i) {
+            ++hist[data[i]];
+        }
+        n = (uint32_t)len;
+    }
+    else {
+        size_t chunks = sample_size / ESTIMATE_SAMPLE_CHUNK;
+        size_t step;
+        if (0 == chunks) {
+            chunks = 1;
+        }
+        step = len / chunks;
+        for (i = 0; i < chunks; ++i) {
+            uint8_t const* chunk = data + i * step;
+            size_t const   size  = (step < ESTIMATE_SAMPLE_CHUNK) ? step : ESTIMATE_SAMPLE_CHUNK;
+            size_t         j;
+            for (j = 0; j < size; ++j) {
+                ++hist[chunk[j]];
+            }
+            n += (uint32_t)size;
+        }
+    }
+    if (0 == n) {
+        return 0;
+    }
+    /* entropy = log2(n) - sum(c * log2(c)) / n, in bits per octet */
+    for (i = 0; i < 256; ++i) {
+        if (hist[i] > 1) {
+            sum += (uint64_t)hist[i] * log2_fixed(hist[i]);
+        }
+    }
+    entropy = log2_fixed(n) - (uint32_t)(sum / n);
+    packed  = (size_t)(((uint64_t)len * entropy) >> 19) + GZIP_HEADER_LENGTH_BYTES
+             + GZIP_FOOTER_LENGTH_BYTES;
+
+    return (packed < len) ? (unsigned)(((len - packed) * 100) / len) : 0;
+}
+
+
+/** Gets a compressor from the pool, if there is one, otherwise from
+    the heap.
+ */
+static struct compressor* compressor_get(void)
+{
+    struct compressor* rslt;
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    rslt = m_pool;
+    if (rslt != NULL) {
+        m_pool = rslt->next;
+        --m_pooled;
+    }
+    pubnub_mutex_unlock(m_lock);
+    if (NULL == rslt) {
+        rslt = (struct compressor*)malloc(sizeof *rslt);
+        if (NULL == rslt) {
+            return NULL;
+        }
+        rslt->deflater = pbgzip_backend_deflater_alloc();
+        if (NULL == rslt->deflater) {
+            free(rslt);
+            return NULL;
+        }
+    }
+
+    return rslt;
+}
+
+
+static void compressor_free(struct compressor* c)
+{
+    if (c != NULL) {
+        pbgzip_backend_deflater_free(c->deflater);
+        free(c);
+    }
+}
+
+
+/** Returns the compressor @p c to the pool, or frees it, if the pool
+    is full.
+ */
+static void compressor_put(struct compressor* c)
+{
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    if (m_pooled < PUBNUB_GZIP_COMPRESSOR_POOL_SIZE) {
+        c->next = m_pool;
+        m_pool  = c;
+        ++m_pooled;
+        c = NULL;
+    }
+    pubnub_mutex_unlock(m_lock);
+    compressor_free(c);
+}
+
 
 static enum pubnub_res deflate_total_to_context_buffer(pubnub_t*   pb,
                                                        char const* message,
@@ -19,86 +184,80 @@ static enum pubnub_res deflate_total_to_context_buffer(pubnub_t*   pb,
     size_t compressed = sizeof pb->core.gzip_msg_buf -
                         (GZIP_HEADER_LENGTH_BYTES + GZIP_FOOTER_LENGTH_BYTES);
     char* gzip_msg_buf = pb->core.gzip_msg_buf;
-    tdefl_compressor comp;
-
-    tdefl_init(&comp, NULL, NULL, TDEFL_DEFAULT_MAX_PROBES);
-    tdefl_status status = tdefl_compress(&comp,
-                                         message,
-                                         &message_size,
-                                         gzip_msg_buf + GZIP_HEADER_LENGTH_BYTES,
-                                         &compressed,
-                                         TDEFL_FINISH);
-    switch (status) {
-    case TDEFL_STATUS_DONE:
-        if (message_size == unpacked_size) {
-            uint32_t crc;
-            size_t packed_size = GZIP_HEADER_LENGTH_BYTES + compressed + GZIP_FOOTER_LENGTH_BYTES;
-            size_t diff = unpacked_size - packed_size;
+    size_t const sample_size = (size_t)pubnub_atomic_load(&m_sample_size);
+    struct compressor* comp;
+    int rslt;
+
+    if (sample_size > 0) {
+        unsigned const savings =
+            estimate_savings((uint8_t const*)message, message_size, sample_size);
 
+        pubnub_atomic_add(&m_estimated, 1);
+        if (savings < (unsigned)pubnub_atomic_load(&m_min_savings)) {
             PUBNUB_LOG_TRACE("deflate_total_to_context_buffer(pb=%p) - "
-                             "Length before compression: %lu bytes - "
-                             "Length after compression: %lu bytes - "
-                             "compression ratio=%ld o/oo\n",
-                             pb,
-                             (unsigned long)unpacked_size,
-                             (unsigned long)packed_size,
-                             (long)(diff*1000)/(long)unpacked_size);
-            if ((packed_size > unpacked_size) ||
-                ((diff*100)/unpacked_size < PUBNUB_MINIMAL_ACCEPTABLE_COMPRESSION_RATIO)) {
-                /* With insufficient compression we choose not to pack */
-                return PNR_STARTED;
-            }
-            /* Cyclic redundancy checksum data(little endian) */
-            crc = pbcrc32(message, unpacked_size);
-            gzip_msg_buf[packed_size - 5] = crc >> 24;
-            gzip_msg_buf[packed_size - 6] = (crc >> 16) & 0xFF;
-            gzip_msg_buf[packed_size - 7] = (crc >> 8) & 0xFF;
-            gzip_msg_buf[packed_size - 8] = crc & 0xFF;
-            /* Unpacked message size is placed at the end of the 'gzip' formated message
-               in the last four bytes(little endian)
-             */
-            gzip_msg_buf[packed_size - 1] = (uint32_t)unpacked_size >> 24;
-            gzip_msg_buf[packed_size - 2] = ((uint32_t)unpacked_size >> 16) & 0xFF;
-            gzip_msg_buf[packed_size - 3] = ((uint32_t)unpacked_size >> 8) & 0xFF;
-            gzip_msg_buf[packed_size - 4] = (uint32_t)unpacked_size & 0xFF;
-            pb->core.gzip_msg_len = packed_size;
-            return PNR_OK;
-        }
-        else {
-            PUBNUB_LOG_ERROR("deflate_total_to_context_buffer(pb=%p) - "
-                             "Hasn't compressed entire message: %zu bytes compressed,"
-                             "unpacked_size=%zu\n",
+                             "estimated savings of %u%% too low, not compressing\n",
                              pb,
-                             message_size,
-                             unpacked_size);
+                             savings);
+            pubnub_atomic_add(&m_skipped, 1);
+            return PNR_STARTED;
         }
-        break;
-    case TDEFL_STATUS_BAD_PARAM:
-        PUBNUB_LOG_ERROR("deflate_total_to_context_buffer(pb=%p) - "
-                         "compression failed : bad parameters\n",
-                         pb);
-        break;
-    case TDEFL_STATUS_OKAY:
-    case TDEFL_STATUS_PUT_BUF_FAILED:
+    }
+    comp = compressor_get();
+    if (NULL == comp) {
         PUBNUB_LOG_ERROR("deflate_total_to_context_buffer(pb=%p) - "
-                         "compression failed : buffer to small\n",
+                         "failed to allocate the compressor\n",
                          pb);
-        break;
-    default:
-        if (status < 0) {
-            PUBNUB_LOG_ERROR("deflate_total_to_context_buffer(pb=%p) - "
-                             "compression failed(status: %d)\n",
-                             pb,
-                             status);
-        }
-        else {
-            PUBNUB_LOG_ERROR("deflate_total_to_context_buffer(pb=%p) - "
-                             "compression status: %d!\n",
-                             pb,
-                             status);
+        return PNR_BAD_COMPRESSION_FORMAT;
+    }
+    rslt = pbgzip_backend_deflate(comp->deflater,
+                                  pb->core.gzip_level,
+                                  pb->core.gzip_max_probes,
+                                  message,
+                                  message_size,
+                                  gzip_msg_buf + GZIP_HEADER_LENGTH_BYTES,
+                                  &compressed);
+    compressor_put(comp);
+    if (0 == rslt) {
+        uint32_t crc;
+        size_t packed_size = GZIP_HEADER_LENGTH_BYTES + compressed + GZIP_FOOTER_LENGTH_BYTES;
+        size_t diff = unpacked_size - packed_size;
+
+        PUBNUB_LOG_TRACE("deflate_total_to_context_buffer(pb=%p) - "
+                         "Length before compression: %lu bytes - "
+                         "Length after compression: %lu bytes - "
+                         "compression ratio=%ld o/oo\n",
+                         pb,
+                         (unsigned long)unpacked_size,
+                         (unsigned long)packed_size,
+                         (long)(diff*1000)/(long)unpacked_size);
+        if ((packed_size > unpacked_size) ||
+            ((diff*100)/unpacked_size < PUBNUB_MINIMAL_ACCEPTABLE_COMPRESSION_RATIO)) {
+            /* With insufficient compression we choose not to pack */
+            pubnub_atomic_add(&m_poor_ratio, 1);
+            return PNR_STARTED;
         }
-        break;
+        /* Cyclic redundancy checksum data(little endian) */
+        crc = pbgzip_backend_crc32(0, message, unpacked_size);
+        gzip_msg_buf[packed_size - 5] = crc >> 24;
+        gzip_msg_buf[packed_size - 6] = (crc >> 16) & 0xFF;
+        gzip_msg_buf[packed_size - 7] = (crc >> 8) & 0xFF;
+        gzip_msg_buf[packed_size - 8] = crc & 0xFF;
+        /* Unpacked message size is placed at the end of the 'gzip' formated message
+           in the last four bytes(little endian)
+         */
+        gzip_msg_buf[packed_size - 1] = (uint32_t)unpacked_size >> 24;
+        gzip_msg_buf[packed_size - 2] = ((uint32_t)unpacked_size >> 16) & 0xFF;
+        gzip_msg_buf[packed_size - 3] = ((uint32_t)unpacked_size >> 8) & 0xFF;
+        gzip_msg_buf[packed_size - 4] = (uint32_t)unpacked_size & 0xFF;
+        pb->core.gzip_msg_len = packed_size;
+        pubnub_atomic_add(&m_packed, 1);
+        return PNR_OK;
     }
+    PUBNUB_LOG_ERROR("deflate_total_to_context_buffer(pb=%p) - "
+                     "compression failed with the %s backend\n",
+                     pb,
+                     pbgzip_backend_name());
+
     return PNR_BAD_COMPRESSION_FORMAT;
 }
 
@@ -129,3 +288,56 @@ enum pubnub_res pbgzip_compress(pubnub_t* pb, char const* message)
 
     return deflate_total_to_context_buffer(pb, message, size);
 }
+
+
+int pubnub_set_gzip_compression(pubnub_t* pb, int level, int max_probes)
+{
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+
+    if ((level < 0) || (level > PBGZIP_BACKEND_MAX_LEVEL)
+        || (max_probes > PBGZIP_BACKEND_MAX_PROBES)) {
+        return -1;
+    }
+    pubnub_mutex_lock(pb->monitor);
+    pb->core.gzip_level      = level;
+    pb->core.gzip_max_probes = max_probes;
+    pubnub_mutex_unlock(pb->monitor);
+
+    return 0;
+}
+
+
+void pubnub_gzip_set_estimate(size_t sample_size, unsigned min_savings)
+{
+    pubnub_atomic_store(&m_sample_size, (long)sample_size);
+    pubnub_atomic_store(&m_min_savings, (long)min_savings);
+}
+
+
+void pubnub_gzip_compress_stats(struct pubnub_gzip_compress_stats* stats)
+{
+    PUBNUB_ASSERT_OPT(stats != NULL);
+
+    stats->estimated  = (unsigned long)pubnub_atomic_load(&m_estimated);
+    stats->skipped    = (unsigned long)pubnub_atomic_load(&m_skipped);
+    stats->packed     = (unsigned long)pubnub_atomic_load(&m_packed);
+    stats->poor_ratio = (unsigned long)pubnub_atomic_load(&m_poor_ratio);
+}
+
+
+void pubnub_gzip_compressor_pool_trim(void)
+{
+    struct compressor* pool;
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    pool     = m_pool;
+    m_pool   = NULL;
+    m_pooled = 0;
+    pubnub_mutex_unlock(m_lock);
+    while (pool != NULL) {
+        struct compressor* next = pool->next;
+        compressor_free(pool);
+        pool = next;
+    }
+}
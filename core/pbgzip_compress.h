@@ -3,11 +3,60 @@
 #define INC_PUBNUB_COMPRESSION
 
 #include "pubnub_api_types.h"
+#include "pubnub_gzip_compression.h"
+
+
+/** Default compression level of the contexts, from 0 (no compression)
+    to 10 (best and slowest), the same as in zlib (except for 10). The
+    default of 6 is the usual trade-off.
+ */
+#if !defined PUBNUB_GZIP_COMPRESSION_LEVEL
+#define PUBNUB_GZIP_COMPRESSION_LEVEL 6
+#endif
+
+/** Default maximum number of dictionary probes per match search of
+    the contexts, up to 4095. More probes can find better matches,
+    but take longer. Negative means: as the compression level says.
+    The libdeflate backend (see pbgzip_backend.h) ignores this.
+ */
+#if !defined PUBNUB_GZIP_MAX_PROBES
+#define PUBNUB_GZIP_MAX_PROBES -1
+#endif
+
+/** The (deflate) compressor state is hundreds of KB, so it is not on
+    the stack, but allocated from the heap and kept in a process-wide
+    pool, to be reused. This is how many compressors are kept there,
+    at most, which is how many contexts can compress at the same time
+    without allocating.
+ */
+#if !defined PUBNUB_GZIP_COMPRESSOR_POOL_SIZE
+#define PUBNUB_GZIP_COMPRESSOR_POOL_SIZE 2
+#endif
+
+/** Before compressing a message, we estimate how much it would
+    compress, from the entropy of (a sample of) its octets, and don't
+    compress it if that's less than #PUBNUB_GZIP_ESTIMATE_MIN_SAVINGS
+    percent. This is the default size of that sample, in octets, 0
+    to not estimate.
+ */
+#if !defined PUBNUB_GZIP_ESTIMATE_SAMPLE_SIZE
+#define PUBNUB_GZIP_ESTIMATE_SAMPLE_SIZE 1024
+#endif
+
+/** The default minimal estimated savings, in percent, for a message
+    to be compressed. Deflate can do better than the estimate (by
+    finding repeated strings), so this should be somewhat less than
+    the savings needed to actually send a compressed message (10%).
+ */
+#if !defined PUBNUB_GZIP_ESTIMATE_MIN_SAVINGS
+#define PUBNUB_GZIP_ESTIMATE_MIN_SAVINGS 5
+#endif
+
 
 /** Compresses(deflates) @p message into gzip-formatted data stored in context buffer.
     @retval PNR_OK on success,
     @retval PNR_STARTED on poor comression ratio,
-    @retval PNR_BAD_COMPRESSION_FORMAT on error     
+    @retval PNR_BAD_COMPRESSION_FORMAT on error
  */
 enum pubnub_res pbgzip_compress(pubnub_t *pb, char const* message);
 
@@ -2,137 +2,89 @@
 #include "pubnub_internal.h"
 
 #include "core/pubnub_assert.h"
-#include "lib/miniz/miniz_tinfl.h"
+#include "core/pbgzip_backend.h"
 #include "core/pubnub_log.h"
 
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
 #define GZIP_HEADER_LENGTH_BYTES 10
 #define GZIP_FOOTER_LENGTH_BYTES 8
 
-static enum pubnub_res inflate_total_to_context_buffer(pubnub_t*      pb,
-                                                       uint8_t const* p_in_buf_next,
-                                                       size_t in_buf_size,
-                                                       size_t out_len)
-{
-    tinfl_decompressor decomp;
-    size_t             dst_buf_size = out_len;
-    tinfl_init(&decomp);
-    tinfl_status status =
-        tinfl_decompress(&decomp,
-                         (const mz_uint8*)p_in_buf_next,
-                         &in_buf_size,
-                         (mz_uint8*)pb->core.decomp_http_reply,
-                         (mz_uint8*)pb->core.decomp_http_reply,
-                         &dst_buf_size,
-                         TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
-    switch (status) {
-    case TINFL_STATUS_DONE:
-        if (dst_buf_size == out_len) {
-            return PNR_OK;
-        }
-        else {
-            PUBNUB_LOG_ERROR("Decompressed length[%u] is smaller than the "
-                             "'unpacked_size' value[%u]!\n"
-                             "(Unpacked:['%.*s'])\n",
-                             (unsigned)dst_buf_size,
-                             (unsigned)out_len,
-                             (int)dst_buf_size,
-                             pb->core.decomp_http_reply);
-        }
-        break;
-    case TINFL_STATUS_FAILED_CANNOT_MAKE_PROGRESS:
-        PUBNUB_LOG_ERROR(
-            "'Tinfl'-decompress status: failed(cannot make progress)!\n");
-        break;
-    case TINFL_STATUS_FAILED:
-        PUBNUB_LOG_ERROR("'Tinfl'-decompress status: failed!\n");
-        break;
-    case TINFL_STATUS_HAS_MORE_OUTPUT:
-        PUBNUB_LOG_ERROR("Decompressed length is grater than the "
-                         "'unpacked_size' value[%u]!\n"
-                         "(Unpacked:['%.*s'])\n",
-                         (unsigned)out_len,
-                         (int)out_len,
-                         pb->core.decomp_http_reply);
-        break;
-    default:
-        if (status < 0) {
-            PUBNUB_LOG_ERROR("Decompression failed(Status: %d)!", status);
-        }
-        else {
-            PUBNUB_LOG_ERROR("'Tinfl'-decompress status: %d!\n", status);
-        }
-        break;
-    }
-    return PNR_BAD_COMPRESSION_FORMAT;
-}
+/** The least we allocate for the inflated reply, at first. If we know
+    the length of the compressed reply, we allocate a few times that.
+ */
+#define INFLATE_MIN_REPLY_CAPACITY 1024
+#define INFLATE_EXPECTED_RATIO 4
 
-#if !PUBNUB_DYNAMIC_REPLY_BUFFER
-PUBNUB_STATIC_ASSERT(sizeof((pubnub_t*)0)->core.http_reply == sizeof((pubnub_t*)0)->core.decomp_http_reply,
-                     http_reply_and_gzip_decompression_buffer_dont_match);
-#endif
 
-static void swap_reply_buffer(pubnub_t* pb)
-{
-#if PUBNUB_DYNAMIC_REPLY_BUFFER
-    char*  aux_buf             = pb->core.http_reply;
-    size_t aux_buf_len         = pb->core.http_buf_len;
-    pb->core.http_reply        = pb->core.decomp_http_reply;
-    pb->core.http_buf_len      = pb->core.decomp_buf_size;
-    pb->core.decomp_http_reply = aux_buf;
-    pb->core.decomp_buf_size   = aux_buf_len;
-#else
-    PUBNUB_ASSERT(pb->core.decomp_buf_size < sizeof pb->core.decomp_http_reply);
-    memcpy(pb->core.http_reply, pb->core.decomp_http_reply, pb->core.decomp_buf_size);
-    pb->core.http_buf_len = pb->core.decomp_buf_size;
-#endif /* PUBNUB_DYNAMIC_REPLY_BUFFER */
-    return;
-}
+/** Where we are in the gzip-formatted reply */
+enum inflate_stage {
+    /** Gzip header */
+    isHeader,
+    /** The deflated data */
+    isDeflate,
+    /** Gzip footer (CRC and length) */
+    isFooter,
+    /** All done, there should be no more data */
+    isDone
+};
+
 
+/** The state of inflating a gzip-formatted reply, as it is received.
+    The inflated data is put right in the reply buffer (which is also
+    the "dictionary" for some backends), so no other buffer is needed.
+ */
+struct pbgzip_inflate {
+    /** The (backend) inflater */
+    struct pbgzip_inflater* inflater;
+    enum inflate_stage stage;
+    /** The header or footer, as much as was received so far */
+    uint8_t head[GZIP_HEADER_LENGTH_BYTES];
+    /** How much of the header or footer was received so far */
+    size_t head_len;
+    /** Capacity of the reply buffer for the inflated data (without
+        the string terminator) */
+    size_t out_cap;
+};
 
-static enum pubnub_res inflate_total(pubnub_t*      pb,
-                                     const uint8_t* p_in_buf_next,
-                                     size_t         in_buf_size,
-                                     size_t         out_len)
+
+/** Makes the reply buffer of @p pb hold at least @p cap octets (and
+    the string terminator), keeping its contents. The static reply
+    buffer can't grow, so then this fails if it is smaller.
+ */
+static enum pubnub_res reserve_reply(pubnub_t* pb, size_t cap)
 {
-    enum pubnub_res result;
 #if PUBNUB_DYNAMIC_REPLY_BUFFER
-    if (pb->core.decomp_buf_size < out_len) {
-        char* newbuf = (char*)realloc(pb->core.decomp_http_reply, out_len + 1);
-        if (NULL == newbuf) {
-            PUBNUB_LOG_ERROR("Failed to reallocate decompression buffer!\n"
-                             "Out length:%lu\n",
-                             (unsigned long)out_len);
-            return PNR_REPLY_TOO_BIG;
-        }
-        pb->core.decomp_http_reply = newbuf;
+    if ((cap > UINT_MAX - 1) || (0 != pbcc_realloc_reply_buffer(&pb->core, (unsigned)cap))) {
+        PUBNUB_LOG_ERROR("pb=%p Failed to allocate %lu octets for the inflated reply!\n",
+                         pb,
+                         (unsigned long)cap);
+        return PNR_REPLY_TOO_BIG;
     }
+#if PUBNUB_USE_REPLY_BUFFER_POOL
+    /* The pool may have given us more */
+    cap = pb->core.http_reply_cap - 1;
+#endif
 #else
-    if (out_len >= sizeof pb->core.decomp_http_reply) {
-        PUBNUB_LOG_ERROR("Decompression buffer too small!\n"
-                         "Size of buffer:%lu - Out length:%lu\n",
-                         (unsigned long)sizeof pb->core.decomp_http_reply,
-                         (unsigned long)out_len);
+    if (cap >= sizeof pb->core.http_reply) {
+        PUBNUB_LOG_ERROR("pb=%p Inflated reply too big for the reply buffer of %lu octets!\n",
+                         pb,
+                         (unsigned long)sizeof pb->core.http_reply);
         return PNR_REPLY_TOO_BIG;
     }
+    cap = sizeof pb->core.http_reply - 1;
 #endif
-    result =
-        inflate_total_to_context_buffer(pb, p_in_buf_next, in_buf_size, out_len);
-    if (result == PNR_OK) {
-        pb->core.decomp_buf_size = out_len;
-        swap_reply_buffer(pb);
-    }
-    return result;
+    pb->core.gzip_inflate->out_cap = cap;
+
+    return PNR_OK;
 }
 
 
-enum pubnub_res pbgzip_decompress(pubnub_t* pb)
+static enum pubnub_res check_header(uint8_t const* data)
 {
-    const uint8_t* data = (uint8_t*)pb->core.http_reply;
-    size_t         size = (size_t)pb->core.http_buf_len;
-    uint32_t       unpacked_size;
-
-    if ((size < (GZIP_HEADER_LENGTH_BYTES + GZIP_FOOTER_LENGTH_BYTES))
-        || (data[0] != 0x1f) || (data[1] != 0x8b)) {
+    if ((data[0] != 0x1f) || (data[1] != 0x8b)) {
         PUBNUB_LOG_ERROR("Compressed data format is not gzip!\n");
         return PNR_BAD_COMPRESSION_FORMAT;
     }
@@ -143,24 +95,207 @@ enum pubnub_res pbgzip_decompress(pubnub_t* pb)
         return PNR_BAD_COMPRESSION_FORMAT;
     }
     if (data[3] != 0) {
-        PUBNUB_LOG_ERROR("GZIP flags should be 0, but are %uX\n",
-                         (unsigned)data[3]);
+        PUBNUB_LOG_ERROR("GZIP flags should be 0, but are %uX\n", (unsigned)data[3]);
+        return PNR_BAD_COMPRESSION_FORMAT;
+    }
+    return PNR_OK;
+}
+
+
+/** Collects the header or footer, of @p size octets, from the @p len
+    octets at @p data. Returns how many octets were taken.
+ */
+static size_t collect_head(struct pbgzip_inflate* st, uint8_t const* data, size_t len, size_t size)
+{
+    size_t n = size - st->head_len;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(st->head + st->head_len, data, n);
+    st->head_len += n;
+    return n;
+}
+
+
+/** Inflates what it can from the @p *len octets at @p *data, which
+    are updated to what's left.
+ */
+static enum pubnub_res inflate_some(pubnub_t* pb, uint8_t const** data, size_t* len)
+{
+    struct pbgzip_inflate*     st = pb->core.gzip_inflate;
+    enum pbgzip_inflate_status status;
+
+    for (;;) {
+        size_t in_size  = *len;
+        size_t out_size = st->out_cap - pb->core.http_buf_len;
+
+        status = pbgzip_backend_inflate(st->inflater,
+                                        *data,
+                                        &in_size,
+                                        (uint8_t*)pb->core.http_reply,
+                                        pb->core.http_buf_len,
+                                        &out_size);
+        *data += in_size;
+        *len -= in_size;
+        pb->core.http_buf_len += out_size;
+        if (status != pbgzInflateNeedsOutput) {
+            break;
+        }
+        if (PNR_OK != reserve_reply(pb, 2 * st->out_cap)) {
+            return PNR_REPLY_TOO_BIG;
+        }
+    }
+    switch (status) {
+    case pbgzInflateDone:
+        st->stage    = isFooter;
+        st->head_len = 0;
+        return PNR_OK;
+    case pbgzInflateNeedsInput:
+        PUBNUB_ASSERT_OPT(0 == *len);
+        return PNR_OK;
+    default:
+        PUBNUB_LOG_ERROR("pb=%p Failed to inflate the reply!\n", pb);
+        break;
+    }
+    return PNR_BAD_COMPRESSION_FORMAT;
+}
+
+
+enum pubnub_res pbgzip_inflate_start(pubnub_t* pb, size_t size_hint)
+{
+    struct pbgzip_inflate* st;
+    size_t                 cap = INFLATE_MIN_REPLY_CAPACITY;
+
+    PUBNUB_ASSERT_OPT(pb != NULL);
+
+    if (NULL == pb->core.gzip_inflate) {
+        st = (struct pbgzip_inflate*)malloc(sizeof *st);
+        if (st != NULL) {
+            st->inflater = pbgzip_backend_inflater_alloc();
+            if (NULL == st->inflater) {
+                free(st);
+                st = NULL;
+            }
+        }
+        if (NULL == st) {
+            PUBNUB_LOG_ERROR("pb=%p Failed to allocate the inflater!\n", pb);
+            return PNR_REPLY_TOO_BIG;
+        }
+        pb->core.gzip_inflate = st;
+    }
+    else {
+        st = pb->core.gzip_inflate;
+        pbgzip_backend_inflater_reset(st->inflater);
+    }
+    st->stage    = isHeader;
+    st->head_len = 0;
+    pb->core.http_buf_len = 0;
+    if (size_hint * INFLATE_EXPECTED_RATIO > cap) {
+        cap = size_hint * INFLATE_EXPECTED_RATIO;
+    }
+#if !PUBNUB_DYNAMIC_REPLY_BUFFER
+    /* It's only a guess, the reply may still fit, we'll know if it
+       doesn't when inflating
+    */
+    if (cap >= sizeof pb->core.http_reply) {
+        cap = sizeof pb->core.http_reply - 1;
+    }
+#endif
+
+    return reserve_reply(pb, cap);
+}
+
+
+enum pubnub_res pbgzip_inflate(pubnub_t* pb, uint8_t const* data, size_t len)
+{
+    struct pbgzip_inflate* st;
+    enum pubnub_res        rslt;
+
+    PUBNUB_ASSERT_OPT(pb != NULL);
+    PUBNUB_ASSERT_OPT(pb->core.gzip_inflate != NULL);
+    PUBNUB_ASSERT_OPT((data != NULL) || (0 == len));
+
+    st = pb->core.gzip_inflate;
+    while (len > 0) {
+        size_t n;
+        switch (st->stage) {
+        case isHeader:
+            n = collect_head(st, data, len, GZIP_HEADER_LENGTH_BYTES);
+            data += n;
+            len -= n;
+            if (GZIP_HEADER_LENGTH_BYTES == st->head_len) {
+                rslt = check_header(st->head);
+                if (rslt != PNR_OK) {
+                    return rslt;
+                }
+                st->stage = isDeflate;
+            }
+            break;
+        case isDeflate:
+            rslt = inflate_some(pb, &data, &len);
+            if (rslt != PNR_OK) {
+                return rslt;
+            }
+            break;
+        case isFooter:
+            n = collect_head(st, data, len, GZIP_FOOTER_LENGTH_BYTES);
+            data += n;
+            len -= n;
+            if (GZIP_FOOTER_LENGTH_BYTES == st->head_len) {
+                st->stage = isDone;
+            }
+            break;
+        default:
+            PUBNUB_LOG_ERROR("pb=%p %lu octets of data after the gzip footer!\n",
+                             pb,
+                             (unsigned long)len);
+            return PNR_BAD_COMPRESSION_FORMAT;
+        }
+    }
+
+    return PNR_OK;
+}
+
+
+enum pubnub_res pbgzip_inflate_finish(pubnub_t* pb)
+{
+    struct pbgzip_inflate* st;
+    uint32_t               unpacked_size;
+
+    PUBNUB_ASSERT_OPT(pb != NULL);
+    PUBNUB_ASSERT_OPT(pb->core.gzip_inflate != NULL);
+
+    st = pb->core.gzip_inflate;
+    if (st->stage != isDone) {
+        PUBNUB_LOG_ERROR("pb=%p gzip-formatted reply is incomplete!\n", pb);
         return PNR_BAD_COMPRESSION_FORMAT;
     }
     /* Unpacked message size is placed at the end of the 'gzip' formated message
        in the last four bytes
      */
-    unpacked_size = (uint32_t)data[size - 4];
-    unpacked_size |= (uint32_t)data[size - 3] << 8;
-    unpacked_size |= (uint32_t)data[size - 2] << 16;
-    unpacked_size |= (uint32_t)data[size - 1] << 24;
-    PUBNUB_LOG_TRACE("pbgzip_decompress(pb=%p)-Length before:%lu and after "
-                     "decompresion:%lu\n",
+    unpacked_size = (uint32_t)st->head[4];
+    unpacked_size |= (uint32_t)st->head[5] << 8;
+    unpacked_size |= (uint32_t)st->head[6] << 16;
+    unpacked_size |= (uint32_t)st->head[7] << 24;
+    PUBNUB_LOG_TRACE("pbgzip_inflate_finish(pb=%p)-Length after decompresion:%lu\n",
                      pb,
-                     (unsigned long)size,
-                     (unsigned long)unpacked_size);
-    size -= (GZIP_HEADER_LENGTH_BYTES + GZIP_FOOTER_LENGTH_BYTES);
+                     (unsigned long)pb->core.http_buf_len);
+    if (unpacked_size != (uint32_t)pb->core.http_buf_len) {
+        PUBNUB_LOG_ERROR("Decompressed length[%lu] differs from the "
+                         "'unpacked_size' value[%lu]!\n",
+                         (unsigned long)pb->core.http_buf_len,
+                         (unsigned long)unpacked_size);
+        return PNR_BAD_COMPRESSION_FORMAT;
+    }
 
-    return inflate_total(
-        pb, data + GZIP_HEADER_LENGTH_BYTES, size, (size_t)unpacked_size);
+    return PNR_OK;
+}
+
+
+void pbgzip_inflate_free(struct pbgzip_inflate* st)
+{
+    if (st != NULL) {
+        pbgzip_backend_inflater_free(st->inflater);
+        free(st);
+    }
 }
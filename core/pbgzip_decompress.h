@@ -4,18 +4,45 @@
 
 #include "pubnub_api_types.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
 /* Types of compressed data format */
 enum pubnub_data_compressionType{
     compressionNONE,
     compressionGZIP
 };
 
-/** Decompresses(inflates) gzip-formatted data stored in the reply context buffer.
-    After decompression puts it back into the same buffer.
+struct pbgzip_inflate;
+
+/** Starts inflating a gzip-formatted reply of the context @p pb,
+    which is to be fed to pbgzip_inflate() as it is received. The
+    inflated data is put in the reply buffer.
+    @param size_hint The length of the gzip-formatted reply, if known,
+    otherwise 0
+    @retval PNR_OK on success,
+    @retval PNR_REPLY_TOO_BIG lack of memory
+ */
+enum pubnub_res pbgzip_inflate_start(pubnub_t *pb, size_t size_hint);
+
+/** Inflates the next @p len octets of the gzip-formatted reply, at
+    @p data, to the reply buffer, after the data inflated so far,
+    updating its length.
     @retval PNR_OK on success,
     @retval PNR_REPLY_TOO_BIG lack of memory,
-    @retval PNR_BAD_COMPRESSION_FORMAT on error     
+    @retval PNR_BAD_COMPRESSION_FORMAT on error
  */
-enum pubnub_res pbgzip_decompress(pubnub_t *pb);
+enum pubnub_res pbgzip_inflate(pubnub_t *pb, uint8_t const* data, size_t len);
+
+/** Finishes inflating the gzip-formatted reply, checking that all of
+    it was received and that the length of the inflated data is as
+    given in it.
+    @retval PNR_OK on success,
+    @retval PNR_BAD_COMPRESSION_FORMAT on error
+ */
+enum pubnub_res pbgzip_inflate_finish(pubnub_t *pb);
+
+/** Frees the inflating state @p st (of a context), if not NULL */
+void pbgzip_inflate_free(struct pbgzip_inflate* st);
 
 #endif /* INC_PUBNUB_DECOMPRESSION */
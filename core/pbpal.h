@@ -120,6 +120,24 @@ int pbpal_send(pubnub_t *pb, void const *data, size_t n);
 */
 int pbpal_send_str(pubnub_t *pb, char const *s);
 
+struct pbpal_iovec;
+
+/** Sends the pieces of data in the @p vec array (of @p count
+    elements) over an established connection (with the Pubnub
+    server), as if they were one (concatenated) piece of data, but
+    with as few system calls (and TLS records) as possible.
+
+    Like pbpal_send(), sends as much as it can, you should check if
+    sending was completed by calling pbpal_send_status(). The data
+    pieces have to remain valid until it's completed, but the
+    @p vec array itself does not.
+
+    Available only if `PUBNUB_USE_VECTORED_SEND` is true (!=0).
+
+    @return 0: sent, -1: error, +1: sending started, not finished
+*/
+int pbpal_sendv(pubnub_t *pb, struct pbpal_iovec const *vec, size_t count);
+
 /** Returns the status of sending. Don't try another
     sending until previous is complete.
 
@@ -179,6 +197,29 @@ int pbpal_read_len(pubnub_t *pb);
 */
 int pbpal_start_read(pubnub_t *pb, size_t n);
 
+/** Starts reading exactly @p n octets (bytes) from an established
+    TCP connection directly to @p dst, rather than to the receive
+    buffer of the context, thus avoiding copying (possibly large)
+    data from one to the other. Data that was already received to
+    the receive buffer (but not read yet) is "read" first. It's used
+    to receive the body (or chunk of it) of the HTTP response to the
+    reply buffer, once its length is known.
+
+    To check if reading is complete, call pbpal_read_status(). Unlike
+    with pbpal_start_read(), it returns PNR_OK only when all of the
+    @p n octets were read.
+
+    Available only if `PUBNUB_USE_ZERO_COPY_RECEIVE` is true (!=0).
+
+    @precondition Previous read (or write) on the context was finished
+
+    @param pb The Pubnub context of an established TCP connection
+    @param dst Buffer to read to, has to have room for @p n octets
+    @param n Number of octets (bytes) to read
+    @return +1: OK (started)
+*/
+int pbpal_start_read_into(pubnub_t *pb, char *dst, size_t n);
+
 /** Returns the status of reading a chunk of data. In general, it's
     used to receive the body (or chunk of it) of the HTTP response.
 
@@ -71,6 +71,18 @@ int pbpal_ntf_watch_in_events(struct pbpal_poll_data* data, pubnub_t* pbp);
  */
 int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms);
 
+/** Wakes up the poll (pbpal_ntf_poll_away()) on the poll-set @p data
+    that is in progress, or, if there is none, makes the next one
+    return right away. Can be called from any thread. This is used to
+    make the poller "see" the work that was given to it from other
+    threads, without waiting for the poll to time out.
+
+    @retval 0 OK
+    @retval -1 this poller can't be woken up, so the user must not
+    poll with a long timeout
+ */
+int pbpal_ntf_callback_poller_wake(struct pbpal_poll_data* data);
+
 /** Deinitialize and deellocate the poller data */
 void pbpal_ntf_callback_poller_deinit(struct pbpal_poll_data** data);
 
@@ -5,113 +5,144 @@
 
 #include "pubnub_assert.h"
 
+#include <stddef.h>
+
+
+#define NODE_TO_PB(node)                                                       \
+    ((pubnub_t*)((char*)(node)-offsetof(struct pubnub_, queue_node)))
+
 
 void pbpal_ntf_callback_queue_init(struct pbpal_ntf_callback_queue* queue)
 {
-    pubnub_mutex_init(queue->monitor);
-    queue->size = sizeof queue->apb / sizeof queue->apb[0];
-    queue->head = queue->tail = 0;
+    queue->stub.next     = NULL;
+    queue->stub.in_queue = 0;
+    queue->stub.pending  = 0;
+    queue->head          = &queue->stub;
+    queue->tail          = &queue->stub;
 }
 
 
 void pbpal_ntf_callback_queue_deinit(struct pbpal_ntf_callback_queue* queue)
 {
-    pubnub_mutex_destroy(queue->monitor);
-    queue->head = queue->tail = 0;
+    queue->head = queue->tail = &queue->stub;
+    queue->stub.next          = NULL;
+}
+
+
+static void push(struct pbpal_ntf_callback_queue*      queue,
+                 struct pbpal_ntf_callback_queue_node* node)
+{
+    struct pbpal_ntf_callback_queue_node* prev;
+
+    node->next = NULL;
+    prev       = (struct pbpal_ntf_callback_queue_node*)pubnub_atomic_exchange_ptr(
+        &queue->head, node);
+    /* Between the exchange and this store, the queue is "broken"
+       (consumer can't get to @p node), but, that's OK, it will just
+       see it on the next round.
+    */
+    pubnub_atomic_store_ptr(&prev->next, node);
+}
+
+
+/** Takes the node from the tail of the @p queue. Returns NULL if
+    queue is empty (or if a producer is in the middle of a push, in
+    which case we'll get it next time).
+ */
+static struct pbpal_ntf_callback_queue_node* pop(struct pbpal_ntf_callback_queue* queue)
+{
+    struct pbpal_ntf_callback_queue_node* tail = queue->tail;
+    struct pbpal_ntf_callback_queue_node* next =
+        (struct pbpal_ntf_callback_queue_node*)pubnub_atomic_load_ptr(&tail->next);
+    struct pbpal_ntf_callback_queue_node* head;
+
+    if (tail == &queue->stub) {
+        if (NULL == next) {
+            return NULL;
+        }
+        queue->tail = next;
+        tail        = next;
+        next = (struct pbpal_ntf_callback_queue_node*)pubnub_atomic_load_ptr(
+            &next->next);
+    }
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+    head = (struct pbpal_ntf_callback_queue_node*)pubnub_atomic_load_ptr(&queue->head);
+    if (tail != head) {
+        return NULL;
+    }
+    push(queue, &queue->stub);
+    next = (struct pbpal_ntf_callback_queue_node*)pubnub_atomic_load_ptr(&tail->next);
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+    return NULL;
 }
 
 
 int pbpal_ntf_callback_enqueue_for_processing(struct pbpal_ntf_callback_queue* queue,
                                               pubnub_t* pb)
 {
-    int    result;
-    size_t next_head;
-
     PUBNUB_ASSERT_OPT(queue != NULL);
     PUBNUB_ASSERT_OPT(pb != NULL);
 
-    pubnub_mutex_lock(queue->monitor);
-    next_head = queue->head + 1;
-    if (next_head == queue->size) {
-        next_head = 0;
+    pubnub_atomic_exchange(&pb->queue_node.pending, 1);
+    if (0 == pubnub_atomic_exchange(&pb->queue_node.in_queue, 1)) {
+        push(queue, &pb->queue_node);
     }
-    if (next_head != queue->tail) {
-        queue->apb[queue->head] = pb;
-        queue->head             = next_head;
-        result                  = +1;
-    }
-    else {
-        result = -1;
-    }
-    pubnub_mutex_unlock(queue->monitor);
 
-    return result;
+    return +1;
 }
 
 
 int pbpal_ntf_callback_requeue_for_processing(struct pbpal_ntf_callback_queue* queue,
                                               pubnub_t* pb)
 {
-    bool   found = false;
-    size_t i;
-
     PUBNUB_ASSERT_OPT(pb != NULL);
 
-    pubnub_mutex_lock(queue->monitor);
-    for (i = queue->tail; i != queue->head;
-         i = (((i + 1) == queue->size) ? 0 : i + 1)) {
-        if (queue->apb[i] == pb) {
-            found = true;
-            break;
-        }
+    if (0 != pubnub_atomic_exchange(&pb->queue_node.pending, 1)) {
+        return 0;
     }
-    pubnub_mutex_unlock(queue->monitor);
-
-    return !found ? pbpal_ntf_callback_enqueue_for_processing(queue, pb) : 0;
+    return pbpal_ntf_callback_enqueue_for_processing(queue, pb);
 }
 
 
 void pbpal_ntf_callback_remove_from_queue(struct pbpal_ntf_callback_queue* queue,
                                           pubnub_t*                        pb)
 {
-    size_t i;
-
     PUBNUB_ASSERT_OPT(queue != NULL);
     PUBNUB_ASSERT_OPT(pb != NULL);
 
-    pubnub_mutex_lock(queue->monitor);
-    for (i = queue->tail; i != queue->head;
-         i = (((i + 1) == queue->size) ? 0 : i + 1)) {
-        if (queue->apb[i] == pb) {
-            queue->apb[i] = NULL;
-            break;
-        }
-    }
-    pubnub_mutex_unlock(queue->monitor);
+    pubnub_atomic_store(&pb->queue_node.pending, 0);
 }
 
 
 void pbpal_ntf_callback_process_queue(struct pbpal_ntf_callback_queue* queue)
 {
-    pubnub_mutex_lock(queue->monitor);
-    while (queue->head != queue->tail) {
-        pubnub_t* pbp = queue->apb[queue->tail++];
-        if (queue->tail == queue->size) {
-            queue->tail = 0;
+    struct pbpal_ntf_callback_queue_node* node;
+
+    while ((node = pop(queue)) != NULL) {
+        pubnub_t* pbp = NODE_TO_PB(node);
+
+        /* First say it's not in the queue any more, then check if it
+           should be processed - so that a concurrent (re)queue will
+           either be seen here, or will put it back in the queue.
+         */
+        pubnub_atomic_exchange(&node->in_queue, 0);
+        if (0 == pubnub_atomic_exchange(&node->pending, 0)) {
+            continue;
+        }
+        pubnub_mutex_lock(pbp->monitor);
+        if (pbp->state == PBS_NULL) {
+            pubnub_mutex_unlock(pbp->monitor);
+            pballoc_free_at_last(pbp);
         }
-        if (pbp != NULL) {
-            pubnub_mutex_unlock(queue->monitor);
-            pubnub_mutex_lock(pbp->monitor);
-            if (pbp->state == PBS_NULL) {
-                pubnub_mutex_unlock(pbp->monitor);
-                pballoc_free_at_last(pbp);
-            }
-            else {
-                pbnc_fsm(pbp);
-                pubnub_mutex_unlock(pbp->monitor);
-            }
-            pubnub_mutex_lock(queue->monitor);
+        else {
+            pbnc_fsm(pbp);
+            pubnub_mutex_unlock(pbp->monitor);
         }
     }
-    pubnub_mutex_unlock(queue->monitor);
 }
@@ -2,7 +2,8 @@
 #if !defined(INC_PBPAL_NTF_CALLBACK_QUEUE)
 #define INC_PBPAL_NTF_CALLBACK_QUEUE
 
-#include "pubnub_mutex.h"
+#include "pubnub_api_types.h"
+#include "pubnub_atomic.h"
 
 
 /** @file pbpal_ntf_callback_queue.h
@@ -19,17 +20,39 @@
  */
 
 
-#define PBPAL_NTF_CALLBACK_QUEUE_LIMIT 1024
+/** The "link" of a context in the queue. It is a part of the Pubnub
+    context, thus the queue is "intrusive" and needs no memory
+    allocation - it's unbounded, as a context is never in the queue
+    more than once.
+ */
+struct pbpal_ntf_callback_queue_node {
+    /** Next in the queue */
+    struct pbpal_ntf_callback_queue_node* volatile next;
+    /** Is the node (physically) in the queue. Set by producers,
+        cleared by the consumer, when it takes the node out of the
+        queue.
+     */
+    pubnub_atomic_t in_queue;
+    /** Should the context be processed. Set on (re)queueing, cleared
+        when removing from queue and by the consumer, when it
+        processes the context.
+     */
+    pubnub_atomic_t pending;
+};
+
 
-/** The queue data. It's a simple circular buffer of (pointers to)
-    contexts, with a mutex as a monitor for multithreading.
+/** The queue data. It's a lock-free, multiple producer, single
+    consumer, intrusive queue of contexts (D. Vyukov's algorithm).
+    Any thread can (re)queue a context, but only the thread that
+    "owns" the queue processes it.
  */
 struct pbpal_ntf_callback_queue {
-    pubnub_mutex_t monitor;
-    size_t         size;
-    size_t         head;
-    size_t         tail;
-    pubnub_t*      apb[PBPAL_NTF_CALLBACK_QUEUE_LIMIT];
+    /** Where producers put nodes. Only changed with atomic exchange. */
+    struct pbpal_ntf_callback_queue_node* volatile head;
+    /** Where the consumer takes nodes from. */
+    struct pbpal_ntf_callback_queue_node* tail;
+    /** The dummy node, so that the queue is never really empty. */
+    struct pbpal_ntf_callback_queue_node stub;
 };
 
 
@@ -48,18 +71,23 @@ int pbpal_ntf_callback_enqueue_for_processing(struct pbpal_ntf_callback_queue* q
 
 /** Requeue Pubnub context @p pb for processing in the @p queue. That
     is, if context is already in queue, let it be. If it's not,
-    enqueue it.
+    enqueue it. As the "is in queue" check is O(1), this is, actually,
+    the same as pbpal_ntf_callback_enqueue_for_processing().
  */
 int pbpal_ntf_callback_requeue_for_processing(struct pbpal_ntf_callback_queue* queue,
                                               pubnub_t* pb);
 
 
-/** Remove Pubnub context @p pb from @p queue */
+/** Remove Pubnub context @p pb from @p queue. It may stay in the
+    queue, but it will not be processed (unless queued again).
+ */
 void pbpal_ntf_callback_remove_from_queue(struct pbpal_ntf_callback_queue* queue,
                                           pubnub_t*                        pb);
 
 
-/** Process all the context in the @p queue. */
+/** Process all the context in the @p queue. Must be called only
+    from the thread that "owns" the @p queue.
+ */
 void pbpal_ntf_callback_process_queue(struct pbpal_ntf_callback_queue* queue);
 
 
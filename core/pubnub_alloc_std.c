@@ -123,6 +123,9 @@ void pballoc_free_at_last(pubnub_t* pb)
     PUBNUB_ASSERT_OPT(pb->state == PBS_NULL);
 
     pbcc_deinit(&pb->core);
+#if PUBNUB_USE_PUBLISH_QUEUE
+    pbpq_deinit(pb);
+#endif
     pbpal_free(pb);
     remove_allocated(pb);
     pubnub_mutex_unlock(pb->monitor);
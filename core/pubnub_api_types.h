@@ -247,6 +247,18 @@ enum pubnub_trans {
       */
     PBTT_HISTORY_WITH_ACTIONS,
 #endif /* PUBNUB_USE_ACTIONS_API */
+#if PUBNUB_USE_PUBLISH_QUEUE
+    /** Publish all the messages from the publish queue of the
+        context, pipelining the requests.
+      */
+    PBTT_PUBLISH_QUEUE,
+#endif
+#if PUBNUB_USE_PUBLISH_BATCH
+    /** Publish an array of messages (a "batch"), pipelining the
+        (POST) requests.
+      */
+    PBTT_PUBLISH_BATCH,
+#endif
     /** Count the number of transaction types */
     PBTT_MAX
 };
@@ -0,0 +1,91 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_ATOMIC
+#define      INC_PUBNUB_ATOMIC
+
+
+/** @file pubnub_atomic.h
+
+    A minimal set of atomic operations, for the few places where we
+    want to avoid locking a mutex. We don't use C11 `<stdatomic.h>`,
+    as not all compilers we support have it, and we compile the same
+    sources as C++, too.
+
+    All operations are sequentially consistent, except for
+    pubnub_atomic_load*(), which has "acquire", and
+    pubnub_atomic_store*(), which has "release" semantics.
+ */
+
+
+/** The type of an atomic integer. Use only through the macros
+    defined here.
+ */
+typedef long volatile pubnub_atomic_t;
+
+
+#if defined(_MSC_VER)
+
+#include <intrin.h>
+
+#define pubnub_atomic_exchange(p, v) _InterlockedExchange((p), (v))
+#define pubnub_atomic_add(p, v) (_InterlockedExchangeAdd((p), (v)) + (v))
+#define pubnub_atomic_cas(p, expected, desired)                                \
+    (_InterlockedCompareExchange((p), (desired), (expected)) == (expected))
+#define pubnub_atomic_load(p) _InterlockedOr((p), 0)
+#define pubnub_atomic_store(p, v) ((void)_InterlockedExchange((p), (v)))
+
+#define pubnub_atomic_exchange_ptr(pp, v)                                      \
+    _InterlockedExchangePointer((void* volatile*)(pp), (v))
+#define pubnub_atomic_load_ptr(pp)                                             \
+    _InterlockedCompareExchangePointer((void* volatile*)(pp), NULL, NULL)
+#define pubnub_atomic_store_ptr(pp, v)                                         \
+    ((void)_InterlockedExchangePointer((void* volatile*)(pp), (v)))
+
+#elif defined(__GNUC__) || defined(__clang__)
+
+#define pubnub_atomic_exchange(p, v) __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define pubnub_atomic_add(p, v) __atomic_add_fetch((p), (v), __ATOMIC_SEQ_CST)
+#define pubnub_atomic_cas(p, expected, desired)                                \
+    __sync_bool_compare_and_swap((p), (expected), (desired))
+#define pubnub_atomic_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define pubnub_atomic_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+#define pubnub_atomic_exchange_ptr(pp, v)                                      \
+    __atomic_exchange_n((pp), (v), __ATOMIC_SEQ_CST)
+#define pubnub_atomic_load_ptr(pp) __atomic_load_n((pp), __ATOMIC_ACQUIRE)
+#define pubnub_atomic_store_ptr(pp, v) __atomic_store_n((pp), (v), __ATOMIC_RELEASE)
+
+#else
+
+/* Don't know how to do atomic operations with this compiler, so,
+   these are OK only if there's just one thread using them. That's
+   the case on the (embedded) platforms we support w/such compilers.
+ */
+#define pubnub_atomic_exchange(p, v) pbpal_atomic_exchange_plain((p), (v))
+#define pubnub_atomic_add(p, v) (*(p) += (v))
+#define pubnub_atomic_cas(p, expected, desired)                                \
+    ((*(p) == (expected)) ? (*(p) = (desired), 1) : 0)
+#define pubnub_atomic_load(p) (*(p))
+#define pubnub_atomic_store(p, v) ((void)(*(p) = (v)))
+
+#define pubnub_atomic_exchange_ptr(pp, v) pbpal_atomic_exchange_ptr_plain((void**)(pp), (v))
+#define pubnub_atomic_load_ptr(pp) (*(pp))
+#define pubnub_atomic_store_ptr(pp, v) ((void)(*(pp) = (v)))
+
+static long pbpal_atomic_exchange_plain(pubnub_atomic_t* p, long v)
+{
+    long old = *p;
+    *p       = v;
+    return old;
+}
+
+static void* pbpal_atomic_exchange_ptr_plain(void** pp, void* v)
+{
+    void* old = *pp;
+    *pp       = v;
+    return old;
+}
+
+#endif
+
+
+#endif /* !defined INC_PUBNUB_ATOMIC */
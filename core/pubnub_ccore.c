@@ -80,7 +80,7 @@ enum pubnub_res pbcc_parse_channel_registry_response(struct pbcc_context* p)
        with value "channel-registry".  Maybe even that there is a key
        "status" (with value 200).
     */
-    result = pbjson_get_object_value(&el, "error", &found);
+    result = pbcc_get_object_value(p, &el, "error", &found);
     if (jonmpOK == result) {
         if (pbjson_elem_equals_string(&found, "false")) {
             return PNR_OK;
@@ -7,6 +7,9 @@
 #include "pubnub_url_encode.h"
 #include "lib/pb_strnlen_s.h"
 #include "pubnub_ccore_pubsub.h"
+#if PUBNUB_USE_REPLY_BUFFER_POOL
+#include "pbcc_reply_buffer_pool.h"
+#endif
 
 
 #include <stdio.h>
@@ -24,12 +27,27 @@ void pbcc_init(struct pbcc_context* p, const char* publish_key, const char* subs
     p->msg_ofs = p->msg_end = 0;
 #if PUBNUB_DYNAMIC_REPLY_BUFFER
     p->http_reply = NULL;
-#if PUBNUB_RECEIVE_GZIP_RESPONSE
-    p->decomp_buf_size   = (size_t)0;
-    p->decomp_http_reply = NULL;
-#endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
+#if PUBNUB_USE_REPLY_BUFFER_POOL
+    p->http_reply_cap = 0;
+#endif /* PUBNUB_USE_REPLY_BUFFER_POOL */
 #endif /* PUBNUB_DYNAMIC_REPLY_BUFFER */
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+    p->gzip_inflate = NULL;
+#endif
     p->message_to_send = NULL;
+#if PUBNUB_USE_JSON_TAPE
+    pbjson_tape_init(&p->reply_tape, NULL, 0);
+    p->reply_tape_len   = 0;
+    p->reply_tape_tried = false;
+    p->reply_tape_valid = false;
+#endif
+#if PUBNUB_USE_URL_ENCODE_CACHE
+    pubnub_url_encode_cache_init(&p->channel_enc_cache);
+#endif
+#if PUBNUB_USE_GZIP_COMPRESSION
+    p->gzip_level      = PUBNUB_GZIP_COMPRESSION_LEVEL;
+    p->gzip_max_probes = PUBNUB_GZIP_MAX_PROBES;
+#endif
 
 #if PUBNUB_CRYPTO_API
     p->secret_key = NULL;
@@ -39,24 +57,179 @@ void pbcc_init(struct pbcc_context* p, const char* publish_key, const char* subs
 
 void pbcc_deinit(struct pbcc_context* p)
 {
-#if PUBNUB_DYNAMIC_REPLY_BUFFER
+#if PUBNUB_USE_REPLY_BUFFER_POOL
+    pbcc_reply_buffer_release(&p->http_reply, &p->http_reply_cap);
+#elif PUBNUB_DYNAMIC_REPLY_BUFFER
     if (p->http_reply != NULL) {
         free(p->http_reply);
         p->http_reply = NULL;
     }
+#endif /* PUBNUB_DYNAMIC_REPLY_BUFFER */
 #if PUBNUB_RECEIVE_GZIP_RESPONSE
-    if (p->decomp_http_reply != NULL) {
-        free(p->decomp_http_reply);
-        p->decomp_http_reply = NULL;
+    pbgzip_inflate_free(p->gzip_inflate);
+    p->gzip_inflate = NULL;
+#endif
+#if PUBNUB_USE_JSON_TAPE
+    if (p->reply_tape.tokens != NULL) {
+        free(p->reply_tape.tokens);
+        pbjson_tape_init(&p->reply_tape, NULL, 0);
     }
-#endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
-#endif /* PUBNUB_DYNAMIC_REPLY_BUFFER */
+    p->reply_tape_tried = false;
+#endif
+#if PUBNUB_USE_URL_ENCODE_CACHE
+    pubnub_url_encode_cache_free(&p->channel_enc_cache);
+#endif
+}
+
+
+void pbcc_invalidate_reply_tape(struct pbcc_context* p)
+{
+#if PUBNUB_USE_JSON_TAPE
+    p->reply_tape_tried = false;
+    if (p->reply_tape.capacity > PUBNUB_JSON_TAPE_RETAIN_MAX) {
+        free(p->reply_tape.tokens);
+        pbjson_tape_init(&p->reply_tape, NULL, 0);
+    }
+#else
+    PUBNUB_UNUSED(p);
+#endif
+}
+
+
+#if PUBNUB_USE_JSON_TAPE
+struct pbjson_tape const* pbcc_reply_tape(struct pbcc_context* p)
+{
+    char const*             reply = p->http_reply;
+    size_t const            len   = p->http_buf_len;
+    enum pbjson_tape_result rslt;
+
+    if (p->reply_tape_tried && (p->reply_tape.json == reply)
+        && (p->reply_tape_len == len)) {
+        return p->reply_tape_valid ? &p->reply_tape : NULL;
+    }
+    p->reply_tape_tried = true;
+    p->reply_tape_valid = false;
+    p->reply_tape_len   = len;
+    p->reply_tape.json  = reply;
+    if (0 == p->reply_tape.capacity) {
+        /* A token for about every 8 characters is typical */
+        unsigned const       capacity = (unsigned)(len / 8) + 16;
+        struct pbjson_token* tokens =
+            (struct pbjson_token*)malloc(capacity * sizeof *tokens);
+        if (NULL == tokens) {
+            PUBNUB_LOG_WARNING("pbcc=%p: failed to allocate JSON tape of %u tokens\n",
+                               p,
+                               capacity);
+            return NULL;
+        }
+        pbjson_tape_init(&p->reply_tape, tokens, capacity);
+    }
+    for (;;) {
+        unsigned             capacity;
+        struct pbjson_token* tokens;
+
+        rslt = pbjson_tape_build(&p->reply_tape, reply, reply + len);
+        if (rslt != jtrNoRoom) {
+            break;
+        }
+        /* There can't be more tokens than characters */
+        capacity = p->reply_tape.capacity * 2;
+        if (capacity > len) {
+            capacity = (unsigned)len + 1;
+        }
+        tokens = (struct pbjson_token*)realloc(p->reply_tape.tokens,
+                                               capacity * sizeof *tokens);
+        if (NULL == tokens) {
+            PUBNUB_LOG_WARNING("pbcc=%p: failed to reallocate JSON tape to %u tokens\n",
+                               p,
+                               capacity);
+            return NULL;
+        }
+        p->reply_tape.tokens   = tokens;
+        p->reply_tape.capacity = capacity;
+    }
+    if (rslt != jtrOK) {
+        PUBNUB_LOG_TRACE("pbcc=%p: no JSON tape for the reply: %d\n", p, rslt);
+        return NULL;
+    }
+    p->reply_tape_valid = true;
+
+    return &p->reply_tape;
+}
+#endif /* PUBNUB_USE_JSON_TAPE */
+
+
+enum pbjson_object_name_parse_result
+pbcc_get_object_value(struct pbcc_context*      p,
+                      struct pbjson_elem const* obj,
+                      char const*               name,
+                      struct pbjson_elem*       parsed)
+{
+#if PUBNUB_USE_JSON_TAPE
+    struct pbjson_tape const* tape;
+
+    PUBNUB_ASSERT_OPT(obj != NULL);
+    PUBNUB_ASSERT_OPT(name != NULL);
+
+    tape = ('\0' != *name) ? pbcc_reply_tape(p) : NULL;
+    if (tape != NULL) {
+        char const* s = pbjson_skip_whitespace(obj->start, obj->end);
+        unsigned    i = (s < obj->end) ? pbjson_tape_find(tape, s) : PBJSON_TAPE_NONE;
+
+        /* Only if the object is all in the element - otherwise, let
+           pbjson_get_object_value() report the error. */
+        if ((i != PBJSON_TAPE_NONE) && ('{' == *s)
+            && (tape->json + tape->tokens[i].end <= obj->end)) {
+            unsigned value;
+            if (tape->tokens[i].next == i + 1) {
+                /* pbjson_get_object_value() says so for `{}` */
+                return jonmpKeyNotString;
+            }
+            value = pbjson_tape_object_get(tape, i, name);
+            if (PBJSON_TAPE_NONE == value) {
+                return jonmpKeyNotFound;
+            }
+            pbjson_tape_elem(tape, value, parsed);
+            return jonmpOK;
+        }
+    }
+#else
+    PUBNUB_UNUSED(p);
+#endif /* PUBNUB_USE_JSON_TAPE */
+
+    return pbjson_get_object_value(obj, name, parsed);
+}
+
+
+char const* pbcc_find_end_element(struct pbcc_context* p, char const* start, char const* end)
+{
+#if PUBNUB_USE_JSON_TAPE
+    /* A primitive is cheap to scan, and its end at the end of the
+       input is reported differently, so leave it be */
+    if ((start < end) && (('{' == *start) || ('[' == *start) || ('"' == *start))) {
+        struct pbjson_tape const* tape = pbcc_reply_tape(p);
+        if (tape != NULL) {
+            unsigned const i = pbjson_tape_find(tape, start);
+            if ((i != PBJSON_TAPE_NONE) && (tape->json + tape->tokens[i].end <= end)) {
+                return tape->json + tape->tokens[i].end - 1;
+            }
+        }
+    }
+#else
+    PUBNUB_UNUSED(p);
+#endif /* PUBNUB_USE_JSON_TAPE */
+
+    return pbjson_find_end_element(start, end);
 }
 
 
 int pbcc_realloc_reply_buffer(struct pbcc_context* p, unsigned bytes)
 {
-#if PUBNUB_DYNAMIC_REPLY_BUFFER
+#if PUBNUB_USE_REPLY_BUFFER_POOL
+    /* When growing for the next chunk, keep what we already got */
+    size_t keep = (p->http_buf_len < bytes) ? p->http_buf_len : bytes;
+    return pbcc_reply_buffer_reserve(&p->http_reply, &p->http_reply_cap, bytes + 1, keep);
+#elif PUBNUB_DYNAMIC_REPLY_BUFFER
     char* newbuf = (char*)realloc(p->http_reply, bytes + 1);
     if (NULL == newbuf) {
         return -1;
@@ -74,7 +247,12 @@ int pbcc_realloc_reply_buffer(struct pbcc_context* p, unsigned bytes)
 
 bool pbcc_ensure_reply_buffer(struct pbcc_context* p)
 {
-#if PUBNUB_DYNAMIC_REPLY_BUFFER
+#if PUBNUB_USE_REPLY_BUFFER_POOL
+    /* Need just one byte for string end */
+    if (0 != pbcc_reply_buffer_reserve(&p->http_reply, &p->http_reply_cap, 1, 0)) {
+        return false;
+    }
+#elif PUBNUB_DYNAMIC_REPLY_BUFFER
     if (NULL == p->http_reply) {
         /* Need just one byte for string end */
         p->http_reply = (char*)malloc(1);
@@ -155,45 +333,82 @@ static int find_string_start(char const* buf, int len)
 }
 
 
+/** The state of splitting an array */
+struct split_scan {
+    bool escaped;
+    bool in_string;
+    int  bracket_level;
+};
+
+
+/** Handles the character at @p s of the array being split, updating
+    the state @p scan. Splits (puts a NUL at @p s) if it's a comma at
+    the root.
+ */
+static void split_char(char* s, struct split_scan* scan)
+{
+    if (scan->escaped) {
+        scan->escaped = false;
+    }
+    else if ('"' == *s) {
+        scan->in_string = !scan->in_string;
+    }
+    else if (scan->in_string) {
+        scan->escaped = ('\\' == *s);
+    }
+    else {
+        switch (*s) {
+        case '[':
+        case '{':
+            scan->bracket_level++;
+            break;
+        case ']':
+        case '}':
+            scan->bracket_level--;
+            break;
+            /* if at root, split! */
+        case ',':
+            if (scan->bracket_level == 0) {
+                *s = '\0';
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+
 bool pbcc_split_array(char* buf)
 {
-    bool escaped       = false;
-    bool in_string     = false;
-    int  bracket_level = 0;
+    struct split_scan scan = { false, false, 0 };
 
-    for (; *buf != '\0'; ++buf) {
-        if (escaped) {
-            escaped = false;
-        }
-        else if ('"' == *buf) {
-            in_string = !in_string;
-        }
-        else if (in_string) {
-            escaped = ('\\' == *buf);
-        }
-        else {
-            switch (*buf) {
-            case '[':
-            case '{':
-                bracket_level++;
-                break;
-            case ']':
-            case '}':
-                bracket_level--;
-                break;
-                /* if at root, split! */
-            case ',':
-                if (bracket_level == 0) {
-                    *buf = '\0';
-                }
-                break;
-            default:
-                break;
-            }
+#if PUBNUB_JSON_USE_SIMD
+    /* As we put NULs in, we need to know where the end is up front */
+    char* const              end   = buf + strlen(buf);
+    struct pbjson_scan_state state = { false, false };
+
+    for (; end - buf >= PBJSON_BLOCK_SIZE; buf += PBJSON_BLOCK_SIZE) {
+        struct pbjson_block found;
+        uint64_t            mask;
+
+        pbjson_scan_block(buf, &state, &found);
+        for (mask = found.brackets | found.commas; mask != 0; mask &= mask - 1) {
+            split_char(buf + __builtin_ctzll(mask), &scan);
         }
     }
+    scan.in_string = state.in_string;
+    scan.escaped   = state.in_escape;
+    for (; buf < end; ++buf) {
+        split_char(buf, &scan);
+    }
+#else
+    for (; *buf != '\0'; ++buf) {
+        split_char(buf, &scan);
+    }
+#endif
 
-    return !(escaped || in_string || (bracket_level > 0));
+    return !(scan.escaped || scan.in_string || (scan.bracket_level > 0));
 }
 
 
@@ -230,6 +445,34 @@ enum pubnub_res pbcc_parse_publish_response(struct pbcc_context* p)
 }
 
 
+int pbcc_publish_timetoken(struct pbcc_context const* p, char* timetoken, size_t n)
+{
+    /* The response was split: "1", the description, the time token */
+    char const* s   = p->http_reply + 1;
+    char const* end = p->http_reply + p->http_buf_len - 1;
+    size_t      len;
+    int         i;
+
+    PUBNUB_ASSERT_OPT(n > 0);
+    timetoken[0] = '\0';
+    for (i = 0; (i < 2) && (s < end); ++i) {
+        s += strlen(s) + 1;
+    }
+    if ((s >= end) || (*s != '"')) {
+        return -1;
+    }
+    ++s;
+    len = strcspn(s, "\"");
+    if ((len >= n) || ('"' != s[len])) {
+        return -1;
+    }
+    memcpy(timetoken, s, len);
+    timetoken[len] = '\0';
+
+    return 0;
+}
+
+
 enum pubnub_res pbcc_parse_subscribe_response(struct pbcc_context* p)
 {
     int      i;
@@ -347,9 +590,9 @@ enum pubnub_res pbcc_append_url_param(struct pbcc_context* pb,
 }
 
 
-void pbcc_via_post_headers(struct pbcc_context* pb,
-                           char*                header,
-                           size_t               max_length)
+size_t pbcc_via_post_headers(struct pbcc_context* pb,
+                             char*                header,
+                             size_t               max_length)
 {
     char     lines[] = "Content-Type: application/json\r\nContent-Length: ";
     unsigned length;
@@ -366,8 +609,8 @@ void pbcc_via_post_headers(struct pbcc_context* pb,
         char h_encoding[] = "Content-Encoding: gzip";
         length = snprintf(header, max_length, "%lu\r\n", (unsigned long)pb->gzip_msg_len);
         PUBNUB_ASSERT_OPT(max_length > length + sizeof h_encoding - 1);
-        memcpy(header + length, h_encoding, sizeof h_encoding - 1);
-        return;
+        memcpy(header + length, h_encoding, sizeof h_encoding);
+        return sizeof lines - 1 + length + sizeof h_encoding - 1;
     }
 #endif
     length = snprintf(header,
@@ -375,6 +618,8 @@ void pbcc_via_post_headers(struct pbcc_context* pb,
                       "%lu",
                       (unsigned long)pb_strnlen_s(pb->message_to_send, PUBNUB_MAX_OBJECT_LENGTH));
     PUBNUB_ASSERT_OPT(max_length > length);
+
+    return sizeof lines - 1 + length;
 }
 
 
@@ -395,6 +640,28 @@ enum pubnub_res pbcc_url_encode(struct pbcc_context* pb, char const* what)
 }
 
 
+enum pubnub_res pbcc_url_encode_channel(struct pbcc_context* pb, char const* channel)
+{
+#if PUBNUB_USE_URL_ENCODE_CACHE
+    int url_encoded_length;
+
+    url_encoded_length = pubnub_url_encode_cached(&pb->channel_enc_cache,
+                                                  pb->http_buf + pb->http_buf_len,
+                                                  channel,
+                                                  sizeof pb->http_buf - pb->http_buf_len);
+    if (url_encoded_length < 0) {
+        pb->http_buf_len = 0;
+        return PNR_TX_BUFF_TOO_SMALL;
+    }
+    pb->http_buf_len += url_encoded_length;
+
+    return PNR_OK;
+#else
+    return pbcc_url_encode(pb, channel);
+#endif
+}
+
+
 enum pubnub_res pbcc_append_url_param_encoded(struct pbcc_context* pb,
                                               char const*          param_name,
                                               size_t      param_name_len,
@@ -433,7 +700,7 @@ enum pubnub_res pbcc_publish_prep(struct pbcc_context* pb,
                                 "/publish/%s/%s/0/",
                                 pb->publish_key,
                                 pb->subscribe_key);
-    APPEND_URL_ENCODED_M(pb, channel);
+    APPEND_URL_ENCODED_CHANNEL_M(pb, channel);
     APPEND_URL_LITERAL_M(pb, "/0");
     if (pubnubSendViaGET == method) {
         pb->http_buf[pb->http_buf_len++] = '/';
@@ -482,7 +749,7 @@ enum pubnub_res pbcc_signal_prep(struct pbcc_context* pb,
                                 "/signal/%s/%s/0/",
                                 pb->publish_key,
                                 pb->subscribe_key);
-    APPEND_URL_ENCODED_M(pb, channel);
+    APPEND_URL_ENCODED_CHANNEL_M(pb, channel);
     APPEND_URL_LITERAL_M(pb, "/0/");
     APPEND_URL_ENCODED_M(pb, message);
 
@@ -516,7 +783,7 @@ enum pubnub_res pbcc_subscribe_prep(struct pbcc_context* p,
 
     p->http_buf_len = snprintf(
         p->http_buf, sizeof p->http_buf, "/subscribe/%s/", p->subscribe_key);
-    APPEND_URL_ENCODED_M(p, channel);
+    APPEND_URL_ENCODED_CHANNEL_M(p, channel);
     p->http_buf_len += snprintf(p->http_buf + p->http_buf_len,
                                 sizeof p->http_buf - p->http_buf_len,
                                 "/0/%s?pnsdk=%s",
@@ -5,11 +5,19 @@
 #include "pubnub_config.h"
 #include "pubnub_api_types.h"
 #include "pubnub_generate_uuid.h"
+#include "pubnub_json_parse.h"
+#if PUBNUB_USE_URL_ENCODE_CACHE
+#include "pubnub_url_encode.h"
+#endif
 
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+struct pbgzip_inflate;
+#endif
+
 
 /** @file pubnub_ccore_pubsub.h
 
@@ -64,13 +72,21 @@ struct pbcc_context {
     
     /** The length of compressed data in 'comp_http_buf' ready to be sent */
     size_t gzip_msg_len;
+
+    /** Compression level of messages, 0 - 10 */
+    int gzip_level;
+
+    /** Maximum dictionary probes per match search, negative: as
+        #gzip_level says */
+    int gzip_max_probes;
 #endif
 
 #if PUBNUB_RECEIVE_GZIP_RESPONSE
-    /** The length of the decompressed data currently in the decompressing
-     * buffer ("scratch").
+    /** The state of inflating a gzip-formatted reply, as it is
+        received, right to the reply buffer. Allocated when first
+        needed.
      */
-    size_t decomp_buf_size;
+    struct pbgzip_inflate* gzip_inflate;
 #endif
     /** The total length of data to be received in a HTTP reply or
         chunk of it.
@@ -79,17 +95,13 @@ struct pbcc_context {
 
 #if PUBNUB_DYNAMIC_REPLY_BUFFER
     char* http_reply;
-#if PUBNUB_RECEIVE_GZIP_RESPONSE
-    char* decomp_http_reply;
-#endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
+#if PUBNUB_USE_REPLY_BUFFER_POOL
+    /** Capacity of the (pooled) reply buffer */
+    size_t http_reply_cap;
+#endif /* PUBNUB_USE_REPLY_BUFFER_POOL */
 #else
     /** The contents of a HTTP reply/reponse */
     char http_reply[PUBNUB_REPLY_MAXLEN + 1];
-#if PUBNUB_RECEIVE_GZIP_RESPONSE
-    /** Auxiliary buffer for unpacking(decompresing) data from HTTP reply buffer
-     */
-    char decomp_http_reply[PUBNUB_REPLY_MAXLEN + 1];
-#endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
 #endif /* PUBNUB_DYNAMIC_REPLY_BUFFER */
 
     /* These in-string offsets are used for yielding messages received
@@ -104,6 +116,26 @@ struct pbcc_context {
     */
     unsigned chan_ofs, chan_end;
 
+#if PUBNUB_USE_JSON_TAPE
+    /** The JSON tape of the reply, built when first needed, for all
+        the lookups in the reply. Its tokens are kept (allocated)
+        between transactions, up to #PUBNUB_JSON_TAPE_RETAIN_MAX. */
+    struct pbjson_tape reply_tape;
+    /** The length of the reply the #reply_tape was built for */
+    size_t reply_tape_len;
+    /** Whether building of the #reply_tape was tried for the current
+        reply */
+    bool reply_tape_tried;
+    /** Whether the #reply_tape is built (OK) for the current reply */
+    bool reply_tape_valid;
+#endif
+
+#if PUBNUB_USE_URL_ENCODE_CACHE
+    /** The url-encoding of the last channel (list), which is usually
+        the same in the next transaction (of the same type) */
+    struct pubnub_url_encode_cache channel_enc_cache;
+#endif
+
 #if PUBNUB_CRYPTO_API
     /** Secret key to use for encryption/decryption */
     char const* secret_key;
@@ -145,6 +177,16 @@ struct pbcc_context {
         }                                                                      \
     }
 
+/** Like APPEND_URL_ENCODED_M(), but for the channel (list), the
+    encoding of which may be cached. */
+#define APPEND_URL_ENCODED_CHANNEL_M(pbc, channel)                             \
+    if ((channel) != NULL) {                                                   \
+        enum pubnub_res rslt_ = pbcc_url_encode_channel((pbc), (channel));     \
+        if (rslt_ != PNR_OK) {                                                 \
+            return rslt_;                                                      \
+        }                                                                      \
+    }
+
 #define APPEND_URL_PARAM_ENCODED_M(pbc, name, var, separator)                  \
     if ((var) != NULL) {                                                       \
         const char      param_[] = name;                                       \
@@ -251,6 +293,37 @@ int pbcc_realloc_reply_buffer(struct pbcc_context* p, unsigned bytes);
 */
 bool pbcc_ensure_reply_buffer(struct pbcc_context* p);
 
+/** Forgets the JSON tape of the reply in the C core context @p p,
+    freeing its tokens if there are more than
+    #PUBNUB_JSON_TAPE_RETAIN_MAX of them. Has to be called when a new
+    reply is received (before it is parsed).
+ */
+void pbcc_invalidate_reply_tape(struct pbcc_context* p);
+
+#if PUBNUB_USE_JSON_TAPE
+/** Returns the JSON tape of the (whole) reply in the C core context
+    @p p, building it if it's not built yet. NULL if the reply is not
+    a valid JSON, or there is no memory for the tape.
+ */
+struct pbjson_tape const* pbcc_reply_tape(struct pbcc_context* p);
+#endif
+
+/** Like pbjson_get_object_value(), but for an object @p obj in the
+    reply in the C core context @p p, which is looked up through the
+    JSON tape of the reply (if available), rather than scanned.
+ */
+enum pbjson_object_name_parse_result
+pbcc_get_object_value(struct pbcc_context*      p,
+                      struct pbjson_elem const* obj,
+                      char const*               name,
+                      struct pbjson_elem*       parsed);
+
+/** Like pbjson_find_end_element(), but for an element in the reply in
+    the C core context @p p, whose end is looked up on the JSON tape
+    of the reply (if available), rather than scanned for.
+ */
+char const* pbcc_find_end_element(struct pbcc_context* p, char const* start, char const* end);
+
 /** Returns the next message from the Pubnub C Core context. NULL if
     there are no (more) messages
 */
@@ -295,12 +368,22 @@ enum pubnub_res pbcc_parse_subscribe_response(struct pbcc_context* p);
 */
 enum pubnub_res pbcc_parse_publish_response(struct pbcc_context* p);
 
+/** Copies the time token from the (successfully parsed) response to
+    a publish transaction in the C core context @p p to @p timetoken,
+    which has room for @p n characters, including the terminating NUL.
+    @retval 0 OK
+    @retval -1 time token not found in the response, or too long
+*/
+int pbcc_publish_timetoken(struct pbcc_context const* p, char* timetoken, size_t n);
+
 /** Prepares HTTP header lines specific for sending message 'via POST' method.
     @param p The Pubnub C core context with all necessary information
     @param header pointer to char array provided for placing these headers
     @param max_length maximum size of array provided
+    @return The length of the headers placed in @p header, which are
+    always NUL-terminated
  */
-void pbcc_via_post_headers(struct pbcc_context* p, char* header, size_t max_length);
+size_t pbcc_via_post_headers(struct pbcc_context* p, char* header, size_t max_length);
 
 /** Prepares the Publish operation (transaction), mostly by
     formatting the URI of the HTTP request.
@@ -343,6 +426,12 @@ enum pubnub_res pbcc_append_url_param(struct pbcc_context* pb,
 
 enum pubnub_res pbcc_url_encode(struct pbcc_context* pb, char const* what);
 
+/** Like pbcc_url_encode(), but for the channel (list) @p channel.
+    With #PUBNUB_USE_URL_ENCODE_CACHE, if it's the same as the last
+    one, its encoding is not done again.
+ */
+enum pubnub_res pbcc_url_encode_channel(struct pbcc_context* pb, char const* channel);
+
 enum pubnub_res pbcc_append_url_param_encoded(struct pbcc_context* pb,
                                               char const*          param_name,
                                               size_t      param_name_len,
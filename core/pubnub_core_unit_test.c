@@ -5,6 +5,7 @@
 #include "pubnub_internal.h"
 #include "pubnub_pubsubapi.h"
 #include "pubnub_coreapi.h"
+#include "pubnub_coreapi_ex.h"
 #if PUBNUB_USE_ADVANCED_HISTORY
 #include "pubnub_memory_block.h"
 #include "pubnub_advanced_history.h"
@@ -19,6 +20,8 @@
 #include "test/pubnub_test_helper.h"
 
 #include "pubnub_json_parse.h"
+#include "pubnub_url_encode.h"
+#include "lib/pbcrc32.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -751,6 +754,325 @@ Ensure(/*pbjson_parse, */ gibberish_json)
 }
 
 
+/* Long enough to be scanned a block at a time (if that is done), with
+   the escapes, the quotes and the brackets in strings moving over the
+   block boundaries as the padding grows.
+ */
+Ensure(/*pbjson_parse, */ find_end_long_json)
+{
+    static char const tail[] = "\\\"}]\\\\\",\"a\":[{\"b\":\"]}\\\\\"},2],\"c\":1}";
+    char              json[200];
+    unsigned          pad;
+
+    for (pad = 0; pad < 140; ++pad) {
+        char const* value;
+        char const* end;
+
+        strcpy(json, "{\"k\":\"");
+        memset(json + 6, 'x', pad);
+        strcpy(json + 6 + pad, tail);
+        value = json + 6;
+        end   = json + strlen(json);
+
+        attest(pbjson_find_end_string(value, end), equals(value + pad + 6));
+        attest(pbjson_find_end_string(value, value + pad + 5), equals(value + pad + 5));
+        attest(pbjson_find_end_complex(json, end), equals(end - 1));
+        attest(pbjson_find_end_complex(json, end - 1), equals(end - 1));
+    }
+}
+
+
+Ensure(/*pbjson_parse, */ split_long_array)
+{
+    char     buf[200];
+    unsigned pad;
+
+    for (pad = 0; pad < 140; ++pad) {
+        char const* s;
+
+        strcpy(buf, "1,\"a,\\\",");
+        memset(buf + 8, 'x', pad);
+        strcpy(buf + 8 + pad, "\\\\\",[2,{\"c\":\",\"}],3");
+        attest(pbcc_split_array(buf), is_true);
+
+        s = buf;
+        attest(s, streqs("1"));
+        s += strlen(s) + 1;
+        attest(strlen(s), equals(pad + 9));
+        s += strlen(s) + 1;
+        attest(s, streqs("[2,{\"c\":\",\"}]"));
+        s += strlen(s) + 1;
+        attest(s, streqs("3"));
+    }
+}
+
+
+Ensure(/*pbjson_parse, */ json_tape)
+{
+    static char const json[] =
+        " {\"a\":[1, {\"x\":\"}\"}, []], \"b\" : {}, \"c\":\"s\\\"\", \"a\":2} tail";
+    static char const   num[] = "42";
+    struct pbjson_token tokens[16];
+    struct pbjson_tape  tape;
+    struct pbjson_elem  elem;
+    unsigned            i;
+
+    pbjson_tape_init(&tape, tokens, 16);
+    attest(pbjson_tape_build(&tape, json, json + sizeof json - 1), equals(jtrOK));
+    attest(tape.count, equals(14));
+    attest(tape.tokens[0].start, equals(1));
+    attest(tape.tokens[0].end, equals(strlen(json) - 5));
+    attest(tape.tokens[0].next, equals(14));
+
+    i = pbjson_tape_object_get(&tape, 0, "a");
+    attest(i, equals(2));
+    pbjson_tape_elem(&tape, i, &elem);
+    attest(pbjson_elem_equals_string(&elem, "[1, {\"x\":\"}\"}, []]"), is_true);
+    attest(pbjson_tape_array_get(&tape, i, 0), equals(3));
+    attest(pbjson_tape_array_get(&tape, i, 1), equals(4));
+    attest(pbjson_tape_array_get(&tape, i, 2), equals(7));
+    attest(pbjson_tape_array_get(&tape, i, 3), equals(PBJSON_TAPE_NONE));
+    attest(pbjson_tape_first_child(&tape, 7), equals(PBJSON_TAPE_NONE));
+    attest(pbjson_tape_next_sibling(&tape, i, 4), equals(7));
+    attest(pbjson_tape_next_sibling(&tape, i, 7), equals(PBJSON_TAPE_NONE));
+
+    i = pbjson_tape_object_get(&tape, 4, "x");
+    pbjson_tape_elem(&tape, i, &elem);
+    attest(pbjson_elem_equals_string(&elem, "\"}\""), is_true);
+
+    i = pbjson_tape_object_get(&tape, 0, "b");
+    pbjson_tape_elem(&tape, i, &elem);
+    attest(pbjson_elem_equals_string(&elem, "{}"), is_true);
+    attest(pbjson_tape_first_child(&tape, i), equals(PBJSON_TAPE_NONE));
+
+    i = pbjson_tape_object_get(&tape, 0, "c");
+    pbjson_tape_elem(&tape, i, &elem);
+    attest(pbjson_elem_equals_string(&elem, "\"s\\\"\""), is_true);
+
+    attest(pbjson_tape_object_get(&tape, 0, "d"), equals(PBJSON_TAPE_NONE));
+    attest(pbjson_tape_object_get(&tape, 2, "a"), equals(PBJSON_TAPE_NONE));
+    attest(pbjson_tape_find(&tape, strchr(json, '[')), equals(2));
+    attest(pbjson_tape_find(&tape, strchr(json, '[') + 1), equals(3));
+    attest(pbjson_tape_find(&tape, json), equals(PBJSON_TAPE_NONE));
+    attest(pbjson_tape_find(&tape, strchr(json, ':')), equals(PBJSON_TAPE_NONE));
+
+    attest(pbjson_tape_build(&tape, num, num + 2), equals(jtrOK));
+    attest(tape.count, equals(1));
+    attest(tape.tokens[0].end, equals(2));
+
+    pbjson_tape_init(&tape, tokens, 5);
+    attest(pbjson_tape_build(&tape, json, json + sizeof json - 1), equals(jtrNoRoom));
+}
+
+
+Ensure(/*pbjson_parse, */ json_tape_rejects_invalid)
+{
+    static char const* const invalid[] = {
+        "{\"a\" 1}", "{\"a\":1,}", "[1,]", "[1 2]", "{1:2}", "[}", "{\"a\":1]",
+        "{\"a\":}", ",", "]", "[\"a\0\"]", "[tre[]"
+    };
+    static char const* const incomplete[] = { "", " ", "{", "[1,", "{\"a\":[1]", "\"abc", "[1" };
+    struct pbjson_token tokens[16];
+    struct pbjson_tape  tape;
+    unsigned            i;
+
+    pbjson_tape_init(&tape, tokens, 16);
+    for (i = 0; i < sizeof invalid / sizeof invalid[0]; ++i) {
+        char const* s = invalid[i];
+        attest(pbjson_tape_build(&tape, s, s + strlen(s) + 1), equals(jtrInvalid));
+    }
+    for (i = 0; i < sizeof incomplete / sizeof incomplete[0]; ++i) {
+        char const* s = incomplete[i];
+        attest(pbjson_tape_build(&tape, s, s + strlen(s)), equals(jtrIncomplete));
+    }
+}
+
+
+Ensure(/*pbjson_parse, */ json_path)
+{
+    static char const json[] =
+        " {\"data\": {\"items\": [1, {\"price\": 9.5}, [true, \"x\"], {\"price\": -12}]},"
+        " \"a\\\"b\": 1, \"n\":null}";
+    struct pbjson_elem el = { json, json + sizeof json - 1 };
+    struct pbjson_elem found;
+
+    attest(pbjson_path(&el, "data.items[1].price", &found), equals(jonmpOK));
+    attest(pbjson_elem_equals_string(&found, "9.5"), is_true);
+    attest(pbjson_path(&el, "data.items[3].price", &found), equals(jonmpOK));
+    attest(pbjson_elem_equals_string(&found, "-12"), is_true);
+    attest(pbjson_path(&el, "data.items[2][1]", &found), equals(jonmpOK));
+    attest(pbjson_elem_equals_string(&found, "\"x\""), is_true);
+    attest(pbjson_path(&el, "data.items[0]", &found), equals(jonmpOK));
+    attest(pbjson_elem_equals_string(&found, "1"), is_true);
+    attest(pbjson_path(&el, "a\\\"b", &found), equals(jonmpOK));
+    attest(pbjson_elem_equals_string(&found, "1"), is_true);
+    attest(pbjson_path(&el, "", &found), equals(jonmpOK));
+    attest(found.start, equals(json + 1));
+    attest(found.end, equals(json + sizeof json - 1));
+
+    attest(pbjson_path(&el, "data.items[4]", &found), equals(jonmpKeyNotFound));
+    attest(pbjson_path(&el, "data.item", &found), equals(jonmpKeyNotFound));
+    attest(pbjson_path(&el, "data.items.price", &found), equals(jonmpNoStartCurly));
+    attest(pbjson_path(&el, "data[0]", &found), equals(jonmpNoStartCurly));
+    attest(pbjson_path(&el, "n.x", &found), equals(jonmpNoStartCurly));
+    attest(pbjson_path(&el, "data..items", &found), equals(jonmpInvalidKeyName));
+    attest(pbjson_path(&el, ".data", &found), equals(jonmpInvalidKeyName));
+    attest(pbjson_path(&el, "data.items[x]", &found), equals(jonmpInvalidKeyName));
+    attest(pbjson_path(&el, "data.items[1", &found), equals(jonmpInvalidKeyName));
+    attest(pbjson_path(&el, "data.items[1]price", &found), equals(jonmpInvalidKeyName));
+
+    el.end = json + 20;
+    attest(pbjson_path(&el, "data", &found), equals(jonmpValueIncomplete));
+}
+
+
+Ensure(/*pbjson_parse, */ json_typed_values)
+{
+    static char const json[] = "[-12.5e1, 42, true, false, \"a\\\"\\\\\\/\\n\\u00e9\\ud83d\\ude00\", null,"
+                               " \"\\ud83d\", \"\\q\", 99999999999999999999]";
+    struct pbjson_elem el = { json, json + sizeof json - 1 };
+    struct pbjson_elem found;
+    double             d;
+    long               l;
+    bool               b;
+    char               s[32];
+
+    pbjson_path(&el, "[0]", &found);
+    attest(pbjson_get_double(&found, &d), equals(0));
+    attest(d == -125.0, is_true);
+    attest(pbjson_get_long(&found, &l), equals(-1));
+    pbjson_path(&el, "[1]", &found);
+    attest(pbjson_get_long(&found, &l), equals(0));
+    attest(l, equals(42));
+    attest(pbjson_get_bool(&found, &b), equals(-1));
+    attest(pbjson_get_string(&found, s, sizeof s), equals(-1));
+    pbjson_path(&el, "[2]", &found);
+    attest(pbjson_get_bool(&found, &b), equals(0));
+    attest(b, is_true);
+    attest(pbjson_get_double(&found, &d), equals(-1));
+    pbjson_path(&el, "[3]", &found);
+    attest(pbjson_get_bool(&found, &b), equals(0));
+    attest(b, is_false);
+
+    pbjson_path(&el, "[4]", &found);
+    attest(pbjson_get_string(&found, s, sizeof s), equals(11));
+    attest(s, streqs("a\"\\/\n\xc3\xa9\xf0\x9f\x98\x80"));
+    /* Truncated, but not in the middle of an UTF-8 sequence */
+    attest(pbjson_get_string(&found, s, 7), equals(11));
+    attest(s, streqs("a\"\\/\n"));
+    attest(pbjson_get_string(&found, NULL, 0), equals(11));
+
+    pbjson_path(&el, "[5]", &found);
+    attest(pbjson_get_string(&found, s, sizeof s), equals(-1));
+    attest(pbjson_get_long(&found, &l), equals(-1));
+    pbjson_path(&el, "[6]", &found);
+    attest(pbjson_get_string(&found, s, sizeof s), equals(-1));
+    pbjson_path(&el, "[7]", &found);
+    attest(pbjson_get_string(&found, s, sizeof s), equals(-1));
+    pbjson_path(&el, "[8]", &found);
+    attest(pbjson_get_long(&found, &l), equals(-1));
+    attest(pbjson_get_double(&found, &d), equals(0));
+}
+
+
+Ensure(/*url_encode, */ url_encode_long)
+{
+    char     what[100];
+    char     buf[300];
+    unsigned pad;
+
+    /* The characters to encode move over the block boundaries */
+    for (pad = 0; pad < 40; ++pad) {
+        memset(what, 'a', pad);
+        strcpy(what + pad, " ~[\"x\xc3\xa9],0123456789abcdefghijklmnop/");
+        attest(pubnub_url_encode(buf, what, sizeof buf), equals(pad + 46));
+        attest(buf + pad, streqs("%20~[%22x%C3%A9],0123456789abcdefghijklmnop%2F"));
+    }
+    attest(pubnub_url_encode(buf, "abc", 4), equals(-1));
+    attest(pubnub_url_encode(buf, "abc", 5), equals(3));
+    attest(pubnub_url_encode(buf, "a b", 6), equals(-1));
+    attest(pubnub_url_encode(buf, "a b", 7), equals(5));
+    attest(pubnub_url_encode(buf, "ab ", 6), equals(5));
+}
+
+
+Ensure(/*url_encode, */ url_encode_cached)
+{
+    struct pubnub_url_encode_cache cache;
+    char                           what[] = "ch 1,ch 2";
+    char                           buf[40];
+
+    pubnub_url_encode_cache_init(&cache);
+    attest(pubnub_url_encode_cached(&cache, buf, what, sizeof buf), equals(13));
+    attest(buf, streqs("ch%201,ch%202"));
+    attest(cache.src, equals(what));
+    memset(buf, 0, sizeof buf);
+    attest(pubnub_url_encode_cached(&cache, buf, what, sizeof buf), equals(13));
+    attest(buf, streqs("ch%201,ch%202"));
+
+    /* Same pointer and length, but changed in place */
+    what[2] = '_';
+    attest(pubnub_url_encode_cached(&cache, buf, what, sizeof buf), equals(11));
+    attest(buf, streqs("ch_1,ch%202"));
+
+    /* Doesn't fit */
+    attest(pubnub_url_encode_cached(&cache, buf, what, 11), equals(-1));
+    attest(pubnub_url_encode_cached(&cache, buf, "other", sizeof buf), equals(5));
+    attest(buf, streqs("other"));
+    pubnub_url_encode_cache_free(&cache);
+    attest(cache.data, is_null);
+}
+
+
+/* The CRC32 one bit at a time, as it is defined */
+static uint32_t crc32_by_bits(uint8_t const* p, size_t n)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    while (n-- > 0) {
+        int k;
+        crc ^= *p++;
+        for (k = 0; k < 8; ++k) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+
+Ensure(/*crc32, */ crc32_known_values)
+{
+    attest(pbcrc32("123456789", 9), equals(0xCBF43926));
+    attest(pbcrc32("a", 1), equals(0xE8B7BE43));
+    attest(pbcrc32_update(0, NULL, 0), equals(0));
+    attest(pbcrc32_update(pbcrc32("12345", 5), "6789", 4), equals(0xCBF43926));
+}
+
+
+Ensure(/*crc32, */ crc32_lengths_and_offsets)
+{
+    static uint8_t data[600];
+    size_t         offset;
+    size_t         len;
+
+    for (len = 0; len < sizeof data; ++len) {
+        data[len] = (uint8_t)(len * 131 + (len >> 3));
+    }
+    /* Crossing the 8 byte (slicing) and 16/64 byte (folding) sizes,
+       at all alignments */
+    for (offset = 0; offset < 16; ++offset) {
+        for (len = 1; len <= 300; ++len) {
+            uint32_t const expected = crc32_by_bits(data + offset, len);
+            attest(pbcrc32(data + offset, len), equals(expected));
+            attest(pbcrc32_update(pbcrc32_update(0, data + offset, len / 3),
+                                  data + offset + len / 3,
+                                  len - len / 3),
+                   equals(expected));
+        }
+    }
+    attest(pbcrc32(data, sizeof data), equals(crc32_by_bits(data, sizeof data)));
+}
+
+
 Describe(single_context_pubnub);
 
 static pubnub_t* pbp;
@@ -1189,6 +1511,76 @@ Ensure(single_context_pubnub, publish)
     attest(pubnub_last_http_code(pbp), equals(200));
 }
 
+#if PUBNUB_USE_GZIP_COMPRESSION
+Ensure(single_context_pubnub, publish_gzip_post_after_get)
+{
+    char const msg[] = "[\"hello\",\"hello\",\"hello\",\"hello\",\"hello\",\"hello\","
+                       "\"hello\",\"hello\"]";
+    struct pubnub_publish_options opts;
+    char                          hedr[128];
+    size_t                        hlen;
+
+    pubnub_init(pbp, "publkey", "subkey");
+
+    expect_have_dns_for_pubnub_origin();
+    expect_outgoing_with_url(
+        "/publish/publkey/subkey/0/jarak/0/%22zec%22?pnsdk=unit-test-0.1");
+    incoming("HTTP/1.1 200\r\nContent-Length: "
+             "30\r\n\r\n[1,\"Sent\",\"14178940800777403\"]",
+             NULL);
+    expect(pbntf_lost_socket, when(pb, equals(pbp)));
+    expect(pbntf_trans_outcome, when(pb, equals(pbp)));
+    attest(pubnub_publish(pbp, "jarak", "\"zec\""), equals(PNR_OK));
+
+    /* The message compresses to 46 octets, and the headers end at
+       "gzip", whatever the previous request left in the buffers */
+    opts        = pubnub_publish_defopts();
+    opts.method = pubnubSendViaPOSTwithGZIP;
+    expect(pbntf_enqueue_for_processing, when(pb, equals(pbp)), returns(0));
+    expect(pbntf_got_socket, when(pb, equals(pbp)), returns(0));
+    expect(pbpal_send_str, when(s, streqs("POST ")), returns(0));
+    expect(pbpal_send_status, returns(0));
+    expect(pbpal_send_str,
+           when(s, streqs("/publish/publkey/subkey/0/jarak/0?pnsdk=unit-test-0.1")),
+           returns(0));
+    expect(pbpal_send_status, returns(0));
+    expect(pbpal_send, when(data, streqs(" HTTP/1.1\r\nHost: ")), returns(0));
+    expect(pbpal_send_status, returns(0));
+    expect(pbpal_send_str, when(s, streqs(PUBNUB_ORIGIN)), returns(0));
+    expect(pbpal_send_status, returns(0));
+    expect(pbpal_send_str,
+           when(s,
+                streqs("\r\nContent-Type: application/json\r\n"
+                       "Content-Length: 46\r\nContent-Encoding: gzip")),
+           returns(0));
+    expect(pbpal_send_status, returns(0));
+    expect(pbpal_send_str,
+           when(s,
+                streqs("\r\nUser-Agent: POSIX-PubNub-C-core/" PUBNUB_SDK_VERSION
+                       "\r\n" ACCEPT_ENCODING "\r\n")),
+           returns(0));
+    expect(pbpal_send_status, returns(0));
+    expect(pbpal_send, when(n, equals(46)), returns(0));
+    expect(pbpal_send_status, returns(0));
+    expect(pbntf_watch_in_events, when(pb, equals(pbp)), returns(0));
+    incoming("HTTP/1.1 200\r\nContent-Length: "
+             "30\r\n\r\n[1,\"Sent\",\"14178940800777404\"]",
+             NULL);
+    expect(pbntf_lost_socket, when(pb, equals(pbp)));
+    expect(pbntf_trans_outcome, when(pb, equals(pbp)));
+    attest(pubnub_publish_ex(pbp, "jarak", msg, opts), equals(PNR_OK));
+    attest(pubnub_last_publish_result(pbp), streqs("\"Sent\""));
+
+    /* Vectored send puts them into a buffer with the previous headers */
+    memset(hedr, 'x', sizeof hedr);
+    hlen = pbcc_via_post_headers(&pbp->core, hedr, sizeof hedr);
+    attest(hlen, equals(strlen(hedr)));
+    attest(hedr,
+           streqs("Content-Type: application/json\r\n"
+                  "Content-Length: 46\r\nContent-Encoding: gzip"));
+}
+#endif /* PUBNUB_USE_GZIP_COMPRESSION */
+
 Ensure(single_context_pubnub, publish_change_origin)
 {
     pubnub_init(pbp, "publkey", "subkey");
@@ -4922,6 +5314,78 @@ Ensure(single_context_pubnub, gzip_bad_compression_format)
            equals(PNR_BAD_COMPRESSION_FORMAT));
 }
 
+Ensure(single_context_pubnub, gzip_response_bigger_than_quarter_of_reply_buffer)
+{
+    /* Compressed, it is more than a quarter of PUBNUB_REPLY_MAXLEN,
+       but inflated, it still fits
+    */
+    uint8_t gzip_body[] = {
+        0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x15,
+        0x51, 0xc9, 0x8d, 0x20, 0x41, 0x08, 0xcb, 0xa5, 0xdf, 0xf3, 0xe0,
+        0x3e, 0x62, 0x19, 0xcd, 0x03, 0xaa, 0x20, 0xff, 0x10, 0xb6, 0x16,
+        0x09, 0x09, 0x64, 0x84, 0xb1, 0xf9, 0xfd, 0xfd, 0x4a, 0x0e, 0x12,
+        0x37, 0x1a, 0xd2, 0xbd, 0xe4, 0x74, 0x91, 0x1d, 0x0f, 0x3a, 0x4a,
+        0x5e, 0xe1, 0x54, 0xb6, 0x66, 0x42, 0xdb, 0x5b, 0x33, 0x9d, 0xae,
+        0x4e, 0xb9, 0x35, 0x49, 0x7c, 0xb5, 0x64, 0x2f, 0x52, 0x55, 0xef,
+        0x10, 0xc5, 0x12, 0xe6, 0xe4, 0x69, 0x98, 0x56, 0x5e, 0xb4, 0x14,
+        0x3f, 0x67, 0x49, 0xe7, 0x84, 0xdc, 0xb8, 0x7d, 0x5c, 0x48, 0xc5,
+        0x1d, 0x56, 0x23, 0x41, 0xbe, 0x9f, 0xef, 0x76, 0x09, 0xce, 0x79,
+        0xc1, 0x7b, 0xd0, 0xc8, 0x46, 0xb9, 0x90, 0x41, 0xb8, 0x81, 0xec,
+        0x48, 0x74, 0x2f, 0xf3, 0xce, 0x6e, 0x92, 0x70, 0xc5, 0x2a, 0x58,
+        0x0b, 0x24, 0x45, 0x6b, 0x7b, 0xb9, 0xf9, 0x71, 0xdb, 0x06, 0x88,
+        0x0d, 0xeb, 0xe9, 0x26, 0x67, 0x5f, 0x2b, 0x5b, 0xd8, 0x26, 0x3e,
+        0xb6, 0x7a, 0x8b, 0xce, 0x1c, 0x52, 0x15, 0x90, 0x91, 0x6d, 0x11,
+        0x00, 0x7e, 0xd4, 0x72, 0xcd, 0x20, 0x2c, 0xbd, 0xe2, 0x0a, 0xf6,
+        0xdc, 0x07, 0x8c, 0x82, 0xa8, 0x2c, 0x63, 0xbd, 0x74, 0x0b, 0xe4,
+        0x01, 0x9a, 0xb2, 0x98, 0xf5, 0xb0, 0x91, 0xcb, 0x67, 0x8a, 0xfc,
+        0x92, 0x25, 0x4b, 0x4b, 0xc8, 0x38, 0x9f, 0x55, 0xd7, 0x7b, 0xea,
+        0x5a, 0x17, 0x35, 0x3c, 0x8f, 0xe0, 0xd4, 0x33, 0xc7, 0x99, 0x22,
+        0x50, 0xff, 0x2b, 0x3f, 0xb2, 0x45, 0xaf, 0xbe, 0x14, 0x40, 0x8f,
+        0x3a, 0x9e, 0xc9, 0xf1, 0x56, 0xd7, 0x0d, 0x41, 0x67, 0x7d, 0x90,
+        0x65, 0x5a, 0x8e, 0x46, 0x43, 0x20, 0x80, 0xad, 0x0f, 0xdf, 0x3d,
+        0x69, 0x5e, 0x26, 0xa7, 0x51, 0x80, 0xe2, 0x2a, 0xd2, 0x49, 0x4f,
+        0x1c, 0xd5, 0x18, 0x88, 0xae, 0x72, 0x4c, 0x6b, 0x85, 0x3a, 0xf4,
+        0xe4, 0xfb, 0x9b, 0xa1, 0xf7, 0xca, 0x03, 0x99, 0xfe, 0x8a, 0x5a,
+        0x49, 0xc1, 0x2b, 0xe0, 0x04, 0x28, 0xfd, 0x4e, 0xff, 0xfe, 0x7e,
+        0x3e, 0x54, 0xb4, 0xd7, 0xa6, 0x47, 0x92, 0x32, 0xb1, 0x38, 0x7d,
+        0x7f, 0xff, 0x00, 0xc6, 0x06, 0xec, 0x10, 0x05, 0x02, 0x00, 0x00
+    };
+    struct uint8_block body_block = { 319, gzip_body };
+
+    pubnub_init(pbp, "looking-glass", "looking-glass");
+    expect_have_dns_for_pubnub_origin();
+    expect_outgoing_with_url(
+        "/subscribe/looking-glass/island/0/0?pnsdk=unit-test-0.1");
+    incoming("HTTP/1.1 200\r\nContent-Length: "
+             "26\r\n\r\n[[],\"1516014978925323471\"]",
+             NULL);
+    expect(pbntf_lost_socket, when(pb, equals(pbp)));
+    expect(pbntf_trans_outcome, when(pb, equals(pbp)));
+    attest(pubnub_subscribe(pbp, "island", NULL), equals(PNR_OK));
+
+    attest(sizeof gzip_body > PUBNUB_REPLY_MAXLEN / 4, is_true);
+    expect(pbntf_enqueue_for_processing, when(pb, equals(pbp)), returns(0));
+    expect(pbntf_got_socket, when(pb, equals(pbp)), returns(0));
+    expect_outgoing_with_url("/subscribe/looking-glass/island/0/"
+                             "1516014978925323471?pnsdk=unit-test-0.1");
+    incoming("HTTP/1.1 200\r\n"
+             "Content-Length: 319\r\n"
+             "Content-Encoding: gzip\r\n"
+             "\r\n",
+             &body_block);
+    expect(pbntf_lost_socket, when(pb, equals(pbp)));
+    expect(pbntf_trans_outcome, when(pb, equals(pbp)));
+    attest(pubnub_subscribe(pbp, "island", NULL), equals(PNR_OK));
+    attest(pubnub_last_time_token(pbp), streqs("1516014978925323472"));
+
+    attest(pubnub_get(pbp), streqs("\"a4c123b1612dd272d1371c17149d439536b3216fdaeeb975729fae923d5a4fd12aabfe228f219e9cb0eb53f16947ccf25ec84d8dbc74254770f58904\""));
+    attest(pubnub_get(pbp), streqs("\"dba41ecccc3fc1626e53a13043b026c48bbf33feff9243a8f506b40928b5b7a767c76fb008f86bebb2737f6a6f0fb23c6f5da2cec255404e4fb44003\""));
+    attest(pubnub_get(pbp), streqs("\"4d6608697a8d41bed440e50454f31af3176813e02ea68ef786e4d3cea27d26934b484e73cf575dcad6ba2b0aee0ca923732881584d8c4fa2815d2802\""));
+    attest(pubnub_get(pbp), streqs("\"827283e0ad84173581569969e58b081006f7e3dfc967a64cb14028d512c9791e558e08baa7196b50ac2f86702824c1c099724caf4941d4072014b3ce\""));
+    attest(pubnub_get(pbp), equals(NULL));
+    attest(pubnub_last_http_code(pbp), equals(200));
+}
+
 /* Verify ASSERT gets fired */
 
 Ensure(single_context_pubnub, illegal_context_fires_assert)
@@ -0,0 +1,68 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_GZIP_COMPRESSION
+#define INC_PUBNUB_GZIP_COMPRESSION
+
+
+#include "pubnub_api_types.h"
+
+#include <stddef.h>
+
+
+/** @file pubnub_gzip_compression.h
+
+    API for setting the options of compressing (with gzip) the
+    messages published with #pubnubSendViaPOSTwithGZIP or
+    #pubnubUsePATCHwithGZIP.
+*/
+
+#if !PUBNUB_USE_GZIP_COMPRESSION
+#error This API is only supported if PUBNUB_USE_GZIP_COMPRESSION macro constant is 'true'
+#endif
+
+/** Counters of the (process-wide) compression decisions */
+struct pubnub_gzip_compress_stats {
+    /** Number of messages estimated */
+    unsigned long estimated;
+    /** Number of messages not compressed, because of the estimate */
+    unsigned long skipped;
+    /** Number of messages compressed, and sent compressed */
+    unsigned long packed;
+    /** Number of messages compressed, but not sent compressed,
+        because they didn't compress well enough */
+    unsigned long poor_ratio;
+};
+
+
+/** Sets the compression of messages (published with gzip) of the
+    context @p pb. Defaults are #PUBNUB_GZIP_COMPRESSION_LEVEL and
+    #PUBNUB_GZIP_MAX_PROBES.
+
+    @param pb The Pubnub context
+    @param level Compression level, 0 (none) - 10 (best)
+    @param max_probes Maximum number of dictionary probes per match
+    search, 0 - 4095, or negative to use what @p level says
+    @return 0: OK, -1: invalid parameters
+ */
+int pubnub_set_gzip_compression(pubnub_t* pb, int level, int max_probes);
+
+/** Frees all the compressors in the (process-wide) compressor pool,
+    which are otherwise kept (up to #PUBNUB_GZIP_COMPRESSOR_POOL_SIZE
+    of them) for reuse by all contexts. Thread-safe.
+ */
+void pubnub_gzip_compressor_pool_trim(void);
+
+/** Sets the (process-wide) compressibility estimate: the size of the
+    sample of a message to estimate on (0 to not estimate, but always
+    compress) and the minimal estimated savings, in percent, to
+    compress. Defaults are #PUBNUB_GZIP_ESTIMATE_SAMPLE_SIZE and
+    #PUBNUB_GZIP_ESTIMATE_MIN_SAVINGS. Thread-safe.
+ */
+void pubnub_gzip_set_estimate(size_t sample_size, unsigned min_savings);
+
+/** Gets the counters of the compression decisions to @p stats.
+    Thread-safe.
+ */
+void pubnub_gzip_compress_stats(struct pubnub_gzip_compress_stats* stats);
+
+
+#endif /* !defined INC_PUBNUB_GZIP_COMPRESSION */
@@ -10,6 +10,7 @@
 #if defined(PUBNUB_CALLBACK_API)
 #include "core/pubnub_ntf_callback.h"
 #include "core/pubnub_dns_servers.h"
+#include "core/pbpal_ntf_callback_queue.h"
 #endif
 
 #if !defined(PUBNUB_USE_IPV6)
@@ -51,6 +52,19 @@
 #define PUBNUB_USE_ACTIONS_API 0
 #endif
 
+#if !defined(PUBNUB_USE_PUBLISH_QUEUE)
+#define PUBNUB_USE_PUBLISH_QUEUE 0
+#elif PUBNUB_USE_PUBLISH_QUEUE
+#include "core/pubnub_publish_queue_core.h"
+#endif
+
+/* In C-core builds, the batch publish API is implemented with the
+   publish queue machinery, so it needs PUBNUB_USE_PUBLISH_QUEUE, too.
+ */
+#if !defined(PUBNUB_USE_PUBLISH_BATCH)
+#define PUBNUB_USE_PUBLISH_BATCH 0
+#endif
+
 #if !defined(PUBNUB_PROXY_API)
 #define PUBNUB_PROXY_API 0
 #elif PUBNUB_PROXY_API
@@ -81,10 +95,71 @@
 #if PUBNUB_ADVANCED_KEEP_ALIVE
 #include <time.h>
 #endif
+#if PUBNUB_TIMERS_API && !defined(PUBNUB_CALLBACK_API)
+#include "lib/msstopwatch/msstopwatch.h"
+#endif
 
 /* Maximum object length that will be sent via PATCH, or POST methods */
 #define PUBNUB_MAX_OBJECT_LENGTH 30000
 
+#if !defined PUBNUB_USE_VECTORED_SEND
+#define PUBNUB_USE_VECTORED_SEND 0
+#endif
+
+#if PUBNUB_USE_VECTORED_SEND
+/** A piece of data to send with pbpal_sendv() */
+struct pbpal_iovec {
+    void const* base;
+    size_t      len;
+};
+
+/** Maximum number of pieces to send with one pbpal_sendv(). We need:
+    method, URL path, HTTP version & "Host:", origin, the rest of the
+    headers and the body.
+ */
+#define PUBNUB_SENDV_MAX 6
+
+/** Maximum length of the HTTP headers (after "Host:") that we have
+    to "print" to a buffer for vectored sending of a request.
+ */
+#define PUBNUB_TX_HEADERS_MAXLEN 400
+#endif
+
+#if !defined PUBNUB_USE_ZERO_COPY_RECEIVE
+#define PUBNUB_USE_ZERO_COPY_RECEIVE 0
+#endif
+
+/* The reply buffer pool only manages dynamic reply buffers */
+#if !defined PUBNUB_USE_REPLY_BUFFER_POOL
+#define PUBNUB_USE_REPLY_BUFFER_POOL 0
+#elif PUBNUB_USE_REPLY_BUFFER_POOL && !PUBNUB_DYNAMIC_REPLY_BUFFER
+#error PUBNUB_USE_REPLY_BUFFER_POOL needs PUBNUB_DYNAMIC_REPLY_BUFFER
+#endif
+
+#if !defined PUBNUB_USE_JSON_TAPE
+#define PUBNUB_USE_JSON_TAPE 0
+#endif
+
+/** Maximum number of JSON tape tokens a context keeps between
+    replies. After a reply that needed more, the tokens are freed
+    (when the next reply comes), so that one huge reply doesn't pin
+    its tape for the life of the context.
+ */
+#if !defined PUBNUB_JSON_TAPE_RETAIN_MAX
+#define PUBNUB_JSON_TAPE_RETAIN_MAX 4096
+#endif
+
+#if !defined PUBNUB_USE_URL_ENCODE_CACHE
+#define PUBNUB_USE_URL_ENCODE_CACHE 0
+#endif
+
+/* Only platforms which can wait on the native socket (a "poll()") can
+   have pubnub_await() sleep until there is I/O to do.
+ */
+#if !defined PUBNUB_SYNC_AWAIT_ON_SOCKET
+#define PUBNUB_SYNC_AWAIT_ON_SOCKET 0
+#endif
+
 /** State of a Pubnub socket. Some states are specific to some
     PALs.
  */
@@ -106,7 +181,9 @@ enum PBSocketState {
     /** Reading a line */
     STATE_READ_LINE = 7,
     /** Sending data */
-    STATE_SENDING_DATA = 8
+    STATE_SENDING_DATA = 8,
+    /** Reading a number of octets directly to a given buffer */
+    STATE_READ_INTO = 9
 };
 
 
@@ -312,6 +389,12 @@ struct pubnub_ {
     /** Number of bytes to send or read - given by the user */
     unsigned len;
 
+#if PUBNUB_USE_ZERO_COPY_RECEIVE
+    /** Next byte to write to when reading directly to a given
+        buffer, rather than to our buffer */
+    uint8_t* rx_dst;
+#endif
+
     /** Indicates whether we are receiving chunked or regular HTTP
      * response
      */
@@ -335,7 +418,24 @@ struct pubnub_ {
         Takes values from enum 'pubnub_method' defined in 'pubnub_api_types.h'.
       */
     uint8_t method;
-    
+
+#if PUBNUB_USE_VECTORED_SEND
+    /** The pieces of data still to send with pbpal_sendv() */
+    struct pbpal_iovec sendv[PUBNUB_SENDV_MAX];
+    /** Number of pieces in `sendv` */
+    uint8_t sendv_count;
+    /** Index of the piece in `sendv` we're sending */
+    uint8_t sendv_index;
+    /** Buffer for HTTP headers (other than "Host:") when doing
+        vectored sending of a request */
+    char tx_headers[PUBNUB_TX_HEADERS_MAXLEN];
+#endif
+
+#if PUBNUB_USE_PUBLISH_QUEUE
+    /** The queue of messages to publish (pipelined) */
+    struct pbpublish_queue publish_queue;
+#endif
+
 #if PUBNUB_ADVANCED_KEEP_ALIVE
     struct pubnub_keep_alive_data {
         time_t   timeout;
@@ -373,6 +473,14 @@ struct pubnub_ {
     struct pubnub_* previous;
     struct pubnub_* next;
     int             timeout_left_ms;
+    /** Deadline of the timer, when in a timing wheel */
+    uint64_t timer_deadline_ms;
+    /** Slot of the timing wheel the timer is in, plus one (0 means
+        not in a wheel) */
+    uint16_t timer_slot;
+#else
+    /** When the current transaction started (sync interface) */
+    pbmsref_t trans_started;
 #endif
 
 #endif /* PUBNUB_TIMERS_API */
@@ -381,6 +489,9 @@ struct pubnub_ {
     pubnub_callback_t cb;
     void*             user_data;
 
+    /** The link of this context in the processing queue */
+    struct pbpal_ntf_callback_queue_node queue_node;
+
 #if PUBNUB_CHANGE_DNS_SERVERS
     struct pbdns_servers_check dns_check;
 #endif    
@@ -3,8 +3,255 @@
 
 #include "pubnub_assert.h"
 
+#include <errno.h>
 #include <string.h>
 
+#if PUBNUB_JSON_USE_SIMD
+#include <immintrin.h>
+
+/* AVX2 code is compiled for its own functions, so that the rest can
+   run on any CPU, and is used only if the CPU supports it.
+ */
+#if !defined PBJSON_HAVE_AVX2
+#if defined __clang__ || (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9))
+#define PBJSON_HAVE_AVX2 1
+#else
+#define PBJSON_HAVE_AVX2 0
+#endif
+#endif
+
+/** Bit `i` is set for the odd `i`s */
+#define ODD_BITS 0xAAAAAAAAAAAAAAAAULL
+
+
+/** Where the interesting characters are in a block: bit `i` of each
+    mask is for the character `i` of the block.
+ */
+struct block_chars {
+    uint64_t quotes;
+    uint64_t backslashes;
+    uint64_t nuls;
+    /** These two are only classified if asked for */
+    uint64_t brackets;
+    uint64_t commas;
+};
+
+
+static void classify_sse2(char const* s, bool structure, struct block_chars* chars)
+{
+    unsigned i;
+
+    chars->quotes = chars->backslashes = chars->nuls = 0;
+    chars->brackets = chars->commas = 0;
+    for (i = 0; i < PBJSON_BLOCK_SIZE; i += 16) {
+        __m128i const v = _mm_loadu_si128((__m128i const*)(s + i));
+
+        chars->quotes |=
+            (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << i;
+        chars->backslashes |=
+            (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << i;
+        chars->nuls |=
+            (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) << i;
+        if (structure) {
+            /* `[` and `]` differ from `{` and `}` only in the 0x20 bit */
+            __m128i const folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+            __m128i const brackets =
+                _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+                             _mm_cmpeq_epi8(folded, _mm_set1_epi8('}')));
+
+            chars->brackets |= (uint64_t)(uint16_t)_mm_movemask_epi8(brackets) << i;
+            chars->commas |=
+                (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(',')))
+                << i;
+        }
+    }
+}
+
+
+#if PBJSON_HAVE_AVX2
+__attribute__((target("avx2"))) static void
+classify_avx2(char const* s, bool structure, struct block_chars* chars)
+{
+    unsigned i;
+
+    chars->quotes = chars->backslashes = chars->nuls = 0;
+    chars->brackets = chars->commas = 0;
+    for (i = 0; i < PBJSON_BLOCK_SIZE; i += 32) {
+        __m256i const v = _mm256_loadu_si256((__m256i const*)(s + i));
+
+        chars->quotes |=
+            (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')))
+            << i;
+        chars->backslashes |=
+            (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')))
+            << i;
+        chars->nuls |=
+            (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()))
+            << i;
+        if (structure) {
+            __m256i const folded   = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+            __m256i const brackets = _mm256_or_si256(
+                _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')),
+                _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}')));
+
+            chars->brackets |= (uint64_t)(uint32_t)_mm256_movemask_epi8(brackets) << i;
+            chars->commas |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                                 _mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')))
+                             << i;
+        }
+    }
+}
+#endif /* PBJSON_HAVE_AVX2 */
+
+
+/** Classifies the characters of the block @p s into @p chars. If
+    @p structure, also looks for the brackets and commas.
+ */
+static void classify(char const* s, bool structure, struct block_chars* chars)
+{
+#if PBJSON_HAVE_AVX2
+    /* This only reads a flag that libgcc sets up at startup */
+    if (__builtin_cpu_supports("avx2")) {
+        classify_avx2(s, structure, chars);
+        return;
+    }
+#endif
+    classify_sse2(s, structure, chars);
+}
+
+
+/** Finds the characters that come right after an odd number of
+    backslashes, that is, the escaped characters (as in simdjson).
+    @p carry is whether the block starts escaped (the previous one
+    ended with an odd number of backslashes) and will be set to whether
+    this block ends with an odd number of backslashes.
+ */
+static uint64_t find_escaped(uint64_t backslashes, bool* carry)
+{
+    uint64_t const prev_odd = *carry ? 1 : 0;
+    uint64_t       start_edges;
+    uint64_t       even_start_mask;
+    uint64_t       even_carries;
+    uint64_t       odd_starts;
+    uint64_t       odd_carries;
+
+    if ((0 == backslashes) && !*carry) {
+        return 0;
+    }
+    /* An escaped backslash doesn't start a run */
+    backslashes &= ~prev_odd;
+    start_edges     = backslashes & ~(backslashes << 1);
+    even_start_mask = ~ODD_BITS ^ prev_odd;
+    /* Adding the start of a run carries to the character after it */
+    even_carries = backslashes + (start_edges & even_start_mask);
+    odd_starts   = start_edges & ~even_start_mask;
+    odd_carries  = backslashes + odd_starts;
+    *carry       = odd_carries < backslashes;
+    odd_carries |= prev_odd;
+
+    return ((even_carries & ~backslashes & ODD_BITS) | (odd_carries & ~backslashes & ~ODD_BITS));
+}
+
+
+/** Bit `i` of the result is the XOR of bits 0 to `i` of @p x */
+static uint64_t prefix_xor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+
+/** Finds the double-quotes in the block @p s that start or end a
+    string, one character at a time. For the (rare) blocks with an
+    escaped double-quote out of a string, which starts a string
+    nonetheless.
+ */
+static uint64_t find_string_quotes_slow(char const*               s,
+                                        uint64_t                  interesting,
+                                        struct pbjson_scan_state* state)
+{
+    uint64_t rslt = 0;
+    unsigned next = 0;
+
+    while (interesting != 0) {
+        unsigned const i = __builtin_ctzll(interesting);
+        interesting &= interesting - 1;
+        if (i > next) {
+            state->in_escape = false;
+        }
+        if (!state->in_string) {
+            if ('"' == s[i]) {
+                state->in_string = true;
+                rslt |= (uint64_t)1 << i;
+            }
+        }
+        else if ('\\' == s[i]) {
+            state->in_escape = !state->in_escape;
+        }
+        else {
+            if (!state->in_escape) {
+                state->in_string = false;
+                rslt |= (uint64_t)1 << i;
+            }
+            state->in_escape = false;
+        }
+        next = i + 1;
+    }
+    if (next < PBJSON_BLOCK_SIZE) {
+        state->in_escape = false;
+    }
+
+    return rslt;
+}
+
+
+void pbjson_scan_block(char const*               s,
+                       struct pbjson_scan_state* state,
+                       struct pbjson_block*      found)
+{
+    struct block_chars chars;
+    uint64_t           escaped;
+    uint64_t           in_string;
+    bool               odd_end = state->in_escape;
+
+    classify(s, true, &chars);
+    escaped = find_escaped(chars.backslashes, &odd_end);
+
+    /* Assume that the escaped quotes are in strings, so they don't
+       start or end one. Opening quotes are in the string, the closing
+       ones are not.
+     */
+    in_string = prefix_xor(chars.quotes & ~escaped);
+    if (state->in_string) {
+        in_string = ~in_string;
+    }
+    if (0 == (chars.quotes & escaped & ~in_string)) {
+        state->in_string = 0 != (in_string >> (PBJSON_BLOCK_SIZE - 1));
+        state->in_escape = state->in_string && odd_end;
+    }
+    else {
+        /* The first escaped quote out of a string was wrongly assumed
+           not to start one, so we need to start over
+         */
+        bool const was_in_string = state->in_string;
+
+        in_string = prefix_xor(
+            find_string_quotes_slow(s, chars.quotes | chars.backslashes, state));
+        if (was_in_string) {
+            in_string = ~in_string;
+        }
+    }
+    found->brackets = chars.brackets & ~in_string;
+    found->commas   = chars.commas & ~in_string;
+    found->nuls     = chars.nuls;
+}
+#endif /* PUBNUB_JSON_USE_SIMD */
+
 
 char const* pbjson_skip_whitespace(char const* start, char const* end)
 {
@@ -23,25 +270,49 @@ char const* pbjson_skip_whitespace(char const* start, char const* end)
 }
 
 
+/** Handles the character @p c of a string, updating @p in_escape.
+    @return Whether @p c is the end of the string
+ */
+static bool string_char(char c, bool* in_escape)
+{
+    switch (c) {
+    case '\\':
+        *in_escape = !*in_escape;
+        break;
+    case '\0':
+        return true;
+    case '"':
+        if (!*in_escape) {
+            return true;
+        }
+        /*FALLTHRU*/
+    default:
+        *in_escape = false;
+        break;
+    }
+    return false;
+}
+
+
 char const* pbjson_find_end_string(char const* start, char const* end)
 {
     bool in_escape = false;
 
+#if PUBNUB_JSON_USE_SIMD
+    for (; end - start >= PBJSON_BLOCK_SIZE; start += PBJSON_BLOCK_SIZE) {
+        struct block_chars chars;
+        uint64_t           ends;
+
+        classify(start, false, &chars);
+        ends = (chars.quotes & ~find_escaped(chars.backslashes, &in_escape)) | chars.nuls;
+        if (ends != 0) {
+            return start + __builtin_ctzll(ends);
+        }
+    }
+#endif
     for (; start < end; ++start) {
-        switch (*start) {
-        case '\\':
-            in_escape = !in_escape;
-            break;
-        case '\0':
+        if (string_char(*start, &in_escape)) {
             return start;
-        case '"':
-            if (!in_escape) {
-                return start;
-            }
-            /*FALLTHRU*/
-        default:
-            in_escape = false;
-            break;
         }
     }
 
@@ -71,55 +342,96 @@ char const* pbjson_find_end_primitive(char const* start, char const* end)
 }
 
 
-char const* pbjson_find_end_complex(char const* start, char const* end)
-{
-    bool        in_string = false, in_escape = false;
-    int         bracket_level = 0, brace_level = 0;
-    char        c;
-    char const* s;
+/** The state of scanning an object or array */
+struct complex_scan {
+    bool in_string;
+    bool in_escape;
+    int  bracket_level;
+    int  brace_level;
+};
 
-    for (s = start, c = *s; (c != '\0') && (s < end); ++s, c = *s) {
-        if (!in_string) {
-            switch (c) {
-            case '{':
-                ++brace_level;
-                break;
-            case '}':
-                if ((--brace_level == 0) && (0 == bracket_level)) {
-                    return s;
-                }
-                break;
-            case '[':
-                ++bracket_level;
-                break;
-            case ']':
-                if ((--bracket_level == 0) && (0 == brace_level)) {
-                    return s;
-                }
-                break;
-            case '"':
-                in_string = true;
-                in_escape = false;
-                break;
-            default:
-                break;
+
+/** Handles the character @p c (which is not NUL) of an object or
+    array, updating the scan state @p scan.
+    @return Whether @p c is the end of the object or array
+ */
+static bool complex_char(char c, struct complex_scan* scan)
+{
+    if (!scan->in_string) {
+        switch (c) {
+        case '{':
+            ++scan->brace_level;
+            break;
+        case '}':
+            if ((--scan->brace_level == 0) && (0 == scan->bracket_level)) {
+                return true;
+            }
+            break;
+        case '[':
+            ++scan->bracket_level;
+            break;
+        case ']':
+            if ((--scan->bracket_level == 0) && (0 == scan->brace_level)) {
+                return true;
             }
+            break;
+        case '"':
+            scan->in_string = true;
+            scan->in_escape = false;
+            break;
+        default:
+            break;
         }
-        else {
-            switch (c) {
-            case '\\':
-                in_escape = !in_escape;
-                break;
-            case '"':
-                if (!in_escape) {
-                    in_string = false;
-                    break;
-                }
-                /*FALLTHRU*/
-            default:
-                in_escape = false;
+    }
+    else {
+        switch (c) {
+        case '\\':
+            scan->in_escape = !scan->in_escape;
+            break;
+        case '"':
+            if (!scan->in_escape) {
+                scan->in_string = false;
                 break;
             }
+            /*FALLTHRU*/
+        default:
+            scan->in_escape = false;
+            break;
+        }
+    }
+    return false;
+}
+
+
+char const* pbjson_find_end_complex(char const* start, char const* end)
+{
+    struct complex_scan scan = { false, false, 0, 0 };
+    char                c;
+    char const*         s = start;
+
+#if PUBNUB_JSON_USE_SIMD
+    struct pbjson_scan_state state = { false, false };
+
+    for (; end - s >= PBJSON_BLOCK_SIZE; s += PBJSON_BLOCK_SIZE) {
+        struct pbjson_block found;
+        uint64_t            mask;
+
+        pbjson_scan_block(s, &state, &found);
+        mask = found.brackets | found.nuls;
+        while (mask != 0) {
+            unsigned const i = __builtin_ctzll(mask);
+            mask &= mask - 1;
+            if (('\0' == s[i]) || complex_char(s[i], &scan)) {
+                return s + i;
+            }
+        }
+    }
+    scan.in_string = state.in_string;
+    scan.in_escape = state.in_escape;
+#endif
+    for (c = *s; (c != '\0') && (s < end); ++s, c = *s) {
+        if (complex_char(c, &scan)) {
+            return s;
         }
     }
     return s;
@@ -205,6 +517,71 @@ pbjson_get_object_value(struct pbjson_elem const* p,
 }
 
 
+enum pbjson_object_name_parse_result
+pbjson_get_next_object_member(struct pbjson_elem const* p,
+                              char const**              pos,
+                              struct pbjson_elem*       key,
+                              struct pbjson_elem*       value)
+{
+    char const* s = pbjson_skip_whitespace(*pos, p->end);
+    char const* end;
+
+    if (s == p->end) {
+        return jonmpObjectIncomplete;
+    }
+    if (*pos == p->start) {
+        if (*s != '{') {
+            return jonmpNoStartCurly;
+        }
+        s = pbjson_skip_whitespace(s + 1, p->end);
+        if (s == p->end) {
+            return jonmpKeyMissing;
+        }
+        if ('}' == *s) {
+            /* Empty object */
+            *pos = s;
+            return jonmpKeyNotFound;
+        }
+    }
+    else if ('}' == *s) {
+        *pos = s;
+        return jonmpKeyNotFound;
+    }
+    else if (*s != ',') {
+        return jonmpMissingValueSeparator;
+    }
+    else {
+        s = pbjson_skip_whitespace(s + 1, p->end);
+        if (s == p->end) {
+            return jonmpKeyMissing;
+        }
+    }
+    if (*s != '"') {
+        return jonmpKeyNotString;
+    }
+    end = pbjson_find_end_string(s + 1, p->end);
+    if ((end == p->end) || (*end != '"')) {
+        return jonmpStringNotTerminated;
+    }
+    key->start = s;
+    key->end   = end + 1;
+    s          = pbjson_skip_whitespace(end + 1, p->end);
+    if ((s == p->end) || (*s != ':')) {
+        return jonmpMissingColon;
+    }
+    s   = pbjson_skip_whitespace(s + 1, p->end);
+    end = pbjson_find_end_element(s, p->end);
+    if ((end == p->end) || ('\0' == *end)) {
+        return jonmpValueIncomplete;
+    }
+    value->start = s;
+    value->end   = end + 1;
+    *pos         = end + 1;
+
+    return jonmpOK;
+}
+
+
 bool pbjson_elem_equals_string(struct pbjson_elem const* e, char const* s)
 {
     char const* p;
@@ -265,3 +642,736 @@ size_t pbjson_element_strcpy(struct pbjson_elem const* p, char* s, size_t n)
 
     return len + 1;
 }
+
+
+void pbjson_tape_init(struct pbjson_tape*  tape,
+                      struct pbjson_token* tokens,
+                      unsigned             capacity)
+{
+    PUBNUB_ASSERT_OPT(tape != NULL);
+    PUBNUB_ASSERT_OPT((tokens != NULL) || (0 == capacity));
+
+    tape->json     = NULL;
+    tape->tokens   = tokens;
+    tape->count    = 0;
+    tape->capacity = capacity;
+}
+
+
+/** What the tape builder expects to find next */
+enum tape_expect {
+    /** Any JSON value */
+    texpValue,
+    /** A value or the closing square bracket of an (empty) array */
+    texpValueOrClose,
+    /** The key of the next member of an object */
+    texpKey,
+    /** The key of the first member or the closing curly brace of an
+        (empty) object */
+    texpKeyOrClose,
+    /** The colon between the key and the value of a member */
+    texpColon,
+    /** A comma before the next value/member or the closing brace or
+        bracket of the object/array */
+    texpCommaOrClose
+};
+
+
+/** Returns whether characters from @p start to @p end can make a
+    JSON primitive (a number, `true`, `false` or `null`). Unlike
+    pbjson_find_end_primitive(), the tape builder is strict here, as
+    the other parsers would see (say) a bracket in a "primitive" as
+    structure.
+ */
+static bool is_primitive(char const* start, char const* end)
+{
+    for (; start < end; ++start) {
+        char const c = *start;
+        if (!(((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'z'))
+              || ((c >= 'A') && (c <= 'Z')) || ('-' == c) || ('+' == c)
+              || ('.' == c))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+enum pbjson_tape_result
+pbjson_tape_build(struct pbjson_tape* tape, char const* start, char const* end)
+{
+    enum tape_expect expect = texpValue;
+    /* The innermost object/array that is not closed yet. While open,
+       the `next` of its token is the index of its parent. */
+    unsigned    open = PBJSON_TAPE_NONE;
+    char const* s    = start;
+
+    PUBNUB_ASSERT_OPT(tape != NULL);
+    PUBNUB_ASSERT_OPT(start <= end);
+
+    tape->json  = start;
+    tape->count = 0;
+    for (;;) {
+        struct pbjson_token* token;
+        char const*          e;
+
+        s = pbjson_skip_whitespace(s, end);
+        if (s == end) {
+            return jtrIncomplete;
+        }
+        switch (expect) {
+        case texpColon:
+            if (*s != ':') {
+                return jtrInvalid;
+            }
+            ++s;
+            expect = texpValue;
+            continue;
+        case texpCommaOrClose:
+            if (',' == *s) {
+                ++s;
+                expect = ('{' == start[tape->tokens[open].start]) ? texpKey : texpValue;
+                continue;
+            }
+            break;
+        case texpKey:
+        case texpKeyOrClose:
+            if ('"' == *s) {
+                if (tape->count == tape->capacity) {
+                    return jtrNoRoom;
+                }
+                e = pbjson_find_end_string(s + 1, end);
+                if (e == end) {
+                    return jtrIncomplete;
+                }
+                if (*e != '"') {
+                    return jtrInvalid;
+                }
+                token        = &tape->tokens[tape->count];
+                token->start = (unsigned)(s - start);
+                token->end   = (unsigned)(e + 1 - start);
+                token->next  = ++tape->count;
+                s            = e + 1;
+                expect       = texpColon;
+                continue;
+            }
+            if (texpKey == expect) {
+                return jtrInvalid;
+            }
+            break;
+        case texpValueOrClose:
+        case texpValue:
+            if (tape->count == tape->capacity) {
+                return jtrNoRoom;
+            }
+            token        = &tape->tokens[tape->count];
+            token->start = (unsigned)(s - start);
+            switch (*s) {
+            case '{':
+            case '[':
+                token->next = open;
+                open        = tape->count++;
+                expect      = ('{' == *s) ? texpKeyOrClose : texpValueOrClose;
+                ++s;
+                continue;
+            case ']':
+                if (texpValueOrClose == expect) {
+                    break;
+                }
+                return jtrInvalid;
+            case '}':
+            case ',':
+            case ':':
+            case '\0':
+                return jtrInvalid;
+            case '"':
+                e = pbjson_find_end_string(s + 1, end);
+                if (e == end) {
+                    return jtrIncomplete;
+                }
+                if (*e != '"') {
+                    return jtrInvalid;
+                }
+                token->end = (unsigned)(e + 1 - start);
+                break;
+            default:
+                e = pbjson_find_end_primitive(s + 1, end);
+                if (e == end) {
+                    if (open != PBJSON_TAPE_NONE) {
+                        return jtrIncomplete;
+                    }
+                    token->end = (unsigned)(end - start);
+                }
+                else if ('\0' == *e) {
+                    return jtrInvalid;
+                }
+                else {
+                    token->end = (unsigned)(e + 1 - start);
+                }
+                if (!is_primitive(s, start + token->end)) {
+                    return jtrInvalid;
+                }
+                break;
+            }
+            if (*s != ']') {
+                token->next = ++tape->count;
+                if (PBJSON_TAPE_NONE == open) {
+                    return jtrOK;
+                }
+                s      = start + token->end;
+                expect = texpCommaOrClose;
+                continue;
+            }
+            break;
+        }
+
+        /* The closing of the innermost open object/array */
+        token = &tape->tokens[open];
+        if (('}' == *s) != ('{' == start[token->start])) {
+            return jtrInvalid;
+        }
+        if ((*s != '}') && (*s != ']')) {
+            return jtrInvalid;
+        }
+        ++s;
+        open        = token->next;
+        token->end  = (unsigned)(s - start);
+        token->next = tape->count;
+        if (PBJSON_TAPE_NONE == open) {
+            return jtrOK;
+        }
+        expect = texpCommaOrClose;
+    }
+}
+
+
+void pbjson_tape_elem(struct pbjson_tape const* tape,
+                      unsigned                  i,
+                      struct pbjson_elem*       elem)
+{
+    PUBNUB_ASSERT_OPT(tape != NULL);
+    PUBNUB_ASSERT_OPT(i < tape->count);
+    PUBNUB_ASSERT_OPT(elem != NULL);
+
+    elem->start = tape->json + tape->tokens[i].start;
+    elem->end   = tape->json + tape->tokens[i].end;
+}
+
+
+unsigned pbjson_tape_find(struct pbjson_tape const* tape, char const* at)
+{
+    unsigned lo;
+    unsigned hi;
+    size_t   ofs;
+
+    PUBNUB_ASSERT_OPT(tape != NULL);
+
+    if ((0 == tape->count) || (at < tape->json)) {
+        return PBJSON_TAPE_NONE;
+    }
+    ofs = at - tape->json;
+    /* Tokens are on the tape in the order of their start */
+    lo = 0;
+    hi = tape->count;
+    while (lo < hi) {
+        unsigned const mid = lo + (hi - lo) / 2;
+        if (tape->tokens[mid].start < ofs) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return ((lo < tape->count) && (tape->tokens[lo].start == ofs)) ? lo : PBJSON_TAPE_NONE;
+}
+
+
+unsigned pbjson_tape_first_child(struct pbjson_tape const* tape, unsigned i)
+{
+    char c;
+
+    PUBNUB_ASSERT_OPT(tape != NULL);
+    PUBNUB_ASSERT_OPT(i < tape->count);
+
+    c = tape->json[tape->tokens[i].start];
+    if ((('{' != c) && ('[' != c)) || (tape->tokens[i].next == i + 1)) {
+        return PBJSON_TAPE_NONE;
+    }
+
+    return i + 1;
+}
+
+
+unsigned pbjson_tape_next_sibling(struct pbjson_tape const* tape,
+                                  unsigned                  parent,
+                                  unsigned                  i)
+{
+    unsigned next;
+
+    PUBNUB_ASSERT_OPT(tape != NULL);
+    PUBNUB_ASSERT_OPT(parent < i);
+    PUBNUB_ASSERT_OPT(i < tape->count);
+
+    next = tape->tokens[i].next;
+
+    return (next < tape->tokens[parent].next) ? next : PBJSON_TAPE_NONE;
+}
+
+
+unsigned pbjson_tape_object_get(struct pbjson_tape const* tape,
+                                unsigned                  obj,
+                                char const*               name)
+{
+    size_t   len;
+    unsigned key;
+    unsigned obj_next;
+
+    PUBNUB_ASSERT_OPT(tape != NULL);
+    PUBNUB_ASSERT_OPT(obj < tape->count);
+    PUBNUB_ASSERT_OPT(name != NULL);
+
+    if (tape->json[tape->tokens[obj].start] != '{') {
+        return PBJSON_TAPE_NONE;
+    }
+    len      = strlen(name);
+    obj_next = tape->tokens[obj].next;
+    for (key = obj + 1; key < obj_next; key = tape->tokens[key + 1].next) {
+        struct pbjson_token const* token = &tape->tokens[key];
+        if ((token->end - token->start - 2 == len)
+            && (0 == memcmp(tape->json + token->start + 1, name, len))) {
+            return key + 1;
+        }
+    }
+
+    return PBJSON_TAPE_NONE;
+}
+
+
+unsigned pbjson_tape_array_get(struct pbjson_tape const* tape, unsigned arr, unsigned n)
+{
+    unsigned i;
+    unsigned arr_next;
+
+    PUBNUB_ASSERT_OPT(tape != NULL);
+    PUBNUB_ASSERT_OPT(arr < tape->count);
+
+    if (tape->json[tape->tokens[arr].start] != '[') {
+        return PBJSON_TAPE_NONE;
+    }
+    arr_next = tape->tokens[arr].next;
+    for (i = arr + 1; i < arr_next; i = tape->tokens[i].next) {
+        if (0 == n--) {
+            return i;
+        }
+    }
+
+    return PBJSON_TAPE_NONE;
+}
+
+
+/** Returns the pointer to the character after the JSON element
+    starting at @p s, not going further than @p end. NULL if the
+    element is not complete (or is not an element at all).
+ */
+static char const* end_of_element(char const* s, char const* end)
+{
+    char const* e;
+
+    if (s == end) {
+        return NULL;
+    }
+    switch (*s) {
+    case '{':
+        e = pbjson_find_end_complex(s, end);
+        return ((e == end) || (*e != '}')) ? NULL : e + 1;
+    case '[':
+        e = pbjson_find_end_complex(s, end);
+        return ((e == end) || (*e != ']')) ? NULL : e + 1;
+    case '"':
+        e = pbjson_find_end_string(s + 1, end);
+        return ((e == end) || (*e != '"')) ? NULL : e + 1;
+    case ',':
+    case ':':
+    case '}':
+    case ']':
+    case '\0':
+        return NULL;
+    default:
+        e = pbjson_find_end_primitive(s + 1, end);
+        if ((e == end) || ('\0' == *e)) {
+            return e;
+        }
+        return e + 1;
+    }
+}
+
+
+static enum pbjson_object_name_parse_result
+get_member(struct pbjson_elem const* obj,
+           char const*               name,
+           size_t                    len,
+           struct pbjson_elem*       parsed)
+{
+    char const*                          pos = obj->start;
+    struct pbjson_elem                   key;
+    struct pbjson_elem                   value;
+    enum pbjson_object_name_parse_result rslt;
+
+    while (jonmpOK == (rslt = pbjson_get_next_object_member(obj, &pos, &key, &value))) {
+        if (((size_t)(key.end - key.start) == len + 2)
+            && (0 == memcmp(key.start + 1, name, len))) {
+            *parsed = value;
+            return jonmpOK;
+        }
+    }
+
+    return rslt;
+}
+
+
+static enum pbjson_object_name_parse_result
+get_element(struct pbjson_elem const* arr, unsigned long index, struct pbjson_elem* parsed)
+{
+    char const* s = arr->start;
+
+    if ((s == arr->end) || (*s != '[')) {
+        return jonmpNoStartCurly;
+    }
+    s = pbjson_skip_whitespace(s + 1, arr->end);
+    if ((s < arr->end) && (']' == *s)) {
+        return jonmpKeyNotFound;
+    }
+    for (;;) {
+        char const* e = end_of_element(s, arr->end);
+        if (NULL == e) {
+            return jonmpValueIncomplete;
+        }
+        if (0 == index--) {
+            parsed->start = s;
+            parsed->end   = e;
+            return jonmpOK;
+        }
+        s = pbjson_skip_whitespace(e, arr->end);
+        if (s == arr->end) {
+            return jonmpObjectIncomplete;
+        }
+        if (']' == *s) {
+            return jonmpKeyNotFound;
+        }
+        if (*s != ',') {
+            return jonmpMissingValueSeparator;
+        }
+        s = pbjson_skip_whitespace(s + 1, arr->end);
+    }
+}
+
+
+enum pbjson_object_name_parse_result pbjson_path(struct pbjson_elem const* p,
+                                                 char const*               path,
+                                                 struct pbjson_elem*       parsed)
+{
+    struct pbjson_elem el;
+    char const*        e;
+    bool               first = true;
+
+    PUBNUB_ASSERT_OPT(p != NULL);
+    PUBNUB_ASSERT_OPT(path != NULL);
+    PUBNUB_ASSERT_OPT(parsed != NULL);
+
+    el.start = pbjson_skip_whitespace(p->start, p->end);
+    e        = end_of_element(el.start, p->end);
+    if (NULL == e) {
+        return jonmpValueIncomplete;
+    }
+    el.end = e;
+    while (*path != '\0') {
+        enum pbjson_object_name_parse_result rslt;
+
+        if ('[' == *path) {
+            char*         idx_end;
+            unsigned long index;
+
+            if ((path[1] < '0') || (path[1] > '9')) {
+                return jonmpInvalidKeyName;
+            }
+            index = strtoul(path + 1, &idx_end, 10);
+            if (*idx_end != ']') {
+                return jonmpInvalidKeyName;
+            }
+            rslt = get_element(&el, index, &el);
+            path = idx_end + 1;
+        }
+        else {
+            size_t len;
+
+            if (!first) {
+                if (*path != '.') {
+                    return jonmpInvalidKeyName;
+                }
+                ++path;
+            }
+            len = strcspn(path, ".[");
+            if (0 == len) {
+                return jonmpInvalidKeyName;
+            }
+            rslt = get_member(&el, path, len, &el);
+            path += len;
+        }
+        if (rslt != jonmpOK) {
+            return rslt;
+        }
+        first = false;
+    }
+    *parsed = el;
+
+    return jonmpOK;
+}
+
+
+/** Puts the element @p e, without the whitespace around it, to
+    @p start and @p end.
+ */
+static void trim(struct pbjson_elem const* e, char const** start, char const** end)
+{
+    char const* s = pbjson_skip_whitespace(e->start, e->end);
+    char const* t = e->end;
+
+    while ((t > s) && ((' ' == t[-1]) || ('\t' == t[-1]) || ('\n' == t[-1]) || ('\r' == t[-1]))) {
+        --t;
+    }
+    *start = s;
+    *end   = t;
+}
+
+
+/** Copies the JSON number @p e to @p buf, which has @p n characters,
+    as a C string, checking that it has only the characters a JSON
+    number can have.
+    @return 0: OK, -1: not a number, or too long
+ */
+static int number_to_buf(struct pbjson_elem const* e, char* buf, size_t n)
+{
+    char const* s;
+    char const* end;
+    size_t      len;
+
+    trim(e, &s, &end);
+    len = end - s;
+    if ((0 == len) || (len >= n) || !(('-' == *s) || ((*s >= '0') && (*s <= '9')))) {
+        return -1;
+    }
+    if (strspn(s, "0123456789+-.eE") < len) {
+        return -1;
+    }
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+
+    return 0;
+}
+
+
+int pbjson_get_double(struct pbjson_elem const* e, double* d)
+{
+    char   buf[64];
+    char*  num_end;
+    double v;
+
+    PUBNUB_ASSERT_OPT(e != NULL);
+    PUBNUB_ASSERT_OPT(d != NULL);
+
+    if (0 != number_to_buf(e, buf, sizeof buf)) {
+        return -1;
+    }
+    v = strtod(buf, &num_end);
+    if ((num_end == buf) || (*num_end != '\0')) {
+        return -1;
+    }
+    *d = v;
+
+    return 0;
+}
+
+
+int pbjson_get_long(struct pbjson_elem const* e, long* l)
+{
+    char  buf[32];
+    char* num_end;
+    long  v;
+
+    PUBNUB_ASSERT_OPT(e != NULL);
+    PUBNUB_ASSERT_OPT(l != NULL);
+
+    if ((0 != number_to_buf(e, buf, sizeof buf)) || (buf[strspn(buf, "-0123456789")] != '\0')) {
+        return -1;
+    }
+    errno = 0;
+    v     = strtol(buf, &num_end, 10);
+    if ((num_end == buf) || (*num_end != '\0') || (ERANGE == errno)) {
+        return -1;
+    }
+    *l = v;
+
+    return 0;
+}
+
+
+int pbjson_get_bool(struct pbjson_elem const* e, bool* b)
+{
+    struct pbjson_elem t;
+
+    PUBNUB_ASSERT_OPT(e != NULL);
+    PUBNUB_ASSERT_OPT(b != NULL);
+
+    trim(e, &t.start, &t.end);
+    if (pbjson_elem_equals_string(&t, "true")) {
+        *b = true;
+    }
+    else if (pbjson_elem_equals_string(&t, "false")) {
+        *b = false;
+    }
+    else {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/** Returns the value of the 4 hex digits at @p s, -1 if they are not
+    hex digits.
+ */
+static long hex4(char const* s)
+{
+    long v = 0;
+    int  i;
+
+    for (i = 0; i < 4; ++i) {
+        char const c = s[i];
+        v <<= 4;
+        if ((c >= '0') && (c <= '9')) {
+            v |= c - '0';
+        }
+        else if ((c >= 'a') && (c <= 'f')) {
+            v |= c - 'a' + 10;
+        }
+        else if ((c >= 'A') && (c <= 'F')) {
+            v |= c - 'A' + 10;
+        }
+        else {
+            return -1;
+        }
+    }
+    return v;
+}
+
+
+int pbjson_get_string(struct pbjson_elem const* e, char* s, size_t n)
+{
+    char const* p;
+    char const* end;
+    size_t      len = 0;
+
+    PUBNUB_ASSERT_OPT(e != NULL);
+    PUBNUB_ASSERT_OPT((s != NULL) || (0 == n));
+
+    trim(e, &p, &end);
+    if ((end - p < 2) || (*p != '"') || (end[-1] != '"')) {
+        return -1;
+    }
+    for (++p, --end; p < end; ++p) {
+        char          out[4];
+        size_t        out_len = 1;
+        unsigned long cp;
+
+        if (*p != '\\') {
+            out[0] = *p;
+        }
+        else if (++p == end) {
+            return -1;
+        }
+        else {
+            switch (*p) {
+            case '"':
+            case '\\':
+            case '/':
+                out[0] = *p;
+                break;
+            case 'b':
+                out[0] = '\b';
+                break;
+            case 'f':
+                out[0] = '\f';
+                break;
+            case 'n':
+                out[0] = '\n';
+                break;
+            case 'r':
+                out[0] = '\r';
+                break;
+            case 't':
+                out[0] = '\t';
+                break;
+            case 'u':
+                if ((end - p < 5) || (hex4(p + 1) < 0)) {
+                    return -1;
+                }
+                cp = (unsigned long)hex4(p + 1);
+                p += 4;
+                if ((cp >= 0xDC00) && (cp <= 0xDFFF)) {
+                    return -1;
+                }
+                if ((cp >= 0xD800) && (cp <= 0xDBFF)) {
+                    /* A surrogate pair */
+                    long low;
+                    if ((end - p < 7) || (p[1] != '\\') || (p[2] != 'u')) {
+                        return -1;
+                    }
+                    low = hex4(p + 3);
+                    if ((low < 0xDC00) || (low > 0xDFFF)) {
+                        return -1;
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + ((unsigned long)low - 0xDC00);
+                    p += 6;
+                }
+                if (cp < 0x80) {
+                    out[0] = (char)cp;
+                }
+                else if (cp < 0x800) {
+                    out[0]  = (char)(0xC0 | (cp >> 6));
+                    out[1]  = (char)(0x80 | (cp & 0x3F));
+                    out_len = 2;
+                }
+                else if (cp < 0x10000) {
+                    out[0]  = (char)(0xE0 | (cp >> 12));
+                    out[1]  = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    out[2]  = (char)(0x80 | (cp & 0x3F));
+                    out_len = 3;
+                }
+                else {
+                    out[0]  = (char)(0xF0 | (cp >> 18));
+                    out[1]  = (char)(0x80 | ((cp >> 12) & 0x3F));
+                    out[2]  = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    out[3]  = (char)(0x80 | (cp & 0x3F));
+                    out_len = 4;
+                }
+                break;
+            default:
+                return -1;
+            }
+        }
+        if (len + out_len < n) {
+            memcpy(s + len, out, out_len);
+        }
+        else if (len < n) {
+            /* Don't cut an UTF-8 sequence, just stop putting */
+            n = len + 1;
+        }
+        len += out_len;
+    }
+    if (n > 0) {
+        s[(len < n) ? len : n - 1] = '\0';
+    }
+
+    return (int)len;
+}
@@ -6,6 +6,29 @@
 #include <stdlib.h>
 
 
+/** If true, scanning of JSON strings, objects and arrays looks at a
+    block of input at a time with SIMD instructions, instead of one
+    character at a time. SSE2 is used, or AVX2 if the CPU (as checked
+    at runtime) supports it.
+
+    By default, used with GCC (and compatible) compilers for x86, in
+    optimized builds. Without optimization, the SIMD intrinsics are
+    not inlined and the plain loops are faster.
+ */
+#if !defined PUBNUB_JSON_USE_SIMD
+#if defined __GNUC__ && defined __OPTIMIZE__ \
+    && (defined __x86_64__ || (defined __i386__ && defined __SSE2__))
+#define PUBNUB_JSON_USE_SIMD 1
+#else
+#define PUBNUB_JSON_USE_SIMD 0
+#endif
+#endif
+
+#if PUBNUB_JSON_USE_SIMD
+#include <stdint.h>
+#endif
+
+
 /** @file pubnub_json_parse.h
 
     A bunch of functions for parsing JSON. These are designed for
@@ -140,6 +163,28 @@ pbjson_get_object_value(struct pbjson_elem const* p,
                         struct pbjson_elem*       parsed);
 
 
+/** Gets the next member (a "key": value pair) of the JSON object
+    @p p. This is for going over all the members of an object in one
+    pass, rather than looking for each key from the start of the
+    object with pbjson_get_object_value().
+
+    @param p The JSON object to iterate over
+    @param pos The iteration position. Set it to `p->start` before
+    the first call, then just pass it back, as updated by the previous
+    call.
+    @param key On success, the key of the member, with the quotes
+    @param value On success, the value of the member
+    @return jonmpOK: got the next member, jonmpKeyNotFound: no more
+    members, @p pos is at the closing curly brace of the object, any
+    other: the error encountered
+*/
+enum pbjson_object_name_parse_result
+pbjson_get_next_object_member(struct pbjson_elem const* p,
+                              char const**              pos,
+                              struct pbjson_elem*       key,
+                              struct pbjson_elem*       value);
+
+
 /** Helper function, returns whether string @p s is equal to the
     contents of the JSON element @p e.
 */
@@ -164,4 +209,226 @@ pbjson_object_name_parse_result_2_string(enum pbjson_object_name_parse_result e)
 size_t pbjson_element_strcpy(struct pbjson_elem const* p, char* s, size_t n);
 
 
+/** Gets the value at the @p path in the JSON element @p p and puts
+    it to @p parsed. This does not parse the whole of @p p, only what
+    is needed to get to the value, without allocating any memory.
+
+    The @p path has the keys of object members separated by dots and
+    indexes of array elements (starting from 0) in square brackets,
+    like: `data.items[3].price`. Keys are compared as they are in the
+    JSON (escapes are not decoded) and can't have a `.` or `[` in
+    them. An empty @p path gives the whole element @p p.
+
+    @return jonmpOK: found, jonmpKeyNotFound: an object member or
+    array element on the path is not there, jonmpInvalidKeyName: @p
+    path is not valid, jonmpNoStartCurly: a value is not an object (or
+    array) where the path says it should be, any other: the error
+    encountered in parsing the JSON
+*/
+enum pbjson_object_name_parse_result pbjson_path(struct pbjson_elem const* p,
+                                                 char const*               path,
+                                                 struct pbjson_elem*       parsed);
+
+
+/** Gets the JSON number @p e as a double, into @p d.
+    @retval 0 OK
+    @retval -1 @p e is not a number
+*/
+int pbjson_get_double(struct pbjson_elem const* e, double* d);
+
+
+/** Gets the JSON number @p e, which has to be an integer that fits a
+    long, into @p l.
+    @retval 0 OK
+    @retval -1 @p e is not an integer or is out of range
+*/
+int pbjson_get_long(struct pbjson_elem const* e, long* l);
+
+
+/** Gets the JSON `true` or `false` @p e into @p b.
+    @retval 0 OK
+    @retval -1 @p e is not `true` nor `false`
+*/
+int pbjson_get_bool(struct pbjson_elem const* e, bool* b);
+
+
+/** Gets the JSON string @p e, without the quotes and with the escapes
+    decoded (`\uXXXX` to UTF-8), to @p s, allocated by the caller as
+    an array of @p n characters. Like snprintf(), at most @p n - 1
+    characters are put to @p s and it is NUL terminated (if @p n > 0).
+    A string of the same length as @p e surely fits.
+
+    @return -1: @p e is not a (valid) string, otherwise: the length of
+    the decoded string (if >= @p n, only part of it was put to @p s)
+*/
+int pbjson_get_string(struct pbjson_elem const* e, char* s, size_t n);
+
+
+#if PUBNUB_JSON_USE_SIMD
+/** Number of characters that pbjson_scan_block() looks at */
+#define PBJSON_BLOCK_SIZE 64
+
+/** The state of scanning JSON a block at a time, carried over from
+    one block to the next.
+ */
+struct pbjson_scan_state {
+    /** Whether we're in a string */
+    bool in_string;
+    /** Whether the last character was a backslash that escapes the
+        next one (can only be in a string)
+     */
+    bool in_escape;
+};
+
+/** What pbjson_scan_block() found in a block. Bit `i` of each mask
+    is for the character `i` of the block.
+ */
+struct pbjson_block {
+    /** Curly braces and square brackets that are not in a string */
+    uint64_t brackets;
+    /** Commas that are not in a string */
+    uint64_t commas;
+    /** NUL characters, in a string or not */
+    uint64_t nuls;
+};
+
+/** Scans the block of #PBJSON_BLOCK_SIZE characters starting at @p s
+    for the characters that give the structure of JSON, that is, the
+    ones that are not in a string. Uses SIMD instructions to look at
+    many characters at once.
+
+    A string starts with a double-quote and ends with a double-quote
+    that is not escaped with a backslash. Backslashes are ignored out
+    of strings. A NUL is treated as any other character.
+
+    @param s The start of the block
+    @param state The scan state at the start of the block, will be
+    updated to the state at the end of the block
+    @param found Where to put the masks of what was found
+ */
+void pbjson_scan_block(char const*               s,
+                       struct pbjson_scan_state* state,
+                       struct pbjson_block*      found);
+#endif /* PUBNUB_JSON_USE_SIMD */
+
+
+/** Index of "no token" in a JSON tape */
+#define PBJSON_TAPE_NONE ((unsigned)-1)
+
+/** A token of a JSON tape: a JSON value or an object key. Offsets are
+    from the start of the JSON the tape was built for. The type of the
+    token is given by its first character: `{` object, `[` array, `"`
+    string (or key), anything else is a primitive.
+ */
+struct pbjson_token {
+    /** Offset of the first character of the token */
+    unsigned start;
+    /** Offset of the character _after_ the last character of the
+        token. For objects and arrays, that is one past the matching
+        closing curly brace/square bracket.
+     */
+    unsigned end;
+    /** Index of the token after this one and all its "children"
+        (for objects and arrays), that is, of the next sibling, if
+        there is one.
+     */
+    unsigned next;
+};
+
+/** A JSON tape: all the tokens of a JSON (keys and values), in the
+    order they appear in it, as found by one pass over it. Once built,
+    it can be used to get to any value without scanning the JSON again:
+    to get a member of an object only the keys of the object are
+    looked at, as the values are skipped in O(1).
+
+    A key of an object member is right before its value on the tape.
+    The first child of an object or array is right after it.
+ */
+struct pbjson_tape {
+    /** The JSON this tape was built for */
+    char const* json;
+    /** The array of tokens, allocated by the user */
+    struct pbjson_token* tokens;
+    /** Number of tokens on the tape */
+    unsigned count;
+    /** Number of elements of the #tokens array */
+    unsigned capacity;
+};
+
+/** Results of building a JSON tape */
+enum pbjson_tape_result {
+    /** Built OK */
+    jtrOK,
+    /** Not a valid JSON */
+    jtrInvalid,
+    /** JSON ended before the (outermost) value was complete */
+    jtrIncomplete,
+    /** More tokens than the capacity of the tape */
+    jtrNoRoom
+};
+
+/** Initializes the JSON tape @p tape to use the array @p tokens,
+    which has @p capacity elements, for its tokens.
+ */
+void pbjson_tape_init(struct pbjson_tape*  tape,
+                      struct pbjson_token* tokens,
+                      unsigned             capacity);
+
+/** Builds the JSON tape @p tape for the JSON value starting at @p
+    start, ending at most at @p end, in one pass. Anything after the
+    end of the value is ignored.
+
+    On jtrNoRoom, it's OK to give more room (change the `tokens` and
+    `capacity` of the @p tape) and build again.
+ */
+enum pbjson_tape_result
+pbjson_tape_build(struct pbjson_tape* tape, char const* start, char const* end);
+
+/** Puts the JSON element of the token @p i of the tape @p tape to
+    @p elem.
+ */
+void pbjson_tape_elem(struct pbjson_tape const* tape,
+                      unsigned                  i,
+                      struct pbjson_elem*       elem);
+
+/** Returns the index of the token that starts at @p at, or
+    #PBJSON_TAPE_NONE if there is no such token on the tape @p tape.
+    It's a binary search, so, O(log n).
+ */
+unsigned pbjson_tape_find(struct pbjson_tape const* tape, char const* at);
+
+/** Returns the index of the first child of the object or array that
+    is the token @p i of the tape @p tape (for an object, that is the
+    key of its first member). #PBJSON_TAPE_NONE if @p i is empty, or
+    not an object or array.
+ */
+unsigned pbjson_tape_first_child(struct pbjson_tape const* tape, unsigned i);
+
+/** Returns the index of the next sibling of the token @p i, a child
+    of the object or array @p parent, on the tape @p tape. That is
+    O(1), regardless of the size of the token @p i. #PBJSON_TAPE_NONE
+    if @p i is the last child.
+ */
+unsigned pbjson_tape_next_sibling(struct pbjson_tape const* tape,
+                                  unsigned                  parent,
+                                  unsigned                  i);
+
+/** Returns the index of the value of the member with the key @p name
+    of the object that is the token @p obj on the tape @p tape.
+    The key is compared as is (escapes are not decoded), the first
+    member with a matching key is found. #PBJSON_TAPE_NONE if not
+    found, or @p obj is not an object.
+ */
+unsigned pbjson_tape_object_get(struct pbjson_tape const* tape,
+                                unsigned                  obj,
+                                char const*               name);
+
+/** Returns the index of the element @p n (counting from 0) of the
+    array that is the token @p arr on the tape @p tape.
+    #PBJSON_TAPE_NONE if there is no such element, or @p arr is not
+    an array.
+ */
+unsigned pbjson_tape_array_get(struct pbjson_tape const* tape, unsigned arr, unsigned n);
+
+
 #endif /* !defined INC_PUBNUB_JSON_PARSE */
@@ -50,16 +50,18 @@
 #define ACCEPT_ENCODING "Accept-Encoding: gzip\r\n"
 #define possible_gzip_response(pb)                                             \
     if ((pb)->data_compressed == compressionGZIP) {                            \
-        pbres                 = pbgzip_decompress(pb);                         \
+        pbres                 = pbgzip_inflate_finish(pb);                     \
         (pb)->data_compressed = compressionNONE;                               \
         if (PNR_OK != pbres) {                                                 \
             outcome_detected((pb), pbres);                                     \
             return pbres;                                                      \
         }                                                                      \
     }
+#define is_gzip_body(pb) ((pb)->data_compressed == compressionGZIP)
 #else
 #define ACCEPT_ENCODING ""
 #define possible_gzip_response(pb)
+#define is_gzip_body(pb) false
 #endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
 
 bool HTTP_request_has_body(uint8_t method)
@@ -107,18 +109,240 @@ static char const* get_method_verb_string(uint8_t method)
     }
 }
 
+static int print_fin_head(char* s, size_t n)
+{
+    return snprintf(s,
+                    n,
+                    "\r\nUser-Agent: %s%s",
+                    pubnub_uagent(),
+                    "\r\n" ACCEPT_ENCODING "\r\n");
+}
+
+
 static int send_fin_head(struct pubnub_* pb)
 {
     char s[200];
-    snprintf(s,
-             sizeof s,
-             "\r\nUser-Agent: %s%s",
-             pubnub_uagent(),
-             "\r\n" ACCEPT_ENCODING "\r\n");
+    print_fin_head(s, sizeof s);
     return pbpal_send_str(pb, s);
 }
 
 
+static size_t body_length(struct pubnub_* pb)
+{
+#if PUBNUB_USE_GZIP_COMPRESSION
+    return (pb->core.gzip_msg_len != 0) ? pb->core.gzip_msg_len
+                                        : strlen(pb->core.message_to_send);
+#else
+    return strlen(pb->core.message_to_send);
+#endif
+}
+
+
+#if PUBNUB_USE_VECTORED_SEND
+/** Sends the whole HTTP request - request line, headers and body -
+    with one pbpal_sendv(), rather than piece by piece, each with its
+    own pbpal_send(). This makes for a lot less system calls (and TLS
+    records).
+ */
+static int send_request_vectored(struct pubnub_* pb)
+{
+    struct pbpal_iovec vec[PUBNUB_SENDV_MAX];
+    char const*        verb     = get_method_verb_string(pb->method);
+    char const*        o        = PUBNUB_ORIGIN_SETTABLE ? pb->origin : PUBNUB_ORIGIN;
+    bool               has_body = HTTP_request_has_body(pb->method);
+    size_t             n        = 0;
+    size_t             hlen     = 0;
+    int                i;
+
+    vec[n].base   = verb;
+    vec[n++].len  = strlen(verb);
+    vec[n].base   = pb->core.http_buf;
+    vec[n++].len  = strlen(pb->core.http_buf);
+    vec[n].base   = " HTTP/1.1\r\nHost: ";
+    vec[n++].len  = sizeof " HTTP/1.1\r\nHost: " - 1;
+    vec[n].base   = o;
+    vec[n++].len  = strlen(o);
+    if (has_body) {
+        memcpy(pb->tx_headers, "\r\n", 2);
+        hlen = 2
+               + pbcc_via_post_headers(
+                   &(pb->core), pb->tx_headers + 2, sizeof pb->tx_headers - 2);
+    }
+    i = print_fin_head(pb->tx_headers + hlen, sizeof pb->tx_headers - hlen);
+    if ((i < 0) || ((size_t)i >= sizeof pb->tx_headers - hlen)) {
+        PUBNUB_LOG_ERROR("pb=%p: HTTP headers too long for vectored send\n", pb);
+        return -1;
+    }
+    vec[n].base  = pb->tx_headers;
+    vec[n++].len = hlen + i;
+    if (has_body) {
+        vec[n].base  = pb->core.message_to_send;
+        vec[n++].len = body_length(pb);
+    }
+    PUBNUB_ASSERT_OPT(n <= PUBNUB_SENDV_MAX);
+
+    return pbpal_sendv(pb, vec, n);
+}
+#endif /* PUBNUB_USE_VECTORED_SEND */
+
+
+#if PUBNUB_USE_PUBLISH_QUEUE
+/** Returns whether @p trans publishes messages with pipelined
+    requests, from the publish queue or a publish batch.
+ */
+static bool is_publish_pipeline(enum pubnub_trans trans)
+{
+#if PUBNUB_USE_PUBLISH_BATCH
+    if (PBTT_PUBLISH_BATCH == trans) {
+        return true;
+    }
+#endif
+    return PBTT_PUBLISH_QUEUE == trans;
+}
+
+
+/** Starts sending the next "window" of publish requests from the
+    publish queue (or batch), back to back, with one pbpal_send().
+    Responses are matched to requests in order, in finish(). Without
+    HTTP keep-alive, or via a proxy, we don't pipeline, but send just
+    one request, the usual way, as the connection is closed after the
+    first response.
+ */
+static int start_sending_publish_pipeline(struct pubnub_* pb)
+{
+    char const* o        = PUBNUB_ORIGIN_SETTABLE ? pb->origin : PUBNUB_ORIGIN;
+    size_t      olen     = strlen(o);
+    char const* verb     = get_method_verb_string(pb->method);
+    size_t      verblen  = strlen(verb);
+    bool        has_body = HTTP_request_has_body(pb->method);
+    bool        pipeline = pb->options.use_http_keep_alive;
+    unsigned    window   = pbpq_window_size(pb);
+    size_t      len      = 0;
+    unsigned    n        = 0;
+    char        fin_head[200];
+    int         fin_len;
+
+#if PUBNUB_PROXY_API
+    pipeline = pipeline && (pbproxyNONE == pb->proxy_type);
+#endif
+    fin_len = print_fin_head(fin_head, sizeof fin_head);
+    if ((fin_len < 0) || ((size_t)fin_len >= sizeof fin_head)) {
+        return -1;
+    }
+    while (n < window) {
+        struct pbpq_item item;
+        enum pubnub_res  rslt;
+        char             headers[100];
+        size_t           hlen    = 0;
+        size_t           bodylen = 0;
+        size_t           need;
+        char*            s;
+
+        pbpq_peek(pb, n, &item);
+#if PUBNUB_USE_GZIP_COMPRESSION
+        pb->core.gzip_msg_len = 0;
+#endif
+        rslt = pbcc_publish_prep(&pb->core,
+                                 item.channel,
+                                 item.message,
+                                 true,
+                                 false,
+                                 item.meta,
+                                 (enum pubnub_method)pb->method);
+        if (rslt != PNR_STARTED) {
+            if (n > 0) {
+                break;
+            }
+            /* We checked the length before, so this is unlikely,
+               but, don't let one message stall the queue.
+             */
+            PUBNUB_LOG_ERROR("pb=%p: can't publish queued message, error %d\n",
+                             pb,
+                             rslt);
+            pbpq_pop(pb, rslt);
+            window = pbpq_window_size(pb);
+            continue;
+        }
+        if (!pipeline) {
+            pb->publish_queue.in_flight = 1;
+            pb->state                   = PBS_TX_GET;
+            return pbpal_send_str(pb, verb);
+        }
+        if (has_body) {
+            memcpy(headers, "\r\n", 2);
+            hlen = 2
+                   + pbcc_via_post_headers(
+                       &pb->core, headers + 2, sizeof headers - 2);
+            bodylen = body_length(pb);
+        }
+        need = len + verblen + pb->core.http_buf_len
+               + (sizeof " HTTP/1.1\r\nHost: " - 1) + olen + hlen + fin_len
+               + bodylen;
+        s = pbpq_reserve(pb, need);
+        if (NULL == s) {
+            if (n > 0) {
+                break;
+            }
+            return -1;
+        }
+        s += len;
+        memcpy(s, verb, verblen);
+        s += verblen;
+        memcpy(s, pb->core.http_buf, pb->core.http_buf_len);
+        s += pb->core.http_buf_len;
+        memcpy(s, " HTTP/1.1\r\nHost: ", sizeof " HTTP/1.1\r\nHost: " - 1);
+        s += sizeof " HTTP/1.1\r\nHost: " - 1;
+        memcpy(s, o, olen);
+        s += olen;
+        memcpy(s, headers, hlen);
+        s += hlen;
+        memcpy(s, fin_head, fin_len);
+        s += fin_len;
+        memcpy(s, pb->core.message_to_send, bodylen);
+        len = need;
+        ++n;
+    }
+    if (0 == n) {
+        return -1;
+    }
+    PUBNUB_LOG_TRACE("pb=%p: pipelining %u publish requests, %lu octets\n",
+                     pb,
+                     n,
+                     (unsigned long)len);
+    pb->publish_queue.in_flight = n;
+    pb->state                   = PBS_TX_BODY;
+
+    return pbpal_send(pb, pb->publish_queue.txbuf, len);
+}
+#endif /* PUBNUB_USE_PUBLISH_QUEUE */
+
+
+/** Starts sending the HTTP request, either all at once, or, if not
+    possible, piece by piece, as the FSM goes through PBS_TX_xxx
+    states.
+ */
+static int start_sending_request(struct pubnub_* pb)
+{
+#if PUBNUB_USE_PUBLISH_QUEUE
+    if (is_publish_pipeline(pb->trans)) {
+        return start_sending_publish_pipeline(pb);
+    }
+#endif
+#if PUBNUB_USE_VECTORED_SEND
+#if PUBNUB_PROXY_API
+    /* Proxies need extra (negotiation) steps, so don't bother */
+    if (pbproxyNONE == pb->proxy_type)
+#endif
+    {
+        pb->state = PBS_TX_BODY;
+        return send_request_vectored(pb);
+    }
+#endif
+    pb->state = PBS_TX_GET;
+    return pbpal_send_str(pb, get_method_verb_string(pb->method));
+}
+
+
 #define SEND_FIN_HEAD(pb)                                                      \
     if (0 > send_fin_head(pb)) {                                               \
         outcome_detected(pb, PNR_IO_ERROR);                                    \
@@ -311,6 +535,12 @@ static PFpbcc_parse_response_T m_aParseResponse[] = { dont_parse,
     , pbcc_parse_history_with_actions_response /* PBTT_HISTORY_WITH_ACTIONS */
 #endif /* PUBNUB_USE_OBJECTS_API */
 #endif /* PUBNUB_ONLY_PUBSUB_API */
+#if PUBNUB_USE_PUBLISH_QUEUE
+    , pbcc_parse_publish_response /* PBTT_PUBLISH_QUEUE */
+#endif
+#if PUBNUB_USE_PUBLISH_BATCH
+    , pbcc_parse_publish_response /* PBTT_PUBLISH_BATCH */
+#endif
 };
 
 
@@ -320,7 +550,11 @@ PUBNUB_STATIC_ASSERT((sizeof m_aParseResponse / sizeof m_aParseResponse[0]) == P
 
 static enum pubnub_res parse_pubnub_result(struct pubnub_* pb)
 {
-    enum pubnub_res pbres = m_aParseResponse[pb->trans](&pb->core);
+    enum pubnub_res pbres;
+
+    /* The (pooled) reply buffer may be the same, but not the reply */
+    pbcc_invalidate_reply_tape(&pb->core);
+    pbres = m_aParseResponse[pb->trans](&pb->core);
     if (pbres != PNR_OK) {
         PUBNUB_LOG_WARNING("pb=%p parsing response for transaction type #%d "
                            "returned error %d\nResponse was: %s\n",
@@ -334,6 +568,49 @@ static enum pubnub_res parse_pubnub_result(struct pubnub_* pb)
 }
 
 
+#if PUBNUB_USE_PUBLISH_QUEUE
+/** Handles the response to a (pipelined) request from the publish
+    queue (or batch). If there are more responses to read, or more messages to
+    publish, the transaction goes on (and we return PNR_STARTED).
+ */
+static enum pubnub_res finish_publish_queue(struct pubnub_* pb, enum pubnub_res pbres)
+{
+    pbpq_pop(pb, pbres);
+    if (pb->flags.should_close) {
+        /* The connection will be closed, so we won't read the
+           responses to the other pipelined requests. They may have
+           been published, so don't send them again, but fail them.
+        */
+        while (pb->publish_queue.in_flight > 0) {
+            PUBNUB_LOG_WARNING("pb=%p: connection closed before the response "
+                               "to a pipelined publish\n",
+                               pb);
+            pbpq_pop(pb, PNR_IO_ERROR);
+        }
+    }
+    else {
+        if (pb->publish_queue.in_flight > 0) {
+            pbpal_start_read_line(pb);
+            pb->state = PBS_RX_HTTP_VER;
+            return PNR_STARTED;
+        }
+        if (pbpq_pending(pb) > 0) {
+            pbntf_start_transaction_timer(pb);
+            if (start_sending_publish_pipeline(pb) < 0) {
+                outcome_detected(pb, PNR_IO_ERROR);
+                return PNR_IO_ERROR;
+            }
+            return PNR_STARTED;
+        }
+    }
+    pbres = pbpq_outcome(pb);
+    outcome_detected(pb, pbres);
+
+    return pbres;
+}
+#endif /* PUBNUB_USE_PUBLISH_QUEUE */
+
+
 static enum pubnub_res finish(struct pubnub_* pb)
 {
     enum pubnub_res pbres;
@@ -373,6 +650,11 @@ static enum pubnub_res finish(struct pubnub_* pb)
     if ((PNR_OK == pbres) && ((pb->http_code / 100) != 2)) {
         pbres = PNR_HTTP_ERROR;
     }
+#if PUBNUB_USE_PUBLISH_QUEUE
+    if (is_publish_pipeline(pb->trans)) {
+        return finish_publish_queue(pb, pbres);
+    }
+#endif
 
     outcome_detected(pb, pbres);
     return pbres;
@@ -480,6 +762,24 @@ static void initialize_fields_in_state_IDLE(struct pubnub_* pb)
 #endif
 }
 
+/** Puts the @p len octets of the body that were read (to the HTTP
+    buffer) into the reply buffer. A gzip body is inflated as it is
+    read, so we don't have to keep it all to inflate it at the end.
+ */
+static enum pubnub_res put_read_body(struct pubnub_* pb, unsigned len)
+{
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+    if (is_gzip_body(pb)) {
+        return pbgzip_inflate(pb, (uint8_t const*)pb->core.http_buf, len);
+    }
+#endif
+    memcpy(pb->core.http_reply + pb->core.http_buf_len, pb->core.http_buf, len);
+    pb->core.http_buf_len += len;
+
+    return PNR_OK;
+}
+
+
 int pbnc_fsm(struct pubnub_* pb)
 {
     enum pubnub_res pbrslt;
@@ -713,24 +1013,22 @@ next_state:
             }
         }
 #endif /* PUBNUB_USE_SSL */
-        i = pbpal_send_str(pb, get_method_verb_string(pb->method));
+        i = start_sending_request(pb);
         if (i < 0) {
             outcome_detected(pb, PNR_IO_ERROR);
             break;
         }
-        pb->state = PBS_TX_GET;
         goto next_state;
 #if PUBNUB_USE_SSL
     case PBS_WAIT_TLS_CONNECT: {
         enum pbpal_tls_result res = pbpal_check_tls(pb);
         switch (res) {
         case pbtlsEstablished:
-            i = pbpal_send_str(pb, get_method_verb_string(pb->method));
+            i = start_sending_request(pb);
             if (i < 0) {
                 outcome_detected(pb, PNR_IO_ERROR);
                 break;
             }
-            pb->state = PBS_TX_GET;
             goto next_state;
         case pbtlsStarted:
             break;
@@ -982,15 +1280,8 @@ next_state:
                 && (pb->proxy_tunnel_established || (pbproxyNONE == pb->proxy_type))
 #endif
             ) {
-                const char* message = pb->core.message_to_send;
-#if PUBNUB_USE_GZIP_COMPRESSION
-                size_t len = (pb->core.gzip_msg_len != 0) ? pb->core.gzip_msg_len
-                                                          : strlen(message);
-#else
-                size_t len = strlen(message);
-#endif
                 pb->state = PBS_TX_BODY;
-                if (-1 == pbpal_send(pb, message, len)) {
+                if (-1 == pbpal_send(pb, pb->core.message_to_send, body_length(pb))) {
                     outcome_detected(pb, PNR_IO_ERROR);
                     break;
                 }
@@ -1022,6 +1313,13 @@ next_state:
         case PNR_IN_PROGRESS:
             break;
         case PNR_OK:
+            if (pbpal_read_len(pb) <= 2) {
+                /* An empty line, like the CRLF that ends the last
+                   chunk of the previous (pipelined) response, skip it.
+                */
+                pbpal_start_read_line(pb);
+                goto next_state;
+            }
             if (strncmp(pb->core.http_buf, "HTTP/1.", 7) != 0) {
                 PUBNUB_LOG_ERROR("pb=%p bad HTTP response version: %.*s\n",
                                  pb,
@@ -1034,7 +1332,11 @@ next_state:
             WATCH_USHORT(pb->http_code);
             pb->core.http_content_len = 0;
             pb->http_chunked          = false;
-            pb->state                 = PBS_RX_HEADERS;
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+            /* In case the previous response was not finished */
+            pb->data_compressed = compressionNONE;
+#endif
+            pb->state = PBS_RX_HEADERS;
             goto next_state;
         case PNR_CONNECTION_TIMEOUT:
         case PNR_TIMEOUT:
@@ -1103,6 +1405,16 @@ next_state:
                 else {
                     pb->state = PBS_RX_CHUNK_LEN;
                 }
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+                if (is_gzip_body(pb)) {
+                    enum pubnub_res res = pbgzip_inflate_start(
+                        pb, pb->http_chunked ? 0 : pb->core.http_content_len);
+                    if (res != PNR_OK) {
+                        outcome_detected(pb, res);
+                        break;
+                    }
+                }
+#endif
                 goto next_state;
             }
             if (strncmp(pb->core.http_buf, h_chunked, sizeof h_chunked - 1) == 0) {
@@ -1147,19 +1459,34 @@ next_state:
         }
         break;
     case PBS_RX_BODY:
-        if (pb->core.http_buf_len < pb->core.http_content_len) {
+        if (is_gzip_body(pb)) {
+            /* Here, the content length is what's left to read of
+               the gzip body, as it is inflated while being read */
+            if (pb->core.http_content_len > 0) {
+                pbpal_start_read(pb, pb->core.http_content_len);
+                pb->state = PBS_RX_BODY_WAIT;
+                goto next_state;
+            }
+        }
+        else if (pb->core.http_buf_len < pb->core.http_content_len) {
+#if PUBNUB_USE_ZERO_COPY_RECEIVE
+            pbpal_start_read_into(pb,
+                                  pb->core.http_reply + pb->core.http_buf_len,
+                                  pb->core.http_content_len - pb->core.http_buf_len);
+#else
             pbpal_start_read(pb, pb->core.http_content_len - pb->core.http_buf_len);
+#endif
             pb->state = PBS_RX_BODY_WAIT;
             goto next_state;
         }
-        else {
-            finish(pb);
+        if (PNR_STARTED == finish(pb)) {
+            goto next_state;
+        }
 #if PUBNUB_PROXY_API
-            if (pb->flags.retry_after_close) {
-                goto next_state;
-            }
-#endif
+        if (pb->flags.retry_after_close) {
+            goto next_state;
         }
+#endif
         break;
     case PBS_RX_BODY_WAIT:
         pbrslt = pbpal_read_status(pb);
@@ -1168,13 +1495,31 @@ next_state:
         case PNR_IN_PROGRESS:
             break;
         case PNR_OK: {
-            unsigned len = pbpal_read_len(pb);
+            unsigned len;
+#if PUBNUB_USE_ZERO_COPY_RECEIVE
+            if (!is_gzip_body(pb)) {
+                /* The whole body was read, right to the reply buffer */
+                pb->core.http_buf_len = pb->core.http_content_len;
+                pb->state             = PBS_RX_BODY;
+                goto next_state;
+            }
+#endif
+            len = pbpal_read_len(pb);
             WATCH_UINT(len);
             WATCH_SIZE_T(pb->core.http_buf_len);
-            PUBNUB_ASSERT_OPT(pb->core.http_buf_len + len
-                              <= pb->core.http_content_len);
-            memcpy(pb->core.http_reply + pb->core.http_buf_len, pb->core.http_buf, len);
-            pb->core.http_buf_len += len;
+            if (is_gzip_body(pb)) {
+                PUBNUB_ASSERT_OPT(len <= pb->core.http_content_len);
+                pb->core.http_content_len -= len;
+            }
+            else {
+                PUBNUB_ASSERT_OPT(pb->core.http_buf_len + len
+                                  <= pb->core.http_content_len);
+            }
+            pbrslt = put_read_body(pb, len);
+            if (pbrslt != PNR_OK) {
+                outcome_detected(pb, pbrslt);
+                break;
+            }
             pb->state = PBS_RX_BODY;
             goto next_state;
         }
@@ -1198,16 +1543,19 @@ next_state:
 
             PUBNUB_LOG_TRACE("About to read a chunk w/length: %u\n", chunk_length);
             if (chunk_length == 0) {
-                finish(pb);
+                if (PNR_STARTED == finish(pb)) {
+                    goto next_state;
+                }
 #if PUBNUB_PROXY_API
                 if (pb->flags.retry_after_close) {
                     goto next_state;
                 }
 #endif
             }
-            else if (0
-                     != pbcc_realloc_reply_buffer(
-                            &pb->core, pb->core.http_buf_len + chunk_length)) {
+            else if (!is_gzip_body(pb)
+                     && (0
+                         != pbcc_realloc_reply_buffer(
+                                &pb->core, pb->core.http_buf_len + chunk_length))) {
                 outcome_detected(pb, PNR_REPLY_TOO_BIG);
             }
             else {
@@ -1223,6 +1571,18 @@ next_state:
         }
         break;
     case PBS_RX_BODY_CHUNK:
+#if PUBNUB_USE_ZERO_COPY_RECEIVE
+        /* Chunk data is read right to the reply buffer, the trailing
+           CRLF to our buffer. Gzip chunks are read to our buffer and
+           inflated from there. */
+        if (!is_gzip_body(pb) && (pb->core.http_content_len > CHUNK_TRAIL_LENGTH)) {
+            pbpal_start_read_into(pb,
+                                  pb->core.http_reply + pb->core.http_buf_len,
+                                  pb->core.http_content_len - CHUNK_TRAIL_LENGTH);
+            pb->state = PBS_RX_BODY_CHUNK_WAIT;
+        }
+        else
+#endif
         if (pb->core.http_content_len > 0) {
             pbpal_start_read(pb, pb->core.http_content_len);
             pb->state = PBS_RX_BODY_CHUNK_WAIT;
@@ -1238,8 +1598,16 @@ next_state:
         case PNR_IN_PROGRESS:
             break;
         case PNR_OK: {
-            unsigned len = pbpal_read_len(pb);
-
+            unsigned len;
+#if PUBNUB_USE_ZERO_COPY_RECEIVE
+            if (!is_gzip_body(pb) && (pb->core.http_content_len > CHUNK_TRAIL_LENGTH)) {
+                pb->core.http_buf_len += pb->core.http_content_len - CHUNK_TRAIL_LENGTH;
+                pb->core.http_content_len = CHUNK_TRAIL_LENGTH;
+                pb->state                 = PBS_RX_BODY_CHUNK;
+                goto next_state;
+            }
+#endif
+            len = pbpal_read_len(pb);
             PUBNUB_ASSERT_OPT(pb->core.http_content_len >= len);
             PUBNUB_ASSERT_OPT(len > 0);
 
@@ -1248,10 +1616,11 @@ next_state:
                 if (len < to_copy) {
                     to_copy = len;
                 }
-                memcpy(pb->core.http_reply + pb->core.http_buf_len,
-                       pb->core.http_buf,
-                       to_copy);
-                pb->core.http_buf_len += to_copy;
+                pbrslt = put_read_body(pb, to_copy);
+                if (pbrslt != PNR_OK) {
+                    outcome_detected(pb, pbrslt);
+                    break;
+                }
             }
             pb->core.http_content_len -= len;
             pb->state = PBS_RX_BODY_CHUNK;
@@ -1319,8 +1688,7 @@ next_state:
             pbntf_trans_outcome(pb, PBS_IDLE);
             break;
         }
-        pb->state = PBS_TX_GET;
-        i = pbpal_send_str(pb, get_method_verb_string(pb->method));
+        i = start_sending_request(pb);
         if (i < 0) {
             pb->state = close_kept_alive_connection(pb);
         }
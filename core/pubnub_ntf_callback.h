@@ -78,5 +78,23 @@ pubnub_callback_t pubnub_get_callback(pubnub_t *pb);
  */
 void pubnub_stop(void);
 
+/** Sets the number of "socket watcher" threads to use. Each of these
+    threads has its own poll-set, timer list and processing queue, and
+    each Pubnub context is always handled by the same thread. So, with
+    many contexts, processing (including TLS handshakes and
+    decompression) is spread over @p n threads (cores), instead of
+    running on one.
+
+    Must be called before the first pubnub_init(), as that's when the
+    threads are started. Not all platforms support more than one
+    thread.
+
+    @param n The number of threads, 1 (the default) up to
+    #PUBNUB_CALLBACK_THREADS_MAX
+    @retval 0 success
+    @retval -1 @p n out of range, not supported, or threads already started
+ */
+int pubnub_set_callback_threads(unsigned n);
+
 #endif /* !defined INC_PUBNUB_NTF_CALLBACK */
 
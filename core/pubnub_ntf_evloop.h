@@ -0,0 +1,120 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_NTF_EVLOOP
+#define      INC_PUBNUB_NTF_EVLOOP
+
+
+#include "pubnub_api_types.h"
+
+
+/** @file pubnub_ntf_evloop.h
+
+    This is the "external event loop" flavour of the callback
+    interface. It's the same callback interface (you register a
+    callback with pubnub_register_callback() and it gets called with
+    the outcome of the transaction), but there is no socket watcher
+    thread. Instead, the application's own event loop (a plain
+    `epoll`/`kqueue` loop, libuv, asio...) watches the sockets of the
+    Pubnub contexts and the timers and "drives" the contexts.
+
+    To do that, the application:
+
+    - sets the hooks with pubnub_set_evloop_hooks(), through which it
+      will be told what sockets to watch, for which events, and by
+      when it should call pubnub_process_timeout()
+
+    - calls pubnub_process_io() when an event happens on a socket of
+      a context
+
+    - calls pubnub_process_timeout() when the deadline it was told
+      about expires (calling it earlier is harmless)
+
+    All the callbacks (transaction outcome and hooks) are called from
+    pubnub_process_io() and pubnub_process_timeout(), except that the
+    hooks may also be called from a Pubnub API function (say,
+    pubnub_cancel()) - from the thread that called it. The functions
+    pubnub_process_io() and pubnub_process_timeout() must always be
+    called from the same thread (the one running the event loop).
+ */
+
+
+/** The events on a socket, as a bitmask */
+enum pubnub_evloop_events {
+    /** Socket can be read from (without blocking) */
+    pbevlIN  = 0x01,
+    /** Socket can be written to (without blocking) */
+    pbevlOUT = 0x02,
+    /** An error or hang-up on the socket */
+    pbevlERR = 0x04
+};
+
+
+/** The hooks through which the Pubnub library tells the event loop
+    what to do. The hooks should not block, and may not call
+    pubnub_process_io() or pubnub_process_timeout(). Every hook gets
+    the `user_data` that was given to pubnub_set_evloop_hooks().
+ */
+struct pubnub_evloop_hooks {
+    /** Start watching the (native) socket @p fd of the context @p pb
+        for @p events (a bitmask of #pubnub_evloop_events).
+        @return 0: OK, -1: failed, will fail the transaction
+     */
+    int (*add_socket)(pubnub_t* pb, int fd, int events, void* user_data);
+    /** Change the @p events to watch for on the socket @p fd of the
+        context @p pb.
+        @return 0: OK, -1: failed
+     */
+    int (*modify_socket)(pubnub_t* pb, int fd, int events, void* user_data);
+    /** Stop watching the socket @p fd of the context @p pb. The
+        socket may already be closed at this point.
+     */
+    void (*remove_socket)(pubnub_t* pb, int fd, void* user_data);
+    /** The nearest deadline changed: call pubnub_process_timeout() in
+        at most @p timeout_ms milliseconds. A @p timeout_ms of 0 means
+        there is work to do "right away".
+     */
+    void (*set_deadline)(int timeout_ms, void* user_data);
+};
+
+
+/** Sets the hooks through which the library talks to the event
+    loop. Has to be called before the first pubnub_init(), as it's
+    not synchronized with the use of the hooks. The @p hooks are
+    copied.
+
+    @param hooks The hooks to use, can't be NULL
+    @param user_data Pointer that will be given to the hooks
+    @retval 0 OK
+    @retval -1 @p hooks is NULL
+ */
+int pubnub_set_evloop_hooks(struct pubnub_evloop_hooks const* hooks, void* user_data);
+
+
+/** Handles the @p events that happened on the socket of the context
+    @p pb. Drives the context, which may end its transaction (and call
+    the callback).
+
+    @param pb The context whose socket has @p events
+    @param events A bitmask of #pubnub_evloop_events
+ */
+void pubnub_process_io(pubnub_t* pb, int events);
+
+
+/** Handles all the expired timers (transactions that timed out) and
+    any other pending work (say, a transaction that was started).
+
+    @return Milliseconds until the next call of this function should
+    be made, or -1 if there is no deadline (until set_deadline hook is
+    called)
+ */
+int pubnub_process_timeout(void);
+
+
+/** Returns the number of milliseconds until pubnub_process_timeout()
+    should be called, or -1 if there is no deadline. Useful for event
+    loops that compute the poll timeout on every iteration, instead of
+    keeping the timer set by the set_deadline hook.
+ */
+int pubnub_evloop_next_timeout_ms(void);
+
+
+#endif /* !defined INC_PUBNUB_NTF_EVLOOP */
@@ -10,6 +10,12 @@
 
 #include "lib/msstopwatch/msstopwatch.h"
 
+#include <stdlib.h>
+
+#if PUBNUB_SYNC_AWAIT_ON_SOCKET
+#include "lib/sockets/pbpal_socket_blocking_io.h"
+#endif
+
 
 int pbntf_init(void)
 {
@@ -59,7 +65,8 @@ void pbntf_trans_outcome(pubnub_t* pb, enum pubnub_state state)
 
 int pbntf_enqueue_for_processing(pubnub_t* pb)
 {
-    PUBNUB_UNUSED(pb);
+    /* A transaction is starting */
+    pb->trans_started = pbms_start();
     return 0;
 }
 
@@ -102,6 +109,95 @@ enum pubnub_res pubnub_last_result(pubnub_t* pb)
 }
 
 
+#if PUBNUB_SYNC_AWAIT_ON_SOCKET
+/** Returns whether the FSM of @p pb, in its current state, waits for
+    its socket to become writable. Otherwise, if it waits for the
+    socket at all, it waits for it to become readable.
+ */
+static bool waits_to_send(pubnub_t const* pb)
+{
+    switch (pb->state) {
+    case PBS_WAIT_DNS_SEND:
+    case PBS_WAIT_CONNECT:
+    case PBS_TX_GET:
+    case PBS_TX_PATH:
+    case PBS_TX_SCHEME:
+    case PBS_TX_HOST:
+    case PBS_TX_PORT_NUM:
+    case PBS_TX_VER:
+    case PBS_TX_EXTRA_HEADERS:
+    case PBS_TX_ORIGIN:
+    case PBS_TX_FIN_HEAD:
+    case PBS_TX_BODY:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+/** Returns whether the FSM of @p pb, in its current state, waits for
+    (some) I/O on its socket, rather than "just" having to be called
+    again.
+ */
+static bool waits_for_socket(pubnub_t const* pb)
+{
+    switch (pb->state) {
+    case PBS_IDLE:
+    case PBS_RETRY:
+    case PBS_READY:
+    case PBS_CONNECTED:
+    case PBS_WAIT_CANCEL:
+    case PBS_KEEP_ALIVE_IDLE:
+    case PBS_KEEP_ALIVE_READY:
+        return false;
+    default:
+        /* Data we already received has to be handled first */
+        return 0 == pb->unreadlen;
+    }
+}
+
+
+/** Returns the socket on which to wait for the FSM of @p pb to be
+    able to do the I/O it wants to do, or SOCKET_INVALID if we can't
+    (or shouldn't) wait.
+ */
+static pbpal_native_socket_t socket_to_wait_on(pubnub_t* pb)
+{
+#if PUBNUB_BLOCKING_IO_SETTABLE
+    if (pb->options.use_blocking_io) {
+        /* The FSM will block in reading/writing, nothing to do */
+        return SOCKET_INVALID;
+    }
+#endif
+    if (!waits_for_socket(pb)) {
+        return SOCKET_INVALID;
+    }
+    return pubnub_get_native_socket(pb);
+}
+
+
+/** Waits, for at most @p timeout_ms milliseconds, for the I/O that
+    the FSM of @p pb is waiting for to be possible - if it is waiting
+    for any, and we can tell.
+ */
+static void wait_for_io(pubnub_t* pb, pbms_t timeout_ms)
+{
+    pbpal_native_socket_t const socket = socket_to_wait_on(pb);
+
+    if (SOCKET_INVALID == socket) {
+        return;
+    }
+    PUBNUB_LOG_TRACE("pubnub_await(pb=%p): waiting for socket to become %s, "
+                     "for at most %ld ms\n",
+                     pb,
+                     waits_to_send(pb) ? "writable" : "readable",
+                     (long)timeout_ms);
+    pbpal_wait_socket_io(socket, waits_to_send(pb), (int)timeout_ms);
+}
+#endif /* PUBNUB_SYNC_AWAIT_ON_SOCKET */
+
+
 enum pubnub_res pubnub_await(pubnub_t* pb)
 {
     pbmsref_t       t0;
@@ -114,6 +210,9 @@ enum pubnub_res pubnub_await(pubnub_t* pb)
     t0 = pbms_start();
     while (!pbnc_can_start_transaction(pb)) {
         pbms_t delta;
+#if PUBNUB_SYNC_AWAIT_ON_SOCKET
+        enum pubnub_state const state_before = pb->state;
+#endif
 
         pbnc_fsm(pb);
 
@@ -128,9 +227,188 @@ enum pubnub_res pubnub_await(pubnub_t* pb)
                 break;
             }
         }
+#if PUBNUB_SYNC_AWAIT_ON_SOCKET
+        else if ((state_before == pb->state) && !pbnc_can_start_transaction(pb)) {
+            /* The FSM didn't get anywhere, so it has to wait for I/O,
+               or for the transaction to time out, whichever comes first.
+             */
+            wait_for_io(pb, pb->transaction_timeout_ms - delta + 1);
+        }
+#endif
     }
     result = pb->core.last_result;
     pubnub_mutex_unlock(pb->monitor);
 
     return result;
 }
+
+
+#if PUBNUB_SYNC_AWAIT_ON_SOCKET
+/** Up to this many contexts, pubnub_await_any() doesn't allocate
+    memory for the sockets to wait on */
+#define AWAIT_ANY_STACK_CONTEXTS 16
+#endif
+
+
+/** What is to be done with a context in pubnub_await_any() */
+enum await_any_step {
+    /** Not in a transaction, nothing to do */
+    aasIdle,
+    /** The transaction ended (or we gave up on it) */
+    aasDone,
+    /** Wait for I/O on the socket, then drive the FSM again */
+    aasWaitIO,
+    /** Drive the FSM again, without waiting */
+    aasAgain
+};
+
+
+/** Does one step of awaiting the end of the transaction on the
+    context @p pb for pubnub_await_any(): drives its FSM (if @p drive)
+    and observes its transaction timeout. Reduces @p wait_ms to the
+    time the transaction has left. Has to be called with @p pb locked.
+ */
+static enum await_any_step await_any_step(pubnub_t* pb, bool drive, pbms_t* wait_ms)
+{
+    enum pubnub_state const state_before = pb->state;
+    pbms_t                  left;
+
+    if (pbnc_can_start_transaction(pb)) {
+        return aasIdle;
+    }
+    if (drive) {
+        pbnc_fsm(pb);
+        if (pbnc_can_start_transaction(pb)) {
+            return aasDone;
+        }
+    }
+    left = pb->transaction_timeout_ms - pbms_elapsed(pb->trans_started);
+    if (left < 0) {
+        if (PNR_STARTED == pb->core.last_result) {
+            pbnc_stop(pb, PNR_TIMEOUT);
+            return pbnc_can_start_transaction(pb) ? aasDone : aasAgain;
+        }
+        /* Like pubnub_await(), give the stopped transaction another
+           timeout period to finish, then give up on it.
+         */
+        left += pb->transaction_timeout_ms;
+        if (left < 0) {
+            return aasDone;
+        }
+    }
+    if (left < *wait_ms) {
+        *wait_ms = left + 1;
+    }
+
+    return (drive && (state_before != pb->state)) ? aasAgain : aasWaitIO;
+}
+
+
+int pubnub_await_any(pubnub_t** ctxs, size_t n, int timeout_ms)
+{
+    pbmsref_t const t0    = pbms_start();
+    bool            first = true;
+    int             rslt  = -1;
+#if PUBNUB_SYNC_AWAIT_ON_SOCKET
+    struct pbpal_socket_wait     on_stack[AWAIT_ANY_STACK_CONTEXTS];
+    struct pbpal_socket_wait*    waits    = on_stack;
+    struct pbpal_socket_wait_mem wait_mem = { NULL, 0 };
+#endif
+
+    PUBNUB_ASSERT_OPT((ctxs != NULL) || (0 == n));
+    if (0 == n) {
+        return -1;
+    }
+#if PUBNUB_SYNC_AWAIT_ON_SOCKET
+    if (n > AWAIT_ANY_STACK_CONTEXTS) {
+        waits = (struct pbpal_socket_wait*)malloc(n * sizeof waits[0]);
+    }
+    if (NULL == waits) {
+        PUBNUB_LOG_WARNING("pubnub_await_any(): failed to allocate, will "
+                           "not wait for I/O\n");
+    }
+#endif
+    for (;;) {
+        size_t i;
+        size_t active   = 0;
+        bool   can_wait = true;
+        pbms_t wait_ms  = (timeout_ms < 0) ? INT32_MAX : timeout_ms - pbms_elapsed(t0);
+
+        for (i = 0; (i < n) && (rslt < 0); ++i) {
+            pubnub_t* pb    = ctxs[i];
+            bool      drive = first;
+
+#if PUBNUB_SYNC_AWAIT_ON_SOCKET
+            if (waits != NULL) {
+                drive = drive || waits[i].ready || (SOCKET_INVALID == waits[i].socket);
+                waits[i].socket = SOCKET_INVALID;
+            }
+            else {
+                drive = true;
+            }
+#else
+            drive = true;
+#endif
+            if (NULL == pb) {
+                continue;
+            }
+            PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+            pubnub_mutex_lock(pb->monitor);
+            switch (await_any_step(pb, drive, &wait_ms)) {
+            case aasIdle:
+                break;
+            case aasDone:
+                rslt = (int)i;
+                break;
+            case aasAgain:
+                ++active;
+                can_wait = false;
+                break;
+            case aasWaitIO:
+                ++active;
+#if PUBNUB_SYNC_AWAIT_ON_SOCKET
+                if (waits != NULL) {
+                    waits[i].socket = socket_to_wait_on(pb);
+                    waits[i].out    = waits_to_send(pb);
+                    waits[i].ready  = 0;
+                }
+                if ((NULL == waits) || (SOCKET_INVALID == waits[i].socket)) {
+                    can_wait = false;
+                }
+#else
+                can_wait = false;
+#endif
+                break;
+            }
+            pubnub_mutex_unlock(pb->monitor);
+        }
+        first = false;
+        if ((rslt >= 0) || (0 == active)) {
+            break;
+        }
+        if ((timeout_ms >= 0) && (pbms_elapsed(t0) >= timeout_ms)) {
+            break;
+        }
+#if PUBNUB_SYNC_AWAIT_ON_SOCKET
+        if (waits != NULL) {
+            /* Even if some FSMs have to go on right away, we check
+               which of the others are ready, to drive only those.
+             */
+            if (pbpal_wait_sockets_io(waits, n, &wait_mem, can_wait ? (int)wait_ms : 0) < 0) {
+                /* We don't know which ones are ready, so drive all */
+                for (i = 0; i < n; ++i) {
+                    waits[i].ready = 1;
+                }
+            }
+        }
+#endif
+    }
+#if PUBNUB_SYNC_AWAIT_ON_SOCKET
+    if (waits != on_stack) {
+        free(waits);
+    }
+    pbpal_free_socket_wait_mem(&wait_mem);
+#endif
+
+    return rslt;
+}
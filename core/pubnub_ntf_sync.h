@@ -5,6 +5,8 @@
 
 #include "pubnub_api_types.h"
 
+#include <stddef.h>
+
 
 /** @file pubnub_ntf_sync.h 
     This is the "sync" notification interface.
@@ -26,8 +28,8 @@
     helper function.
 
     Since pubnub_last_result() is part of the "Core API", this
-    interface only provides one additional function, which will wait
-    in a loop for the transaction to finish.
+    interface only provides additional functions which will wait
+    in a loop for the transaction(s) to finish.
 */
 
 
@@ -39,5 +41,30 @@
 */
 enum pubnub_res pubnub_await(pubnub_t *p);
 
+/** Waits for the first of the transactions on the @p n contexts in
+    the array @p ctxs to finish. The contexts' FSMs are driven
+    together, and, where the platform supports it, we wait on all of
+    their sockets at once (with one poll()), so one thread can
+    efficiently service many concurrent transactions.
+
+    Contexts that have no transaction in progress are ignored, as are
+    NULL pointers in @p ctxs. So, after handling a finished
+    transaction, just call this again (either start a new transaction
+    on that context, or put NULL in its place).
+
+    Transaction timeouts are observed for each context (counting from
+    the start of its transaction), just like pubnub_await() does.
+
+    @param ctxs Array of contexts to wait on
+    @param n Number of contexts in @p ctxs
+    @param timeout_ms Maximum time to wait, in milliseconds. If
+    negative, wait until a transaction finishes.
+
+    @return Index (in @p ctxs) of the context whose transaction
+    finished - get its outcome with pubnub_last_result(), or -1 if
+    none finished in @p timeout_ms, or none are in progress
+*/
+int pubnub_await_any(pubnub_t **ctxs, size_t n, int timeout_ms);
+
 
 #endif        /* defined INC_PUBNUB_NTF_CONTIKI */
@@ -0,0 +1,108 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_PUBLISH_BATCH
+#define INC_PUBNUB_PUBLISH_BATCH
+
+#include "pubnub_config.h"
+
+#include "pubnub_api_types.h"
+
+#if !PUBNUB_USE_PUBLISH_BATCH
+#error To use the batch publish API you must define PUBNUB_USE_PUBLISH_BATCH=1
+#endif
+
+#include <stddef.h>
+
+
+/** @file pubnub_publish_batch.h
+
+    This API is for publishing an array of messages (a "batch") in
+    one transaction (of type `PBTT_PUBLISH_BATCH`). Each message is
+    published with its own POST request, but requests are written
+    back to back on the same (kept alive) connection (HTTP
+    pipelining), at most "pipeline depth" of them in flight (see
+    pubnub_set_publish_pipeline_depth()). Responses are matched to
+    requests in order and the result of each is kept, so you can get
+    them all after the transaction is done.
+
+    The batch is copied to a single memory block ("arena") of the
+    context, which is reused (grown if needed) for next batches, so
+    you don't have to keep it after pubnub_publish_batch() returns.
+*/
+
+
+/** Maximum number of messages in one batch */
+#if !defined PUBNUB_PUBLISH_BATCH_MAX
+#define PUBNUB_PUBLISH_BATCH_MAX 256
+#endif
+
+/** Maximum length of a time token, including the terminating NUL */
+#define PUBNUB_PUBLISH_TIMETOKEN_SIZE 20
+
+
+/** One message to publish in a batch */
+struct pubnub_publish_batch_item {
+    /** The channel to publish to */
+    char const* channel;
+    /** The message to publish, expected to be in JSON format */
+    char const* message;
+    /** The meta-data of the message (JSON object), NULL if none */
+    char const* meta;
+};
+
+/** The result of publishing one message of a batch */
+struct pubnub_publish_batch_result {
+    /** The outcome of publishing. It is `PNR_STARTED` if the
+        message was not (yet) responded to. */
+    enum pubnub_res result;
+    /** The time token of the published message, if the publish
+        succeeded, otherwise an empty string */
+    char timetoken[PUBNUB_PUBLISH_TIMETOKEN_SIZE];
+};
+
+
+/** Starts a transaction to publish all the @p count messages in
+    @p items, in order, on the context @p pb.
+
+    If any message would not fit in the request buffer of the
+    context, none are published.
+
+    The outcome of the transaction is the first error that happened
+    while publishing messages of the batch, or `PNR_OK` if all were
+    published successfully. Use pubnub_publish_batch_results() to
+    get the result of each message.
+
+    @param pb The pubnub context. Can't be NULL
+    @param items Array of messages to publish
+    @param count Number of messages in @p items
+
+    @retval PNR_STARTED transaction started (if it was finished right
+    away, as can happen with blocking I/O, its outcome is returned
+    instead)
+    @retval PNR_IN_PROGRESS some transaction is in progress
+    @retval PNR_INVALID_PARAMETERS @p count is 0 or bigger than
+    #PUBNUB_PUBLISH_BATCH_MAX
+    @retval PNR_TX_BUFF_TOO_SMALL a message (with its channel and
+    meta) too long to be published
+    @retval PNR_INTERNAL_ERROR failed to allocate memory for the copy
+    of the batch
+*/
+enum pubnub_res pubnub_publish_batch(pubnub_t*                               pb,
+                                     struct pubnub_publish_batch_item const* items,
+                                     size_t                                  count);
+
+/** Gets the results of publishing the messages of the last batch on
+    the context @p pb. Results are in the same order as the messages
+    were in the batch.
+
+    @param pb The pubnub context. Can't be NULL
+    @param results Array to put the results to
+    @param n Number of elements of @p results
+    @return The number of results in the last batch (if more than
+    @p n, only the first @p n were put to @p results)
+*/
+size_t pubnub_publish_batch_results(pubnub_t*                           pb,
+                                    struct pubnub_publish_batch_result* results,
+                                    size_t                              n);
+
+
+#endif /* !defined INC_PUBNUB_PUBLISH_BATCH */
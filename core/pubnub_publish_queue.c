@@ -0,0 +1,514 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "pubnub_publish_queue.h"
+#include "pubnub_publish_queue_core.h"
+#include "pubnub_ccore_pubsub.h"
+#include "pubnub_netcore.h"
+#include "pubnub_assert.h"
+#include "pubnub_log.h"
+#include "pubnub_version.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/** The length of the "fixed" parts of the publish URL: the path
+    separators and names of the query parameters.
+ */
+#define PUBLISH_URL_OVERHEAD 64
+
+
+void pbpq_init(pubnub_t* pb)
+{
+    struct pbpublish_queue* q = &pb->publish_queue;
+
+    memset(q->msg, 0, sizeof q->msg);
+    q->head        = 0;
+    q->count       = 0;
+    q->in_flight   = 0;
+    q->depth       = PUBNUB_PUBLISH_PIPELINE_DEPTH;
+    q->first_error = PNR_OK;
+    q->published   = 0;
+    q->failed      = 0;
+    q->txbuf       = NULL;
+    q->txbuf_size  = 0;
+#if PUBNUB_USE_PUBLISH_BATCH
+    q->arena         = NULL;
+    q->arena_size    = 0;
+    q->batch         = NULL;
+    q->batch_results = NULL;
+    q->batch_count   = 0;
+    q->batch_acked   = 0;
+#endif
+}
+
+
+static void drop_from(struct pbpublish_queue* q, unsigned keep)
+{
+    while (q->count > keep) {
+        unsigned i = (q->head + q->count - 1) % PUBNUB_PUBLISH_QUEUE_MAX;
+        free(q->msg[i]);
+        q->msg[i] = NULL;
+        --q->count;
+    }
+}
+
+
+void pbpq_deinit(pubnub_t* pb)
+{
+    struct pbpublish_queue* q = &pb->publish_queue;
+
+    drop_from(q, 0);
+    free(q->txbuf);
+    q->txbuf      = NULL;
+    q->txbuf_size = 0;
+#if PUBNUB_USE_PUBLISH_BATCH
+    free(q->arena);
+    q->arena       = NULL;
+    q->arena_size  = 0;
+    q->batch_count = 0;
+#endif
+}
+
+
+void pbpq_peek(pubnub_t* pb, unsigned i, struct pbpq_item* item)
+{
+    struct pbpublish_queue* q = &pb->publish_queue;
+    char const*             s;
+
+#if PUBNUB_USE_PUBLISH_BATCH
+    if (PBTT_PUBLISH_BATCH == pb->trans) {
+        struct pubnub_publish_batch_item const* it;
+        PUBNUB_ASSERT_OPT(q->batch_acked + i < q->batch_count);
+        it            = &q->batch[q->batch_acked + i];
+        item->channel = it->channel;
+        item->message = it->message;
+        item->meta    = it->meta;
+        return;
+    }
+#endif
+    PUBNUB_ASSERT_OPT(i < q->count);
+    s             = q->msg[(q->head + i) % PUBNUB_PUBLISH_QUEUE_MAX];
+    item->channel = s;
+    item->message = s + strlen(s) + 1;
+    item->meta    = NULL;
+}
+
+
+unsigned pbpq_pending(pubnub_t* pb)
+{
+    struct pbpublish_queue* q = &pb->publish_queue;
+
+#if PUBNUB_USE_PUBLISH_BATCH
+    if (PBTT_PUBLISH_BATCH == pb->trans) {
+        return q->batch_count - q->batch_acked;
+    }
+#endif
+    return q->count;
+}
+
+
+unsigned pbpq_window_size(pubnub_t* pb)
+{
+    unsigned pending = pbpq_pending(pb);
+    unsigned depth   = pb->publish_queue.depth;
+
+    return (pending < depth) ? pending : depth;
+}
+
+
+char* pbpq_reserve(pubnub_t* pb, size_t n)
+{
+    struct pbpublish_queue* q = &pb->publish_queue;
+
+    if (n > q->txbuf_size) {
+        char* p = (char*)realloc(q->txbuf, n);
+        if (NULL == p) {
+            PUBNUB_LOG_ERROR("pb=%p: Failed to allocate %lu octets for "
+                             "pipelined publish requests\n",
+                             pb,
+                             (unsigned long)n);
+            return NULL;
+        }
+        q->txbuf      = p;
+        q->txbuf_size = n;
+    }
+    return q->txbuf;
+}
+
+
+void pbpq_pop(pubnub_t* pb, enum pubnub_res result)
+{
+    struct pbpublish_queue* q = &pb->publish_queue;
+
+#if PUBNUB_USE_PUBLISH_BATCH
+    if (PBTT_PUBLISH_BATCH == pb->trans) {
+        struct pubnub_publish_batch_result* r;
+        PUBNUB_ASSERT_OPT(q->batch_acked < q->batch_count);
+        r         = &q->batch_results[q->batch_acked++];
+        r->result = result;
+        if (PNR_OK == result) {
+            pbcc_publish_timetoken(&pb->core, r->timetoken, sizeof r->timetoken);
+        }
+    }
+    else
+#endif
+    {
+        PUBNUB_ASSERT_OPT(q->count > 0);
+        free(q->msg[q->head]);
+        q->msg[q->head] = NULL;
+        q->head         = (q->head + 1) % PUBNUB_PUBLISH_QUEUE_MAX;
+        --q->count;
+    }
+    if (q->in_flight > 0) {
+        --q->in_flight;
+    }
+    if (PNR_OK == result) {
+        ++q->published;
+    }
+    else {
+        ++q->failed;
+        if (PNR_OK == q->first_error) {
+            q->first_error = result;
+        }
+    }
+}
+
+
+enum pubnub_res pbpq_outcome(pubnub_t* pb)
+{
+    struct pbpublish_queue* q = &pb->publish_queue;
+
+    q->in_flight = 0;
+    return q->first_error;
+}
+
+
+/** Returns whether the message to @p channel, with the @p meta
+    (can be NULL), would (surely) fit in the request buffer of the
+    context @p pb when published via @p method. URL encoding can, at
+    most, triple the length of a string. Via POST, the message is
+    copied to the buffer after the URL, as is.
+ */
+static bool fits_in_buf(pubnub_t*          pb,
+                        char const*        channel,
+                        char const*        message,
+                        char const*        meta,
+                        enum pubnub_method method)
+{
+    struct pbcc_context* p    = &pb->core;
+    char const*          uuid = pbcc_uuid_get(p);
+    size_t               need = PUBLISH_URL_OVERHEAD;
+
+    need += strlen(p->publish_key) + strlen(p->subscribe_key);
+    need += 3 * (strlen(channel) + strlen(pubnub_uname()));
+    if (pubnubSendViaGET == method) {
+        need += 3 * strlen(message);
+    }
+    else {
+        need += strlen(message) + 2;
+    }
+    if (meta != NULL) {
+        need += 3 * strlen(meta);
+    }
+    if (uuid != NULL) {
+        need += 3 * strlen(uuid);
+    }
+    if (p->auth != NULL) {
+        need += 3 * strlen(p->auth);
+    }
+
+    return need < sizeof p->http_buf;
+}
+
+
+static enum pubnub_res start_queue_transaction(pubnub_t* pb)
+{
+    pb->publish_queue.first_error = PNR_OK;
+    pb->publish_queue.in_flight   = 0;
+    pb->trans                     = PBTT_PUBLISH_QUEUE;
+    pb->method                    = pubnubSendViaGET;
+    pb->core.last_result          = PNR_STARTED;
+    pbnc_fsm(pb);
+
+    return pb->core.last_result;
+}
+
+
+enum pubnub_res pubnub_publish_enqueue(pubnub_t*   pb,
+                                       char const* channel,
+                                       char const* message)
+{
+    struct pbpublish_queue* q;
+    size_t                  chlen;
+    size_t                  msglen;
+    char*                   s;
+    enum pubnub_res         rslt;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+    PUBNUB_ASSERT_OPT(channel != NULL);
+    PUBNUB_ASSERT_OPT(message != NULL);
+
+    pubnub_mutex_lock(pb->monitor);
+    q = &pb->publish_queue;
+    if (!pbnc_can_start_transaction(pb) && (pb->trans != PBTT_PUBLISH_QUEUE)) {
+        pubnub_mutex_unlock(pb->monitor);
+        return PNR_IN_PROGRESS;
+    }
+    if (!fits_in_buf(pb, channel, message, NULL, pubnubSendViaGET)) {
+        pubnub_mutex_unlock(pb->monitor);
+        return PNR_TX_BUFF_TOO_SMALL;
+    }
+    if (q->count == PUBNUB_PUBLISH_QUEUE_MAX) {
+        PUBNUB_LOG_WARNING("pb=%p: publish queue full\n", pb);
+        if (pbnc_can_start_transaction(pb)) {
+            /* Left over from a failed transaction, drain it */
+            start_queue_transaction(pb);
+        }
+        pubnub_mutex_unlock(pb->monitor);
+        return PNR_IN_PROGRESS;
+    }
+    chlen  = strlen(channel) + 1;
+    msglen = strlen(message) + 1;
+    s      = (char*)malloc(chlen + msglen);
+    if (NULL == s) {
+        pubnub_mutex_unlock(pb->monitor);
+        return PNR_INTERNAL_ERROR;
+    }
+    memcpy(s, channel, chlen);
+    memcpy(s + chlen, message, msglen);
+    q->msg[(q->head + q->count) % PUBNUB_PUBLISH_QUEUE_MAX] = s;
+    ++q->count;
+
+    if (pbnc_can_start_transaction(pb)) {
+        rslt = start_queue_transaction(pb);
+    }
+    else {
+        rslt = PNR_OK;
+    }
+    pubnub_mutex_unlock(pb->monitor);
+
+    return rslt;
+}
+
+
+enum pubnub_res pubnub_publish_queue_flush(pubnub_t* pb)
+{
+    enum pubnub_res rslt;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+
+    pubnub_mutex_lock(pb->monitor);
+    if (!pbnc_can_start_transaction(pb)) {
+        rslt = PNR_IN_PROGRESS;
+    }
+    else if (0 == pb->publish_queue.count) {
+        rslt = PNR_OK;
+    }
+    else {
+        rslt = start_queue_transaction(pb);
+    }
+    pubnub_mutex_unlock(pb->monitor);
+
+    return rslt;
+}
+
+
+size_t pubnub_publish_queue_size(pubnub_t* pb)
+{
+    size_t rslt;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+
+    pubnub_mutex_lock(pb->monitor);
+    rslt = pb->publish_queue.count;
+    pubnub_mutex_unlock(pb->monitor);
+
+    return rslt;
+}
+
+
+void pubnub_publish_queue_clear(pubnub_t* pb)
+{
+    unsigned keep = 0;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+
+    pubnub_mutex_lock(pb->monitor);
+    if (!pbnc_can_start_transaction(pb) && (PBTT_PUBLISH_QUEUE == pb->trans)) {
+        keep = pb->publish_queue.in_flight;
+    }
+    drop_from(&pb->publish_queue, keep);
+    pubnub_mutex_unlock(pb->monitor);
+}
+
+
+int pubnub_set_publish_pipeline_depth(pubnub_t* pb, unsigned depth)
+{
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+
+    if ((depth < 1) || (depth > PUBNUB_PUBLISH_PIPELINE_DEPTH_MAX)) {
+        return -1;
+    }
+    pubnub_mutex_lock(pb->monitor);
+    pb->publish_queue.depth = depth;
+    pubnub_mutex_unlock(pb->monitor);
+
+    return 0;
+}
+
+
+void pubnub_publish_queue_stats(pubnub_t*      pb,
+                                unsigned long* published,
+                                unsigned long* failed)
+{
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+
+    pubnub_mutex_lock(pb->monitor);
+    if (published != NULL) {
+        *published = pb->publish_queue.published;
+    }
+    if (failed != NULL) {
+        *failed = pb->publish_queue.failed;
+    }
+    pubnub_mutex_unlock(pb->monitor);
+}
+
+
+#if PUBNUB_USE_PUBLISH_BATCH
+/** Copies the string @p s to @p *dst, advancing it, and returns the
+    copy. NULL is "copied" as NULL.
+ */
+static char const* arena_strdup(char** dst, char const* s)
+{
+    char*  rslt = *dst;
+    size_t n;
+
+    if (NULL == s) {
+        return NULL;
+    }
+    n = strlen(s) + 1;
+    memcpy(rslt, s, n);
+    *dst += n;
+
+    return rslt;
+}
+
+
+/** Copies the @p count @p items of a batch to the arena of the
+    context @p pb, growing it if needed.
+ */
+static enum pubnub_res copy_batch(pubnub_t*                               pb,
+                                  struct pubnub_publish_batch_item const* items,
+                                  unsigned                                count)
+{
+    struct pbpublish_queue* q    = &pb->publish_queue;
+    size_t                  need = count * (sizeof *q->batch + sizeof *q->batch_results);
+    char*                   s;
+    unsigned                i;
+
+    for (i = 0; i < count; ++i) {
+        need += strlen(items[i].channel) + strlen(items[i].message) + 2;
+        if (items[i].meta != NULL) {
+            need += strlen(items[i].meta) + 1;
+        }
+    }
+    if (need > q->arena_size) {
+        char* p = (char*)realloc(q->arena, need);
+        if (NULL == p) {
+            PUBNUB_LOG_ERROR("pb=%p: Failed to allocate %lu octets for "
+                             "publish batch\n",
+                             pb,
+                             (unsigned long)need);
+            return PNR_INTERNAL_ERROR;
+        }
+        q->arena      = p;
+        q->arena_size = need;
+    }
+    q->batch         = (struct pubnub_publish_batch_item*)q->arena;
+    q->batch_results = (struct pubnub_publish_batch_result*)(q->batch + count);
+    s                = (char*)(q->batch_results + count);
+    for (i = 0; i < count; ++i) {
+        q->batch[i].channel              = arena_strdup(&s, items[i].channel);
+        q->batch[i].message              = arena_strdup(&s, items[i].message);
+        q->batch[i].meta                 = arena_strdup(&s, items[i].meta);
+        q->batch_results[i].result       = PNR_STARTED;
+        q->batch_results[i].timetoken[0] = '\0';
+    }
+    q->batch_count = count;
+    q->batch_acked = 0;
+
+    return PNR_OK;
+}
+
+
+enum pubnub_res pubnub_publish_batch(pubnub_t*                               pb,
+                                     struct pubnub_publish_batch_item const* items,
+                                     size_t                                  count)
+{
+    enum pubnub_res rslt;
+    size_t          i;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+    PUBNUB_ASSERT_OPT((items != NULL) || (0 == count));
+
+    if ((0 == count) || (count > PUBNUB_PUBLISH_BATCH_MAX)) {
+        return PNR_INVALID_PARAMETERS;
+    }
+    pubnub_mutex_lock(pb->monitor);
+    if (!pbnc_can_start_transaction(pb)) {
+        pubnub_mutex_unlock(pb->monitor);
+        return PNR_IN_PROGRESS;
+    }
+    for (i = 0; i < count; ++i) {
+        PUBNUB_ASSERT_OPT(items[i].channel != NULL);
+        PUBNUB_ASSERT_OPT(items[i].message != NULL);
+        if (!fits_in_buf(pb,
+                         items[i].channel,
+                         items[i].message,
+                         items[i].meta,
+                         pubnubSendViaPOST)) {
+            pubnub_mutex_unlock(pb->monitor);
+            return PNR_TX_BUFF_TOO_SMALL;
+        }
+    }
+    rslt = copy_batch(pb, items, (unsigned)count);
+    if (rslt != PNR_OK) {
+        pubnub_mutex_unlock(pb->monitor);
+        return rslt;
+    }
+    pb->publish_queue.first_error = PNR_OK;
+    pb->publish_queue.in_flight   = 0;
+    pb->trans                     = PBTT_PUBLISH_BATCH;
+    pb->method                    = pubnubSendViaPOST;
+    pb->core.last_result          = PNR_STARTED;
+    pbnc_fsm(pb);
+    rslt = pb->core.last_result;
+    pubnub_mutex_unlock(pb->monitor);
+
+    return rslt;
+}
+
+
+size_t pubnub_publish_batch_results(pubnub_t*                           pb,
+                                    struct pubnub_publish_batch_result* results,
+                                    size_t                              n)
+{
+    size_t count;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+    PUBNUB_ASSERT_OPT((results != NULL) || (0 == n));
+
+    pubnub_mutex_lock(pb->monitor);
+    count = pb->publish_queue.batch_count;
+    if ((count > 0) && (n > 0)) {
+        memcpy(results,
+               pb->publish_queue.batch_results,
+               ((n < count) ? n : count) * sizeof *results);
+    }
+    pubnub_mutex_unlock(pb->monitor);
+
+    return count;
+}
+#endif /* PUBNUB_USE_PUBLISH_BATCH */
@@ -0,0 +1,137 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_PUBLISH_QUEUE
+#define INC_PUBNUB_PUBLISH_QUEUE
+
+#include "pubnub_config.h"
+
+#include "pubnub_api_types.h"
+
+#if !PUBNUB_USE_PUBLISH_QUEUE
+#error To use the publish queue API you must define PUBNUB_USE_PUBLISH_QUEUE=1
+#endif
+
+#include <stddef.h>
+
+
+/** @file pubnub_publish_queue.h
+
+    This API is for high-rate publishing from a single context.
+    Messages are put in a (per context) publish queue and the whole
+    queue is published in one transaction (of type
+    `PBTT_PUBLISH_QUEUE`). Several publish requests are written back
+    to back on the same (kept alive) connection (HTTP pipelining)
+    and responses are matched to them in order. Thus, you don't pay
+    one round-trip time per message.
+
+    The number of requests "in flight" (sent, but not yet responded
+    to) is bounded by the "pipeline depth" of the context. When
+    using a proxy, or HTTP keep-alive is off, pipelining is not used,
+    messages are published one by one. If the server closes the
+    connection while requests are in flight, the messages that got
+    no response fail with `PNR_IO_ERROR` - they may have been
+    published, so they are not sent again.
+
+    The outcome of the transaction is the first error that happened
+    while publishing messages from the queue, or `PNR_OK` if all
+    were published successfully. Messages that were not published
+    because of a transport (I/O, timeout) error stay in the queue,
+    to be published in the next transaction.
+
+    All functions here are thread-safe (if Pubnub is built to be
+    thread-safe).
+*/
+
+
+/** Maximum number of messages in the publish queue of a context */
+#if !defined PUBNUB_PUBLISH_QUEUE_MAX
+#define PUBNUB_PUBLISH_QUEUE_MAX 64
+#endif
+
+/** Maximum pipeline depth, that is, maximum number of publish
+    requests in flight at any time on a context.
+*/
+#if !defined PUBNUB_PUBLISH_PIPELINE_DEPTH_MAX
+#define PUBNUB_PUBLISH_PIPELINE_DEPTH_MAX 16
+#endif
+
+/** Default pipeline depth of a context */
+#if !defined PUBNUB_PUBLISH_PIPELINE_DEPTH
+#define PUBNUB_PUBLISH_PIPELINE_DEPTH 8
+#endif
+
+
+/** Puts the @p message to be published on @p channel to the publish
+    queue of the context @p pb. Both @p channel and @p message are
+    copied, so you don't have to keep them after this returns.
+
+    If there is no transaction in progress on @p pb, a queue
+    transaction (`PBTT_PUBLISH_QUEUE`) is started. If a queue
+    transaction is in progress, the message will be published in it.
+
+    @param pb The pubnub context. Can't be NULL
+    @param channel The string with the channel name to publish to.
+    @param message The message to publish, expected to be in JSON format
+
+    @retval PNR_STARTED a queue transaction was started (if it was
+    finished right away, as can happen with blocking I/O, its outcome
+    is returned instead)
+    @retval PNR_OK message queued, will be published in the ongoing
+    queue transaction
+    @retval PNR_IN_PROGRESS some other transaction is in progress, or
+    the publish queue is full (if there's no transaction in progress,
+    a queue transaction is started, to drain it); message was not
+    queued
+    @retval PNR_TX_BUFF_TOO_SMALL message (and/or channel) too long to
+    be published via GET, message was not queued
+    @retval PNR_INTERNAL_ERROR failed to allocate memory for the copy
+    of the message
+*/
+enum pubnub_res pubnub_publish_enqueue(pubnub_t*   pb,
+                                       char const* channel,
+                                       char const* message);
+
+/** Starts a queue transaction on the context @p pb, to publish the
+    messages that are in its publish queue. Use this to retry
+    publishing of the messages left in the queue after a failed
+    queue transaction, if you have no new message to enqueue.
+
+    @retval PNR_STARTED a queue transaction was started
+    @retval PNR_OK publish queue is empty, nothing to do
+    @retval PNR_IN_PROGRESS a transaction is in progress
+ */
+enum pubnub_res pubnub_publish_queue_flush(pubnub_t* pb);
+
+/** Returns the number of messages in the publish queue of the
+    context @p pb, including those that were sent, but not yet
+    responded to.
+ */
+size_t pubnub_publish_queue_size(pubnub_t* pb);
+
+/** Removes all messages from the publish queue of the context @p pb
+    that are not "in flight".
+ */
+void pubnub_publish_queue_clear(pubnub_t* pb);
+
+/** Sets the pipeline depth of the context @p pb to @p depth, which
+    has to be in range [1, PUBNUB_PUBLISH_PIPELINE_DEPTH_MAX]. Depth
+    of 1 means no pipelining - next request is sent only after the
+    response to the previous one was received.
+
+    Takes effect on the next "batch" of messages sent.
+
+    @retval 0 OK
+    @retval -1 @p depth out of range
+ */
+int pubnub_set_publish_pipeline_depth(pubnub_t* pb, unsigned depth);
+
+/** Gets the statistics of the publish queue of the context @p pb:
+    the number of messages successfully published (@p published) and
+    the number of messages for which publishing failed (@p failed),
+    since the context was initialized. Either pointer can be NULL.
+ */
+void pubnub_publish_queue_stats(pubnub_t*      pb,
+                                unsigned long* published,
+                                unsigned long* failed);
+
+
+#endif /* !defined INC_PUBNUB_PUBLISH_QUEUE */
@@ -0,0 +1,120 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_PUBLISH_QUEUE_CORE
+#define INC_PUBNUB_PUBLISH_QUEUE_CORE
+
+#include "core/pubnub_publish_queue.h"
+#if PUBNUB_USE_PUBLISH_BATCH
+#include "core/pubnub_publish_batch.h"
+#endif
+
+#include <stdbool.h>
+
+
+/** @file pubnub_publish_queue_core.h
+
+    The internals of the publish queue. The queue itself is kept
+    here, while sending pipelined requests and matching responses to
+    them is done in the Pubnub "net-core" FSM.
+
+    A publish batch uses the same machinery, so it's kept here, too.
+    Which one is used depends on the transaction type of the context.
+ */
+
+
+/** The publish queue of a context. It's a ring buffer of messages,
+    the oldest (first to publish) is at `head`. First `in_flight`
+    messages from the `head` were sent, but not yet responded to.
+ */
+struct pbpublish_queue {
+    /** Each message is a single allocated block, holding the
+        channel, then the message itself, both NUL-terminated.
+    */
+    char* msg[PUBNUB_PUBLISH_QUEUE_MAX];
+    /** Index of the oldest message */
+    unsigned head;
+    /** Number of messages in the queue */
+    unsigned count;
+    /** Number of messages sent, but not yet responded to */
+    unsigned in_flight;
+    /** Maximum number of messages in flight */
+    unsigned depth;
+    /** The first error in current transaction, PNR_OK if none */
+    enum pubnub_res first_error;
+    /** Number of successfully published messages */
+    unsigned long published;
+    /** Number of messages whose publishing failed */
+    unsigned long failed;
+    /** Buffer for the pipelined requests, grown as needed */
+    char* txbuf;
+    /** Size of the `txbuf` */
+    size_t txbuf_size;
+#if PUBNUB_USE_PUBLISH_BATCH
+    /** One memory block holding the messages of the current batch,
+        their results and copies of all the strings, grown as needed */
+    char* arena;
+    /** Size of the `arena` */
+    size_t arena_size;
+    /** Messages of the current batch (in the `arena`) */
+    struct pubnub_publish_batch_item* batch;
+    /** Results for the messages of the current batch (in the `arena`) */
+    struct pubnub_publish_batch_result* batch_results;
+    /** Number of messages in the current batch */
+    unsigned batch_count;
+    /** Number of messages of the current batch responded to */
+    unsigned batch_acked;
+#endif
+};
+
+
+/** A message to publish, as seen by the net-core FSM */
+struct pbpq_item {
+    char const* channel;
+    char const* message;
+    char const* meta;
+};
+
+
+/** Initializes the publish queue of the context @p pb */
+void pbpq_init(pubnub_t* pb);
+
+/** Frees all the messages and memory of the publish queue of the
+    context @p pb */
+void pbpq_deinit(pubnub_t* pb);
+
+/** Gets the message at position @p i (from the first one not
+    responded to) of the queue, or batch, of the context @p pb, to
+    @p item. Item's `meta` is NULL for queued messages.
+ */
+void pbpq_peek(pubnub_t* pb, unsigned i, struct pbpq_item* item);
+
+/** Number of messages yet to be responded to in the current queue or
+    batch transaction of the context @p pb.
+ */
+unsigned pbpq_pending(pubnub_t* pb);
+
+/** Number of messages to send in the next pipelined "window", with
+    respect to the pipeline depth of the context @p pb.
+ */
+unsigned pbpq_window_size(pubnub_t* pb);
+
+/** Makes sure the request buffer of the context @p pb has room for
+    at least @p n octets.
+    @return Pointer to the buffer, NULL on allocation failure
+ */
+char* pbpq_reserve(pubnub_t* pb, size_t n);
+
+/** Removes the message at the head of the queue of the context @p
+    pb, accounting the @p result of its publishing. For a batch, the
+    result (and the time token from the response in the context, if
+    publish succeeded) is stored as the result of the message.
+ */
+void pbpq_pop(pubnub_t* pb, enum pubnub_res result);
+
+/** Returns the outcome of the (just finished) queue transaction of
+    the context @p pb and resets for the next one. Messages that
+    were in flight are "returned" to the queue.
+ */
+enum pubnub_res pbpq_outcome(pubnub_t* pb);
+
+
+#endif /* !defined INC_PUBNUB_PUBLISH_QUEUE_CORE */
@@ -24,12 +24,16 @@ pubnub_t* pubnub_init(pubnub_t* p, const char* publish_key, const char* subscrib
         p->wait_connect_timeout_ms = PUBNUB_DEFAULT_WAIT_CONNECT_TIMER;
 #if defined(PUBNUB_CALLBACK_API)
         p->previous = p->next = NULL;
+        p->timer_slot         = 0;
 #endif
     }
 #if defined(PUBNUB_CALLBACK_API)
     p->cb        = NULL;
     p->user_data = NULL;
     p->flags.sent_queries = 0;
+    p->queue_node.next     = NULL;
+    p->queue_node.in_queue = 0;
+    p->queue_node.pending  = 0;
 #endif /* defined(PUBNUB_CALLBACK_API) */
     if (PUBNUB_ORIGIN_SETTABLE) {
         p->origin = PUBNUB_ORIGIN;
@@ -77,6 +81,9 @@ pubnub_t* pubnub_init(pubnub_t* p, const char* publish_key, const char* subscrib
 
 #if PUBNUB_RECEIVE_GZIP_RESPONSE
     p->data_compressed = compressionNONE;
+#endif
+#if PUBNUB_USE_PUBLISH_QUEUE
+    pbpq_init(p);
 #endif
     pubnub_mutex_unlock(p->monitor);
 
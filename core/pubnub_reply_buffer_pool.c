@@ -0,0 +1,224 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#if PUBNUB_USE_REPLY_BUFFER_POOL
+#include "core/pbcc_reply_buffer_pool.h"
+#else
+#error PUBNUB_USE_REPLY_BUFFER_POOL must be defined and set to 1 before compiling this file
+#endif
+
+#include "core/pubnub_atomic.h"
+#include "core/pubnub_assert.h"
+#include "core/pubnub_log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/** Size of the smallest size class */
+#define MIN_CLASS_SIZE ((size_t)1 << PUBNUB_REPLY_BUFFER_POOL_MIN_SHIFT)
+
+/** Size of the largest size class */
+#define MAX_CLASS_SIZE                                                         \
+    (MIN_CLASS_SIZE << (PUBNUB_REPLY_BUFFER_POOL_CLASSES - 1))
+
+
+/** A free block in the pool. Blocks are (way) bigger than this, so
+    we keep the link in the block itself.
+ */
+struct free_block {
+    struct free_block* next;
+};
+
+
+pubnub_mutex_static_decl_and_init(m_lock);
+static struct free_block* m_free[PUBNUB_REPLY_BUFFER_POOL_CLASSES] pubnub_guarded_by(m_lock);
+static size_t m_retained_bytes pubnub_guarded_by(m_lock);
+static size_t m_retained_blocks pubnub_guarded_by(m_lock);
+static size_t m_retain_max pubnub_guarded_by(m_lock) = PUBNUB_REPLY_BUFFER_POOL_RETAIN_MAX;
+static unsigned long m_pool_hits pubnub_guarded_by(m_lock);
+static unsigned long m_heap_allocs pubnub_guarded_by(m_lock);
+static unsigned long m_heap_frees pubnub_guarded_by(m_lock);
+
+/** Reuse doesn't touch the pool, so it's counted w/out locking */
+static pubnub_atomic_t m_reused;
+
+
+/** Returns the index of the (smallest) size class that can hold @p n
+    octets, or -1 if none can.
+ */
+static int size_class(size_t n)
+{
+    int    i;
+    size_t size = MIN_CLASS_SIZE;
+
+    for (i = 0; i < PUBNUB_REPLY_BUFFER_POOL_CLASSES; ++i, size <<= 1) {
+        if (n <= size) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+/** Frees blocks from the pool, starting with the largest ones, until
+    no more than @p max octets are retained. Has to be called with
+    the lock held.
+ */
+static void shrink_to(size_t max)
+{
+    int i;
+
+    for (i = PUBNUB_REPLY_BUFFER_POOL_CLASSES - 1;
+         (i >= 0) && (m_retained_bytes > max);
+         --i) {
+        size_t const size = MIN_CLASS_SIZE << i;
+        while ((m_free[i] != NULL) && (m_retained_bytes > max)) {
+            struct free_block* block = m_free[i];
+            m_free[i]                = block->next;
+            free(block);
+            m_retained_bytes -= size;
+            --m_retained_blocks;
+            ++m_heap_frees;
+        }
+    }
+}
+
+
+/** Returns the block @p buf of capacity @p cap to the pool, or frees
+    it if it can't be kept.
+ */
+static void block_put(char* buf, size_t cap)
+{
+    int const i = size_class(cap);
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    if ((i >= 0) && ((MIN_CLASS_SIZE << i) == cap)
+        && (m_retained_bytes + cap <= m_retain_max)) {
+        struct free_block* block = (struct free_block*)buf;
+        block->next              = m_free[i];
+        m_free[i]                = block;
+        m_retained_bytes += cap;
+        ++m_retained_blocks;
+    }
+    else {
+        free(buf);
+        ++m_heap_frees;
+    }
+    pubnub_mutex_unlock(m_lock);
+}
+
+
+/** Gets a block that can hold @p n octets, from the pool if there is
+    one, otherwise from the heap. Puts its capacity to @p cap.
+ */
+static char* block_get(size_t n, size_t* cap)
+{
+    int const i = size_class(n);
+    char*     rslt;
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    if ((i >= 0) && (m_free[i] != NULL)) {
+        struct free_block* block = m_free[i];
+        m_free[i]                = block->next;
+        m_retained_bytes -= MIN_CLASS_SIZE << i;
+        --m_retained_blocks;
+        ++m_pool_hits;
+        pubnub_mutex_unlock(m_lock);
+        *cap = MIN_CLASS_SIZE << i;
+        return (char*)block;
+    }
+    pubnub_mutex_unlock(m_lock);
+
+    *cap = (i >= 0) ? (MIN_CLASS_SIZE << i) : n;
+    rslt = (char*)malloc(*cap);
+    if (rslt != NULL) {
+        pubnub_mutex_lock(m_lock);
+        ++m_heap_allocs;
+        pubnub_mutex_unlock(m_lock);
+    }
+    return rslt;
+}
+
+
+int pbcc_reply_buffer_reserve(char** buf, size_t* cap, size_t n, size_t keep)
+{
+    char*  newbuf;
+    size_t newcap;
+
+    PUBNUB_ASSERT_OPT(buf != NULL);
+    PUBNUB_ASSERT_OPT(cap != NULL);
+    PUBNUB_ASSERT_OPT(keep <= n);
+
+    if ((*buf != NULL) && (n <= *cap)) {
+        pubnub_atomic_add(&m_reused, 1);
+        return 0;
+    }
+    newbuf = block_get(n, &newcap);
+    if (NULL == newbuf) {
+        PUBNUB_LOG_ERROR("Failed to allocate reply buffer of %lu octets\n",
+                         (unsigned long)n);
+        return -1;
+    }
+    if (*buf != NULL) {
+        if (keep > 0) {
+            memcpy(newbuf, *buf, keep);
+        }
+        block_put(*buf, *cap);
+    }
+    *buf = newbuf;
+    *cap = newcap;
+
+    return 0;
+}
+
+
+void pbcc_reply_buffer_release(char** buf, size_t* cap)
+{
+    PUBNUB_ASSERT_OPT(buf != NULL);
+    PUBNUB_ASSERT_OPT(cap != NULL);
+
+    if (*buf != NULL) {
+        block_put(*buf, *cap);
+        *buf = NULL;
+    }
+    *cap = 0;
+}
+
+
+void pubnub_reply_buffer_pool_stats(struct pubnub_reply_buffer_pool_stats* stats)
+{
+    PUBNUB_ASSERT_OPT(stats != NULL);
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    stats->reused          = (unsigned long)pubnub_atomic_load(&m_reused);
+    stats->pool_hits       = m_pool_hits;
+    stats->heap_allocs     = m_heap_allocs;
+    stats->heap_frees      = m_heap_frees;
+    stats->retained_blocks = m_retained_blocks;
+    stats->retained_bytes  = m_retained_bytes;
+    stats->retain_max      = m_retain_max;
+    pubnub_mutex_unlock(m_lock);
+}
+
+
+void pubnub_reply_buffer_pool_set_retain_max(size_t max)
+{
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    m_retain_max = max;
+    shrink_to(max);
+    pubnub_mutex_unlock(m_lock);
+}
+
+
+void pubnub_reply_buffer_pool_trim(void)
+{
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    shrink_to(0);
+    pubnub_mutex_unlock(m_lock);
+}
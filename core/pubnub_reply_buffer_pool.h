@@ -0,0 +1,87 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_REPLY_BUFFER_POOL
+#define INC_PUBNUB_REPLY_BUFFER_POOL
+
+#include "pubnub_config.h"
+
+#if !PUBNUB_USE_REPLY_BUFFER_POOL
+#error To use the reply buffer pool API you must define PUBNUB_USE_REPLY_BUFFER_POOL=1
+#endif
+
+#include <stddef.h>
+
+
+/** @file pubnub_reply_buffer_pool.h
+
+    With a dynamic reply buffer (`PUBNUB_DYNAMIC_REPLY_BUFFER`), the
+    reply buffers of contexts (also used to inflate gzip) are allocated
+    from a process-wide pool of blocks, whose sizes are powers of two
+    ("size classes"). A context keeps its buffer (the biggest one it
+    needed so far - "high-water mark") between transactions, so a
+    steady-state subscribe loop does no allocation at all. Buffers
+    that a context lets go of (when it needs a bigger one, or when
+    it's freed) are kept in the pool, for any context to take, up to
+    a (configurable) limit of retained memory.
+
+    Buffers bigger than the largest size class are allocated from
+    (and freed to) the heap directly.
+
+    All functions here are thread-safe.
+*/
+
+
+/** Smallest size class of the pool is 2 to the power of this */
+#if !defined PUBNUB_REPLY_BUFFER_POOL_MIN_SHIFT
+#define PUBNUB_REPLY_BUFFER_POOL_MIN_SHIFT 10
+#endif
+
+/** Number of size classes of the pool. With the defaults, that's
+    blocks of 1 KiB to 1 MiB.
+*/
+#if !defined PUBNUB_REPLY_BUFFER_POOL_CLASSES
+#define PUBNUB_REPLY_BUFFER_POOL_CLASSES 11
+#endif
+
+/** Default limit of memory retained in the pool, in octets */
+#if !defined PUBNUB_REPLY_BUFFER_POOL_RETAIN_MAX
+#define PUBNUB_REPLY_BUFFER_POOL_RETAIN_MAX (2 * 1024 * 1024)
+#endif
+
+
+/** Statistics of the reply buffer pool */
+struct pubnub_reply_buffer_pool_stats {
+    /** Number of times a context's own buffer was big enough, so
+        nothing had to be allocated */
+    unsigned long reused;
+    /** Number of buffers taken from the pool */
+    unsigned long pool_hits;
+    /** Number of buffers allocated from the heap */
+    unsigned long heap_allocs;
+    /** Number of buffers freed to the heap */
+    unsigned long heap_frees;
+    /** Number of buffers now in the pool */
+    size_t retained_blocks;
+    /** Memory now retained in the pool, in octets */
+    size_t retained_bytes;
+    /** Limit of memory retained in the pool, in octets */
+    size_t retain_max;
+};
+
+
+/** Gets the statistics of the reply buffer pool to @p stats. */
+void pubnub_reply_buffer_pool_stats(struct pubnub_reply_buffer_pool_stats* stats);
+
+/** Sets the limit of memory retained in the reply buffer pool to
+    @p max octets. If more than that is retained now, (some) buffers
+    in the pool are freed. Setting it to 0 effectively disables the
+    pool (but contexts still keep their own buffers).
+ */
+void pubnub_reply_buffer_pool_set_retain_max(size_t max);
+
+/** Frees all the buffers in the reply buffer pool. Buffers of the
+    contexts are not affected.
+ */
+void pubnub_reply_buffer_pool_trim(void);
+
+
+#endif /* !defined INC_PUBNUB_REPLY_BUFFER_POOL */
@@ -131,4 +131,64 @@ void pubnub_ssl_dont_use_system_certificate_store(pubnub_t *p);
  */
 void pubnub_ssl_set_usrdef_pem_cert(pubnub_t *p, char const *contents);
 
+
+/** Pre-warms the process-wide cache of SSL/TLS contexts (with
+    pre-loaded certificate stores) for the given certificate
+    settings. Contexts which have the same certificate settings share
+    the same SSL/TLS context, which is created (and certificates
+    loaded) when the first of them establishes a TLS connection.
+    Calling this at start-up moves that cost out of the first
+    connection.
+
+    The parameters have the same meaning as the context settings
+    of the same name (pubnub_set_ssl_verify_locations(),
+    pubnub_ssl_set_usrdef_pem_cert() and
+    pubnub_ssl_use_system_certificate_store()). Use NULL, NULL,
+    NULL, false for the defaults. The strings are copied.
+
+    A pre-warmed SSL/TLS context is kept in the cache even if no
+    Pubnub context uses it, until pubnub_ssl_ctx_cache_clear().
+
+    This is only available on OpenSSL.
+
+    @return 0: OK, -1: error
+ */
+int pubnub_ssl_ctx_prewarm(char const* sCAfile,
+                           char const* sCApath,
+                           char const* userPEMcert,
+                           bool        use_system_certificate_store);
+
+/** Releases the pre-warmed SSL/TLS contexts from the process-wide
+    cache. The ones that are in use by some Pubnub context(s) will
+    be freed when they are not used any more.
+
+    This is only available on OpenSSL.
+ */
+void pubnub_ssl_ctx_cache_clear(void);
+
+
+/** Gets the statistics of the process-wide TLS session cache. When
+    reusing of SSL sessions is enabled on a context (see
+    pubnub_set_reuse_ssl_session()) and the context doesn't have its
+    own session yet, it will try to resume the session that some
+    context made to the same origin - which can avoid a full
+    handshake on a new context (or a lot of them, after a network
+    outage). Sessions are evicted from the cache when they expire.
+
+    This is only available on OpenSSL.
+
+    @param hits Number of times a session was found in the cache.
+    May be NULL if you're not interested in it.
+    @param misses Number of times a session was not found in the
+    cache. May be NULL if you're not interested in it.
+ */
+void pubnub_ssl_session_cache_stats(unsigned long* hits, unsigned long* misses);
+
+/** Removes all the TLS sessions from the process-wide TLS session
+    cache. Contexts keep their own sessions.
+
+    This is only available on OpenSSL.
+ */
+void pubnub_ssl_session_cache_clear(void);
+
 #endif /* defined INC_PUBNUB_SSL */
@@ -68,3 +68,18 @@ struct pubnub_v2_message pubnub_get_v2(pubnub_t* pb)
 
     return result;
 }
+
+
+size_t pubnub_get_v2_batch(pubnub_t* pb, struct pubnub_v2_message* msgs, size_t max)
+{
+    size_t result;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+    PUBNUB_ASSERT_OPT((msgs != NULL) || (0 == max));
+
+    pubnub_mutex_lock(pb->monitor);
+    result = pbcc_get_msgs_v2(&pb->core, msgs, max);
+    pubnub_mutex_unlock(pb->monitor);
+
+    return result;
+}
@@ -12,6 +12,8 @@
 
 #include "pubnub_subscribe_v2_message.h"
 
+#include <stddef.h>
+
 /** @file pubnub_subscribe_v2.h
 
     This API is for the support of subscribe V2, which enables
@@ -95,6 +97,30 @@ enum pubnub_res pubnub_subscribe_v2(pubnub_t*                          p,
 struct pubnub_v2_message pubnub_get_v2(pubnub_t* pbp);
 
 
+/** Parse and return (up to) @p max next V2 messages, if any, into
+    the array @p msgs. This is like calling pubnub_get_v2() up to
+    @p max times, but is faster, especially if there are many
+    messages in the response. Unlike pubnub_get_v2(), which returns
+    an empty message for a malformed one, this skips malformed
+    messages. Use like:
+
+        struct pubnub_v2_message msgs[16];
+        size_t i, n;
+        while ((n = pubnub_get_v2_batch(pbp, msgs, 16)) > 0) {
+            for (i = 0; i < n; ++i) {
+                handle_message(&msgs[i]);
+            }
+        }
+
+    @param pbp The Pubnub context. Can't be NULL.
+    @param msgs The array to put the messages in
+    @param max The number of elements of @p msgs
+    @return The number of messages put in @p msgs. If less than
+    @p max, there are no more messages.
+ */
+size_t pubnub_get_v2_batch(pubnub_t* pbp, struct pubnub_v2_message* msgs, size_t max);
+
+
 
 
 #endif /* !defined INC_PUBNUB_SUBSCRIBE_V2 */
@@ -0,0 +1,259 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_timer_wheel.h"
+
+#include "pubnub_internal.h"
+#include "pubnub_assert.h"
+#include "pubnub_log.h"
+
+
+/** Index of the slot for timers beyond the span of the wheel */
+#define OVERFLOW_SLOT (PBTW_LEVELS * PBTW_SLOTS)
+
+/** Number of bits of time spanned by the whole wheel */
+#define WHEEL_BITS (PBTW_LEVELS * PBTW_SLOT_BITS)
+
+#define SLOT_MASK ((uint64_t)PBTW_SLOTS - 1)
+
+
+static unsigned lowest_bit(uint64_t bits)
+{
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(bits);
+#else
+    unsigned i = 0;
+    while (0 == (bits & 1)) {
+        bits >>= 1;
+        ++i;
+    }
+    return i;
+#endif
+}
+
+
+static void link_to_slot(struct pubnub_timer_wheel* wheel, pubnub_t* pb, unsigned idx)
+{
+    pubnub_t* head = wheel->slot[idx];
+
+    pb->previous = NULL;
+    pb->next     = head;
+    if (head != NULL) {
+        head->previous = pb;
+    }
+    wheel->slot[idx] = pb;
+    pb->timer_slot   = (uint16_t)(idx + 1);
+    if (idx < OVERFLOW_SLOT) {
+        wheel->occupied[idx / PBTW_SLOTS] |= (uint64_t)1 << (idx % PBTW_SLOTS);
+    }
+}
+
+
+/** Puts @p pb to the slot for its deadline, given the current time
+    of the @p wheel. The deadline must not be before the current time.
+ */
+static void place(struct pubnub_timer_wheel* wheel, pubnub_t* pb)
+{
+    uint64_t const deadline = pb->timer_deadline_ms;
+    uint64_t const now      = wheel->now_ms;
+    unsigned       level;
+
+    PUBNUB_ASSERT_OPT(deadline >= now);
+    for (level = 0; level < PBTW_LEVELS; ++level) {
+        unsigned const shift = level * PBTW_SLOT_BITS;
+        if ((deadline >> (shift + PBTW_SLOT_BITS)) == (now >> (shift + PBTW_SLOT_BITS))) {
+            link_to_slot(wheel,
+                         pb,
+                         level * PBTW_SLOTS + (unsigned)((deadline >> shift) & SLOT_MASK));
+            return;
+        }
+    }
+    link_to_slot(wheel, pb, OVERFLOW_SLOT);
+}
+
+
+/** Takes the whole list out of the slot @p idx of @p wheel */
+static pubnub_t* take_slot(struct pubnub_timer_wheel* wheel, unsigned idx)
+{
+    pubnub_t* list = wheel->slot[idx];
+
+    wheel->slot[idx] = NULL;
+    if (idx < OVERFLOW_SLOT) {
+        wheel->occupied[idx / PBTW_SLOTS] &= ~((uint64_t)1 << (idx % PBTW_SLOTS));
+    }
+    return list;
+}
+
+
+/** Re-places all timers from the slot @p idx of @p wheel, which
+    moves them to lower levels.
+ */
+static void cascade(struct pubnub_timer_wheel* wheel, unsigned idx)
+{
+    pubnub_t* list = take_slot(wheel, idx);
+
+    while (list != NULL) {
+        pubnub_t* next = list->next;
+        place(wheel, list);
+        list = next;
+    }
+}
+
+
+void pubnub_timer_wheel_init(struct pubnub_timer_wheel* wheel, uint64_t now_ms)
+{
+    unsigned i;
+
+    PUBNUB_ASSERT_OPT(wheel != NULL);
+
+    wheel->now_ms = now_ms;
+    wheel->count  = 0;
+    for (i = 0; i < PBTW_LEVELS; ++i) {
+        wheel->occupied[i] = 0;
+    }
+    for (i = 0; i <= OVERFLOW_SLOT; ++i) {
+        wheel->slot[i] = NULL;
+    }
+}
+
+
+void pubnub_timer_wheel_add(struct pubnub_timer_wheel* wheel,
+                            pubnub_t*                  to_add,
+                            uint64_t                   deadline_ms)
+{
+    PUBNUB_ASSERT_OPT(wheel != NULL);
+    PUBNUB_ASSERT_OPT(to_add != NULL);
+
+    pubnub_timer_wheel_remove(wheel, to_add);
+    if (deadline_ms <= wheel->now_ms) {
+        deadline_ms = wheel->now_ms + 1;
+    }
+    to_add->timer_deadline_ms = deadline_ms;
+    place(wheel, to_add);
+    ++wheel->count;
+}
+
+
+void pubnub_timer_wheel_remove(struct pubnub_timer_wheel* wheel,
+                               pubnub_t*                  to_remove)
+{
+    unsigned idx;
+
+    PUBNUB_ASSERT_OPT(wheel != NULL);
+    PUBNUB_ASSERT_OPT(to_remove != NULL);
+
+    if (0 == to_remove->timer_slot) {
+        return;
+    }
+    idx = to_remove->timer_slot - 1;
+    PUBNUB_ASSERT(idx <= OVERFLOW_SLOT);
+    if (to_remove->previous != NULL) {
+        to_remove->previous->next = to_remove->next;
+    }
+    else {
+        PUBNUB_ASSERT(wheel->slot[idx] == to_remove);
+        wheel->slot[idx] = to_remove->next;
+        if ((NULL == to_remove->next) && (idx < OVERFLOW_SLOT)) {
+            wheel->occupied[idx / PBTW_SLOTS] &= ~((uint64_t)1 << (idx % PBTW_SLOTS));
+        }
+    }
+    if (to_remove->next != NULL) {
+        to_remove->next->previous = to_remove->previous;
+    }
+    to_remove->previous = to_remove->next = NULL;
+    to_remove->timer_slot                 = 0;
+    --wheel->count;
+}
+
+
+pubnub_t* pubnub_timer_wheel_advance(struct pubnub_timer_wheel* wheel,
+                                     uint64_t                   now_ms)
+{
+    pubnub_t* expired = NULL;
+
+    PUBNUB_ASSERT_OPT(wheel != NULL);
+
+    while (wheel->now_ms < now_ms) {
+        unsigned const cur = (unsigned)(wheel->now_ms & SLOT_MASK);
+        uint64_t const ahead =
+            (cur == PBTW_SLOTS - 1) ? 0 : wheel->occupied[0] & (~(uint64_t)0 << (cur + 1));
+        uint64_t  next;
+        pubnub_t* list;
+
+        if (0 == wheel->count) {
+            wheel->now_ms = now_ms;
+            break;
+        }
+        if (ahead != 0) {
+            next = (wheel->now_ms & ~SLOT_MASK) | lowest_bit(ahead);
+        }
+        else {
+            /* Nothing more at level 0, skip to the next cascade */
+            next = (wheel->now_ms | SLOT_MASK) + 1;
+        }
+        if (next > now_ms) {
+            wheel->now_ms = now_ms;
+            break;
+        }
+        wheel->now_ms = next;
+        if (0 == (next & SLOT_MASK)) {
+            unsigned level;
+            if (0 == (next & (((uint64_t)1 << WHEEL_BITS) - 1))) {
+                cascade(wheel, OVERFLOW_SLOT);
+            }
+            for (level = PBTW_LEVELS - 1; level > 0; --level) {
+                unsigned const shift = level * PBTW_SLOT_BITS;
+                if (0 == (next & (((uint64_t)1 << shift) - 1))) {
+                    cascade(wheel, level * PBTW_SLOTS + (unsigned)((next >> shift) & SLOT_MASK));
+                }
+            }
+        }
+
+        list = take_slot(wheel, (unsigned)(next & SLOT_MASK));
+        while (list != NULL) {
+            pubnub_t* pb = list;
+            list         = pb->next;
+            PUBNUB_ASSERT(pb->timer_deadline_ms == next);
+            PUBNUB_LOG_TRACE("pubnub_timer_wheel_advance(wheel=%p): pb=%p expired\n",
+                             wheel,
+                             pb);
+            pb->timer_slot = 0;
+            pb->previous   = NULL;
+            pb->next       = expired;
+            expired        = pb;
+            --wheel->count;
+        }
+    }
+
+    return expired;
+}
+
+
+int64_t pubnub_timer_wheel_next_ms(struct pubnub_timer_wheel const* wheel,
+                                   uint64_t                         now_ms)
+{
+    uint64_t earliest;
+    unsigned level;
+
+    PUBNUB_ASSERT_OPT(wheel != NULL);
+
+    if (0 == wheel->count) {
+        return -1;
+    }
+    /* Past the last slot of the last level is the "overflow" */
+    earliest = ((wheel->now_ms >> WHEEL_BITS) + 1) << WHEEL_BITS;
+    /* All occupied slots are "ahead" of the current time on their
+       level, so the lowest one on a level is the earliest.
+     */
+    for (level = 0; level < PBTW_LEVELS; ++level) {
+        if (wheel->occupied[level] != 0) {
+            unsigned const shift = level * PBTW_SLOT_BITS;
+            uint64_t const at =
+                ((wheel->now_ms >> (shift + PBTW_SLOT_BITS)) << (shift + PBTW_SLOT_BITS))
+                | ((uint64_t)lowest_bit(wheel->occupied[level]) << shift);
+            if (at < earliest) {
+                earliest = at;
+            }
+        }
+    }
+
+    return (earliest > now_ms) ? (int64_t)(earliest - now_ms) : 0;
+}
@@ -0,0 +1,102 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_TIMER_WHEEL
+#define INC_PUBNUB_TIMER_WHEEL
+
+
+#include "pubnub_api_types.h"
+
+#include <stdint.h>
+
+
+/** @file pubnub_timer_wheel.h
+
+    A hierarchical timing wheel of Pubnub contexts (their timers).
+    It has #PBTW_LEVELS levels of #PBTW_SLOTS slots each. A slot of
+    level 0 holds the timers that expire in a particular millisecond,
+    a slot of level 1 those that expire in a particular (aligned)
+    span of #PBTW_SLOTS milliseconds, and so on. As time goes by,
+    timers from higher levels "cascade" down to lower ones, until
+    they expire from level 0.
+
+    Adding and removing a timer is O(1), regardless of the number of
+    timers in the wheel. Time is absolute (milliseconds from some
+    arbitrary, but fixed, point - typically, a monotonic clock).
+
+    Timers are kept in the contexts (`next`/`previous` links), so a
+    context can be in just one wheel (or timer list) at the time.
+    The wheel is not thread-safe, the user must lock it.
+*/
+
+
+/** Number of bits of time handled by a level of the wheel */
+#define PBTW_SLOT_BITS 6
+
+/** Number of slots in a level of the wheel */
+#define PBTW_SLOTS (1 << PBTW_SLOT_BITS)
+
+/** Number of levels of the wheel. With the 1 ms resolution, the
+    wheel spans about 4.6 hours. Timers further away than that are
+    kept aside and put to the wheel when they get close enough.
+ */
+#define PBTW_LEVELS 4
+
+
+/** The timing wheel. Treat as opaque. */
+struct pubnub_timer_wheel {
+    /** The time up to which (inclusive) the timers were expired */
+    uint64_t now_ms;
+    /** Bitmaps of non-empty slots, one per level */
+    uint64_t occupied[PBTW_LEVELS];
+    /** Slots, each is a list of contexts (timers). The last one is
+        for timers beyond the span of the wheel. */
+    pubnub_t* slot[PBTW_LEVELS * PBTW_SLOTS + 1];
+    /** Number of timers in the wheel */
+    unsigned count;
+};
+
+
+/** Initializes the timing wheel @p wheel, with the current time
+    @p now_ms. Wheel will be empty.
+ */
+void pubnub_timer_wheel_init(struct pubnub_timer_wheel* wheel, uint64_t now_ms);
+
+/** Adds the timer of the context @p to_add, which has to expire at
+    @p deadline_ms, to @p wheel. If @p to_add is already in @p wheel,
+    it is first removed (so, this re-starts a timer).
+
+    If @p deadline_ms is not after the current time of the wheel,
+    the timer will expire on the next advance of time.
+ */
+void pubnub_timer_wheel_add(struct pubnub_timer_wheel* wheel,
+                            pubnub_t*                  to_add,
+                            uint64_t                   deadline_ms);
+
+/** Removes the timer of the context @p to_remove from @p wheel. If
+    it is not in @p wheel, does nothing.
+ */
+void pubnub_timer_wheel_remove(struct pubnub_timer_wheel* wheel,
+                               pubnub_t*                  to_remove);
+
+/** Advances the time of @p wheel to @p now_ms, dequeueing all the
+    timers that have expired up to (including) that time, and
+    returning them in a list (linked by `next`).
+
+    @return List of expired timers (NULL if none have expired)
+ */
+pubnub_t* pubnub_timer_wheel_advance(struct pubnub_timer_wheel* wheel,
+                                     uint64_t                   now_ms);
+
+/** Returns the number of milliseconds from @p now_ms to the moment
+    the wheel @p wheel next needs to be advanced. That is no later
+    than the earliest deadline in the wheel, but may be earlier (when
+    timers have to cascade down the levels). Use it as the timeout
+    for waiting on I/O.
+
+    @return Milliseconds to wait (0 if something is due already), or
+    -1 if the wheel is empty
+ */
+int64_t pubnub_timer_wheel_next_ms(struct pubnub_timer_wheel const* wheel,
+                                   uint64_t                         now_ms);
+
+
+#endif /* !defined INC_PUBNUB_TIMER_WHEEL */
@@ -0,0 +1,137 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "cgreen/cgreen.h"
+#include "cgreen/mocks.h"
+
+#include "pubnub_internal.h"
+#include "pubnub_timer_wheel.h"
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+
+
+/* A less chatty cgreen :) */
+
+#define attest assert_that
+#define equals is_equal_to
+#define differs is_not_equal_to
+
+
+Describe(pubnub_timer_wheel);
+
+/* Start at an "odd" time, so that we're not aligned to slots */
+#define START_MS 1000003
+
+static struct pubnub_timer_wheel m_wheel;
+static pubnub_t m_pb[3];
+
+
+BeforeEach(pubnub_timer_wheel) {
+    unsigned i;
+    pubnub_timer_wheel_init(&m_wheel, START_MS);
+    for (i = 0; i < sizeof m_pb / sizeof m_pb[0]; ++i) {
+        m_pb[i].previous   = m_pb[i].next = NULL;
+        m_pb[i].timer_slot = 0;
+    }
+}
+
+
+AfterEach(pubnub_timer_wheel) {
+}
+
+
+Ensure(pubnub_timer_wheel, expire_when_empty) {
+    attest(pubnub_timer_wheel_next_ms(&m_wheel, START_MS), equals(-1));
+    attest(pubnub_timer_wheel_advance(&m_wheel, START_MS + 1000), equals(NULL));
+    attest(pubnub_timer_wheel_next_ms(&m_wheel, START_MS + 1000), equals(-1));
+}
+
+
+Ensure(pubnub_timer_wheel, expire_one_exactly_on_time) {
+    pubnub_t* expired;
+
+    pubnub_timer_wheel_add(&m_wheel, &m_pb[0], START_MS + 10);
+    attest(pubnub_timer_wheel_next_ms(&m_wheel, START_MS), equals(10));
+    attest(pubnub_timer_wheel_advance(&m_wheel, START_MS + 9), equals(NULL));
+    attest(pubnub_timer_wheel_next_ms(&m_wheel, START_MS + 9), equals(1));
+    expired = pubnub_timer_wheel_advance(&m_wheel, START_MS + 10);
+    attest(expired, equals(&m_pb[0]));
+    attest(expired->next, equals(NULL));
+    attest(pubnub_timer_wheel_next_ms(&m_wheel, START_MS + 10), equals(-1));
+}
+
+
+Ensure(pubnub_timer_wheel, expire_far_one_after_cascading) {
+    pubnub_t* expired       = NULL;
+    uint64_t  now           = START_MS;
+    uint64_t const deadline = START_MS + 310000;
+
+    pubnub_timer_wheel_add(&m_wheel, &m_pb[0], deadline);
+    while (NULL == expired) {
+        int64_t wait = pubnub_timer_wheel_next_ms(&m_wheel, now);
+        attest(wait >= 0, equals(true));
+        attest(now + wait <= deadline, equals(true));
+        now += (wait > 0) ? wait : 1;
+        expired = pubnub_timer_wheel_advance(&m_wheel, now);
+    }
+    attest(expired, equals(&m_pb[0]));
+    attest(now, equals(deadline));
+}
+
+
+Ensure(pubnub_timer_wheel, expire_beyond_the_span_of_the_wheel) {
+    pubnub_t* expired;
+    uint64_t const deadline = START_MS + 20000000;
+
+    pubnub_timer_wheel_add(&m_wheel, &m_pb[0], deadline);
+    attest(pubnub_timer_wheel_advance(&m_wheel, deadline - 1), equals(NULL));
+    expired = pubnub_timer_wheel_advance(&m_wheel, deadline);
+    attest(expired, equals(&m_pb[0]));
+}
+
+
+Ensure(pubnub_timer_wheel, expire_several_in_one_go) {
+    pubnub_t* expired;
+
+    pubnub_timer_wheel_add(&m_wheel, &m_pb[0], START_MS + 5);
+    pubnub_timer_wheel_add(&m_wheel, &m_pb[1], START_MS + 5000);
+    pubnub_timer_wheel_add(&m_wheel, &m_pb[2], START_MS + 70);
+    attest(pubnub_timer_wheel_next_ms(&m_wheel, START_MS), equals(5));
+
+    expired = pubnub_timer_wheel_advance(&m_wheel, START_MS + 100);
+    attest(expired, differs(NULL));
+    attest(expired->next, differs(NULL));
+    attest(expired->next->next, equals(NULL));
+    attest((expired == &m_pb[0]) || (expired == &m_pb[2]), equals(true));
+    attest((expired->next == &m_pb[0]) || (expired->next == &m_pb[2]), equals(true));
+
+    expired = pubnub_timer_wheel_advance(&m_wheel, START_MS + 5000);
+    attest(expired, equals(&m_pb[1]));
+}
+
+
+Ensure(pubnub_timer_wheel, removed_does_not_expire) {
+    pubnub_timer_wheel_add(&m_wheel, &m_pb[0], START_MS + 10);
+    pubnub_timer_wheel_add(&m_wheel, &m_pb[1], START_MS + 10);
+    pubnub_timer_wheel_remove(&m_wheel, &m_pb[0]);
+    pubnub_timer_wheel_remove(&m_wheel, &m_pb[0]);
+    attest(pubnub_timer_wheel_advance(&m_wheel, START_MS + 10), equals(&m_pb[1]));
+    attest(pubnub_timer_wheel_next_ms(&m_wheel, START_MS + 10), equals(-1));
+}
+
+
+Ensure(pubnub_timer_wheel, add_again_restarts_timer) {
+    pubnub_timer_wheel_add(&m_wheel, &m_pb[0], START_MS + 10);
+    pubnub_timer_wheel_add(&m_wheel, &m_pb[0], START_MS + 1000);
+    attest(pubnub_timer_wheel_advance(&m_wheel, START_MS + 999), equals(NULL));
+    attest(pubnub_timer_wheel_advance(&m_wheel, START_MS + 1000), equals(&m_pb[0]));
+}
+
+
+Ensure(pubnub_timer_wheel, past_deadline_expires_on_next_advance) {
+    pubnub_timer_wheel_advance(&m_wheel, START_MS + 100);
+    pubnub_timer_wheel_add(&m_wheel, &m_pb[0], START_MS);
+    attest(pubnub_timer_wheel_next_ms(&m_wheel, START_MS + 100), equals(1));
+    attest(pubnub_timer_wheel_advance(&m_wheel, START_MS + 101), equals(&m_pb[0]));
+}
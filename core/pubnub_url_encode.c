@@ -5,65 +5,226 @@
 #include "pubnub_assert.h"
 #include "pubnub_log.h"
 
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
-int pubnub_url_encode(char* buffer, char const* what, size_t buffer_size)
+
+/** If true, the characters that don't need encoding are found a
+    block at a time, with SSSE3, if the CPU (as checked at runtime)
+    supports it. Like for JSON parsing, only in optimized builds with
+    GCC (compatible) compilers for x86.
+ */
+#if !defined PUBNUB_URL_ENCODE_USE_SIMD
+#if defined __GNUC__ && defined __OPTIMIZE__ \
+    && (defined __x86_64__ || (defined __i386__ && defined __SSE2__))
+#define PUBNUB_URL_ENCODE_USE_SIMD 1
+#else
+#define PUBNUB_URL_ENCODE_USE_SIMD 0
+#endif
+#endif
+
+#if PUBNUB_URL_ENCODE_USE_SIMD
+#include <immintrin.h>
+#endif
+
+
+/** The #OK_SPAN_CHARACTERS as a bitmap: bit `c % 32` of element
+    `c / 32` is set if character `c` (< 128) is OK.
+ */
+static uint32_t const m_ok_bits[4] = { 0x00000000U, 0x2FFF7000U, 0xAFFFFFFFU, 0x47FFFFFEU };
+
+
+static bool is_ok(unsigned char c)
 {
-    int i = 0;
+    return (c < 128) && (0 != ((m_ok_bits[c >> 5] >> (c & 31)) & 1));
+}
 
-    PUBNUB_ASSERT_OPT(buffer != NULL);
-    PUBNUB_ASSERT_OPT(what != NULL);
 
-    *buffer='\0';
-    while (what[0]) {
+static size_t ok_span_scalar(char const* s, size_t len)
+{
+    size_t i;
+    for (i = 0; (i < len) && is_ok((unsigned char)s[i]); ++i) {
+        continue;
+    }
+    return i;
+}
+
+
+#if PUBNUB_URL_ENCODE_USE_SIMD
+/* A character is OK if it's set in both the bitmask for its low
+   nibble and the bitmask for its high nibble, the bits of which are
+   "which high nibble". One shuffle of a table per nibble and we
+   check 16 characters at once. */
+__attribute__((target("ssse3"))) static size_t ok_span_ssse3(char const* s, size_t len)
+{
+    __m128i const lut_lo = _mm_setr_epi8(0x2E, 0x3E, 0x3E, 0x3E, 0x3E, 0x3E, 0x3E, 0x3E,
+                                         0x3E, 0x3E, 0x3E, 0x1E, 0x15, 0x1F, 0x35, 0x1C);
+    __m128i const lut_hi = _mm_setr_epi8(0x00, 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20,
+                                         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
+    __m128i const nibble = _mm_set1_epi8(0x0F);
+    size_t        i;
+
+    for (i = 0; i + 16 <= len; i += 16) {
+        __m128i const v  = _mm_loadu_si128((__m128i const*)(s + i));
+        __m128i const lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(v, nibble));
+        __m128i const hi =
+            _mm_shuffle_epi8(lut_hi, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+        unsigned const not_ok = (unsigned)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()));
+        if (not_ok != 0) {
+            return i + __builtin_ctz(not_ok);
+        }
+    }
+    return i + ok_span_scalar(s + i, len - i);
+}
+#endif /* PUBNUB_URL_ENCODE_USE_SIMD */
+
+
+/** Returns the number of characters from the start of @p s, of
+    length @p len, that don't need encoding.
+ */
+static size_t ok_span(char const* s, size_t len)
+{
+#if PUBNUB_URL_ENCODE_USE_SIMD
+#if !defined __SSSE3__
+    if (__builtin_cpu_supports("ssse3"))
+#endif
+    {
+        return ok_span_ssse3(s, len);
+    }
+#endif
+    return ok_span_scalar(s, len);
+}
+
+
+static void log_too_long(char const* buffer, size_t buffer_size, char const* rest)
+{
+    PUBNUB_LOG_ERROR("Error:|Url-encoded string is longer than permited.\n"
+                     "      |buffer_size = %u\n"
+                     "      |url-encoded_stretch = \"%s\"\n"
+                     "      |url-encoded-stretch_length = %u\n"
+                     "      |rest_of_the_string_to_be_encoded = \"%s\"\n"
+                     "      |length_of_the_rest_of_the_string_to_be_encoded = %u\n",
+                     (unsigned)buffer_size,
+                     buffer,
+                     (unsigned)strlen(buffer),
+                     rest,
+                     (unsigned)strlen(rest));
+}
+
+
+/** Url-encodes @p what, of length @p len */
+static int encode(char* buffer, char const* what, size_t len, size_t buffer_size)
+{
+    char const* end = what + len;
+    size_t      i   = 0;
+
+    while (what < end) {
         /* RFC 3986 Unreserved characters plus few
          * safe reserved ones. */
-        size_t okspan = strspn(what, OK_SPAN_CHARACTERS);
+        size_t const okspan = ok_span(what, end - what);
         if (okspan > 0) {
             if (okspan >= (unsigned)(buffer_size - i - 1)) {
-                PUBNUB_LOG_ERROR("Error:|Url-encoded string is longer than permited.\n"
-                                 "      |buffer_size = %u\n"
-                                 "      |url-encoded_stretch = \"%s\"\n"
-                                 "      |url-encoded-stretch_length = %u\n"
-                                 "      |rest_of_the_string_to_be_encoded = \"%s\"\n"
-                                 "      |length_of_the_rest_of_the_string_to_be_encoded = %u\n",
-                                 (unsigned)buffer_size,
-                                 buffer,
-                                 (unsigned)strlen(buffer),
-                                 what,
-                                 (unsigned)strlen(what));
+                buffer[i] = '\0';
+                log_too_long(buffer, buffer_size, what);
                 return -1;
             }
             memcpy(buffer + i, what, okspan);
             i += okspan;
-            buffer[i] = '\0';
             what += okspan;
         }
-        if (what[0]) {
+        for (; (what < end) && !is_ok((unsigned char)*what); ++what) {
             /* %-encode a non-ok character. */
-            char enc[4] = { '%' };
-            enc[1]      = "0123456789ABCDEF"[(unsigned char)what[0] / 16];
-            enc[2]      = "0123456789ABCDEF"[(unsigned char)what[0] % 16];
             if (3 > buffer_size - i - 1) {
-                PUBNUB_LOG_ERROR("Error:|Url-encoded string is longer than permited.\n"
-                                 "      |buffer_size = %u\n"
-                                 "      |url-encoded_stretch = \"%s\"\n"
-                                 "      |url-encoded-stretch_length = %u\n"
-                                 "      |rest_of_the_string_to_be_encoded = \"%s\"\n"
-                                 "      |length_of_the_rest_of_the_string_to_be_encoded = %u\n",
-                                 (unsigned)buffer_size,
-                                 buffer,
-                                 (unsigned)strlen(buffer),
-                                 what,
-                                 (unsigned)strlen(what));
+                buffer[i] = '\0';
+                log_too_long(buffer, buffer_size, what);
                 return -1;
             }
-            /* Last copied character is '\0' */
-            memcpy(buffer + i, enc, 4);
+            buffer[i]     = '%';
+            buffer[i + 1] = "0123456789ABCDEF"[(unsigned char)*what / 16];
+            buffer[i + 2] = "0123456789ABCDEF"[(unsigned char)*what % 16];
             i += 3;
-            ++what;
         }
     }
+    buffer[i] = '\0';
 
-    return i;
+    return (int)i;
+}
+
+
+int pubnub_url_encode(char* buffer, char const* what, size_t buffer_size)
+{
+    PUBNUB_ASSERT_OPT(buffer != NULL);
+    PUBNUB_ASSERT_OPT(what != NULL);
+
+    return encode(buffer, what, strlen(what), buffer_size);
+}
+
+
+void pubnub_url_encode_cache_init(struct pubnub_url_encode_cache* cache)
+{
+    PUBNUB_ASSERT_OPT(cache != NULL);
+
+    cache->src     = NULL;
+    cache->len     = 0;
+    cache->enc_len = 0;
+    cache->data    = NULL;
+    cache->cap     = 0;
+}
+
+
+void pubnub_url_encode_cache_free(struct pubnub_url_encode_cache* cache)
+{
+    PUBNUB_ASSERT_OPT(cache != NULL);
+
+    free(cache->data);
+    pubnub_url_encode_cache_init(cache);
+}
+
+
+int pubnub_url_encode_cached(struct pubnub_url_encode_cache* cache,
+                             char*                           buffer,
+                             char const*                     what,
+                             size_t                          buffer_size)
+{
+    size_t len;
+    size_t need;
+    int    rslt;
+
+    PUBNUB_ASSERT_OPT(cache != NULL);
+    PUBNUB_ASSERT_OPT(buffer != NULL);
+    PUBNUB_ASSERT_OPT(what != NULL);
+
+    len = strlen(what);
+    /* The same pointer may have different contents by now, so we
+       have to compare them, but that's cheaper than encoding. If the
+       encoding might not fit, let encode() decide and report. */
+    if ((what == cache->src) && (len == cache->len) && (cache->enc_len + 2 <= buffer_size)
+        && (0 == memcmp(cache->data, what, len))) {
+        memcpy(buffer, cache->data + len, cache->enc_len + 1);
+        return (int)cache->enc_len;
+    }
+    rslt = encode(buffer, what, len, buffer_size);
+    if (rslt < 0) {
+        return rslt;
+    }
+    need = len + rslt + 1;
+    if (need > cache->cap) {
+        char* data = (char*)realloc(cache->data, need);
+        if (NULL == data) {
+            /* Not caching is not an error */
+            cache->src = NULL;
+            return rslt;
+        }
+        cache->data = data;
+        cache->cap  = need;
+    }
+    memcpy(cache->data, what, len);
+    memcpy(cache->data + len, buffer, rslt + 1);
+    cache->src     = what;
+    cache->len     = len;
+    cache->enc_len = rslt;
+
+    return rslt;
 }
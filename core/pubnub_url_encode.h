@@ -2,6 +2,8 @@
 #if !defined INC_PUBNUB_URL_ENCODE
 #define INC_PUBNUB_URL_ENCODE
 
+#include <stddef.h>
+
 /* RFC 3986 Unreserved characters plus few
  * safe reserved ones. */
 #define OK_SPAN_CHARACTERS "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.~,=:;@[]"
@@ -12,5 +14,41 @@
  */
 int pubnub_url_encode(char* buffer, char const* what, size_t buffer_size);
 
+
+/** A cache of the last string that was url-encoded, to not encode it
+    again if the same string (same pointer, same contents) is encoded
+    next - like the channel (list) of a subscribe, repeated every
+    time.
+ */
+struct pubnub_url_encode_cache {
+    /** The string that was encoded (the pointer given) */
+    char const* src;
+    /** Length of the string that was encoded */
+    size_t len;
+    /** Length of the encoding */
+    size_t enc_len;
+    /** Copy of the string that was encoded, followed by its encoding
+        (NUL terminated). Allocated. */
+    char* data;
+    /** Size of the allocated #data */
+    size_t cap;
+};
+
+/** Initializes the url-encode @p cache to empty */
+void pubnub_url_encode_cache_init(struct pubnub_url_encode_cache* cache);
+
+/** Frees what the url-encode @p cache allocated, leaving it empty */
+void pubnub_url_encode_cache_free(struct pubnub_url_encode_cache* cache);
+
+/** Like pubnub_url_encode(), but if @p what is the string (the same
+    pointer, with the same contents) that was encoded last with the
+    @p cache, copies the encoding from the @p cache. Otherwise, it
+    encodes @p what and remembers it in the @p cache.
+ */
+int pubnub_url_encode_cached(struct pubnub_url_encode_cache* cache,
+                             char*                           buffer,
+                             char const*                     what,
+                             size_t                          buffer_size);
+
 #endif /* !defined INC_PUBNUB_URL_ENCODE */
 
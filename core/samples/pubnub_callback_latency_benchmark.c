@@ -0,0 +1,262 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "pubnub_callback.h"
+
+#include "core/pubnub_helper.h"
+#include "core/pubnub_timers.h"
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/** @file pubnub_callback_latency_benchmark.c
+
+    Measures the latency of transactions on the callback interface:
+
+    - start to send: from starting a publish to its request being
+      written to the socket, that is, how long it takes the callback
+      thread to "notice" the new transaction and send the request,
+      which is what this is really about. We get the time of the
+      write by interposing send() and sendmsg(), so this is not
+      available with OpenSSL, which writes to the socket in its own
+      way.
+
+    - start to outcome: from starting a publish to getting its
+      outcome via callback, which also includes the round-trip to
+      the server.
+
+    Between publishes we pause a little, to let the callback thread
+    go (back) to waiting for I/O.
+
+    Usage: pubnub_callback_latency_benchmark [origin [count [pause_ms]]]
+ */
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+struct Bench {
+    pthread_mutex_t mutw;
+    pthread_cond_t  condw;
+    bool            done;
+    enum pubnub_res result;
+    double          done_at_ms;
+    /** When the request was sent, 0 if not (yet) */
+    double sent_at_ms;
+};
+
+
+/** The benchmark, for the send() interposer */
+static struct Bench m_bench;
+
+
+/** Records the time @p t of sending (the first request of a
+    publish), if not already recorded.
+ */
+static void record_send(double t)
+{
+    pthread_mutex_lock(&m_bench.mutw);
+    if (0 == m_bench.sent_at_ms) {
+        m_bench.sent_at_ms = t;
+    }
+    pthread_mutex_unlock(&m_bench.mutw);
+}
+
+
+/** Records when a request is sent and sends it, with the "real"
+    send().
+ */
+ssize_t send(int s, void const* buf, size_t len, int flags)
+{
+    typedef ssize_t (*send_fn)(int, void const*, size_t, int);
+    static send_fn real_send;
+
+    record_send(now_ms());
+    if (NULL == real_send) {
+        real_send = (send_fn)dlsym(RTLD_NEXT, "send");
+        if (NULL == real_send) {
+            return -1;
+        }
+    }
+    return real_send(s, buf, len, flags);
+}
+
+
+/** Like send(), for the vectored send (`PUBNUB_USE_VECTORED_SEND`) */
+ssize_t sendmsg(int s, struct msghdr const* msg, int flags)
+{
+    typedef ssize_t (*sendmsg_fn)(int, struct msghdr const*, int);
+    static sendmsg_fn real_sendmsg;
+
+    record_send(now_ms());
+    if (NULL == real_sendmsg) {
+        real_sendmsg = (sendmsg_fn)dlsym(RTLD_NEXT, "sendmsg");
+        if (NULL == real_sendmsg) {
+            return -1;
+        }
+    }
+    return real_sendmsg(s, msg, flags);
+}
+
+
+static void bench_callback(pubnub_t*         pb,
+                           enum pubnub_trans trans,
+                           enum pubnub_res   result,
+                           void*             user_data)
+{
+    struct Bench* bench = (struct Bench*)user_data;
+    double const  t     = now_ms();
+
+    PUBNUB_UNUSED(pb);
+    PUBNUB_UNUSED(trans);
+    pthread_mutex_lock(&bench->mutw);
+    bench->done       = true;
+    bench->result     = result;
+    bench->done_at_ms = t;
+    pthread_cond_signal(&bench->condw);
+    pthread_mutex_unlock(&bench->mutw);
+}
+
+
+static enum pubnub_res await_outcome(struct Bench* bench)
+{
+    enum pubnub_res rslt;
+
+    pthread_mutex_lock(&bench->mutw);
+    while (!bench->done) {
+        pthread_cond_wait(&bench->condw, &bench->mutw);
+    }
+    bench->done = false;
+    rslt        = bench->result;
+    pthread_mutex_unlock(&bench->mutw);
+
+    return rslt;
+}
+
+
+static int compare_double(void const* a, void const* b)
+{
+    double const x = *(double const*)a;
+    double const y = *(double const*)b;
+    return (x > y) - (x < y);
+}
+
+
+static double percentile(double const* sorted, unsigned n, unsigned pct)
+{
+    unsigned i = (n * pct + 99) / 100;
+    return sorted[(i > 0) ? i - 1 : 0];
+}
+
+
+/** Prints the percentiles of the @p count @p latency values, which
+    are sorted.
+ */
+static void print_latency(char const* what, double* latency, unsigned count)
+{
+    qsort(latency, count, sizeof latency[0], compare_double);
+    printf("  %-17s p50=%.3f p90=%.3f p99=%.3f max=%.3f\n",
+           what,
+           percentile(latency, count, 50),
+           percentile(latency, count, 90),
+           percentile(latency, count, 99),
+           latency[count - 1]);
+}
+
+
+int main(int argc, char* argv[])
+{
+    char const*     origin   = (argc > 1) ? argv[1] : NULL;
+    unsigned const  count    = (argc > 2) ? (unsigned)atoi(argv[2]) : 1000;
+    unsigned const  pause_ms = (argc > 3) ? (unsigned)atoi(argv[3]) : 5;
+    struct Bench*   bench    = &m_bench;
+    double*         to_send;
+    double*         to_outcome;
+    unsigned        i;
+    unsigned        sent   = 0;
+    unsigned        failed = 0;
+    pubnub_t*       pbp;
+    struct timespec pause;
+
+    if (0 == count) {
+        printf("Nothing to do\n");
+        return 0;
+    }
+    to_send    = (double*)malloc(sizeof to_send[0] * count);
+    to_outcome = (double*)malloc(sizeof to_outcome[0] * count);
+    pbp        = pubnub_alloc();
+    if ((NULL == to_send) || (NULL == to_outcome) || (NULL == pbp)) {
+        printf("Failed to allocate\n");
+        return -1;
+    }
+    pthread_mutex_init(&bench->mutw, NULL);
+    pthread_cond_init(&bench->condw, NULL);
+    bench->done = false;
+
+    pubnub_init(pbp, "demo", "demo");
+    if (origin != NULL) {
+        pubnub_origin_set(pbp, origin);
+    }
+    pubnub_register_callback(pbp, bench_callback, bench);
+    pause.tv_sec  = pause_ms / 1000;
+    pause.tv_nsec = (pause_ms % 1000) * 1000000L;
+
+    /* The first one also connects, so we don't count it */
+    pubnub_publish(pbp, "latency_bench", "\"warm-up\"");
+    await_outcome(bench);
+
+    for (i = 0; i < count; ++i) {
+        double started;
+
+        pthread_mutex_lock(&bench->mutw);
+        bench->sent_at_ms = 0;
+        pthread_mutex_unlock(&bench->mutw);
+        started = now_ms();
+        if (PNR_STARTED == pubnub_publish(pbp, "latency_bench", "\"ping\"")) {
+            if (await_outcome(bench) != PNR_OK) {
+                ++failed;
+            }
+            to_outcome[i] = bench->done_at_ms - started;
+        }
+        else {
+            ++failed;
+            to_outcome[i] = now_ms() - started;
+        }
+        pthread_mutex_lock(&bench->mutw);
+        if (bench->sent_at_ms != 0) {
+            to_send[sent++] = bench->sent_at_ms - started;
+        }
+        pthread_mutex_unlock(&bench->mutw);
+        nanosleep(&pause, NULL);
+    }
+
+    printf("%u publishes (%u failed), latency in ms:\n", count, failed);
+    if (sent > 0) {
+        print_latency("start to send:", to_send, sent);
+    }
+    else {
+        printf("  start to send:    not available (no send() seen)\n");
+    }
+    print_latency("start to outcome:", to_outcome, count);
+
+    pubnub_free(pbp);
+    free(to_outcome);
+    free(to_send);
+    pthread_cond_destroy(&bench->condw);
+    pthread_mutex_destroy(&bench->mutw);
+
+    return 0;
+}
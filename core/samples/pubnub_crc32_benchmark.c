@@ -0,0 +1,127 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "lib/pbcrc32.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/** @file pubnub_crc32_benchmark.c
+
+    Measures the throughput of pbcrc32() (used for the gzip trailer of
+    compressed publishes) on payloads of 100 bytes to 32 KB, against
+    the byte-at-a-time table lookup it used to be.
+
+    Usage: pubnub_crc32_benchmark [megabytes_per_size]
+ */
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+static uint32_t m_table[256];
+
+
+static void make_table(void)
+{
+    uint32_t i;
+    for (i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        int      k;
+        for (k = 0; k < 8; ++k) {
+            c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        }
+        m_table[i] = c;
+    }
+}
+
+
+/** The CRC one byte at a time, as pbcrc32() used to compute it */
+static uint32_t crc32_bytewise(void const* data, size_t n)
+{
+    uint8_t const* p   = (uint8_t const*)data;
+    uint32_t       crc = 0xFFFFFFFF;
+
+    for (; n > 0; --n, ++p) {
+        crc = m_table[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+
+typedef uint32_t (*crc_function)(void const* data, size_t n);
+
+
+static uint32_t crc32_library(void const* data, size_t n)
+{
+    return pbcrc32(data, n);
+}
+
+
+/** Returns the MB/s of @p f over @p total bytes in @p size chunks */
+static double run(crc_function f, uint8_t const* data, size_t size, size_t total, uint32_t* crc)
+{
+    size_t const iterations = (total + size - 1) / size;
+    double const started    = now_ms();
+    uint32_t     acc        = 0;
+    size_t       i;
+    double       ms;
+
+    for (i = 0; i < iterations; ++i) {
+        acc ^= f(data, size);
+    }
+    ms   = now_ms() - started;
+    *crc = acc;
+
+    return (ms > 0) ? (iterations * size) / (ms * 1000.0) : 0.0;
+}
+
+
+int main(int argc, char* argv[])
+{
+    static size_t const sizes[] = { 100, 256, 1024, 4096, 16384, 32768 };
+    unsigned const      mb      = (argc > 1) ? (unsigned)atoi(argv[1]) : 200;
+    size_t const        total   = (size_t)mb * 1024 * 1024;
+    uint8_t*            data    = (uint8_t*)malloc(sizes[sizeof sizes / sizeof sizes[0] - 1]);
+    size_t              i;
+
+    if (NULL == data) {
+        printf("Failed to allocate\n");
+        return -1;
+    }
+    for (i = 0; i < sizes[sizeof sizes / sizeof sizes[0] - 1]; ++i) {
+        data[i] = (uint8_t)(rand() >> 4);
+    }
+    make_table();
+
+    printf("CRC32 of %u MB in chunks of each size\n", mb);
+    printf("%8s %16s %16s %8s\n", "bytes", "bytewise MB/s", "pbcrc32 MB/s", "speedup");
+    for (i = 0; i < sizeof sizes / sizeof sizes[0]; ++i) {
+        uint32_t     crc_old;
+        uint32_t     crc_new;
+        double const old_mbs = run(crc32_bytewise, data, sizes[i], total, &crc_old);
+        double const new_mbs = run(crc32_library, data, sizes[i], total, &crc_new);
+
+        if (crc_old != crc_new) {
+            printf("CRC mismatch for %lu bytes: %08lx != %08lx!\n",
+                   (unsigned long)sizes[i],
+                   (unsigned long)crc_old,
+                   (unsigned long)crc_new);
+            return -1;
+        }
+        printf("%8lu %16.1f %16.1f %7.1fx\n",
+               (unsigned long)sizes[i],
+               old_mbs,
+               new_mbs,
+               (old_mbs > 0) ? new_mbs / old_mbs : 0.0);
+    }
+    free(data);
+
+    return 0;
+}
@@ -0,0 +1,270 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_callback.h"
+
+#include "core/pubnub_ntf_evloop.h"
+#include "core/pubnub_helper.h"
+#include "core/pubnub_timers.h"
+
+#include <sys/epoll.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/** @file pubnub_evloop_epoll_sample.c
+
+    Shows how to drive Pubnub contexts from the application's own
+    event loop - here, a plain (Linux) `epoll` loop, on the main
+    thread, with no threads of the Pubnub library.
+
+    A few contexts each publish some messages, one after the other,
+    starting the next publish from the callback of the previous one.
+
+    Usage: pubnub_evloop_epoll_sample [origin [contexts [publishes]]]
+ */
+
+
+/** The state of our event loop */
+struct Evloop {
+    int epfd;
+    /** When to call pubnub_process_timeout(), in our monotonic
+        milliseconds, -1 if there is no deadline */
+    long deadline;
+};
+
+
+struct Publisher {
+    unsigned left;
+    unsigned failed;
+};
+
+
+static unsigned m_active;
+
+
+static long now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+
+static uint32_t to_epoll(int events)
+{
+    uint32_t rslt = 0;
+    if (events & pbevlIN) {
+        rslt |= EPOLLIN;
+    }
+    if (events & pbevlOUT) {
+        rslt |= EPOLLOUT;
+    }
+    return rslt;
+}
+
+
+static int from_epoll(uint32_t events)
+{
+    int rslt = 0;
+    if (events & EPOLLIN) {
+        rslt |= pbevlIN;
+    }
+    if (events & EPOLLOUT) {
+        rslt |= pbevlOUT;
+    }
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        rslt |= pbevlERR;
+    }
+    return rslt;
+}
+
+
+static int add_socket(pubnub_t* pb, int fd, int events, void* user_data)
+{
+    struct Evloop*     evloop = (struct Evloop*)user_data;
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof ev);
+    ev.events   = to_epoll(events);
+    ev.data.ptr = pb;
+    return epoll_ctl(evloop->epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+
+static int modify_socket(pubnub_t* pb, int fd, int events, void* user_data)
+{
+    struct Evloop*     evloop = (struct Evloop*)user_data;
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof ev);
+    ev.events   = to_epoll(events);
+    ev.data.ptr = pb;
+    return epoll_ctl(evloop->epfd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+
+static void remove_socket(pubnub_t* pb, int fd, void* user_data)
+{
+    struct Evloop* evloop = (struct Evloop*)user_data;
+
+    PUBNUB_UNUSED(pb);
+    /* If the socket is already closed, epoll forgot it on its own */
+    epoll_ctl(evloop->epfd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+
+static void set_deadline(int timeout_ms, void* user_data)
+{
+    struct Evloop* evloop   = (struct Evloop*)user_data;
+    long const     deadline = now_ms() + timeout_ms;
+
+    if ((evloop->deadline < 0) || (deadline < evloop->deadline)) {
+        evloop->deadline = deadline;
+    }
+}
+
+
+static void publish_next(pubnub_t* pb, struct Publisher* publisher)
+{
+    enum pubnub_res res;
+
+    if (0 == publisher->left) {
+        --m_active;
+        return;
+    }
+    --publisher->left;
+    res = pubnub_publish(pb, "hello_world", "\"Hello from the event loop\"");
+    if (res != PNR_STARTED) {
+        printf("pubnub_publish() failed to start: %s\n", pubnub_res_2_string(res));
+        ++publisher->failed;
+        --m_active;
+    }
+}
+
+
+static void sample_callback(pubnub_t*         pb,
+                            enum pubnub_trans trans,
+                            enum pubnub_res   result,
+                            void*             user_data)
+{
+    struct Publisher* publisher = (struct Publisher*)user_data;
+
+    PUBNUB_UNUSED(trans);
+    if (result != PNR_OK) {
+        printf("Context %p publish failed: %s\n", pb, pubnub_res_2_string(result));
+        ++publisher->failed;
+    }
+    publish_next(pb, publisher);
+}
+
+
+static void run_evloop(struct Evloop* evloop)
+{
+    struct epoll_event events[16];
+
+    while (m_active > 0) {
+        int  i;
+        int  n;
+        int  timeout_ms = -1;
+        long now        = now_ms();
+
+        if (evloop->deadline >= 0) {
+            timeout_ms = (evloop->deadline > now) ? (int)(evloop->deadline - now) : 0;
+        }
+        n = epoll_wait(evloop->epfd, events, sizeof events / sizeof events[0], timeout_ms);
+        if ((n < 0) && (errno != EINTR)) {
+            printf("epoll_wait() failed, errno=%d\n", errno);
+            break;
+        }
+        for (i = 0; i < n; ++i) {
+            pubnub_process_io((pubnub_t*)events[i].data.ptr,
+                              from_epoll(events[i].events));
+        }
+        if ((evloop->deadline >= 0) && (now_ms() >= evloop->deadline)) {
+            int next;
+
+            evloop->deadline = -1;
+            next             = pubnub_process_timeout();
+            if (next >= 0) {
+                set_deadline(next, evloop);
+            }
+        }
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    char const*       origin     = (argc > 1) ? argv[1] : NULL;
+    unsigned const    contexts   = (argc > 2) ? (unsigned)atoi(argv[2]) : 3;
+    unsigned const    publishes  = (argc > 3) ? (unsigned)atoi(argv[3]) : 5;
+    struct Evloop     evloop;
+    pubnub_t**        pbp;
+    struct Publisher* publisher;
+    unsigned          i;
+    unsigned          failed = 0;
+
+    struct pubnub_evloop_hooks hooks;
+
+    evloop.epfd     = epoll_create1(EPOLL_CLOEXEC);
+    evloop.deadline = -1;
+    pbp             = (pubnub_t**)calloc(contexts, sizeof pbp[0]);
+    publisher       = (struct Publisher*)calloc(contexts, sizeof publisher[0]);
+    if ((-1 == evloop.epfd) || (NULL == pbp) || (NULL == publisher)) {
+        printf("Failed to set up the event loop\n");
+        return -1;
+    }
+
+    /* Has to be done before the first pubnub_init() */
+    hooks.add_socket    = add_socket;
+    hooks.modify_socket = modify_socket;
+    hooks.remove_socket = remove_socket;
+    hooks.set_deadline  = set_deadline;
+    pubnub_set_evloop_hooks(&hooks, &evloop);
+
+    for (i = 0; i < contexts; ++i) {
+        pbp[i] = pubnub_alloc();
+        if (NULL == pbp[i]) {
+            printf("Failed to allocate Pubnub context %u\n", i);
+            return -1;
+        }
+        pubnub_init(pbp[i], "demo", "demo");
+        if (origin != NULL) {
+            pubnub_origin_set(pbp[i], origin);
+        }
+        publisher[i].left   = publishes;
+        publisher[i].failed = 0;
+        pubnub_register_callback(pbp[i], sample_callback, &publisher[i]);
+    }
+
+    /* Starting a transaction only queues it, the event loop does the
+       rest */
+    m_active = contexts;
+    for (i = 0; i < contexts; ++i) {
+        publish_next(pbp[i], &publisher[i]);
+    }
+    run_evloop(&evloop);
+
+    for (i = 0; i < contexts; ++i) {
+        failed += publisher[i].failed;
+        /* Not interested in the cancelling of the kept-alive connection */
+        pubnub_register_callback(pbp[i], NULL, NULL);
+        pubnub_free(pbp[i]);
+    }
+    /* Freeing is done from the event loop, too */
+    pubnub_process_timeout();
+    printf("%u contexts published %u messages, %u failed\n",
+           contexts,
+           contexts * publishes,
+           failed);
+
+    free(publisher);
+    free(pbp);
+    close(evloop.epfd);
+
+    return 0;
+}
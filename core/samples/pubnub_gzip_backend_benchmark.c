@@ -0,0 +1,271 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "core/pbgzip_backend.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !PUBNUB_USE_GZIP_COMPRESSION || !PUBNUB_RECEIVE_GZIP_RESPONSE
+#error This benchmark needs PUBNUB_USE_GZIP_COMPRESSION=1 and PUBNUB_RECEIVE_GZIP_RESPONSE=1
+#endif
+
+
+/** @file pubnub_gzip_backend_benchmark.c
+
+    Measures the throughput, in MB/s (of uncompressed data), of the
+    gzip backend (see pbgzip_backend.h) this is linked with: deflate
+    at a few compression levels, inflate (fed in pieces, as a reply
+    arrives from the network) and CRC32, on JSON payloads like those
+    of Pubnub: a published message, a subscribe reply with many
+    messages and a history reply.
+
+    The backend is chosen when building, so, to compare them, build
+    this for each, as `pubnub_gzip_backend_benchmark_<backend>`:
+
+        make -f posix.mk GZIP_BACKEND=zlib pubnub_gzip_backend_benchmark_zlib
+
+    Usage: pubnub_gzip_backend_benchmark_<backend> [megabytes_per_test]
+ */
+
+
+/** Inflate takes the deflated data in pieces of this size, about
+    what one read from a socket gives */
+#define INFLATE_PIECE 1400
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+/** A message, as it would be published */
+static size_t make_message(char* s, unsigned i)
+{
+    return sprintf(s,
+                   "{\"id\":%u,\"sender\":\"user-%u\",\"text\":\"Hello from "
+                   "sensor %u, all systems nominal\",\"temperature\":%u.%u,"
+                   "\"status\":\"%s\",\"tags\":[\"floor-%u\",\"building-a\"]}",
+                   i,
+                   i * 7919 % 1000,
+                   i * 13 % 100,
+                   15 + i * 13 % 20,
+                   i % 10,
+                   (i % 3) ? "ok" : "warning",
+                   i % 12);
+}
+
+
+/** A subscribe (V2) reply with @p count messages */
+static char* make_subscribe_reply(unsigned count)
+{
+    char*    rslt = (char*)malloc(count * 600 + 100);
+    size_t   n;
+    unsigned i;
+
+    if (NULL == rslt) {
+        return NULL;
+    }
+    n = sprintf(rslt, "{\"t\":{\"t\":\"16139874503745612\",\"r\":12},\"m\":[");
+    for (i = 0; i < count; ++i) {
+        n += sprintf(rslt + n,
+                     "%s{\"a\":\"%u\",\"f\":0,\"i\":\"client-%08x-%04x\","
+                     "\"p\":{\"t\":\"161398745037%05u\",\"r\":12},"
+                     "\"k\":\"sub-c-5f1b7c8e-fbee-11e3-aa40-02ee2ddab7fe\","
+                     "\"c\":\"chat.room-%u\",\"d\":",
+                     (i > 0) ? "," : "",
+                     i % 4,
+                     i * 2654435761u,
+                     i % 7,
+                     i * 37,
+                     i % 5);
+        n += make_message(rslt + n, i);
+        n += sprintf(rslt + n, ",\"b\":\"chat.*\"}");
+    }
+    sprintf(rslt + n, "]}");
+
+    return rslt;
+}
+
+
+/** A history reply with @p count messages */
+static char* make_history_reply(unsigned count)
+{
+    char*    rslt = (char*)malloc(count * 400 + 100);
+    size_t   n;
+    unsigned i;
+
+    if (NULL == rslt) {
+        return NULL;
+    }
+    n = sprintf(rslt, "[[");
+    for (i = 0; i < count; ++i) {
+        n += sprintf(rslt + n, "%s{\"message\":", (i > 0) ? "," : "");
+        n += make_message(rslt + n, i);
+        n += sprintf(rslt + n, ",\"timetoken\":\"161398745037%05u\"}", i * 41);
+    }
+    sprintf(rslt + n, "],16139874503700000,16139874503799999]");
+
+    return rslt;
+}
+
+
+/** A plain bitwise CRC32 (as in gzip), to check the backend's against */
+static uint32_t reference_crc32(void const* data, size_t n)
+{
+    uint8_t const* p   = (uint8_t const*)data;
+    uint32_t       crc = 0xFFFFFFFF;
+
+    while (n-- > 0) {
+        int k;
+        crc ^= *p++;
+        for (k = 0; k < 8; ++k) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+
+static double mb_per_s(size_t bytes, double ms)
+{
+    return (ms > 0) ? bytes / (ms * 1000.0) : 0.0;
+}
+
+
+/** Inflates the @p packed_len octets at @p packed, to @p out, in
+    pieces, returning the inflated length, or 0 on error.
+ */
+static size_t inflate_pieces(struct pbgzip_inflater* inf,
+                             uint8_t const*          packed,
+                             size_t                  packed_len,
+                             uint8_t*                out,
+                             size_t                  out_size)
+{
+    size_t out_len = 0;
+
+    pbgzip_backend_inflater_reset(inf);
+    while (packed_len > 0) {
+        size_t in_len = (packed_len < INFLATE_PIECE) ? packed_len : INFLATE_PIECE;
+        size_t got    = out_size - out_len;
+        enum pbgzip_inflate_status const st =
+            pbgzip_backend_inflate(inf, packed, &in_len, out, out_len, &got);
+        packed += in_len;
+        packed_len -= in_len;
+        out_len += got;
+        if (pbgzInflateDone == st) {
+            return out_len;
+        }
+        if (st != pbgzInflateNeedsInput) {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+
+static int run(char const* name, char const* payload, unsigned mb)
+{
+    static int const levels[] = { 1, 6, 9 };
+    size_t const     len      = strlen(payload);
+    size_t const     total    = (size_t)mb * 1024 * 1024;
+    unsigned const   iters    = (unsigned)((total + len - 1) / len);
+    size_t const     cap      = len + len / 2 + 1000;
+    uint8_t*         packed   = (uint8_t*)malloc(cap);
+    uint8_t*         out      = (uint8_t*)malloc(len + 1);
+    struct pbgzip_deflater* def = pbgzip_backend_deflater_alloc();
+    struct pbgzip_inflater* inf = pbgzip_backend_inflater_alloc();
+    size_t           packed_len = 0;
+    uint32_t const   expected_crc = reference_crc32(payload, len);
+    uint32_t         crc          = 0;
+    double           started;
+    unsigned         i;
+    size_t           k;
+
+    if ((NULL == packed) || (NULL == out) || (NULL == def) || (NULL == inf)) {
+        printf("Failed to allocate\n");
+        return -1;
+    }
+    printf("%s, %lu bytes:\n", name, (unsigned long)len);
+    for (k = 0; k < sizeof levels / sizeof levels[0]; ++k) {
+        started = now_ms();
+        for (i = 0; i < iters; ++i) {
+            packed_len = cap;
+            if (0 != pbgzip_backend_deflate(def, levels[k], -1, payload, len, packed, &packed_len)) {
+                printf("Deflate failed at level %d!\n", levels[k]);
+                return -1;
+            }
+        }
+        printf("  deflate level %d: %8.1f MB/s, ratio %5.1f%%\n",
+               levels[k],
+               mb_per_s((size_t)iters * len, now_ms() - started),
+               packed_len * 100.0 / len);
+    }
+
+    /* The last one, at level 9, is inflated */
+    started = now_ms();
+    for (i = 0; i < iters; ++i) {
+        if (inflate_pieces(inf, packed, packed_len, out, len + 1) != len) {
+            printf("Inflate failed!\n");
+            return -1;
+        }
+    }
+    printf("  inflate:         %8.1f MB/s\n", mb_per_s((size_t)iters * len, now_ms() - started));
+    if (0 != memcmp(out, payload, len)) {
+        printf("Inflated data differs!\n");
+        return -1;
+    }
+
+    started = now_ms();
+    for (i = 0; i < iters; ++i) {
+        crc = pbgzip_backend_crc32(0, payload, len);
+    }
+    printf("  crc32:           %8.1f MB/s (%08lx)\n",
+           mb_per_s((size_t)iters * len, now_ms() - started),
+           (unsigned long)crc);
+    if (crc != expected_crc) {
+        printf("CRC32 differs from the reference %08lx!\n",
+               (unsigned long)expected_crc);
+        return -1;
+    }
+
+    pbgzip_backend_deflater_free(def);
+    pbgzip_backend_inflater_free(inf);
+    free(out);
+    free(packed);
+
+    return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+    unsigned const mb = (argc > 1) ? (unsigned)atoi(argv[1]) : 50;
+    char           message[400];
+    char*          subscribe = make_subscribe_reply(100);
+    char*          history   = make_history_reply(100);
+    int            rslt;
+
+    if ((NULL == subscribe) || (NULL == history)) {
+        printf("Failed to allocate\n");
+        return -1;
+    }
+    make_message(message, 42);
+    printf("gzip backend: %s, %u MB per test\n", pbgzip_backend_name(), mb);
+    rslt = run("published message", message, mb);
+    if (0 == rslt) {
+        rslt = run("subscribe reply", subscribe, mb);
+    }
+    if (0 == rslt) {
+        rslt = run("history reply", history, mb);
+    }
+    free(history);
+    free(subscribe);
+
+    return rslt;
+}
@@ -0,0 +1,229 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_sync.h"
+
+#include "pubnub_internal.h"
+#include "core/pubnub_gzip_compression.h"
+#include "lib/miniz/miniz_tdef.h"
+#include "lib/miniz/miniz_tinfl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !PUBNUB_USE_GZIP_COMPRESSION
+#error This benchmark needs PUBNUB_USE_GZIP_COMPRESSION=1
+#endif
+
+
+/** @file pubnub_gzip_compress_benchmark.c
+
+    Measures how many messages per second can be compressed for a
+    publish with gzip (`pubnubSendViaPOSTwithGZIP`), without any
+    networking, with:
+
+    - a compressor on the stack, initialized for each message, which
+      is how it used to be done
+
+    - pbgzip_compress(), which takes a compressor from the pool, at
+      a few compression levels and probe counts
+
+    Each compressed message is checked by decompressing it. Then, a
+    message of random octets (which doesn't compress) is "compressed"
+    with and without the compressibility estimate.
+
+    Usage: pubnub_gzip_compress_benchmark [message_size [iterations]]
+ */
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+/** Makes a JSON message of about @p size characters, looking like
+    something an application would publish.
+ */
+static char* make_message(size_t size)
+{
+    static char const item_fmt[] =
+        "{\"id\":%u,\"name\":\"sensor-%u\",\"temperature\":%u.%u,"
+        "\"status\":\"%s\",\"tags\":[\"floor-%u\",\"building-a\"]}";
+    char*    rslt = (char*)malloc(size + sizeof item_fmt + 40);
+    size_t   n    = 0;
+    unsigned i;
+
+    if (NULL == rslt) {
+        return NULL;
+    }
+    rslt[n++] = '[';
+    for (i = 0; n < size; ++i) {
+        if (i > 0) {
+            rslt[n++] = ',';
+        }
+        n += sprintf(rslt + n,
+                     item_fmt,
+                     i,
+                     i * 7 % 1000,
+                     15 + i * 13 % 20,
+                     i % 10,
+                     (i % 3) ? "ok" : "warning",
+                     i % 12);
+    }
+    rslt[n++] = ']';
+    rslt[n]   = '\0';
+
+    return rslt;
+}
+
+
+/** Compresses @p message the way it used to be done, with the
+    compressor on the stack, returning the compressed size.
+ */
+static size_t compress_on_stack(char const* message, size_t len, char* out, size_t out_size)
+{
+    tdefl_compressor comp;
+    size_t           in_size = len;
+
+    tdefl_init(&comp, NULL, NULL, TDEFL_DEFAULT_MAX_PROBES);
+    if (tdefl_compress(&comp, message, &in_size, out, &out_size, TDEFL_FINISH)
+        != TDEFL_STATUS_DONE) {
+        return 0;
+    }
+    return out_size;
+}
+
+
+/** Makes a message of @p size random (non-zero) octets */
+static char* make_random_message(size_t size)
+{
+    char*  rslt = (char*)malloc(size + 1);
+    size_t i;
+
+    if (NULL == rslt) {
+        return NULL;
+    }
+    for (i = 0; i < size; ++i) {
+        rslt[i] = (char)(1 + rand() % 255);
+    }
+    rslt[size] = '\0';
+
+    return rslt;
+}
+
+
+/** Checks that the gzip data of @p pb decompresses to @p message */
+static int check(pubnub_t* pb, char const* message, size_t len, char* scratch)
+{
+    size_t const n = tinfl_decompress_mem_to_mem(scratch,
+                                                 len + 1,
+                                                 pb->core.gzip_msg_buf + 10,
+                                                 pb->core.gzip_msg_len - 18,
+                                                 0);
+    return ((n == len) && (0 == memcmp(scratch, message, len))) ? 0 : -1;
+}
+
+
+int main(int argc, char* argv[])
+{
+    size_t const   size       = (argc > 1) ? (size_t)atoi(argv[1]) : 2000;
+    unsigned const iterations = (argc > 2) ? (unsigned)atoi(argv[2]) : 5000;
+    static int const levels[][2] = { { 1, -1 }, { 3, -1 }, { 6, -1 }, { 6, 16 }, { 9, -1 } };
+    char*     message = make_message(size);
+    char*     scratch = (char*)malloc(size * 2 + 1000);
+    pubnub_t* pb      = pubnub_alloc();
+    size_t    len;
+    size_t    packed = 0;
+    double    started;
+    double    ms;
+    unsigned  i;
+    size_t    k;
+
+    if ((NULL == message) || (NULL == scratch) || (NULL == pb)) {
+        printf("Failed to allocate\n");
+        return -1;
+    }
+    pubnub_init(pb, "demo", "demo");
+    len = strlen(message);
+    printf("Compressing a %lu byte message %u times\n", (unsigned long)len, iterations);
+
+    started = now_ms();
+    for (i = 0; i < iterations; ++i) {
+        packed = compress_on_stack(message, len, scratch, size * 2 + 1000);
+    }
+    ms = now_ms() - started;
+    printf("%24s: %9.0f messages/s, %6lu bytes\n",
+           "on stack, probes 128",
+           iterations * 1000.0 / ms,
+           (unsigned long)packed);
+
+    for (k = 0; k < sizeof levels / sizeof levels[0]; ++k) {
+        char name[40];
+
+        pubnub_set_gzip_compression(pb, levels[k][0], levels[k][1]);
+        started = now_ms();
+        for (i = 0; i < iterations; ++i) {
+            if (PNR_OK != pbgzip_compress(pb, message)) {
+                printf("Message not compressed at level %d!\n", levels[k][0]);
+                return -1;
+            }
+        }
+        ms = now_ms() - started;
+        if (0 != check(pb, message, len, scratch)) {
+            printf("Decompressed message differs at level %d!\n", levels[k][0]);
+            return -1;
+        }
+        if (levels[k][1] < 0) {
+            snprintf(name, sizeof name, "pooled, level %d", levels[k][0]);
+        }
+        else {
+            snprintf(name, sizeof name, "pooled, level %d/probes %d", levels[k][0], levels[k][1]);
+        }
+        printf("%24s: %9.0f messages/s, %6lu bytes\n",
+               name,
+               iterations * 1000.0 / ms,
+               (unsigned long)pb->core.gzip_msg_len);
+    }
+
+    free(message);
+    message = make_random_message(size);
+    if (NULL == message) {
+        printf("Failed to allocate\n");
+        return -1;
+    }
+    pubnub_set_gzip_compression(pb, PUBNUB_GZIP_COMPRESSION_LEVEL, PUBNUB_GZIP_MAX_PROBES);
+    for (k = 0; k < 2; ++k) {
+        struct pubnub_gzip_compress_stats stats;
+
+        pubnub_gzip_set_estimate((0 == k) ? 0 : PUBNUB_GZIP_ESTIMATE_SAMPLE_SIZE,
+                                 PUBNUB_GZIP_ESTIMATE_MIN_SAVINGS);
+        started = now_ms();
+        for (i = 0; i < iterations; ++i) {
+            if (PNR_OK == pbgzip_compress(pb, message)) {
+                printf("Random message compressed!\n");
+                return -1;
+            }
+        }
+        ms = now_ms() - started;
+        printf("%24s: %9.0f messages/s\n",
+               (0 == k) ? "random, no estimate" : "random, estimate",
+               iterations * 1000.0 / ms);
+        pubnub_gzip_compress_stats(&stats);
+        printf("%24s  estimated=%lu skipped=%lu packed=%lu poor_ratio=%lu\n",
+               "",
+               stats.estimated,
+               stats.skipped,
+               stats.packed,
+               stats.poor_ratio);
+    }
+
+    pubnub_free(pb);
+    pubnub_gzip_compressor_pool_trim();
+    free(scratch);
+    free(message);
+
+    return 0;
+}
@@ -0,0 +1,247 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_sync.h"
+
+#include "pubnub_internal.h"
+#include "core/pbcc_subscribe_v2.h"
+#include "core/pubnub_json_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/** @file pubnub_subscribe_v2_decode_benchmark.c
+
+    Measures how long it takes to decode a subscribe V2 response with
+    many messages, without any networking: we put a made-up response
+    into the context, as if it was received, and decode it again and
+    again, with:
+
+    - "by key": looking up each member of each message from the start
+      of the message (and the envelope members from the start of the
+      response), which is how it used to be done
+
+    - pubnub_get_v2(), one message at a time
+
+    - pubnub_get_v2_batch(), many messages at a time
+
+    Usage: pubnub_subscribe_v2_decode_benchmark [messages [iterations]]
+ */
+
+
+/** How many messages to get with one pubnub_get_v2_batch() */
+#define BATCH_SIZE 16
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+/** Makes a subscribe V2 response with @p count messages, looking
+    like the ones the Pubnub network sends.
+ */
+static char* make_response(unsigned count, size_t* len)
+{
+    static char const head[] = "{\"t\":{\"t\":\"15628652479932717\",\"r\":4},\"m\":[";
+    static char const msg_fmt[] =
+        "{\"a\":\"4\",\"f\":0,\"i\":\"client-9e1a7b3c-4d2f-4e5a-8b6c-1f2e3d4c5b6a\","
+        "\"p\":{\"t\":\"156286524799%05u\",\"r\":4},\"k\":\"sub-c-4cbd1d40-1a2b-11e6\","
+        "\"c\":\"benchmark_channel\",\"u\":{\"sender\":\"bench\",\"seq\":%u},"
+        "\"d\":{\"text\":\"Hello, this is message %u\",\"n\":%u,\"ok\":true},"
+        "\"b\":\"benchmark_channel\"}";
+    size_t const cap = sizeof head + count * (sizeof msg_fmt + 40) + 3;
+    char*        rslt = (char*)malloc(cap);
+    size_t       n;
+    unsigned     i;
+
+    if (NULL == rslt) {
+        return NULL;
+    }
+    memcpy(rslt, head, sizeof head - 1);
+    n = sizeof head - 1;
+    for (i = 0; i < count; ++i) {
+        if (i > 0) {
+            rslt[n++] = ',';
+        }
+        n += snprintf(rslt + n, cap - n, msg_fmt, i, i, i, i);
+    }
+    rslt[n++] = ']';
+    rslt[n++] = '}';
+    rslt[n]   = '\0';
+    *len      = n;
+
+    return rslt;
+}
+
+
+/** Decodes the response in @p p the old way, looking up each member
+    by key, from the start of the object. Returns the number of
+    messages decoded.
+ */
+static unsigned decode_by_key(struct pbcc_context* p)
+{
+    struct pbjson_elem el;
+    struct pbjson_elem found;
+    struct pbjson_elem titel;
+    char const*        start;
+    char const*        end;
+    unsigned           count = 0;
+
+    el.start = p->http_reply;
+    el.end   = p->http_reply + p->http_buf_len;
+    if ((jonmpOK != pbjson_get_object_value(&el, "t", &found))
+        || (jonmpOK != pbjson_get_object_value(&found, "t", &titel))
+        || (jonmpOK != pbjson_get_object_value(&found, "r", &titel))
+        || (jonmpOK != pbjson_get_object_value(&el, "m", &found))) {
+        return 0;
+    }
+    start = found.start + 1;
+    end   = found.end - 1;
+    while (start < end) {
+        struct pubnub_v2_message msg;
+        struct pbjson_elem       msgel;
+
+        msgel.start = start;
+        msgel.end   = pbjson_find_end_complex(start, end);
+        if (msgel.end == end) {
+            break;
+        }
+        memset(&msg, 0, sizeof msg);
+        if (jonmpOK == pbjson_get_object_value(&msgel, "d", &found)) {
+            msg.payload.ptr  = (char*)found.start;
+            msg.payload.size = found.end - found.start;
+        }
+        if (jonmpOK == pbjson_get_object_value(&msgel, "c", &found)) {
+            msg.channel.ptr  = (char*)found.start + 1;
+            msg.channel.size = found.end - found.start - 2;
+        }
+        if (jonmpOK == pbjson_get_object_value(&msgel, "e", &found)) {
+            msg.message_type = pbjson_elem_equals_string(&found, "1") ? pbsbSignal
+                                                                      : pbsbPublished;
+        }
+        if ((jonmpOK == pbjson_get_object_value(&msgel, "p", &found))
+            && (jonmpOK == pbjson_get_object_value(&found, "t", &titel))) {
+            msg.tt.ptr  = (char*)titel.start + 1;
+            msg.tt.size = titel.end - titel.start - 2;
+        }
+        if (jonmpOK == pbjson_get_object_value(&msgel, "b", &found)) {
+            msg.match_or_group.ptr  = (char*)found.start;
+            msg.match_or_group.size = found.end - found.start;
+        }
+        if (jonmpOK == pbjson_get_object_value(&msgel, "u", &found)) {
+            msg.metadata.ptr  = (char*)found.start;
+            msg.metadata.size = found.end - found.start;
+        }
+        if (msg.payload.ptr != NULL) {
+            ++count;
+        }
+        start = msgel.end + 2;
+    }
+
+    return count;
+}
+
+
+/** Puts the @p response into the context @p pb, as if received */
+static int put_response(pubnub_t* pb, char const* response, size_t len)
+{
+    if (0 != pbcc_realloc_reply_buffer(&pb->core, (unsigned)len)) {
+        return -1;
+    }
+    memcpy(pb->core.http_reply, response, len + 1);
+    pb->core.http_buf_len = len;
+
+    return 0;
+}
+
+
+enum decode_mode { dmByKey, dmGetV2, dmBatch };
+
+
+static double run(pubnub_t* pb, enum decode_mode mode, unsigned iterations, unsigned expected)
+{
+    double const started = now_ms();
+    unsigned     i;
+
+    for (i = 0; i < iterations; ++i) {
+        struct pubnub_v2_message msgs[BATCH_SIZE];
+        unsigned                 count = 0;
+        size_t                   n;
+
+        switch (mode) {
+        case dmByKey:
+            count = decode_by_key(&pb->core);
+            break;
+        case dmGetV2:
+            if (PNR_OK != pbcc_parse_subscribe_v2_response(&pb->core)) {
+                break;
+            }
+            while (pubnub_get_v2(pb).payload.ptr != NULL) {
+                ++count;
+            }
+            break;
+        case dmBatch:
+            if (PNR_OK != pbcc_parse_subscribe_v2_response(&pb->core)) {
+                break;
+            }
+            do {
+                n = pubnub_get_v2_batch(pb, msgs, BATCH_SIZE);
+                count += (unsigned)n;
+            } while (BATCH_SIZE == n);
+            break;
+        }
+        if (count != expected) {
+            printf("Decoded %u messages instead of %u!\n", count, expected);
+            return -1;
+        }
+    }
+
+    return now_ms() - started;
+}
+
+
+int main(int argc, char* argv[])
+{
+    unsigned const messages   = (argc > 1) ? (unsigned)atoi(argv[1]) : 100;
+    unsigned const iterations = (argc > 2) ? (unsigned)atoi(argv[2]) : 10000;
+    static char const* const mode_name[] = { "by key", "pubnub_get_v2()", "pubnub_get_v2_batch()" };
+    size_t    len;
+    char*     response = make_response(messages, &len);
+    pubnub_t* pb       = pubnub_alloc();
+    int       mode;
+
+    if ((NULL == response) || (NULL == pb)) {
+        printf("Failed to allocate\n");
+        return -1;
+    }
+    pubnub_init(pb, "demo", "demo");
+    if (0 != put_response(pb, response, len)) {
+        printf("Failed to allocate reply buffer of %lu bytes\n", (unsigned long)len);
+        return -1;
+    }
+    printf("Decoding %u iterations of a response with %u messages (%lu bytes)\n",
+           iterations,
+           messages,
+           (unsigned long)len);
+    for (mode = dmByKey; mode <= dmBatch; ++mode) {
+        double const ms = run(pb, (enum decode_mode)mode, iterations, messages);
+        if (ms < 0) {
+            return -1;
+        }
+        printf("%22s: %9.3f ms total, %8.3f us per response, %7.1f ns per message\n",
+               mode_name[mode],
+               ms,
+               ms * 1000.0 / iterations,
+               (messages > 0) ? ms * 1000000.0 / iterations / messages : 0.0);
+    }
+
+    pubnub_free(pb);
+    free(response);
+
+    return 0;
+}
@@ -44,6 +44,11 @@
  * messages got queued on the Pubnub server. */
 #define PUBNUB_REPLY_MAXLEN 1024
 
+#if PUBNUB_USE_GZIP_COMPRESSION
+/* Maximum compressed message length allowed */
+#define PUBNUB_COMPRESSED_MAXLEN 1024
+#endif
+
 /** If defined, the PubNub implementation will not try to catch-up on
  * messages it could miss while subscribe failed with an IO error or
  * such.  Use this if missing some messages is not a problem.  
@@ -209,9 +209,9 @@ namespace pubnub {
     TEST_DECL(tst)                                                      \
     {                                                                   \
         char const* const this_test_name_ = #tst;                       \
-        /* Eliminating unused variable warning */                       \
+        /* Eliminating unused variable warnings */                      \
         do {                                                            \
-        } while (sizeof cannot_do == 0);
+        } while ((sizeof cannot_do == 0) && (NULL == this_test_name_));
 
 #define TEST_ENDDEF }
 
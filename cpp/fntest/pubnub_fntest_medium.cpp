@@ -281,6 +281,41 @@ TEST_DEF(wrong_api_usage)
 }
 TEST_ENDDEF
 
+#if PUBNUB_USE_PUBLISH_BATCH
+TEST_DEF(publish_batch_and_single_transaction_exclude_each_other)
+{
+    context                   pbp(pubkey, keysub, origin);
+    std::string const         ch(pnfntst_make_name(this_test_name_));
+    std::chrono::milliseconds rel_time = Td;
+    pubnub_res                result = PNR_STARTED;
+    std::vector<publish_batch_item> const batch = {
+        publish_batch_item(ch, "\"Test B1\""),
+        publish_batch_item(ch, "\"Test B2\"")
+    };
+
+    SENSE(pbp.subscribe(ch)).in(Td) == PNR_OK;
+
+    pbp.set_blocking_io(non_blocking);
+    auto futr = pbp.subscribe(ch);
+    SENSE(pbp.publish_batch(batch)).in(Td) == PNR_IN_PROGRESS;
+
+    pbp.cancel();
+    EXPECT_TRUE(pubnub::wait_for(futr, rel_time, result));
+    EXPECT_RESULT(futr, result) == PNR_CANCELLED;
+
+    auto futr_2 = pbp.publish_batch(batch);
+    if (!futr_2.is_ready()) {
+        SENSE(pbp.publish(ch, "\"Test - 2\"")).in(Td) == PNR_IN_PROGRESS;
+        SENSE(pbp.subscribe(ch)).in(Td) == PNR_IN_PROGRESS;
+    }
+    rel_time = Td;
+    result = PNR_STARTED;
+    EXPECT_TRUE(pubnub::wait_for(futr_2, rel_time, result));
+    EXPECT_RESULT(futr_2, result) == PNR_OK;
+}
+TEST_ENDDEF
+#endif /* PUBNUB_USE_PUBLISH_BATCH */
+
 TEST_DEF(handling_errors_from_pubnub)
 {
     context           pbp(pubkey, keysub, origin);
@@ -295,3 +330,26 @@ TEST_DEF(handling_errors_from_pubnub)
     EXPECT(pbp.parse_last_publish_result()) == PNPUB_INVALID_CHAR_IN_CHAN_NAME;
 }
 TEST_ENDDEF
+
+TEST_DEF(json_view_paths_and_indexes)
+{
+    std::string const msg("[{\"name\":\"a\\u00e9\",\"items\":[7,{\"price\":2.5}]},true,null]");
+    json_view const   v(msg);
+    std::string       name;
+    double            price = 0;
+    long              first = 0;
+    bool              flag  = false;
+
+    EXPECT_TRUE(v[0]["name"].get(name));
+    EXPECT(name) == std::string("a\xc3\xa9");
+    EXPECT_TRUE(v[0]["items"][0].get(first));
+    EXPECT(first) == 7;
+    EXPECT_TRUE(v["[0].items[1].price"].get(price));
+    EXPECT(price) == 2.5;
+    EXPECT_TRUE(v[1].get(flag));
+    EXPECT(flag) == true;
+    EXPECT_TRUE(v[2].is_null());
+    EXPECT(v[3].valid()) == false;
+    EXPECT(v[-1].valid()) == false;
+}
+TEST_ENDDEF
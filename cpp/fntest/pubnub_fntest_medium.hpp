@@ -11,6 +11,10 @@ TEST_DECL(connect_disconnect_and_connect_again);
 TEST_DECL(connect_disconnect_and_connect_again_group);
 TEST_DECL(connect_disconnect_and_connect_again_combo);
 TEST_DECL(wrong_api_usage);
+#if PUBNUB_USE_PUBLISH_BATCH
+TEST_DECL(publish_batch_and_single_transaction_exclude_each_other);
+#endif
 TEST_DECL(handling_errors_from_pubnub);
+TEST_DECL(json_view_paths_and_indexes);
 
 #endif // !defined INC_PUBNUB_FNTEST_MEDIUM
@@ -65,7 +65,11 @@ static TestData m_aTest[] = {
     LIST_TEST(connect_disconnect_and_connect_again_group),
     LIST_TEST(connect_disconnect_and_connect_again_combo),
     LIST_TEST(wrong_api_usage),
-    LIST_TEST(handling_errors_from_pubnub)
+#if PUBNUB_USE_PUBLISH_BATCH
+    LIST_TEST(publish_batch_and_single_transaction_exclude_each_other),
+#endif
+    LIST_TEST(handling_errors_from_pubnub),
+    LIST_TEST(json_view_paths_and_indexes)
 };
 
 #define TEST_COUNT (sizeof m_aTest / sizeof m_aTest[0])
@@ -32,18 +32,56 @@ ifndef USE_ACTIONS_API
 USE_ACTIONS_API = 1
 endif
 
+ifndef USE_PUBLISH_QUEUE
+USE_PUBLISH_QUEUE = 1
+endif
+
+ifndef USE_REPLY_BUFFER_POOL
+USE_REPLY_BUFFER_POOL = 1
+endif
+
 ifeq ($(USE_PROXY), 1)
 SOURCEFILES += ../core/pubnub_proxy.c ../core/pubnub_proxy_core.c ../core/pbhttp_digest.c ../core/pbntlm_core.c ../core/pbntlm_packer_std.c
 endif
 
+##
+# The compression library for gzip (publishing and receiving). By
+# default, it's the bundled `miniz`. Set `GZIP_BACKEND=zlib` to use
+# zlib, or zlib-ng built in the zlib compatible mode, which is much
+# faster. Set `GZIP_BACKEND=libdeflate` to use libdeflate, which is
+# the fastest to deflate, but can't inflate piece by piece, as data
+# arrives, so miniz is used to inflate. See `core/pbgzip_backend.h`.
+ifndef GZIP_BACKEND
+GZIP_BACKEND = miniz
+endif
+
+ifeq ($(GZIP_BACKEND), zlib)
+GZIP_BACKEND_SOURCEFILES = ../core/pbgzip_backend_zlib.c
+GZIP_BACKEND_OBJFILES = pbgzip_backend_zlib.o
+GZIP_BACKEND_LDLIBS = -lz
+else ifeq ($(GZIP_BACKEND), libdeflate)
+GZIP_BACKEND_SOURCEFILES = ../core/pbgzip_backend_libdeflate.c ../lib/miniz/miniz_tinfl.c
+GZIP_BACKEND_OBJFILES = pbgzip_backend_libdeflate.o miniz_tinfl.o
+GZIP_BACKEND_LDLIBS = -ldeflate
+else
+GZIP_BACKEND_SOURCEFILES = ../core/pbgzip_backend_miniz.c ../lib/miniz/miniz_tdef.c ../lib/miniz/miniz_tinfl.c ../lib/miniz/miniz.c ../lib/pbcrc32.c
+GZIP_BACKEND_OBJFILES = pbgzip_backend_miniz.o miniz_tdef.o miniz_tinfl.o miniz.o pbcrc32.o
+GZIP_BACKEND_LDLIBS =
+endif
+
 ifeq ($(USE_GZIP_COMPRESSION), 1)
-SOURCEFILES += ../lib/miniz/miniz_tdef.c ../lib/miniz/miniz.c ../lib/pbcrc32.c ../core/pbgzip_compress.c
-OBJFILES += miniz_tdef.o miniz.o pbcrc32.o pbgzip_compress.o
+SOURCEFILES += ../core/pbgzip_compress.c
+OBJFILES += pbgzip_compress.o
 endif
 
 ifeq ($(RECEIVE_GZIP_RESPONSE), 1)
-SOURCEFILES += ../lib/miniz/miniz_tinfl.c ../core/pbgzip_decompress.c
-OBJFILES += miniz_tinfl.o pbgzip_decompress.o
+SOURCEFILES += ../core/pbgzip_decompress.c
+OBJFILES += pbgzip_decompress.o
+endif
+
+ifneq ($(USE_GZIP_COMPRESSION)$(RECEIVE_GZIP_RESPONSE), 00)
+SOURCEFILES += $(GZIP_BACKEND_SOURCEFILES)
+OBJFILES += $(GZIP_BACKEND_OBJFILES)
 endif
 
 ifeq ($(USE_SUBSCRIBE_V2), 1)
@@ -66,6 +104,16 @@ SOURCEFILES += ../core/pbcc_actions_api.c ../core/pubnub_actions_api.c
 OBJFILES += pbcc_actions_api.o pubnub_actions_api.o
 endif
 
+ifeq ($(USE_PUBLISH_QUEUE), 1)
+SOURCEFILES += ../core/pubnub_publish_queue.c
+OBJFILES += pubnub_publish_queue.o
+endif
+
+ifeq ($(USE_REPLY_BUFFER_POOL), 1)
+SOURCEFILES += ../core/pubnub_reply_buffer_pool.c
+OBJFILES += pubnub_reply_buffer_pool.o
+endif
+
 OS := $(shell uname)
 ifeq ($(OS),Darwin)
 SOURCEFILES += ../posix/monotonic_clock_get_time_darwin.c
@@ -75,7 +123,9 @@ SOURCEFILES += ../posix/monotonic_clock_get_time_posix.c
 LDLIBS=-lrt -lpthread
 endif
 
-CFLAGS =-g -I .. -I ../posix -I . -Wall -D PUBNUB_THREADSAFE -D PUBNUB_LOG_LEVEL=PUBNUB_LOG_LEVEL_WARNING -D PUBNUB_ONLY_PUBSUB_API=$(ONLY_PUBSUB_API) -D PUBNUB_PROXY_API=$(USE_PROXY) -D PUBNUB_USE_GZIP_COMPRESSION=$(USE_GZIP_COMPRESSION) -D PUBNUB_RECEIVE_GZIP_RESPONSE=$(RECEIVE_GZIP_RESPONSE) -D PUBNUB_USE_SUBSCRIBE_V2=$(USE_SUBSCRIBE_V2) -D PUBNUB_USE_OBJECTS_API=$(USE_OBJECTS_API) -D PUBNUB_USE_ACTIONS_API=$(USE_ACTIONS_API)
+LDLIBS += $(GZIP_BACKEND_LDLIBS)
+
+CFLAGS =-g -I .. -I ../posix -I . -Wall -D PUBNUB_THREADSAFE -D PUBNUB_LOG_LEVEL=PUBNUB_LOG_LEVEL_WARNING -D PUBNUB_ONLY_PUBSUB_API=$(ONLY_PUBSUB_API) -D PUBNUB_PROXY_API=$(USE_PROXY) -D PUBNUB_USE_GZIP_COMPRESSION=$(USE_GZIP_COMPRESSION) -D PUBNUB_RECEIVE_GZIP_RESPONSE=$(RECEIVE_GZIP_RESPONSE) -D PUBNUB_USE_SUBSCRIBE_V2=$(USE_SUBSCRIBE_V2) -D PUBNUB_USE_OBJECTS_API=$(USE_OBJECTS_API) -D PUBNUB_USE_ACTIONS_API=$(USE_ACTIONS_API) -D PUBNUB_USE_PUBLISH_QUEUE=$(USE_PUBLISH_QUEUE) -D PUBNUB_USE_REPLY_BUFFER_POOL=$(USE_REPLY_BUFFER_POOL)
 # -g enables debugging, remove to get a smaller executable
 
 
@@ -85,17 +135,17 @@ cpp98: pubnub_sync_sample pubnub_callback_sample cancel_subscribe_sync_sample su
 
 cpp11: pubnub_callback_cpp11_sample futres_nesting_callback_cpp11 fntest_runner pubnub_callback_cpp11_subloop_sample
 
-pubnub_sync_sample: samples/pubnub_sample.cpp $(SOURCEFILES) ../core/pubnub_ntf_sync.c pubnub_futres_sync.cpp
-	$(CXX) -o $@ $(CFLAGS)  -x c++ samples/pubnub_sample.cpp ../core/pubnub_ntf_sync.c pubnub_futres_sync.cpp $(SOURCEFILES) $(LDLIBS)
+pubnub_sync_sample: samples/pubnub_sample.cpp $(SOURCEFILES) ../core/pubnub_ntf_sync.c ../posix/pubnub_get_native_socket.c pubnub_futres_sync.cpp
+	$(CXX) -o $@ $(CFLAGS)  -x c++ samples/pubnub_sample.cpp ../core/pubnub_ntf_sync.c ../posix/pubnub_get_native_socket.c pubnub_futres_sync.cpp $(SOURCEFILES) $(LDLIBS)
 
-cancel_subscribe_sync_sample: samples/cancel_subscribe_sync_sample.cpp $(SOURCEFILES) ../core/pubnub_ntf_sync.c pubnub_futres_sync.cpp
-	$(CXX) -o $@ $(CFLAGS)  -x c++ samples/cancel_subscribe_sync_sample.cpp ../core/pubnub_ntf_sync.c pubnub_futres_sync.cpp $(SOURCEFILES) $(LDLIBS)
+cancel_subscribe_sync_sample: samples/cancel_subscribe_sync_sample.cpp $(SOURCEFILES) ../core/pubnub_ntf_sync.c ../posix/pubnub_get_native_socket.c pubnub_futres_sync.cpp
+	$(CXX) -o $@ $(CFLAGS)  -x c++ samples/cancel_subscribe_sync_sample.cpp ../core/pubnub_ntf_sync.c ../posix/pubnub_get_native_socket.c pubnub_futres_sync.cpp $(SOURCEFILES) $(LDLIBS)
 
-futres_nesting_sync: samples/futres_nesting.cpp $(SOURCEFILES) ../core/pubnub_ntf_sync.c pubnub_futres_sync.cpp
-	$(CXX) -o $@ $(CFLAGS)  -x c++ samples/futres_nesting.cpp ../core/pubnub_ntf_sync.c pubnub_futres_sync.cpp $(SOURCEFILES) $(LDLIBS)
+futres_nesting_sync: samples/futres_nesting.cpp $(SOURCEFILES) ../core/pubnub_ntf_sync.c ../posix/pubnub_get_native_socket.c pubnub_futres_sync.cpp
+	$(CXX) -o $@ $(CFLAGS)  -x c++ samples/futres_nesting.cpp ../core/pubnub_ntf_sync.c ../posix/pubnub_get_native_socket.c pubnub_futres_sync.cpp $(SOURCEFILES) $(LDLIBS)
 
-pubnub_sync_subloop_sample: samples/pubnub_subloop_sample.cpp $(SOURCEFILES) ../core/pubnub_ntf_sync.c pubnub_futres_sync.cpp
-	$(CXX) -o $@ $(CFLAGS)  -x c++ samples/pubnub_subloop_sample.cpp ../core/pubnub_ntf_sync.c pubnub_futres_sync.cpp $(SOURCEFILES) $(LDLIBS)
+pubnub_sync_subloop_sample: samples/pubnub_subloop_sample.cpp $(SOURCEFILES) ../core/pubnub_ntf_sync.c ../posix/pubnub_get_native_socket.c pubnub_futres_sync.cpp
+	$(CXX) -o $@ $(CFLAGS)  -x c++ samples/pubnub_subloop_sample.cpp ../core/pubnub_ntf_sync.c ../posix/pubnub_get_native_socket.c pubnub_futres_sync.cpp $(SOURCEFILES) $(LDLIBS)
 
 ##
 # The socket poller module to use. You should use the `poll` poller, it
@@ -106,8 +156,8 @@ pubnub_sync_subloop_sample: samples/pubnub_subloop_sample.cpp $(SOURCEFILES) ../
 SOCKET_POLLER_C=../lib/sockets/pbpal_ntf_callback_poller_poll.c
 SOCKET_POLLER_OBJ=pbpal_ntf_callback_poller_poll.o
 
-CALLBACK_INTF_SOURCEFILES= ../posix/pubnub_ntf_callback_posix.c ../posix/pubnub_get_native_socket.c ../core/pubnub_timer_list.c ../lib/sockets/pbpal_adns_sockets.c ../lib/pubnub_dns_codec.c $(SOCKET_POLLER_C)  ../core/pbpal_ntf_callback_queue.c ../core/pbpal_ntf_callback_admin.c ../core/pbpal_ntf_callback_handle_timer_list.c  ../core/pubnub_callback_subscribe_loop.c
-CALLBACK_INTF_OBJFILES=pubnub_ntf_callback_posix.o pubnub_get_native_socket.o pubnub_timer_list.o pbpal_adns_sockets.o pubnub_dns_codec.o $(SOCKET_POLLER_OBJ) pbpal_ntf_callback_queue.o pbpal_ntf_callback_admin.o pbpal_ntf_callback_handle_timer_list.o pubnub_callback_subscribe_loop.o
+CALLBACK_INTF_SOURCEFILES= ../posix/pubnub_ntf_callback_posix.c ../posix/pubnub_get_native_socket.c ../core/pubnub_timer_list.c ../core/pubnub_timer_wheel.c ../lib/sockets/pbpal_adns_sockets.c ../lib/pubnub_dns_codec.c $(SOCKET_POLLER_C)  ../core/pbpal_ntf_callback_queue.c ../core/pbpal_ntf_callback_admin.c ../core/pbpal_ntf_callback_handle_timer_list.c  ../core/pubnub_callback_subscribe_loop.c
+CALLBACK_INTF_OBJFILES=pubnub_ntf_callback_posix.o pubnub_get_native_socket.o pubnub_timer_list.o pubnub_timer_wheel.o pbpal_adns_sockets.o pubnub_dns_codec.o $(SOCKET_POLLER_OBJ) pbpal_ntf_callback_queue.o pbpal_ntf_callback_admin.o pbpal_ntf_callback_handle_timer_list.o pubnub_callback_subscribe_loop.o
 
 ifndef USE_DNS_SERVERS
 USE_DNS_SERVERS = 1
@@ -150,8 +200,8 @@ pubnub_callback_subloop_sample: samples/pubnub_subloop_sample.cpp $(SOURCEFILES)
 pubnub_callback_cpp11_subloop_sample: samples/pubnub_subloop_sample.cpp $(SOURCEFILES) $(CALLBACK_INTF_SOURCEFILES) pubnub_futres_cpp11.cpp
 	$(CXX) -o $@ -std=c++11 -D PUBNUB_CALLBACK_API $(CFLAGS) $(CFLAGS_CALLBACK) -x c++  samples/pubnub_subloop_sample.cpp $(CALLBACK_INTF_SOURCEFILES) pubnub_futres_cpp11.cpp $(SOURCEFILES) $(LDLIBS)
 
-fntest_runner: fntest/pubnub_fntest_runner.cpp $(SOURCEFILES)  ../core/pubnub_ntf_sync.c ../core/srand_from_pubnub_time.c pubnub_futres_sync.cpp fntest/pubnub_fntest.cpp fntest/pubnub_fntest_basic.cpp fntest/pubnub_fntest_medium.cpp
-	$(CXX) -o $@ -std=c++11 -D PUBNUB_LOG_LEVEL=PUBNUB_LOG_LEVEL_WARNING $(CFLAGS) -x c++ fntest/pubnub_fntest_runner.cpp ../core/pubnub_ntf_sync.c ../core/srand_from_pubnub_time.c pubnub_futres_sync.cpp fntest/pubnub_fntest.cpp fntest/pubnub_fntest_basic.cpp fntest/pubnub_fntest_medium.cpp $(SOURCEFILES) $(LDLIBS) 
+fntest_runner: fntest/pubnub_fntest_runner.cpp $(SOURCEFILES)  ../core/pubnub_ntf_sync.c ../posix/pubnub_get_native_socket.c ../core/srand_from_pubnub_time.c pubnub_futres_sync.cpp fntest/pubnub_fntest.cpp fntest/pubnub_fntest_basic.cpp fntest/pubnub_fntest_medium.cpp
+	$(CXX) -o $@ -std=c++11 -D PUBNUB_LOG_LEVEL=PUBNUB_LOG_LEVEL_WARNING $(CFLAGS) -x c++ fntest/pubnub_fntest_runner.cpp ../core/pubnub_ntf_sync.c ../posix/pubnub_get_native_socket.c ../core/srand_from_pubnub_time.c pubnub_futres_sync.cpp fntest/pubnub_fntest.cpp fntest/pubnub_fntest_basic.cpp fntest/pubnub_fntest_medium.cpp $(SOURCEFILES) $(LDLIBS) 
 
 
 clean:
@@ -12,6 +12,7 @@
 
 #include <functional>
 #include <string>
+#include <vector>
 
 #if PUBNUB_USE_EXTERN_C
 extern "C" {
@@ -232,6 +233,18 @@ public:
     /// Parses the last (or latest) result of the transaction 'publish'.
     pubnub_publish_res parse_last_publish_result();
 
+#if !defined(PUBNUB_CALLBACK_API)
+    /// Awaits the first of the transactions of the future results
+    /// @p futs to end, for at most @p timeout_ms milliseconds (if
+    /// negative, until one ends), driving them all from this thread.
+    /// Future results that are ready (and NULLs) are ignored.
+    /// @see pubnub_await_any()
+    /// @return Index (in @p futs) of the future result whose
+    /// transaction ended (get its outcome with await()), or -1
+    /// if none did
+    static int await_any(std::vector<futres*> const& futs, int timeout_ms = -1);
+#endif
+
     // We can construct from a temporary
 #if __cplusplus >= 201103L
     futres(futres&& x) :
@@ -17,6 +17,7 @@ extern "C" {
 #include "core/pubnub_timers.h"
 #include "core/pubnub_helper.h"
 #include "core/pubnub_free_with_timeout.h"
+#include "core/pubnub_json_parse.h"
 #if defined(PUBNUB_CALLBACK_API)
 #include "core/pubnub_ntf_callback.h"
 #endif
@@ -40,6 +41,9 @@ extern "C" {
 #if PUBNUB_USE_ACTIONS_API
 #include "core/pubnub_actions_api.h"
 #endif
+#if PUBNUB_USE_PUBLISH_BATCH
+#include "core/pubnub_publish_batch.h"
+#endif
 #if PUBNUB_USE_EXTERN_C
 }
 #endif
@@ -52,6 +56,7 @@ extern "C" {
 
 #include <string>
 #include <cstring>
+#include <cstdio>
 #include <vector>
 #include <map>
 #include <stdexcept>
@@ -59,6 +64,9 @@ extern "C" {
 #if __cplusplus >= 201103L
 #include <chrono>
 #endif
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 #include <iostream>
 
@@ -182,6 +190,140 @@ inline enum pubnub_proxy_type ccore_proxy_type(proxy_type prtp)
 }
 #endif
 
+#if PUBNUB_USE_PUBLISH_BATCH
+/// One message to publish in a batch. Empty @p meta means "no
+/// meta-data".
+struct publish_batch_item {
+    std::string channel;
+    std::string message;
+    std::string meta;
+
+    publish_batch_item(std::string const& ch,
+                       std::string const& msg,
+                       std::string const& mt = "")
+        : channel(ch)
+        , message(msg)
+        , meta(mt)
+    {
+    }
+};
+
+/// The result of publishing one message of a batch
+struct publish_batch_result {
+    /// The outcome, PNR_STARTED if not responded to
+    pubnub_res result;
+    /// The time token of the published message, empty on failure
+    std::string timetoken;
+};
+#endif /* PUBNUB_USE_PUBLISH_BATCH */
+
+/** A view of a JSON value, like a `string_view` (it doesn't own the
+    JSON text, which has to outlive it), to get values from a received
+    message without parsing all of it to a "DOM". Something like:
+
+        std::string m = pn.get();
+        pubnub::json_view msg(m);
+        double price;
+        if (msg["data.items[3].price"].get(price)) {
+            ...
+        }
+
+    Getting a path that is not there gives an "invalid" view.
+    @see pbjson_path
+*/
+class json_view {
+    pbjson_elem d_;
+
+public:
+    json_view() { d_.start = d_.end = 0; }
+    json_view(char const* start, char const* end)
+    {
+        d_.start = start;
+        d_.end   = end;
+    }
+    json_view(pbjson_elem const& el)
+        : d_(el)
+    {
+    }
+    /// Views the (NUL terminated) @p json
+    json_view(char const* json)
+    {
+        d_.start = json;
+        d_.end   = (0 == json) ? json : json + strlen(json);
+    }
+    /// Views the @p json, which has to outlive this view
+    json_view(std::string const& json)
+    {
+        d_.start = json.data();
+        d_.end   = json.data() + json.size();
+    }
+#if __cplusplus >= 201103L
+    /// A temporary would be gone before the view is used
+    json_view(std::string&&) = delete;
+#endif
+    /// Whether it views a (found) JSON value
+    bool valid() const { return d_.start != 0; }
+    char const* data() const { return d_.start; }
+    size_t      size() const { return d_.end - d_.start; }
+    /// The JSON text of the value (say, a string with the quotes)
+    std::string str() const { return valid() ? std::string(d_.start, size()) : ""; }
+    pbjson_elem const& elem() const { return d_; }
+#if __cplusplus >= 201703L
+    operator std::string_view() const { return std::string_view(d_.start, size()); }
+#endif
+
+    /// Returns the value at the @p path in this one, like
+    /// `data.items[3].price`. Invalid if not found.
+    json_view path(char const* path) const
+    {
+        pbjson_elem found;
+        if (!valid() || (jonmpOK != pbjson_path(&d_, path, &found))) {
+            return json_view();
+        }
+        return json_view(found);
+    }
+    json_view operator[](char const* p) const { return path(p); }
+    json_view operator[](std::string const& p) const { return path(p.c_str()); }
+    /// Returns the element @p index of this array. Invalid if not
+    /// found (or not an array).
+    json_view operator[](unsigned index) const
+    {
+        char p[24];
+        snprintf(p, sizeof p, "[%u]", index);
+        return path(p);
+    }
+    /// So that `view[0]` is not ambiguous with `operator[](char const*)`
+    json_view operator[](int index) const
+    {
+        return (index < 0) ? json_view() : (*this)[static_cast<unsigned>(index)];
+    }
+
+    bool is_null() const { return valid() && pbjson_elem_equals_string(&d_, "null"); }
+    /// Gets the number, returns false if not a number
+    bool get(double& d) const { return valid() && (0 == pbjson_get_double(&d_, &d)); }
+    /// Gets the integer, returns false if not an integer or it
+    /// doesn't fit
+    bool get(long& l) const { return valid() && (0 == pbjson_get_long(&d_, &l)); }
+    /// Gets the `true` or `false`, returns false if neither
+    bool get(bool& b) const { return valid() && (0 == pbjson_get_bool(&d_, &b)); }
+    /// Gets the string, with the escapes decoded, returns false if
+    /// not a string
+    bool get(std::string& s) const
+    {
+        if (!valid()) {
+            return false;
+        }
+        /* The decoded string is never longer than the JSON one */
+        std::vector<char> buf(size() + 1);
+        int const         len = pbjson_get_string(&d_, &buf[0], buf.size());
+        if (len < 0) {
+            return false;
+        }
+        s.assign(&buf[0], len);
+        return true;
+    }
+};
+
 /** A wrapper class for subscribe options, enabling a nicer
     usage. Something like:
 
@@ -615,12 +757,20 @@ public:
     std::vector<v2_message> get_all_v2() const
     {
         std::vector<v2_message> all;
-        v2_message msg = get_v2();
-
-        while (!msg.is_empty()) {
-            all.push_back(msg);
-            msg = get_v2();
-        }
+        pubnub_v2_message       msgs[16];
+        size_t const            max = sizeof msgs / sizeof msgs[0];
+        size_t                  n;
+
+        do {
+            n = pubnub_get_v2_batch(d_pb, msgs, max);
+            for (size_t i = 0; i < n; ++i) {
+                v2_message msg(msgs[i]);
+                if (msg.is_empty()) {
+                    return all;
+                }
+                all.push_back(msg);
+            }
+        } while (n == max);
         return all;
     }
 #endif /* PUBNUB_USE_SUBSCRIBE_V2 */
@@ -728,6 +878,39 @@ public:
     }
 #endif
 
+#if PUBNUB_USE_PUBLISH_BATCH
+    /// Publishes all the messages from @p items in one transaction,
+    /// pipelining the requests. Get the result of each message with
+    /// publish_batch_results() after the transaction is done.
+    /// @see pubnub_publish_batch
+    futres publish_batch(std::vector<publish_batch_item> const& items)
+    {
+        std::vector<pubnub_publish_batch_item> c_items(items.size());
+        for (size_t i = 0; i < items.size(); ++i) {
+            c_items[i].channel = items[i].channel.c_str();
+            c_items[i].message = items[i].message.c_str();
+            c_items[i].meta = items[i].meta.empty() ? 0 : items[i].meta.c_str();
+        }
+        return doit(pubnub_publish_batch(
+            d_pb, c_items.empty() ? 0 : &c_items[0], c_items.size()));
+    }
+
+    /// Returns the results of publishing the messages of the last
+    /// batch, in the order they were in the batch.
+    /// @see pubnub_publish_batch_results
+    std::vector<publish_batch_result> publish_batch_results()
+    {
+        std::vector<pubnub_publish_batch_result> c_results(PUBNUB_PUBLISH_BATCH_MAX);
+        size_t n = pubnub_publish_batch_results(d_pb, &c_results[0], c_results.size());
+        std::vector<publish_batch_result> rslt(n);
+        for (size_t i = 0; i < n; ++i) {
+            rslt[i].result = c_results[i].result;
+            rslt[i].timetoken = c_results[i].timetoken;
+        }
+        return rslt;
+    }
+#endif /* PUBNUB_USE_PUBLISH_BATCH */
+
     /// Subscribes to @p channel and/or @p channel_group
     /// @see pubnub_subscribe
     futres subscribe(std::string const& channel,
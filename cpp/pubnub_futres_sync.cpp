@@ -113,6 +113,29 @@ pubnub_publish_res futres::parse_last_publish_result()
     return d_ctx.parse_last_publish_result();
 }
 
+
+int futres::await_any(std::vector<futres*> const& futs, int timeout_ms)
+{
+    std::vector<pubnub_t*> ctxs(futs.size(), static_cast<pubnub_t*>(0));
+    int                    rslt;
+
+    if (futs.empty()) {
+        return -1;
+    }
+    for (size_t i = 0; i < futs.size(); ++i) {
+        if ((futs[i] != 0) && futs[i]->valid() && !futs[i]->is_ready()) {
+            ctxs[i] = futs[i]->d_pimpl->d_pb;
+        }
+    }
+    rslt = pubnub_await_any(&ctxs[0], ctxs.size(), timeout_ms);
+    if (rslt >= 0) {
+        /* Get (and keep) the outcome */
+        futs[rslt]->d_pimpl->last_result();
+    }
+
+    return rslt;
+}
+
 #if (__cplusplus >= 201103L) || (_MSC_VER >= 1600)
 void futres::then(std::function<void(context&, pubnub_res)> f)
 {
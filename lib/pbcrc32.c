@@ -2,33 +2,209 @@
 #include "lib/pbcrc32.h"
 #include "core/pubnub_assert.h"
 
-static uint32_t crc32_for_byte(uint32_t r)
+#include "lib/pbcrc32_tables.h"
+
+
+/** If true, on x86, the CRC of longer data is computed by "folding"
+    it with carry-less multiplication (PCLMULQDQ), if the CPU (as
+    checked at runtime) supports it. Only with GCC (compatible)
+    compilers, which can compile such code for its own functions.
+ */
+#if !defined PBCRC32_USE_PCLMUL
+#if defined __GNUC__ && (defined __x86_64__ || (defined __i386__ && defined __SSE2__))
+#define PBCRC32_USE_PCLMUL 1
+#else
+#define PBCRC32_USE_PCLMUL 0
+#endif
+#endif
+
+/** If true, on ARM, the CRC is computed with the CRC32 instructions.
+    These are optional in ARMv8.0 and mandatory from ARMv8.1, so this
+    is decided at compile time, by the target architecture (say,
+    `-march=armv8-a+crc`).
+ */
+#if !defined PBCRC32_USE_ARM_CRC
+#if defined __ARM_FEATURE_CRC32 && !defined __ARM_BIG_ENDIAN
+#define PBCRC32_USE_ARM_CRC 1
+#else
+#define PBCRC32_USE_ARM_CRC 0
+#endif
+#endif
+
+#if PBCRC32_USE_PCLMUL
+#include <immintrin.h>
+#endif
+#if PBCRC32_USE_ARM_CRC
+#include <arm_acle.h>
+#include <string.h>
+#endif
+
+
+/** Computes the CRC one byte at a time, on the "inverted" @p crc */
+static uint32_t crc32_bytes(uint32_t crc, uint8_t const* p, size_t n)
 {
-    int j;
-    for(j = 0; j < 8; ++j) {
-        r = ((r & 1) ? 0 : (uint32_t)0xEDB88320L) ^ (r >> 1);
+    for (; n > 0; --n, ++p) {
+        crc = m_crc32_table[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
     }
-    return r ^ (uint32_t)0xFF000000L;
+    return crc;
 }
 
-uint32_t pbcrc32(const void *data, size_t n_bytes)
+
+/** Computes the CRC eight bytes at a time (slicing-by-8), on the
+    "inverted" @p crc. Data is read byte by byte, to be independent of
+    alignment and endianness - compilers make that a load, where they
+    can.
+ */
+static uint32_t crc32_slice8(uint32_t crc, uint8_t const* p, size_t n)
 {
-    static uint32_t table[0x100];
-    uint32_t crc = 0;
-    uint8_t *p, *end;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint32_t const one = crc
+                             ^ ((uint32_t)p[0] | ((uint32_t)p[1] << 8)
+                                | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+        uint32_t const two = (uint32_t)p[4] | ((uint32_t)p[5] << 8)
+                             | ((uint32_t)p[6] << 16) | ((uint32_t)p[7] << 24);
+        crc = m_crc32_table[7][one & 0xFF] ^ m_crc32_table[6][(one >> 8) & 0xFF]
+              ^ m_crc32_table[5][(one >> 16) & 0xFF] ^ m_crc32_table[4][one >> 24]
+              ^ m_crc32_table[3][two & 0xFF] ^ m_crc32_table[2][(two >> 8) & 0xFF]
+              ^ m_crc32_table[1][(two >> 16) & 0xFF] ^ m_crc32_table[0][two >> 24];
+    }
+    return crc32_bytes(crc, p, n);
+}
 
-    PUBNUB_ASSERT_OPT(data != NULL);
-    PUBNUB_ASSERT_OPT(n_bytes > 0);
-    if (!(*table)) {
-        size_t i;
-        for(i = 0; i < 0x100; ++i) {
-            table[i] = crc32_for_byte(i);
-        }
+
+#if PBCRC32_USE_PCLMUL
+/* Less than this is faster with slicing-by-8 */
+#define PCLMUL_MIN_LENGTH 64
+
+/** Computes the CRC on the "inverted" @p crc of @p n bytes at @p p,
+    which has to be a multiple of 16, and at least 64, by folding 4
+    128-bit lanes at once with carry-less multiplication, then
+    folding the lanes into one and a Barrett reduction to 32 bits.
+    As in "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+    Instruction" by Intel, with the constants for the bit-reflected
+    CRC32 polynomial.
+ */
+__attribute__((target("pclmul,sse4.1"))) static uint32_t
+crc32_pclmul(uint32_t crc, uint8_t const* p, size_t n)
+{
+    __m128i const k1k2 = _mm_set_epi64x(0x01C6E41596LL, 0x0154442BD4LL);
+    __m128i const k3k4 = _mm_set_epi64x(0x00CCAA009ELL, 0x01751997D0LL);
+    __m128i const k5k0 = _mm_set_epi64x(0, 0x0163CD6124LL);
+    __m128i const poly = _mm_set_epi64x(0x01F7011641LL, 0x01DB710641LL);
+    __m128i const mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    __m128i       x1;
+    __m128i       x2;
+    __m128i       x3;
+    __m128i       x4;
+    __m128i       t;
+
+    x1 = _mm_loadu_si128((__m128i const*)(p + 0x00));
+    x2 = _mm_loadu_si128((__m128i const*)(p + 0x10));
+    x3 = _mm_loadu_si128((__m128i const*)(p + 0x20));
+    x4 = _mm_loadu_si128((__m128i const*)(p + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    p += 64;
+    n -= 64;
+
+    /* Fold 4 lanes, 64 bytes at a time */
+    for (; n >= 64; p += 64, n -= 64) {
+        __m128i const t1 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        __m128i const t2 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        __m128i const t3 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        __m128i const t4 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, t1), _mm_loadu_si128((__m128i const*)(p + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, t2), _mm_loadu_si128((__m128i const*)(p + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, t3), _mm_loadu_si128((__m128i const*)(p + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, t4), _mm_loadu_si128((__m128i const*)(p + 0x30)));
     }
-    p   = (uint8_t*)data;
-    end = p + n_bytes;
-    for (; p < end; ++p) {
-        crc = table[(uint8_t)crc ^ (*p)] ^ (crc >> 8);
+
+    /* Fold the 4 lanes into one */
+    t  = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), t);
+    t  = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), t);
+    t  = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), t);
+
+    /* Fold the rest, 16 bytes at a time */
+    for (; n >= 16; p += 16, n -= 16) {
+        t  = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((__m128i const*)p)), t);
+    }
+
+    /* Fold 128 bits to 64 */
+    t  = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), t);
+    t  = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5k0, 0x00);
+    x1 = _mm_xor_si128(x1, t);
+
+    /* Barrett reduction to 32 bits */
+    t  = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x10);
+    t  = _mm_clmulepi64_si128(_mm_and_si128(t, mask32), poly, 0x00);
+    x1 = _mm_xor_si128(x1, t);
+
+    return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+#endif /* PBCRC32_USE_PCLMUL */
+
+
+#if PBCRC32_USE_ARM_CRC
+static uint32_t crc32_arm(uint32_t crc, uint8_t const* p, size_t n)
+{
+    for (; n >= 8; n -= 8, p += 8) {
+        uint64_t v;
+        memcpy(&v, p, sizeof v);
+        crc = __crc32d(crc, v);
+    }
+    for (; n > 0; --n, ++p) {
+        crc = __crc32b(crc, *p);
     }
     return crc;
 }
+#endif /* PBCRC32_USE_ARM_CRC */
+
+
+uint32_t pbcrc32_update(uint32_t crc, const void* data, size_t n_bytes)
+{
+    uint8_t const* p = (uint8_t const*)data;
+
+    PUBNUB_ASSERT_OPT((data != NULL) || (0 == n_bytes));
+
+    crc = ~crc;
+#if PBCRC32_USE_ARM_CRC
+    crc = crc32_arm(crc, p, n_bytes);
+#else
+#if PBCRC32_USE_PCLMUL
+    if ((n_bytes >= PCLMUL_MIN_LENGTH) && __builtin_cpu_supports("pclmul")
+        && __builtin_cpu_supports("sse4.1")) {
+        size_t const folded = n_bytes & ~(size_t)15;
+        crc = crc32_pclmul(crc, p, folded);
+        p += folded;
+        n_bytes -= folded;
+    }
+#endif
+    crc = crc32_slice8(crc, p, n_bytes);
+#endif /* PBCRC32_USE_ARM_CRC */
+
+    return ~crc;
+}
+
+
+uint32_t pbcrc32(const void* data, size_t n_bytes)
+{
+    PUBNUB_ASSERT_OPT(data != NULL);
+    PUBNUB_ASSERT_OPT(n_bytes > 0);
+
+    return pbcrc32_update(0, data, n_bytes);
+}
@@ -11,5 +11,13 @@
  */ 
 uint32_t pbcrc32(const void *data, size_t n_bytes);
 
+/* Updates the CRC32 checksum @p crc (of the data before) with
+   @p n_bytes of @p data, returning the checksum of all the data.
+   Start with a @p crc of 0. So, pbcrc32(data, n) is the same as
+   pbcrc32_update(0, data, n), but the checksum can be computed
+   piece by piece, too.
+ */
+uint32_t pbcrc32_update(uint32_t crc, const void *data, size_t n_bytes);
+
 #endif /* INC_PB_CRC32 */
 
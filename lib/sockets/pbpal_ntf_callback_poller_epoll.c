@@ -0,0 +1,254 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "lib/sockets/pbpal_ntf_callback_poller_epoll.h"
+
+#include "pubnub_get_native_socket.h"
+
+#include "core/pubnub_assert.h"
+#include "core/pubnub_log.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+
+#if !defined(INVALID_SOCKET)
+#define INVALID_SOCKET -1
+#endif
+
+/* We use edge-triggered notifications. That is OK, because the FSM
+   always reads/writes until the socket would block. Also, whenever
+   we change what we watch for, we do an `EPOLL_CTL_MOD`, which
+   re-arms the notification, so we can't "miss the edge" on state
+   transitions.
+ */
+#define PBPAL_EPOLL_IN_EVENTS (EPOLLIN | EPOLLRDHUP | EPOLLET)
+#define PBPAL_EPOLL_OUT_EVENTS (EPOLLOUT | EPOLLET)
+
+
+struct pbpal_poll_data* pbpal_ntf_callback_poller_init(void)
+{
+    struct pbpal_poll_data* rslt;
+    struct epoll_event      ev;
+
+    rslt = (struct pbpal_poll_data*)malloc(sizeof *rslt);
+    if (NULL == rslt) {
+        return NULL;
+    }
+    rslt->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (-1 == rslt->epfd) {
+        PUBNUB_LOG_ERROR("Failed to create epoll instance, error = %d\n", errno);
+        free(rslt);
+        return NULL;
+    }
+    rslt->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (-1 == rslt->wakefd) {
+        PUBNUB_LOG_ERROR("Failed to create eventfd, error = %d\n", errno);
+        close(rslt->epfd);
+        free(rslt);
+        return NULL;
+    }
+    /* Level-triggered, we read it out when it fires */
+    memset(&ev, 0, sizeof ev);
+    ev.events   = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (0 != epoll_ctl(rslt->epfd, EPOLL_CTL_ADD, rslt->wakefd, &ev)) {
+        PUBNUB_LOG_ERROR("Failed to add eventfd to epoll, error = %d\n", errno);
+        close(rslt->wakefd);
+        close(rslt->epfd);
+        free(rslt);
+        return NULL;
+    }
+    rslt->size = 0;
+
+    return rslt;
+}
+
+
+static int epoll_ctl_pb(struct pbpal_poll_data* data,
+                        int                     op,
+                        pbpal_native_socket_t   sockt,
+                        pubnub_t*               pb,
+                        uint32_t                events)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof ev);
+    ev.events   = events;
+    ev.data.ptr = pb;
+
+    return epoll_ctl(data->epfd, op, sockt, &ev);
+}
+
+
+void pbpal_ntf_callback_save_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
+
+    PUBNUB_ASSERT_OPT(data != NULL);
+
+    if (INVALID_SOCKET == sockt) {
+        return;
+    }
+    if (0 != epoll_ctl_pb(data, EPOLL_CTL_ADD, sockt, pb, PBPAL_EPOLL_OUT_EVENTS)) {
+        PUBNUB_LOG_ERROR("pbpal_ntf_callback_save_socket(pb=%p) sockt=%d: "
+                         "epoll_ctl(ADD) failed, error = %d\n",
+                         pb,
+                         sockt,
+                         errno);
+        return;
+    }
+    ++data->size;
+}
+
+
+void pbpal_ntf_callback_remove_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
+
+    PUBNUB_ASSERT_OPT(data != NULL);
+
+    if (INVALID_SOCKET == sockt) {
+        return;
+    }
+    if (0 != epoll_ctl_pb(data, EPOLL_CTL_DEL, sockt, pb, 0)) {
+        PUBNUB_LOG_DEBUG("pbpal_ntf_callback_remove_socket(pb=%p) sockt=%d: "
+                         "Not Found! error = %d\n",
+                         pb,
+                         sockt,
+                         errno);
+        return;
+    }
+    PUBNUB_ASSERT_OPT(data->size > 0);
+    --data->size;
+}
+
+
+void pbpal_ntf_callback_update_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
+
+    PUBNUB_ASSERT_OPT(data != NULL);
+
+    if (INVALID_SOCKET == sockt) {
+        PUBNUB_LOG_WARNING(
+            "pbpal_ntf_callback_update_socket(pb=%p): no socket!\n", pb);
+        return;
+    }
+    /* The old socket was closed before the new one was opened (and
+       closing a socket removes it from the epoll set), so this is,
+       usually, a new socket for us. But, the new socket may well have
+       the same descriptor as the old one, so be prepared for that.
+    */
+    if (0 == epoll_ctl_pb(data, EPOLL_CTL_ADD, sockt, pb, PBPAL_EPOLL_OUT_EVENTS)) {
+        return;
+    }
+    if ((EEXIST != errno)
+        || (0 != epoll_ctl_pb(data, EPOLL_CTL_MOD, sockt, pb, PBPAL_EPOLL_OUT_EVENTS))) {
+        PUBNUB_LOG_WARNING("pbpal_ntf_callback_update_socket(pb=%p) sockt=%d: "
+                           "failed, error = %d\n",
+                           pb,
+                           sockt,
+                           errno);
+    }
+}
+
+
+int pbpal_ntf_watch_out_events(struct pbpal_poll_data* data, pubnub_t* pbp)
+{
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pbp);
+
+    PUBNUB_ASSERT_OPT(data != NULL);
+
+    if (0 != epoll_ctl_pb(data, EPOLL_CTL_MOD, sockt, pbp, PBPAL_EPOLL_OUT_EVENTS)) {
+        PUBNUB_LOG_WARNING(
+            "pbpal_ntf_watch_out_events(pbp=%p): Not Found! error = %d\n",
+            pbp,
+            errno);
+        return -1;
+    }
+    return 0;
+}
+
+
+int pbpal_ntf_watch_in_events(struct pbpal_poll_data* data, pubnub_t* pbp)
+{
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pbp);
+
+    PUBNUB_ASSERT_OPT(data != NULL);
+
+    if (0 != epoll_ctl_pb(data, EPOLL_CTL_MOD, sockt, pbp, PBPAL_EPOLL_IN_EVENTS)) {
+        PUBNUB_LOG_WARNING(
+            "pbpal_ntf_watch_in_events(pbp=%p): Not Found! error = %d\n",
+            pbp,
+            errno);
+        return -1;
+    }
+    return 0;
+}
+
+
+int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms)
+{
+    int rslt;
+    int i;
+
+    /* Even with no sockets, the eventfd is in the set, so we don't
+       have to "sleep" instead of polling.
+    */
+    rslt = epoll_wait(data->epfd, data->aevents, PBPAL_EPOLL_MAX_EVENTS, ms);
+    if (-1 == rslt) {
+        if (EINTR != errno) {
+            /* error? what to do about it? */
+            PUBNUB_LOG_WARNING("epoll size = %u, error = %d\n",
+                               (unsigned)data->size,
+                               errno);
+        }
+        return -1;
+    }
+    for (i = 0; i < rslt; ++i) {
+        pubnub_t* pbp = (pubnub_t*)data->aevents[i].data.ptr;
+        if (NULL == pbp) {
+            uint64_t count;
+            if (read(data->wakefd, &count, sizeof count) < 0) {
+                PUBNUB_LOG_TRACE("Reading eventfd failed, error = %d\n", errno);
+            }
+            continue;
+        }
+        pbntf_requeue_for_processing(pbp);
+    }
+
+    return rslt;
+}
+
+
+int pbpal_ntf_callback_poller_wake(struct pbpal_poll_data* data)
+{
+    uint64_t const one = 1;
+
+    PUBNUB_ASSERT_OPT(data != NULL);
+
+    /* If the counter is full (EAGAIN), the eventfd is already
+       "readable", so the wake-up is pending anyway.
+    */
+    if ((write(data->wakefd, &one, sizeof one) < 0) && (EAGAIN != errno)) {
+        PUBNUB_LOG_WARNING("Writing to eventfd failed, error = %d\n", errno);
+    }
+    return 0;
+}
+
+
+void pbpal_ntf_callback_poller_deinit(struct pbpal_poll_data** data)
+{
+    PUBNUB_ASSERT_OPT(data != NULL);
+    PUBNUB_ASSERT_OPT(*data != NULL);
+
+    close((*data)->wakefd);
+    close((*data)->epfd);
+    free(*data);
+    *data = NULL;
+}
@@ -0,0 +1,42 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined(INC_PBPAL_NTF_CALLBACK_POLLER_EPOLL)
+#define      INC_PBPAL_NTF_CALLBACK_POLLER_EPOLL
+
+#include "core/pbpal_ntf_callback_poller.h"
+
+#include <sys/epoll.h>
+
+#include <stddef.h>
+
+
+/** The maximum number of events that we get from the kernel in one
+    call to epoll_wait(). This is _not_ a limit on the number of
+    sockets we can watch - if more sockets are ready, we'll get
+    them on the next poll.
+ */
+#if !defined(PBPAL_EPOLL_MAX_EVENTS)
+#define PBPAL_EPOLL_MAX_EVENTS 64
+#endif
+
+
+/** Linux epoll() poller data. Unlike the poll() and select()
+    pollers, we don't keep an array of sockets and contexts, as epoll
+    keeps the poll-set in the kernel. The "user data" of each epoll
+    event is the Pubnub context itself, so we don't have to look for
+    it (neither when changing what to watch for, nor when dispatching
+    events).
+ */
+struct pbpal_poll_data {
+    /** The epoll file descriptor */
+    int epfd;
+    /** The eventfd used to wake up epoll_wait(), it's in the epoll
+        set with a NULL context */
+    int wakefd;
+    /** Number of sockets (contexts) in the poll-set */
+    size_t size;
+    /** The events that epoll_wait() gives back to us */
+    struct epoll_event aevents[PBPAL_EPOLL_MAX_EVENTS];
+};
+
+
+#endif /* !defined(INC_PBPAL_NTF_CALLBACK_POLLER_EPOLL) */
@@ -10,6 +10,12 @@
 
 #include <string.h>
 
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
 
 #if defined(_WIN32)
 /* Yes, we do know that it's not really that simple, there are subtle,
@@ -28,6 +34,62 @@
 #endif
 
 
+#if !defined(_WIN32)
+static int set_nonblock_cloexec(int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+    if ((-1 == flags) || (-1 == fcntl(fd, F_SETFL, flags | O_NONBLOCK))) {
+        return -1;
+    }
+    return fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+
+/** Creates the wake-up pipe of @p data and puts its read end as the
+    first element of the poll-set.
+ */
+static int make_wake_pipe(struct pbpal_poll_data* data)
+{
+    if (0 != pipe(data->wakefd)) {
+        PUBNUB_LOG_ERROR("Failed to create wake-up pipe, error = %d\n", errno);
+        return -1;
+    }
+    if ((0 != set_nonblock_cloexec(data->wakefd[0]))
+        || (0 != set_nonblock_cloexec(data->wakefd[1]))) {
+        PUBNUB_LOG_ERROR("Failed to set up wake-up pipe, error = %d\n", errno);
+        close(data->wakefd[0]);
+        close(data->wakefd[1]);
+        return -1;
+    }
+    data->apoll = (struct pollfd*)malloc(sizeof data->apoll[0] * 2);
+    data->apb   = (pubnub_t**)malloc(sizeof data->apb[0] * 2);
+    if ((NULL == data->apoll) || (NULL == data->apb)) {
+        free(data->apoll);
+        free(data->apb);
+        close(data->wakefd[0]);
+        close(data->wakefd[1]);
+        return -1;
+    }
+    data->apoll[0].fd     = data->wakefd[0];
+    data->apoll[0].events = POLLIN;
+    data->apb[0]          = NULL;
+    data->size            = 1;
+    data->cap             = 2;
+
+    return 0;
+}
+
+
+static void drain_wake_pipe(struct pbpal_poll_data* data)
+{
+    char buf[64];
+    while (read(data->wakefd[0], buf, sizeof buf) > 0) {
+        continue;
+    }
+}
+#endif /* !defined(_WIN32) */
+
+
 struct pbpal_poll_data* pbpal_ntf_callback_poller_init(void)
 {
     struct pbpal_poll_data* rslt;
@@ -39,6 +101,12 @@ struct pbpal_poll_data* pbpal_ntf_callback_poller_init(void)
     rslt->size = rslt->cap = 0;
     rslt->apoll            = NULL;
     rslt->apb              = NULL;
+#if !defined(_WIN32)
+    if (0 != make_wake_pipe(rslt)) {
+        free(rslt);
+        return NULL;
+    }
+#endif
 
     return rslt;
 }
@@ -191,6 +259,12 @@ int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms)
         size_t apoll_size = data->size;
         for (i = 0; i < apoll_size; ++i) {
             if (data->apoll[i].revents & (POLLIN | POLLOUT | POLLERR | POLLHUP | POLLNVAL)) {
+#if !defined(_WIN32)
+                if (NULL == data->apb[i]) {
+                    drain_wake_pipe(data);
+                    continue;
+                }
+#endif
                 pbntf_requeue_for_processing(data->apb[i]);
             }
         }
@@ -200,11 +274,34 @@ int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms)
 }
 
 
+int pbpal_ntf_callback_poller_wake(struct pbpal_poll_data* data)
+{
+    PUBNUB_ASSERT_OPT(data != NULL);
+#if defined(_WIN32)
+    /* WSAPoll() can't wait on anything but sockets */
+    PUBNUB_UNUSED(data);
+    return -1;
+#else
+    /* If the pipe is full (EAGAIN), the wake-up is pending anyway */
+    if ((write(data->wakefd[1], "", 1) < 0) && (EAGAIN != errno)) {
+        PUBNUB_LOG_WARNING("Writing to wake-up pipe failed, error = %d\n", errno);
+    }
+    return 0;
+#endif
+}
+
+
 void pbpal_ntf_callback_poller_deinit(struct pbpal_poll_data** data)
 {
     PUBNUB_ASSERT_OPT(data != NULL);
     PUBNUB_ASSERT_OPT(*data != NULL);
 
+#if !defined(_WIN32)
+    close((*data)->wakefd[0]);
+    close((*data)->wakefd[1]);
+#endif
+    free((*data)->apoll);
+    free((*data)->apb);
     free(*data);
     *data = NULL;
 }
@@ -23,6 +23,11 @@ struct pbpal_poll_data {
     size_t         size;
     size_t         cap;
     pubnub_t**     apb;
+#if !defined(_WIN32)
+    /** The pipe used to wake up poll(). Its read end is always the
+        first in @c apoll, with a NULL context in @c apb. */
+    int wakefd[2];
+#endif
 };
 
 
@@ -226,6 +226,14 @@ int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms)
 }
 
 
+int pbpal_ntf_callback_poller_wake(struct pbpal_poll_data* data)
+{
+    /* Not supported (yet) by this poller */
+    PUBNUB_UNUSED(data);
+    return -1;
+}
+
+
 void pbpal_ntf_callback_poller_deinit(struct pbpal_poll_data** data)
 {
     PUBNUB_ASSERT_OPT(data != NULL);
@@ -4,6 +4,55 @@
 
 #include "pubnub_get_native_socket.h"
 
+#include <stddef.h>
+
 int pbpal_set_socket_blocking_io(pbpal_native_socket_t socket, int use_blocking_io);
 
+/** A socket to wait on, with pbpal_wait_sockets_io() */
+struct pbpal_socket_wait {
+    /** The socket to wait on. If invalid (SOCKET_INVALID), it is
+        ignored */
+    pbpal_native_socket_t socket;
+    /** If non-zero, wait for @p socket to become writable, otherwise
+        to become readable */
+    int out;
+    /** Output: non-zero if @p socket is ready (for the I/O we waited
+        for, or there was an error/hang-up on it) */
+    int ready;
+};
+
+/** Memory that pbpal_wait_sockets_io() needs to wait on more sockets
+    than it can on the stack. Kept by the caller across waits, so that
+    it is not allocated on every wait. Zero-initialize it before the
+    first wait and release it with pbpal_free_socket_wait_mem().
+ */
+struct pbpal_socket_wait_mem {
+    void*  buf;
+    size_t n;
+};
+
+/** Releases the memory from @p mem, leaving it empty */
+void pbpal_free_socket_wait_mem(struct pbpal_socket_wait_mem* mem);
+
+/** Waits for the @p socket to become readable or, if @p out is
+    non-zero, writable - or for an error/hang-up on it - for at most
+    @p timeout_ms milliseconds.
+
+    @return >0: ready, 0: timed out, -1: error
+ */
+int pbpal_wait_socket_io(pbpal_native_socket_t socket, int out, int timeout_ms);
+
+/** Waits for any of the @p n sockets in @p waits to become ready,
+    for at most @p timeout_ms milliseconds. Sets the `ready` member of
+    all of them.
+
+    @param mem Memory to (re)use if @p n is too big to wait on the
+    stack. If NULL, it is allocated for this wait only.
+    @return Number of sockets that are ready (0: timed out), -1: error
+ */
+int pbpal_wait_sockets_io(struct pbpal_socket_wait*     waits,
+                          size_t                        n,
+                          struct pbpal_socket_wait_mem* mem,
+                          int                           timeout_ms);
+
 #endif /* INC_SOCKET_BLOCKING_IO */
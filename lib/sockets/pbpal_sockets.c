@@ -12,6 +12,10 @@
 
 #include <string.h>
 
+#if PUBNUB_USE_VECTORED_SEND && !defined(_WIN32)
+#include <sys/uio.h>
+#endif
+
 
 static void buf_setup(pubnub_t* pb)
 {
@@ -39,6 +43,9 @@ void pbpal_init(pubnub_t* pb)
     pal_init();
     pb->pal.socket = SOCKET_INVALID;
     pb->sock_state = STATE_NONE;
+#if PUBNUB_USE_VECTORED_SEND
+    pb->sendv_count = 0;
+#endif
     buf_setup(pb);
 #if PUBNUB_USE_MULTIPLE_ADDRESSES
     pbpal_multiple_addresses_reset_counters(&pb->spare_addresses);
@@ -51,7 +58,7 @@ int pbpal_send(pubnub_t* pb, void const* data, size_t n)
     PUBNUB_ASSERT_INT_OPT(pb->sock_state, ==, STATE_NONE);
 
     pb->ptr        = (uint8_t*)data;
-    pb->len        = (uint16_t)n;
+    pb->len        = (unsigned)n;
     pb->sock_state = STATE_SENDING_DATA;
     pb->left       = sizeof pb->core.http_buf / sizeof pb->core.http_buf[0];
 
@@ -65,6 +72,78 @@ int pbpal_send_str(pubnub_t* pb, char const* s)
 }
 
 
+#if PUBNUB_USE_VECTORED_SEND
+int pbpal_sendv(pubnub_t* pb, struct pbpal_iovec const* vec, size_t count)
+{
+    size_t i;
+
+    PUBNUB_ASSERT_INT_OPT(pb->sock_state, ==, STATE_NONE);
+    PUBNUB_ASSERT_OPT(count <= PUBNUB_SENDV_MAX);
+
+    pb->len         = 0;
+    pb->sendv_count = 0;
+    for (i = 0; i < count; ++i) {
+        if (vec[i].len > 0) {
+            pb->sendv[pb->sendv_count++] = vec[i];
+            pb->len += vec[i].len;
+        }
+    }
+    pb->sendv_index = 0;
+    pb->sock_state  = STATE_SENDING_DATA;
+    pb->left        = sizeof pb->core.http_buf / sizeof pb->core.http_buf[0];
+
+    return pbpal_send_status(pb);
+}
+
+
+/** Sends (as much as possible of) what's left of the "vector" of
+    data, in one system call.
+ */
+static int socket_sendv(pubnub_t* pb)
+{
+#if defined(_WIN32)
+    /* No writev() here, so, send piece by piece */
+    struct pbpal_iovec const* v = &pb->sendv[pb->sendv_index];
+    return socket_send(pb->pal.socket, (char const*)v->base, (int)v->len);
+#else
+    struct iovec  iov[PUBNUB_SENDV_MAX];
+    struct msghdr msg;
+    unsigned      i;
+
+    memset(&msg, 0, sizeof msg);
+    for (i = pb->sendv_index; i < pb->sendv_count; ++i) {
+        iov[msg.msg_iovlen].iov_base = (void*)pb->sendv[i].base;
+        iov[msg.msg_iovlen].iov_len  = pb->sendv[i].len;
+        ++msg.msg_iovlen;
+    }
+    msg.msg_iov = iov;
+#if defined(__linux__)
+    return sendmsg(pb->pal.socket, &msg, MSG_NOSIGNAL);
+#else
+    return sendmsg(pb->pal.socket, &msg, 0);
+#endif
+#endif /* defined(_WIN32) */
+}
+
+
+/** Skips the @p n octets that were sent from the "vector" of data */
+static void sendv_advance(pubnub_t* pb, unsigned n)
+{
+    while (n > 0) {
+        struct pbpal_iovec* v = &pb->sendv[pb->sendv_index];
+        PUBNUB_ASSERT_OPT(pb->sendv_index < pb->sendv_count);
+        if (n < v->len) {
+            v->base = (char const*)v->base + n;
+            v->len -= n;
+            break;
+        }
+        n -= v->len;
+        ++pb->sendv_index;
+    }
+}
+#endif /* PUBNUB_USE_VECTORED_SEND */
+
+
 int pbpal_send_status(pubnub_t* pb)
 {
     int rslt;
@@ -75,13 +154,27 @@ int pbpal_send_status(pubnub_t* pb)
 
     PUBNUB_ASSERT_OPT(pb->sock_state == STATE_SENDING_DATA);
 
+#if PUBNUB_USE_VECTORED_SEND
+    rslt = (pb->sendv_count > 0) ? socket_sendv(pb)
+                                 : socket_send(pb->pal.socket, (char*)pb->ptr, pb->len);
+#else
     rslt = socket_send(pb->pal.socket, (char*)pb->ptr, pb->len);
+#endif
     if (rslt <= 0) {
         rslt = (pbpal_handle_socket_error(rslt, pb, __FILE__, __LINE__) == PNR_IN_PROGRESS) ? +1 : -1;
     }
     else {
         PUBNUB_ASSERT_OPT((unsigned)rslt <= pb->len);
+#if PUBNUB_USE_VECTORED_SEND
+        if (pb->sendv_count > 0) {
+            sendv_advance(pb, rslt);
+        }
+        else {
+            pb->ptr += rslt;
+        }
+#else
         pb->ptr += rslt;
+#endif
         pb->len -= rslt;
         rslt = (0 == pb->len) ? 0 : +1;
     }
@@ -90,6 +183,9 @@ int pbpal_send_status(pubnub_t* pb)
         pb->ptr        = (uint8_t*)pb->core.http_buf;
         pb->unreadlen  = 0;
         pb->sock_state = STATE_NONE;
+#if PUBNUB_USE_VECTORED_SEND
+        pb->sendv_count = 0;
+#endif
     }
 
     return rslt;
@@ -201,10 +297,60 @@ int pbpal_start_read(pubnub_t* pb, size_t n)
 }
 
 
+#if PUBNUB_USE_ZERO_COPY_RECEIVE
+int pbpal_start_read_into(pubnub_t* pb, char* dst, size_t n)
+{
+    PUBNUB_ASSERT_UINT_OPT(n, >, 0);
+    PUBNUB_ASSERT_INT_OPT(pb->sock_state, ==, STATE_NONE);
+
+    pb->rx_dst     = (uint8_t*)dst;
+    pb->sock_state = STATE_READ_INTO;
+    pb->len        = n;
+
+    return +1;
+}
+
+
+static enum pubnub_res read_into_status(pubnub_t* pb)
+{
+    if (pb->unreadlen > 0) {
+        /* Already received to our buffer, with the headers */
+        unsigned n = (pb->unreadlen >= pb->len) ? pb->len : pb->unreadlen;
+        memcpy(pb->rx_dst, pb->ptr, n);
+        pb->ptr += n;
+        pb->unreadlen -= n;
+        pb->rx_dst += n;
+        pb->len -= n;
+    }
+    if (pb->len > 0) {
+        int have_read = socket_recv(pb->pal.socket, (char*)pb->rx_dst, pb->len, 0);
+        if (have_read <= 0) {
+            return pbpal_handle_socket_error(have_read, pb, __FILE__, __LINE__);
+        }
+        PUBNUB_ASSERT_OPT((unsigned)have_read <= pb->len);
+        pb->rx_dst += have_read;
+        pb->len -= have_read;
+    }
+
+    if (0 == pb->len) {
+        pb->sock_state = STATE_NONE;
+        return PNR_OK;
+    }
+
+    return PNR_IN_PROGRESS;
+}
+#endif /* PUBNUB_USE_ZERO_COPY_RECEIVE */
+
+
 enum pubnub_res pbpal_read_status(pubnub_t* pb)
 {
     int have_read;
 
+#if PUBNUB_USE_ZERO_COPY_RECEIVE
+    if (STATE_READ_INTO == pb->sock_state) {
+        return read_into_status(pb);
+    }
+#endif
     PUBNUB_ASSERT_OPT(STATE_READ == pb->sock_state);
 
     if (0 == pb->unreadlen) {
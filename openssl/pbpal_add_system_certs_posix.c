@@ -2,7 +2,7 @@
 #include "pbpal_add_system_certs.h"
 
 
-int pbpal_add_system_certs(pubnub_t* pb)
+int pbpal_add_system_certs(SSL_CTX* sslCtx)
 {
     /* not available on POSIX */
     return -1;
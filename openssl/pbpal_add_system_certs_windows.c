@@ -12,9 +12,9 @@
 
 #pragma comment(lib, "crypt32")
 
-int pbpal_add_system_certs(pubnub_t* pb)
+int pbpal_add_system_certs(SSL_CTX* sslCtx)
 {
-    X509_STORE *cert_store = SSL_CTX_get_cert_store(pb->pal.ctx);
+    X509_STORE *cert_store = SSL_CTX_get_cert_store(sslCtx);
     HCERTSTORE hStore = CertOpenSystemStoreW(0, L"ROOT");
     PCCERT_CONTEXT pContext = NULL;
 
@@ -10,7 +10,9 @@
 #endif
 
 #include "pbpal_add_system_certs.h"
+#include "pbpal_mutex.h"
 #include "pubnub_internal.h"
+#include "core/pubnub_ssl.h"
 #include "core/pubnub_assert.h"
 #include "core/pubnub_log.h"
 #include "lib/sockets/pbpal_adns_sockets.h"
@@ -25,6 +27,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 
 #define TLS_PORT 443
 
@@ -139,41 +142,581 @@ static int add_pubnub_cert(SSL_CTX* sslCtx)
 }
 
 
-static void add_certs(pubnub_t* pb)
+/** The key of the SSL_CTX cache - the certificate settings. */
+struct ssl_ctx_key {
+    char const* CAfile;
+    char const* CApath;
+    char const* userPEMcert;
+    bool        use_system_certificate_store;
+};
+
+
+/** An entry in the process-wide SSL_CTX cache. Contexts which have
+    the same certificate settings share the same SSL_CTX, so we parse
+    the certificates and build the X509 store only once.
+ */
+struct ssl_ctx_cache_entry {
+    /** The shared SSL_CTX */
+    SSL_CTX* ctx;
+    /** Our own copy of the certificate settings (the key) */
+    struct ssl_ctx_key key;
+    /** Number of contexts using this entry */
+    unsigned refcount;
+    /** Was this entry pre-warmed, in which case it is kept even
+        if no context uses it */
+    bool prewarmed;
+    /** Next entry in the cache */
+    struct ssl_ctx_cache_entry* next;
+};
+
+
+/** The SSL_CTX cache. It's a simple list, as there are very few
+    different certificate settings in any process (usually just one).
+ */
+static struct ssl_ctx_cache_entry* m_ssl_ctx_cache;
+
+/** The lock for both the SSL_CTX cache and the SSL session cache */
+pbpal_mutex_static_decl_and_init(m_ssl_cache_lock);
+
+
+static void add_certs(SSL_CTX* sslCtx, struct ssl_ctx_key const* key)
 {
     PUBNUB_LOG_TRACE(
-        "add_certs(pb=%p): pb->options.use_system_certificate_store=%d, "
-        "pb->ssl_userPEMcert=%p, pb->ssl_CAfile='%s', pb->ssl_CApath='%s'.\n",
-        pb,
-        pb->options.use_system_certificate_store,
-        pb->ssl_userPEMcert,
-        pb->ssl_CAfile,
-        pb->ssl_CApath);
-
-    if (pb->options.use_system_certificate_store
-        && (0 == pbpal_add_system_certs(pb))) {
+        "add_certs(SSL_CTX=%p): use_system_certificate_store=%d, "
+        "userPEMcert=%p, CAfile='%s', CApath='%s'.\n",
+        sslCtx,
+        key->use_system_certificate_store,
+        key->userPEMcert,
+        key->CAfile,
+        key->CApath);
+
+    if (key->use_system_certificate_store
+        && (0 == pbpal_add_system_certs(sslCtx))) {
         return;
     }
 
-    if (NULL != pb->ssl_userPEMcert) {
-        add_pem_cert(pb->pal.ctx, pb->ssl_userPEMcert);
+    if (NULL != key->userPEMcert) {
+        add_pem_cert(sslCtx, key->userPEMcert);
     }
 
-    if ((NULL == pb->ssl_CAfile) && (NULL == pb->ssl_CApath)) {
-        add_pubnub_cert(pb->pal.ctx);
+    if ((NULL == key->CAfile) && (NULL == key->CApath)) {
+        add_pubnub_cert(sslCtx);
     }
     else {
-        if (!SSL_CTX_load_verify_locations(
-                pb->pal.ctx, pb->ssl_CAfile, pb->ssl_CApath)) {
+        if (!SSL_CTX_load_verify_locations(sslCtx, key->CAfile, key->CApath)) {
             ERR_print_errors_cb(print_to_pubnub_log, NULL);
             PUBNUB_LOG_ERROR(
                 "SSL_CTX_load_verify_locations(CAfile=%s, CApath=%s) failed",
-                pb->ssl_CAfile,
-                pb->ssl_CApath);
+                key->CAfile,
+                key->CApath);
+        }
+    }
+}
+
+
+static bool str_same(char const* a, char const* b)
+{
+    if ((NULL == a) || (NULL == b)) {
+        return a == b;
+    }
+    return 0 == strcmp(a, b);
+}
+
+
+static bool key_same(struct ssl_ctx_key const* a, struct ssl_ctx_key const* b)
+{
+    return (a->use_system_certificate_store == b->use_system_certificate_store)
+           && str_same(a->CAfile, b->CAfile) && str_same(a->CApath, b->CApath)
+           && str_same(a->userPEMcert, b->userPEMcert);
+}
+
+
+static char* str_dup(char const* s)
+{
+    char*  rslt;
+    size_t len;
+
+    if (NULL == s) {
+        return NULL;
+    }
+    len  = strlen(s) + 1;
+    rslt = (char*)malloc(len);
+    if (rslt != NULL) {
+        memcpy(rslt, s, len);
+    }
+    return rslt;
+}
+
+
+static void entry_free(struct ssl_ctx_cache_entry* entry)
+{
+    SSL_CTX_free(entry->ctx);
+    free((char*)entry->key.CAfile);
+    free((char*)entry->key.CApath);
+    free((char*)entry->key.userPEMcert);
+    free(entry);
+}
+
+
+static struct ssl_ctx_cache_entry* entry_new(struct ssl_ctx_key const* key)
+{
+    struct ssl_ctx_cache_entry* entry;
+
+    entry = (struct ssl_ctx_cache_entry*)calloc(1, sizeof *entry);
+    if (NULL == entry) {
+        return NULL;
+    }
+    entry->key.use_system_certificate_store = key->use_system_certificate_store;
+    entry->key.CAfile                       = str_dup(key->CAfile);
+    entry->key.CApath                       = str_dup(key->CApath);
+    entry->key.userPEMcert                  = str_dup(key->userPEMcert);
+    if (((NULL != key->CAfile) && (NULL == entry->key.CAfile))
+        || ((NULL != key->CApath) && (NULL == entry->key.CApath))
+        || ((NULL != key->userPEMcert) && (NULL == entry->key.userPEMcert))) {
+        entry_free(entry);
+        return NULL;
+    }
+    entry->ctx = SSL_CTX_new(SSLv23_client_method());
+    if (NULL == entry->ctx) {
+        ERR_print_errors_cb(print_to_pubnub_log, NULL);
+        PUBNUB_LOG_ERROR("SSL_CTX_new failed\n");
+        entry_free(entry);
+        return NULL;
+    }
+    PUBNUB_LOG_TRACE("Got SSL_CTX=%p\n", entry->ctx);
+    add_certs(entry->ctx, &entry->key);
+
+    return entry;
+}
+
+
+/** Finds the cache entry for the @p key, creating it if needed.
+    @pre m_ssl_cache_lock is locked
+ */
+static struct ssl_ctx_cache_entry* cache_find_or_add(struct ssl_ctx_key const* key)
+{
+    struct ssl_ctx_cache_entry* entry;
+
+    for (entry = m_ssl_ctx_cache; entry != NULL; entry = entry->next) {
+        if (key_same(&entry->key, key)) {
+            return entry;
         }
     }
+    entry = entry_new(key);
+    if (entry != NULL) {
+        entry->next     = m_ssl_ctx_cache;
+        m_ssl_ctx_cache = entry;
+    }
+
+    return entry;
 }
 
+
+/** Removes the @p entry from the cache and frees it, if nobody
+    uses it any more.
+    @pre m_ssl_cache_lock is locked
+ */
+static void cache_remove_if_unused(struct ssl_ctx_cache_entry* entry)
+{
+    struct ssl_ctx_cache_entry** pp;
+
+    if ((entry->refcount > 0) || entry->prewarmed) {
+        return;
+    }
+    for (pp = &m_ssl_ctx_cache; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == entry) {
+            *pp = entry->next;
+            entry_free(entry);
+            return;
+        }
+    }
+}
+
+
+SSL_CTX* pbpal_acquire_ssl_ctx(pubnub_t* pb)
+{
+    struct ssl_ctx_key          key;
+    struct ssl_ctx_cache_entry* entry;
+    SSL_CTX*                    rslt = NULL;
+
+    key.CAfile                       = pb->ssl_CAfile;
+    key.CApath                       = pb->ssl_CApath;
+    key.userPEMcert                  = pb->ssl_userPEMcert;
+    key.use_system_certificate_store = pb->options.use_system_certificate_store;
+
+    pbpal_mutex_init_static(m_ssl_cache_lock);
+    pbpal_mutex_lock(m_ssl_cache_lock);
+    entry = cache_find_or_add(&key);
+    if (entry != NULL) {
+        ++entry->refcount;
+        rslt = entry->ctx;
+    }
+    pbpal_mutex_unlock(m_ssl_cache_lock);
+
+    return rslt;
+}
+
+
+/** Finds the cache entry of the @p ctx.
+    @pre m_ssl_cache_lock is locked
+ */
+static struct ssl_ctx_cache_entry* cache_find_ctx(SSL_CTX const* ctx)
+{
+    struct ssl_ctx_cache_entry* entry;
+
+    for (entry = m_ssl_ctx_cache; entry != NULL; entry = entry->next) {
+        if (entry->ctx == ctx) {
+            break;
+        }
+    }
+    return entry;
+}
+
+
+/** Releases a reference to the cache @p entry.
+    @pre m_ssl_cache_lock is locked
+ */
+static void cache_release(struct ssl_ctx_cache_entry* entry)
+{
+    PUBNUB_ASSERT_OPT(entry->refcount > 0);
+    --entry->refcount;
+    cache_remove_if_unused(entry);
+}
+
+
+void pbpal_release_ssl_ctx(SSL_CTX* ctx)
+{
+    struct ssl_ctx_cache_entry* entry;
+
+    pbpal_mutex_init_static(m_ssl_cache_lock);
+    pbpal_mutex_lock(m_ssl_cache_lock);
+    entry = cache_find_ctx(ctx);
+    PUBNUB_ASSERT_OPT(entry != NULL);
+    if (entry != NULL) {
+        cache_release(entry);
+    }
+    pbpal_mutex_unlock(m_ssl_cache_lock);
+}
+
+
+int pubnub_ssl_ctx_prewarm(char const* sCAfile,
+                           char const* sCApath,
+                           char const* userPEMcert,
+                           bool        use_system_certificate_store)
+{
+    struct ssl_ctx_key          key;
+    struct ssl_ctx_cache_entry* entry;
+
+    if (0 != pbpal_openssl_lib_init()) {
+        return -1;
+    }
+    key.CAfile                       = sCAfile;
+    key.CApath                       = sCApath;
+    key.userPEMcert                  = userPEMcert;
+    key.use_system_certificate_store = use_system_certificate_store;
+
+    pbpal_mutex_init_static(m_ssl_cache_lock);
+    pbpal_mutex_lock(m_ssl_cache_lock);
+    entry = cache_find_or_add(&key);
+    if (entry != NULL) {
+        entry->prewarmed = true;
+    }
+    pbpal_mutex_unlock(m_ssl_cache_lock);
+
+    return (NULL == entry) ? -1 : 0;
+}
+
+
+void pubnub_ssl_ctx_cache_clear(void)
+{
+    struct ssl_ctx_cache_entry* entry;
+    struct ssl_ctx_cache_entry* next;
+
+    pbpal_mutex_init_static(m_ssl_cache_lock);
+    pbpal_mutex_lock(m_ssl_cache_lock);
+    for (entry = m_ssl_ctx_cache; entry != NULL; entry = next) {
+        next             = entry->next;
+        entry->prewarmed = false;
+        cache_remove_if_unused(entry);
+    }
+    pbpal_mutex_unlock(m_ssl_cache_lock);
+}
+
+
+/** The maximum time (in seconds) a TLS session is kept in the
+    process-wide session cache. Sessions are evicted earlier if they
+    expire earlier (per the session's own timeout, which the server
+    sets).
+*/
+#if !defined(PUBNUB_SSL_SESSION_CACHE_TTL_S)
+#define PUBNUB_SSL_SESSION_CACHE_TTL_S 300
+#endif
+
+
+/** An entry in the process-wide TLS session cache. This enables
+    resuming a TLS session across contexts (and context "lifetimes"),
+    not just on a re-connect on the same context. The key is the
+    origin and port - and the SSL_CTX, because a resumed session is
+    not verified again, so, we must not use a session that was
+    verified with different certificate settings.
+
+    An entry holds a reference to its SSL_CTX (cache entry), so that
+    the session outlives the contexts that made it.
+ */
+struct ssl_session_cache_entry {
+    char*                           origin;
+    uint16_t                        port;
+    struct ssl_ctx_cache_entry*     ctx_entry;
+    SSL_SESSION*                    session;
+    time_t                          expiry;
+    struct ssl_session_cache_entry* next;
+};
+
+
+/** The TLS session cache. Like the SSL_CTX cache, it's a simple
+    list, as there are very few origins any process connects to.
+ */
+static struct ssl_session_cache_entry* m_ssl_session_cache;
+
+/** Number of times we found / didn't find a session in the cache */
+static unsigned long m_ssl_session_cache_hits;
+static unsigned long m_ssl_session_cache_misses;
+
+
+static char const* tls_origin(pubnub_t const* pb)
+{
+    return PUBNUB_ORIGIN_SETTABLE ? pb->origin : PUBNUB_ORIGIN;
+}
+
+
+static void session_up_ref(SSL_SESSION* session)
+{
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    CRYPTO_add(&session->references, 1, CRYPTO_LOCK_SSL_SESSION);
+#else
+    SSL_SESSION_up_ref(session);
+#endif
+}
+
+
+/** @pre m_ssl_cache_lock is locked */
+static void session_entry_free(struct ssl_session_cache_entry* entry)
+{
+    SSL_SESSION_free(entry->session);
+    cache_release(entry->ctx_entry);
+    free(entry->origin);
+    free(entry);
+}
+
+
+/** Removes the entries that satisfy @p pred from the session cache.
+    @pre m_ssl_cache_lock is locked
+ */
+static void session_cache_remove_if(
+    bool (*pred)(struct ssl_session_cache_entry const*, void const*),
+    void const* arg)
+{
+    struct ssl_session_cache_entry** pp = &m_ssl_session_cache;
+
+    while (*pp != NULL) {
+        struct ssl_session_cache_entry* entry = *pp;
+        if (pred(entry, arg)) {
+            *pp = entry->next;
+            session_entry_free(entry);
+        }
+        else {
+            pp = &entry->next;
+        }
+    }
+}
+
+
+static bool session_expired(struct ssl_session_cache_entry const* entry,
+                            void const*                           now)
+{
+    return entry->expiry <= *(time_t const*)now;
+}
+
+
+static bool session_is(struct ssl_session_cache_entry const* entry,
+                       void const*                           session)
+{
+    return entry->session == (SSL_SESSION const*)session;
+}
+
+
+/** Finds the session cache entry for the @p pb's origin, port and
+    SSL_CTX, evicting the expired entries along the way.
+    @pre m_ssl_cache_lock is locked
+ */
+static struct ssl_session_cache_entry* session_cache_find(pubnub_t const* pb)
+{
+    struct ssl_session_cache_entry* entry;
+    time_t                          now    = time(NULL);
+    char const*                     origin = tls_origin(pb);
+
+    session_cache_remove_if(session_expired, &now);
+    for (entry = m_ssl_session_cache; entry != NULL; entry = entry->next) {
+        if ((entry->port == TLS_PORT) && (entry->ctx_entry->ctx == pb->pal.ctx)
+            && (0 == strcmp(entry->origin, origin))) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+
+/** Gets (a reference to) the cached TLS session for the context
+    @p pb, if there is one, NULL otherwise.
+ */
+static SSL_SESSION* session_cache_get(pubnub_t const* pb)
+{
+    struct ssl_session_cache_entry* entry;
+    SSL_SESSION*                    rslt = NULL;
+
+    pbpal_mutex_init_static(m_ssl_cache_lock);
+    pbpal_mutex_lock(m_ssl_cache_lock);
+    entry = session_cache_find(pb);
+    if (entry != NULL) {
+        rslt = entry->session;
+        session_up_ref(rslt);
+        ++m_ssl_session_cache_hits;
+    }
+    else {
+        ++m_ssl_session_cache_misses;
+    }
+    pbpal_mutex_unlock(m_ssl_cache_lock);
+
+    return rslt;
+}
+
+
+/** Puts the @p session into the cache for the context @p pb,
+    replacing the session that is there (if any).
+ */
+static void session_cache_put(pubnub_t const* pb, SSL_SESSION* session)
+{
+    struct ssl_session_cache_entry* entry;
+    time_t                          now    = time(NULL);
+    time_t                          expiry = SSL_SESSION_get_time(session)
+                                    + SSL_SESSION_get_timeout(session);
+
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    if (!SSL_SESSION_is_resumable(session)) {
+        return;
+    }
+#endif
+    if (expiry > now + PUBNUB_SSL_SESSION_CACHE_TTL_S) {
+        expiry = now + PUBNUB_SSL_SESSION_CACHE_TTL_S;
+    }
+    if (expiry <= now) {
+        return;
+    }
+
+    pbpal_mutex_init_static(m_ssl_cache_lock);
+    pbpal_mutex_lock(m_ssl_cache_lock);
+    entry = session_cache_find(pb);
+    if (NULL == entry) {
+        struct ssl_ctx_cache_entry* ctx_entry = cache_find_ctx(pb->pal.ctx);
+        PUBNUB_ASSERT_OPT(ctx_entry != NULL);
+        entry = (struct ssl_session_cache_entry*)calloc(1, sizeof *entry);
+        if (entry != NULL) {
+            entry->origin = str_dup(tls_origin(pb));
+            if (NULL == entry->origin) {
+                free(entry);
+                entry = NULL;
+            }
+        }
+        if (NULL == entry) {
+            pbpal_mutex_unlock(m_ssl_cache_lock);
+            PUBNUB_LOG_WARNING(
+                "pb=%p: Failed to allocate TLS session cache entry\n", pb);
+            return;
+        }
+        ++ctx_entry->refcount;
+        entry->port         = TLS_PORT;
+        entry->ctx_entry    = ctx_entry;
+        entry->next         = m_ssl_session_cache;
+        m_ssl_session_cache = entry;
+    }
+    else if (entry->session != session) {
+        SSL_SESSION_free(entry->session);
+        entry->session = NULL;
+    }
+    if (NULL == entry->session) {
+        session_up_ref(session);
+        entry->session = session;
+    }
+    entry->expiry = expiry;
+    pbpal_mutex_unlock(m_ssl_cache_lock);
+}
+
+
+void pbpal_update_ssl_session(pubnub_t* pb)
+{
+    SSL_SESSION* session;
+
+    if ((NULL == pb->pal.ssl) || (NULL == pb->pal.session)
+        || !pb->options.reuse_SSL_session) {
+        return;
+    }
+    /* With TLS 1.3, the session (ticket) the server sends us comes
+       after the handshake, so we check if we got a new one.
+    */
+    session = SSL_get1_session(pb->pal.ssl);
+    if (NULL == session) {
+        return;
+    }
+    if (session != pb->pal.session) {
+        SSL_SESSION_free(pb->pal.session);
+        pb->pal.session = session;
+        session_cache_put(pb, session);
+    }
+    else {
+        SSL_SESSION_free(session);
+    }
+}
+
+
+void pbpal_forget_ssl_session(pubnub_t* pb)
+{
+    if (NULL == pb->pal.session) {
+        return;
+    }
+    pbpal_mutex_init_static(m_ssl_cache_lock);
+    pbpal_mutex_lock(m_ssl_cache_lock);
+    session_cache_remove_if(session_is, pb->pal.session);
+    pbpal_mutex_unlock(m_ssl_cache_lock);
+}
+
+
+void pubnub_ssl_session_cache_stats(unsigned long* hits, unsigned long* misses)
+{
+    pbpal_mutex_init_static(m_ssl_cache_lock);
+    pbpal_mutex_lock(m_ssl_cache_lock);
+    if (hits != NULL) {
+        *hits = m_ssl_session_cache_hits;
+    }
+    if (misses != NULL) {
+        *misses = m_ssl_session_cache_misses;
+    }
+    pbpal_mutex_unlock(m_ssl_cache_lock);
+}
+
+
+void pubnub_ssl_session_cache_clear(void)
+{
+    pbpal_mutex_init_static(m_ssl_cache_lock);
+    pbpal_mutex_lock(m_ssl_cache_lock);
+    while (m_ssl_session_cache != NULL) {
+        struct ssl_session_cache_entry* entry = m_ssl_session_cache;
+        m_ssl_session_cache                   = entry->next;
+        session_entry_free(entry);
+    }
+    pbpal_mutex_unlock(m_ssl_cache_lock);
+}
+
+
 enum pbpal_tls_result pbpal_start_tls(pubnub_t* pb)
 {
     SSL* ssl;
@@ -186,14 +729,12 @@ enum pbpal_tls_result pbpal_start_tls(pubnub_t* pb)
 
     if (NULL == pb->pal.ctx) {
         PUBNUB_LOG_TRACE("pb=%p: Don't have SSL_CTX\n", pb);
-        pb->pal.ctx = SSL_CTX_new(SSLv23_client_method());
+        pb->pal.ctx = pbpal_acquire_ssl_ctx(pb);
         if (NULL == pb->pal.ctx) {
-            ERR_print_errors_cb(print_to_pubnub_log, pb);
-            PUBNUB_LOG_ERROR("pb=%p SSL_CTX_new failed\n", pb);
+            PUBNUB_LOG_ERROR("pb=%p: Failed to get SSL_CTX\n", pb);
             return pbtlsResourceFailure;
         }
-        PUBNUB_LOG_TRACE("pb=%p: Got SSL_CTX\n", pb);
-        add_certs(pb);
+        PUBNUB_LOG_TRACE("pb=%p: Got SSL_CTX=%p\n", pb, pb->pal.ctx);
     }
     ssl = pb->pal.ssl = SSL_new(pb->pal.ctx);
     if (NULL == ssl) {
@@ -205,8 +746,11 @@ enum pbpal_tls_result pbpal_start_tls(pubnub_t* pb)
     SSL_set_fd(ssl, pb->pal.socket);
     WATCH_ENUM(pb->options.use_blocking_io);
     pb->pal.tryconn = pbms_start();
-    if (pb->options.reuse_SSL_session && (pb->pal.session != NULL)) {
-        if (!SSL_set_session(ssl, pb->pal.session)) {
+    if (pb->options.reuse_SSL_session) {
+        if (NULL == pb->pal.session) {
+            pb->pal.session = session_cache_get(pb);
+        }
+        if ((pb->pal.session != NULL) && !SSL_set_session(ssl, pb->pal.session)) {
             ERR_print_errors_cb(print_to_pubnub_log, NULL);
         }
     }
@@ -267,6 +811,9 @@ enum pbpal_tls_result pbpal_check_tls(pubnub_t* pb)
             SSL_SESSION_free(pb->pal.session);
         }
         pb->pal.session = SSL_get1_session(pb->pal.ssl);
+        if (pb->pal.session != NULL) {
+            session_cache_put(pb, pb->pal.session);
+        }
         if (0 == pb->pal.ip_timeout) {
             pb->pal.ip_timeout = SSL_SESSION_get_time(pb->pal.session)
                                  + SSL_SESSION_get_timeout(pb->pal.session);
@@ -92,7 +92,7 @@ static void buf_setup(pubnub_t* pb)
 }
 
 
-static int pal_init(void)
+int pbpal_openssl_lib_init(void)
 {
     static bool s_init = false;
     if (!s_init) {
@@ -108,6 +108,19 @@ static int pal_init(void)
         if (locks_setup()) {
             return -1;
         }
+        s_init = true;
+    }
+    return 0;
+}
+
+
+static int pal_init(void)
+{
+    static bool s_init = false;
+    if (!s_init) {
+        if (0 != pbpal_openssl_lib_init()) {
+            return -1;
+        }
         if (0 != socket_platform_init()) {
             return -1;
         }
@@ -138,7 +151,7 @@ int pbpal_send(pubnub_t* pb, void const* data, size_t n)
     PUBNUB_ASSERT_INT_OPT(pb->sock_state, ==, STATE_NONE);
 
     pb->ptr        = (uint8_t*)data;
-    pb->len        = (uint16_t)n;
+    pb->len        = (unsigned)n;
     pb->sock_state = STATE_SENDING_DATA;
     pb->left       = sizeof pb->core.http_buf / sizeof pb->core.http_buf[0];
 
@@ -152,6 +165,46 @@ int pbpal_send_str(pubnub_t* pb, char const* s)
 }
 
 
+#if PUBNUB_USE_VECTORED_SEND
+int pbpal_sendv(pubnub_t* pb, struct pbpal_iovec const* vec, size_t count)
+{
+    size_t total = 0;
+    size_t i;
+    char*  p;
+
+    PUBNUB_ASSERT_INT_OPT(pb->sock_state, ==, STATE_NONE);
+    for (i = 0; i < count; ++i) {
+        total += vec[i].len;
+    }
+    /* There's no "SSL_writev()", so we coalesce the data, to have
+       it all in one TLS record (and one system call).
+    */
+    if (total > pb->pal.txbuf_size) {
+        p = (char*)realloc(pb->pal.txbuf, total);
+        if (NULL == p) {
+            PUBNUB_LOG_ERROR("pb=%p: Failed to allocate %lu octets to send\n",
+                             pb,
+                             (unsigned long)total);
+            return -1;
+        }
+        pb->pal.txbuf      = p;
+        pb->pal.txbuf_size = total;
+    }
+    for (p = pb->pal.txbuf, i = 0; i < count; ++i) {
+        memcpy(p, vec[i].base, vec[i].len);
+        p += vec[i].len;
+    }
+
+    pb->ptr        = (uint8_t*)pb->pal.txbuf;
+    pb->len        = (unsigned)total;
+    pb->sock_state = STATE_SENDING_DATA;
+    pb->left       = sizeof pb->core.http_buf / sizeof pb->core.http_buf[0];
+
+    return pbpal_send_status(pb);
+}
+#endif /* PUBNUB_USE_VECTORED_SEND */
+
+
 enum pubnub_res pbpal_handle_socket_condition(int result, pubnub_t* pb, char const* file, int line)
 {
     SSL* ssl = pb->pal.ssl;
@@ -178,6 +231,7 @@ enum pubnub_res pbpal_handle_socket_condition(int result, pubnub_t* pb, char con
                 /* Expire the IP for the next connect */
                 pb->pal.ip_timeout = 0;
                 if ((pb->pal.session != NULL) && pb->options.reuse_SSL_session) {
+                    pbpal_forget_ssl_session(pb);
                     SSL_SESSION_free(pb->pal.session);
                     pb->pal.session = NULL;
                 }
@@ -195,6 +249,7 @@ enum pubnub_res pbpal_handle_socket_condition(int result, pubnub_t* pb, char con
             pb->pal.ip_timeout = 0;
             ERR_print_errors_cb(print_to_pubnub_log, pb);
             if ((pb->pal.session != NULL) && pb->options.reuse_SSL_session) {
+                pbpal_forget_ssl_session(pb);
                 SSL_SESSION_free(pb->pal.session);
                 pb->pal.session = NULL;
             }
@@ -370,11 +425,71 @@ int pbpal_start_read(pubnub_t* pb, size_t n)
 }
 
 
+#if PUBNUB_USE_ZERO_COPY_RECEIVE
+int pbpal_start_read_into(pubnub_t* pb, char* dst, size_t n)
+{
+    PUBNUB_ASSERT_UINT_OPT(n, >, 0);
+    PUBNUB_ASSERT_INT_OPT(pb->sock_state, ==, STATE_NONE);
+
+    pb->rx_dst     = (uint8_t*)dst;
+    pb->sock_state = STATE_READ_INTO;
+    pb->len        = n;
+
+    return +1;
+}
+
+
+static enum pubnub_res read_into_status(pubnub_t* pb)
+{
+    SSL* ssl = pb->pal.ssl;
+
+    if (pb->unreadlen > 0) {
+        /* Already received to our buffer, with the headers */
+        unsigned n = (pb->unreadlen >= pb->len) ? pb->len : pb->unreadlen;
+        memcpy(pb->rx_dst, pb->ptr, n);
+        pb->ptr += n;
+        pb->unreadlen -= n;
+        pb->rx_dst += n;
+        pb->len -= n;
+    }
+    /* As with other reads, OpenSSL gives us one TLS record at a
+       time, so we loop while there's data to read.
+    */
+    while (pb->len > 0) {
+        int have_read;
+        if (NULL == ssl) {
+            have_read = socket_recv(pb->pal.socket, (char*)pb->rx_dst, pb->len, 0);
+        }
+        else {
+            have_read = SSL_read(ssl, pb->rx_dst, pb->len);
+        }
+        if (have_read <= 0) {
+            return pbpal_handle_socket_condition(have_read, pb, __FILE__, __LINE__);
+        }
+        PUBNUB_ASSERT_OPT((unsigned)have_read <= pb->len);
+        pb->rx_dst += have_read;
+        pb->len -= have_read;
+        if ((NULL == ssl) && (pb->len > 0)) {
+            return PNR_IN_PROGRESS;
+        }
+    }
+    pb->sock_state = STATE_NONE;
+
+    return PNR_OK;
+}
+#endif /* PUBNUB_USE_ZERO_COPY_RECEIVE */
+
+
 enum pubnub_res pbpal_read_status(pubnub_t* pb)
 {
     int  have_read;
     SSL* ssl = pb->pal.ssl;
 
+#if PUBNUB_USE_ZERO_COPY_RECEIVE
+    if (STATE_READ_INTO == pb->sock_state) {
+        return read_into_status(pb);
+    }
+#endif
     PUBNUB_ASSERT_OPT(STATE_READ == pb->sock_state);
 
     /* OpenSSL reads one TLS record at a time,
@@ -436,6 +551,7 @@ int pbpal_close(pubnub_t* pb)
 {
     pb->unreadlen = 0;
     if (pb->pal.ssl != NULL) {
+        pbpal_update_ssl_session(pb);
         SSL_shutdown(pb->pal.ssl);
         SSL_free(pb->pal.ssl);
         pb->pal.ssl = NULL;
@@ -475,7 +591,8 @@ void pbpal_free(pubnub_t* pb)
     }
     /* The rest, OTOH, is expected */
     if (pb->pal.ctx != NULL) {
-        SSL_CTX_free(pb->pal.ctx);
+        pbpal_release_ssl_ctx(pb->pal.ctx);
+        pb->pal.ctx = NULL;
         if (NULL != pb->pal.session) {
             SSL_SESSION_free(pb->pal.session);
             pb->pal.session = NULL;
@@ -484,4 +601,9 @@ void pbpal_free(pubnub_t* pb)
     else {
         PUBNUB_ASSERT_OPT(NULL == pb->pal.session);
     }
+    if (pb->pal.txbuf != NULL) {
+        free(pb->pal.txbuf);
+        pb->pal.txbuf      = NULL;
+        pb->pal.txbuf_size = 0;
+    }
 }
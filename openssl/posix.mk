@@ -34,19 +34,57 @@ ifndef USE_ACTIONS_API
 USE_ACTIONS_API = 1
 endif
 
+ifndef USE_PUBLISH_QUEUE
+USE_PUBLISH_QUEUE = 1
+endif
+
+ifndef USE_REPLY_BUFFER_POOL
+USE_REPLY_BUFFER_POOL = 1
+endif
+
 ifeq ($(USE_PROXY), 1)
 SOURCEFILES += ../core/pubnub_proxy.c ../core/pubnub_proxy_core.c ../core/pbhttp_digest.c ../core/pbntlm_core.c ../core/pbntlm_packer_std.c
 OBJFILES += pubnub_proxy.o pubnub_proxy_core.o pbhttp_digest.o pbntlm_core.o pbntlm_packer_std.o
 endif
 
+##
+# The compression library for gzip (publishing and receiving). By
+# default, it's the bundled `miniz`. Set `GZIP_BACKEND=zlib` to use
+# zlib, or zlib-ng built in the zlib compatible mode, which is much
+# faster. Set `GZIP_BACKEND=libdeflate` to use libdeflate, which is
+# the fastest to deflate, but can't inflate piece by piece, as data
+# arrives, so miniz is used to inflate. See `core/pbgzip_backend.h`.
+ifndef GZIP_BACKEND
+GZIP_BACKEND = miniz
+endif
+
+ifeq ($(GZIP_BACKEND), zlib)
+GZIP_BACKEND_SOURCEFILES = ../core/pbgzip_backend_zlib.c
+GZIP_BACKEND_OBJFILES = pbgzip_backend_zlib.o
+GZIP_BACKEND_LDLIBS = -lz
+else ifeq ($(GZIP_BACKEND), libdeflate)
+GZIP_BACKEND_SOURCEFILES = ../core/pbgzip_backend_libdeflate.c ../lib/miniz/miniz_tinfl.c
+GZIP_BACKEND_OBJFILES = pbgzip_backend_libdeflate.o miniz_tinfl.o
+GZIP_BACKEND_LDLIBS = -ldeflate
+else
+GZIP_BACKEND_SOURCEFILES = ../core/pbgzip_backend_miniz.c ../lib/miniz/miniz_tdef.c ../lib/miniz/miniz_tinfl.c ../lib/miniz/miniz.c ../lib/pbcrc32.c
+GZIP_BACKEND_OBJFILES = pbgzip_backend_miniz.o miniz_tdef.o miniz_tinfl.o miniz.o pbcrc32.o
+GZIP_BACKEND_LDLIBS =
+endif
+
 ifeq ($(USE_GZIP_COMPRESSION), 1)
-SOURCEFILES += ../lib/miniz/miniz_tdef.c ../lib/miniz/miniz.c ../lib/pbcrc32.c ../core/pbgzip_compress.c
-OBJFILES += miniz_tdef.o miniz.o pbcrc32.o pbgzip_compress.o
+SOURCEFILES += ../core/pbgzip_compress.c
+OBJFILES += pbgzip_compress.o
 endif
 
 ifeq ($(RECEIVE_GZIP_RESPONSE), 1)
-SOURCEFILES += ../lib/miniz/miniz_tinfl.c ../core/pbgzip_decompress.c
-OBJFILES += miniz_tinfl.o pbgzip_decompress.o
+SOURCEFILES += ../core/pbgzip_decompress.c
+OBJFILES += pbgzip_decompress.o
+endif
+
+ifneq ($(USE_GZIP_COMPRESSION)$(RECEIVE_GZIP_RESPONSE), 00)
+SOURCEFILES += $(GZIP_BACKEND_SOURCEFILES)
+OBJFILES += $(GZIP_BACKEND_OBJFILES)
 endif
 
 ifeq ($(USE_SUBSCRIBE_V2), 1)
@@ -69,7 +107,17 @@ SOURCEFILES += ../core/pbcc_actions_api.c ../core/pubnub_actions_api.c
 OBJFILES += pbcc_actions_api.o pubnub_actions_api.o
 endif
 
-CFLAGS = -g -D PUBNUB_THREADSAFE -D PUBNUB_LOG_LEVEL=PUBNUB_LOG_LEVEL_WARNING -Wall -D PUBNUB_ONLY_PUBSUB_API=$(ONLY_PUBSUB_API) -D PUBNUB_PROXY_API=$(USE_PROXY) -D PUBNUB_USE_GZIP_COMPRESSION=$(USE_GZIP_COMPRESSION) -D PUBNUB_RECEIVE_GZIP_RESPONSE=$(RECEIVE_GZIP_RESPONSE) -D PUBNUB_USE_SUBSCRIBE_V2=$(USE_SUBSCRIBE_V2) -D PUBNUB_USE_OBJECTS_API=$(USE_OBJECTS_API) -D PUBNUB_USE_ACTIONS_API=$(USE_ACTIONS_API)
+ifeq ($(USE_PUBLISH_QUEUE), 1)
+SOURCEFILES += ../core/pubnub_publish_queue.c
+OBJFILES += pubnub_publish_queue.o
+endif
+
+ifeq ($(USE_REPLY_BUFFER_POOL), 1)
+SOURCEFILES += ../core/pubnub_reply_buffer_pool.c
+OBJFILES += pubnub_reply_buffer_pool.o
+endif
+
+CFLAGS = -g -D PUBNUB_THREADSAFE -D PUBNUB_LOG_LEVEL=PUBNUB_LOG_LEVEL_WARNING -Wall -D PUBNUB_ONLY_PUBSUB_API=$(ONLY_PUBSUB_API) -D PUBNUB_PROXY_API=$(USE_PROXY) -D PUBNUB_USE_GZIP_COMPRESSION=$(USE_GZIP_COMPRESSION) -D PUBNUB_RECEIVE_GZIP_RESPONSE=$(RECEIVE_GZIP_RESPONSE) -D PUBNUB_USE_SUBSCRIBE_V2=$(USE_SUBSCRIBE_V2) -D PUBNUB_USE_OBJECTS_API=$(USE_OBJECTS_API) -D PUBNUB_USE_ACTIONS_API=$(USE_ACTIONS_API) -D PUBNUB_USE_PUBLISH_QUEUE=$(USE_PUBLISH_QUEUE) -D PUBNUB_USE_REPLY_BUFFER_POOL=$(USE_REPLY_BUFFER_POOL)
 # -g enables debugging, remove to get a smaller executable
 # -fsanitize=address Use AddressSanitizer
 # -fsanitize=thread Use ThreadSanitizer
@@ -86,20 +134,39 @@ OBJFILES += monotonic_clock_get_time_posix.o
 LDLIBS=-lrt -lpthread -lssl -lcrypto
 endif
 
+LDLIBS += $(GZIP_BACKEND_LDLIBS)
+
 
 INCLUDES=-I .. -I .
 
-all: pubnub_sync_sample metadata cancel_subscribe_sync_sample pubnub_sync_subloop_sample pubnub_publish_via_post_sample pubnub_advanced_history_sample pubnub_callback_sample subscribe_publish_callback_sample pubnub_callback_subloop_sample pubnub_fntest pubnub_console_sync pubnub_console_callback pubnub_crypto_sync_sample subscribe_publish_from_callback publish_callback_subloop_sample publish_queue_callback_subloop
+all: pubnub_sync_sample metadata cancel_subscribe_sync_sample pubnub_sync_subloop_sample pubnub_publish_via_post_sample pubnub_advanced_history_sample pubnub_callback_sample subscribe_publish_callback_sample pubnub_callback_subloop_sample pubnub_fntest pubnub_console_sync pubnub_console_callback pubnub_crypto_sync_sample subscribe_publish_from_callback publish_callback_subloop_sample publish_queue_callback_subloop pubnub_callback_latency_benchmark pubnub_evloop_epoll_sample pubnub_subscribe_v2_decode_benchmark pubnub_crc32_benchmark pubnub_gzip_compress_benchmark pubnub_gzip_backend_benchmark_$(GZIP_BACKEND)
 
-SYNC_INTF_SOURCEFILES=../core/pubnub_ntf_sync.c ../core/pubnub_sync_subscribe_loop.c ../core/srand_from_pubnub_time.c
-SYNC_INTF_OBJFILES=pubnub_ntf_sync.o pubnub_sync_subscribe_loop.o srand_from_pubnub_time.o
+SYNC_INTF_SOURCEFILES=../core/pubnub_ntf_sync.c pubnub_get_native_socket.c ../core/pubnub_sync_subscribe_loop.c ../core/srand_from_pubnub_time.c
+SYNC_INTF_OBJFILES=pubnub_ntf_sync.o pubnub_get_native_socket.o pubnub_sync_subscribe_loop.o srand_from_pubnub_time.o
 
 pubnub_sync.a : $(SOURCEFILES) $(SYNC_INTF_SOURCEFILES)
 	$(CC) -c $(CFLAGS) $(INCLUDES) $(SOURCEFILES) $(SYNC_INTF_SOURCEFILES)
 	ar rcs pubnub_sync.a $(OBJFILES) $(SYNC_INTF_OBJFILES)
 
-CALLBACK_INTF_SOURCEFILES=pubnub_ntf_callback_posix.c pubnub_get_native_socket.c ../core/pubnub_timer_list.c ../lib/sockets/pbpal_ntf_callback_poller_poll.c ../lib/sockets/pbpal_adns_sockets.c ../lib/pubnub_dns_codec.c ../core/pbpal_ntf_callback_queue.c ../core/pbpal_ntf_callback_admin.c ../core/pbpal_ntf_callback_handle_timer_list.c  ../core/pubnub_callback_subscribe_loop.c
-CALLBACK_INTF_OBJFILES=pubnub_ntf_callback_posix.o pubnub_get_native_socket.o pubnub_timer_list.o pbpal_ntf_callback_poller_poll.o pbpal_adns_sockets.o pubnub_dns_codec.o pbpal_ntf_callback_queue.o pbpal_ntf_callback_admin.o pbpal_ntf_callback_handle_timer_list.o pubnub_callback_subscribe_loop.o
+##
+# The socket poller module to use for the callback interface. By
+# default, it's the portable `poll` poller. On Linux, you can set
+# `USE_EPOLL=1` to use the (edge-triggered) `epoll` poller, which is
+# O(1) per event, thus much better if you have a lot of contexts.
+ifndef USE_EPOLL
+USE_EPOLL = 0
+endif
+
+ifeq ($(USE_EPOLL), 1)
+SOCKET_POLLER_C=../lib/sockets/pbpal_ntf_callback_poller_epoll.c
+SOCKET_POLLER_OBJ=pbpal_ntf_callback_poller_epoll.o
+else
+SOCKET_POLLER_C=../lib/sockets/pbpal_ntf_callback_poller_poll.c
+SOCKET_POLLER_OBJ=pbpal_ntf_callback_poller_poll.o
+endif
+
+CALLBACK_INTF_SOURCEFILES=pubnub_ntf_callback_posix.c pubnub_get_native_socket.c ../core/pubnub_timer_list.c ../core/pubnub_timer_wheel.c $(SOCKET_POLLER_C) ../lib/sockets/pbpal_adns_sockets.c ../lib/pubnub_dns_codec.c ../core/pbpal_ntf_callback_queue.c ../core/pbpal_ntf_callback_admin.c ../core/pbpal_ntf_callback_handle_timer_list.c  ../core/pubnub_callback_subscribe_loop.c
+CALLBACK_INTF_OBJFILES=pubnub_ntf_callback_posix.o pubnub_get_native_socket.o pubnub_timer_list.o pubnub_timer_wheel.o $(SOCKET_POLLER_OBJ) pbpal_adns_sockets.o pubnub_dns_codec.o pbpal_ntf_callback_queue.o pbpal_ntf_callback_admin.o pbpal_ntf_callback_handle_timer_list.o pubnub_callback_subscribe_loop.o
 
 ifndef USE_DNS_SERVERS
 USE_DNS_SERVERS = 1
@@ -125,10 +192,36 @@ pubnub_callback.a : $(SOURCEFILES) $(CALLBACK_INTF_SOURCEFILES)
 	$(CC) -c $(CFLAGS) $(CFLAGS_CALLBACK) $(INCLUDES) -D PUBNUB_CALLBACK_API $(SOURCEFILES) $(CALLBACK_INTF_SOURCEFILES)
 	ar rcs pubnub_callback.a $(OBJFILES) $(CALLBACK_INTF_OBJFILES)
 
+##
+# The callback interface driven by the application's own event loop
+# (see `core/pubnub_ntf_evloop.h`), instead of our socket watcher
+# thread(s). It has no poller of its own.
+EVLOOP_INTF_SOURCEFILES=$(subst pubnub_ntf_callback_posix.c,pubnub_ntf_evloop_posix.c,$(filter-out $(SOCKET_POLLER_C),$(CALLBACK_INTF_SOURCEFILES)))
+EVLOOP_INTF_OBJFILES=$(subst pubnub_ntf_callback_posix.o,pubnub_ntf_evloop_posix.o,$(filter-out $(SOCKET_POLLER_OBJ),$(CALLBACK_INTF_OBJFILES)))
+
+pubnub_evloop.a : $(SOURCEFILES) $(EVLOOP_INTF_SOURCEFILES)
+	$(CC) -c $(CFLAGS) $(CFLAGS_CALLBACK) $(INCLUDES) -D PUBNUB_CALLBACK_API $(SOURCEFILES) $(EVLOOP_INTF_SOURCEFILES)
+	ar rcs pubnub_evloop.a $(OBJFILES) $(EVLOOP_INTF_OBJFILES)
+
 
 pubnub_sync_sample: ../core/samples/pubnub_sync_sample.c pubnub_sync.a
 	$(CC) -o $@ $(CFLAGS) $(INCLUDES) ../core/samples/pubnub_sync_sample.c pubnub_sync.a $(LDLIBS)
 
+pubnub_subscribe_v2_decode_benchmark: ../core/samples/pubnub_subscribe_v2_decode_benchmark.c pubnub_sync.a
+	$(CC) -o $@ $(CFLAGS) $(INCLUDES) ../core/samples/pubnub_subscribe_v2_decode_benchmark.c pubnub_sync.a $(LDLIBS)
+
+pubnub_crc32_benchmark: ../core/samples/pubnub_crc32_benchmark.c ../lib/pbcrc32.c pubnub_sync.a
+	$(CC) -o $@ $(CFLAGS) $(INCLUDES) ../core/samples/pubnub_crc32_benchmark.c ../lib/pbcrc32.c pubnub_sync.a $(LDLIBS)
+
+# Compares with miniz used directly, whatever the gzip backend
+MINIZ_SOURCEFILES = ../lib/miniz/miniz_tdef.c ../lib/miniz/miniz_tinfl.c ../lib/miniz/miniz.c
+
+pubnub_gzip_compress_benchmark: ../core/samples/pubnub_gzip_compress_benchmark.c pubnub_sync.a
+	$(CC) -o $@ $(CFLAGS) $(INCLUDES) ../core/samples/pubnub_gzip_compress_benchmark.c $(MINIZ_SOURCEFILES) pubnub_sync.a $(LDLIBS)
+
+pubnub_gzip_backend_benchmark_$(GZIP_BACKEND): ../core/samples/pubnub_gzip_backend_benchmark.c $(GZIP_BACKEND_SOURCEFILES)
+	$(CC) -o $@ $(CFLAGS) $(INCLUDES) ../core/samples/pubnub_gzip_backend_benchmark.c $(GZIP_BACKEND_SOURCEFILES) ../core/pubnub_assert_std.c $(LDLIBS)
+
 metadata: ../core/samples/metadata.c pubnub_sync.a
 	$(CC) -o $@ $(CFLAGS) $(INCLUDES) ../core/samples/metadata.c pubnub_sync.a $(LDLIBS)
 
@@ -165,6 +258,12 @@ publish_callback_subloop_sample: ../core/samples/publish_callback_subloop_sample
 publish_queue_callback_subloop: ../core/samples/publish_queue_callback_subloop.c pubnub_callback.a
 	$(CC) -o $@ -D PUBNUB_CALLBACK_API $(CFLAGS) $(CFLAGS_CALLBACK) $(INCLUDES) ../core/samples/publish_queue_callback_subloop.c pubnub_callback.a $(LDLIBS)
 
+pubnub_callback_latency_benchmark: ../core/samples/pubnub_callback_latency_benchmark.c pubnub_callback.a
+	$(CC) -o $@ -D PUBNUB_CALLBACK_API $(CFLAGS) $(CFLAGS_CALLBACK) $(INCLUDES) ../core/samples/pubnub_callback_latency_benchmark.c pubnub_callback.a $(LDLIBS)
+
+pubnub_evloop_epoll_sample: ../core/samples/pubnub_evloop_epoll_sample.c pubnub_evloop.a
+	$(CC) -o $@ -D PUBNUB_CALLBACK_API $(CFLAGS) $(CFLAGS_CALLBACK) $(INCLUDES) ../core/samples/pubnub_evloop_epoll_sample.c pubnub_evloop.a $(LDLIBS)
+
 pubnub_fntest: ../core/fntest/pubnub_fntest.c ../core/fntest/pubnub_fntest_basic.c ../core/fntest/pubnub_fntest_medium.c ../posix/fntest/pubnub_fntest_posix.c ../posix/fntest/pubnub_fntest_runner.c pubnub_sync.a
 	$(CC) -o $@ $(CFLAGS) $(INCLUDES) ../core/fntest/pubnub_fntest.c ../core/fntest/pubnub_fntest_basic.c ../core/fntest/pubnub_fntest_medium.c  ../posix/fntest/pubnub_fntest_posix.c ../posix/fntest/pubnub_fntest_runner.c pubnub_sync.a $(LDLIBS) -lpthread
 
@@ -178,4 +277,4 @@ pubnub_console_callback: $(CONSOLE_SOURCEFILES) ../core/samples/console/pnc_ops_
 
 
 clean:
-	rm pubnub_sync_sample metadata pubnub_sync_subloop_sample cancel_subscribe_sync_sample pubnub_publish_via_post_sample pubnub_callback_sample subscribe_publish_callback_sample pubnub_fntest pubnub_console_sync pubnub_console_callback pubnub_crypto_sync_sample pubnub_sync.a pubnub_callback.a pubnub_callback_subloop_sample subscribe_publish_from_callback publish_callback_subloop_sample publish_queue_callback_subloop *.o *.dSYM
+	rm pubnub_sync_sample metadata pubnub_sync_subloop_sample cancel_subscribe_sync_sample pubnub_publish_via_post_sample pubnub_callback_sample subscribe_publish_callback_sample pubnub_fntest pubnub_console_sync pubnub_console_callback pubnub_crypto_sync_sample pubnub_sync.a pubnub_callback.a pubnub_callback_subloop_sample subscribe_publish_from_callback publish_callback_subloop_sample publish_queue_callback_subloop pubnub_callback_latency_benchmark pubnub_evloop_epoll_sample pubnub_evloop.a pubnub_subscribe_v2_decode_benchmark pubnub_crc32_benchmark pubnub_gzip_compress_benchmark pubnub_gzip_backend_benchmark_* *.o *.dSYM
@@ -76,6 +76,9 @@ typedef int pb_socket_t;
 #define socket_disable_SIGPIPE(socket)
 #endif
 
+/** On POSIX, the sync interface pubnub_await() can poll() the socket */
+#define PUBNUB_SYNC_AWAIT_ON_SOCKET 1
+
 #else
 typedef SOCKET pb_socket_t;
 
@@ -116,6 +119,10 @@ struct pubnub_pal {
     int          ip_family;
     time_t       ip_timeout;
     pbmsref_t    tryconn;
+    /** Buffer to coalesce the data into for pbpal_sendv(), so that
+        it's sent in one TLS record. Grows as needed. */
+    char*        txbuf;
+    size_t       txbuf_size;
 };
 
 #ifdef _WIN32
@@ -157,4 +164,37 @@ int snprintf(char* buffer, size_t n, const char* format, ...);
 #include "core/pubnub_internal_common.h"
 
 
+/** Initializes the OpenSSL library (once). Unlike the "full" PAL
+    initialization, this can be called before any context is
+    initialized.
+    @return 0: OK, -1: error
+ */
+int pbpal_openssl_lib_init(void);
+
+/** Gets a (reference to a) shared SSL_CTX for the certificate
+    settings of the context @p pb from the process-wide cache,
+    creating it if it's not in the cache.
+    @return The SSL_CTX, NULL on error
+ */
+SSL_CTX* pbpal_acquire_ssl_ctx(pubnub_t* pb);
+
+/** Releases a reference to the shared SSL_CTX @p ctx, previously
+    acquired with pbpal_acquire_ssl_ctx(). The SSL_CTX is freed when
+    the last reference is released (unless it was pre-warmed).
+ */
+void pbpal_release_ssl_ctx(SSL_CTX* ctx);
+
+/** Updates the TLS session of the context @p pb (and the process-wide
+    session cache) to the latest one we got from the server on the
+    current connection. Call before closing the connection.
+ */
+void pbpal_update_ssl_session(pubnub_t* pb);
+
+/** Removes the TLS session of the context @p pb from the
+    process-wide session cache (if it's there), because it failed
+    (so we don't want others to try to resume it).
+ */
+void pbpal_forget_ssl_session(pubnub_t* pb);
+
+
 #endif /* !defined INC_PUBNUB_INTERNAL */
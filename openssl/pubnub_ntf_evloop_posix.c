@@ -0,0 +1 @@
+../posix/pubnub_ntf_evloop_posix.c
\ No newline at end of file
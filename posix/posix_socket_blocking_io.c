@@ -2,8 +2,12 @@
 #include "pubnub_get_native_socket.h"
 #include "core/pubnub_log.h"
 #include "pubnub_internal.h"
+#include "lib/sockets/pbpal_socket_blocking_io.h"
 
 #include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdlib.h>
 
 int pbpal_set_socket_blocking_io(pbpal_native_socket_t socket, int use_blocking_io)
 {
@@ -20,3 +24,77 @@ int pbpal_set_socket_blocking_io(pbpal_native_socket_t socket, int use_blocking_
 
     return 0;
 }
+
+
+/** Up to this many sockets, we don't allocate memory for poll() */
+#define WAIT_SOCKETS_ON_STACK 16
+
+
+void pbpal_free_socket_wait_mem(struct pbpal_socket_wait_mem* mem)
+{
+    free(mem->buf);
+    mem->buf = NULL;
+    mem->n   = 0;
+}
+
+
+int pbpal_wait_sockets_io(struct pbpal_socket_wait*     waits,
+                          size_t                        n,
+                          struct pbpal_socket_wait_mem* mem,
+                          int                           timeout_ms)
+{
+    struct pollfd  on_stack[WAIT_SOCKETS_ON_STACK];
+    struct pollfd* pfd = on_stack;
+    size_t         i;
+    int            rslt;
+
+    if ((mem != NULL) && (mem->n >= n)) {
+        pfd = (struct pollfd*)mem->buf;
+    }
+    else if (n > WAIT_SOCKETS_ON_STACK) {
+        pfd = (struct pollfd*)malloc(n * sizeof pfd[0]);
+        if (NULL == pfd) {
+            PUBNUB_LOG_ERROR("pbpal_wait_sockets_io(): failed to allocate "
+                             "for %lu sockets\n",
+                             (unsigned long)n);
+            return -1;
+        }
+        if (mem != NULL) {
+            free(mem->buf);
+            mem->buf = pfd;
+            mem->n   = n;
+        }
+    }
+    for (i = 0; i < n; ++i) {
+        /* poll() ignores negative descriptors */
+        pfd[i].fd      = (SOCKET_INVALID == waits[i].socket) ? -1 : (int)waits[i].socket;
+        pfd[i].events  = waits[i].out ? POLLOUT : POLLIN;
+        pfd[i].revents = 0;
+    }
+    do {
+        rslt = poll(pfd, (nfds_t)n, timeout_ms);
+    } while ((-1 == rslt) && (EINTR == errno));
+    if (-1 == rslt) {
+        PUBNUB_LOG_WARNING("pbpal_wait_sockets_io(): poll() failed, errno=%d\n", errno);
+    }
+    for (i = 0; i < n; ++i) {
+        waits[i].ready = (rslt > 0) && (pfd[i].revents != 0);
+    }
+    if ((pfd != on_stack) && ((NULL == mem) || (pfd != mem->buf))) {
+        free(pfd);
+    }
+
+    return rslt;
+}
+
+
+int pbpal_wait_socket_io(pbpal_native_socket_t socket, int out, int timeout_ms)
+{
+    struct pbpal_socket_wait wait;
+
+    wait.socket = socket;
+    wait.out    = out;
+    wait.ready  = 0;
+
+    return pbpal_wait_sockets_io(&wait, 1, NULL, timeout_ms);
+}
@@ -104,6 +104,14 @@
     */
 #define PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB 0
 
+#if !defined(PUBNUB_CALLBACK_THREADS_MAX)
+/** The maximum number of "polling" (socket watcher) threads, when
+    using the callback interface. The actual number of threads is set
+    at runtime with pubnub_set_callback_threads() and is 1 by default.
+    */
+#define PUBNUB_CALLBACK_THREADS_MAX 16
+#endif
+
 #if !defined(PUBNUB_USE_IPV6)
 /** If true (!=0), enable support for Ipv6 network addresses */
 #define PUBNUB_USE_IPV6 1
@@ -202,5 +210,62 @@
 #define PUBNUB_USE_ACTIONS_API 1
 #endif
 
+#if !defined(PUBNUB_USE_VECTORED_SEND)
+/** If true (!=0), the whole HTTP request (request line, headers and
+    body) will be sent with one (vectored) send (one TLS record on
+    SSL/TLS connections), rather than piece by piece, which saves a
+    lot of system calls. This is not used when connecting via a
+    proxy. */
+#define PUBNUB_USE_VECTORED_SEND 1
+#endif
+
+#if !defined(PUBNUB_USE_ZERO_COPY_RECEIVE)
+/** If true (!=0), the body of the HTTP response will be received
+    right to the reply buffer, once its length (or the length of the
+    chunk) is known, rather than through the receive buffer, which
+    saves copying all of it. */
+#define PUBNUB_USE_ZERO_COPY_RECEIVE 1
+#endif
+
+#if !defined(PUBNUB_USE_REPLY_BUFFER_POOL)
+/** If true (!=0), the (dynamic) reply buffers of contexts are taken
+    from a process-wide pool of size-class blocks, and each context
+    keeps its biggest buffer between transactions, rather than
+    reallocating it on every response. */
+#define PUBNUB_USE_REPLY_BUFFER_POOL PUBNUB_DYNAMIC_REPLY_BUFFER
+#endif
+
+#if !defined(PUBNUB_USE_JSON_TAPE)
+/** If true (!=0), the reply is indexed in one pass, to a JSON tape,
+    when first looked into, and all the lookups of values in it (by
+    the response parsers and the functions that get data from the
+    response) go through the tape, rather than scanning the reply
+    again. Needs some memory for the tape, kept in the context.
+ */
+#define PUBNUB_USE_JSON_TAPE 1
+#endif
+
+#if !defined(PUBNUB_USE_URL_ENCODE_CACHE)
+/** If true (!=0), the url-encoding of the last channel (list) is kept
+    in the context, and used if the next transaction has the same
+    channel (list) - which is usual for subscribe.
+ */
+#define PUBNUB_USE_URL_ENCODE_CACHE 1
+#endif
+
+#if !defined(PUBNUB_USE_PUBLISH_QUEUE)
+/** If true (!=0) will enable using the publish queue API, for high
+    rate publishing, with several publish requests pipelined on the
+    same (kept alive) connection. */
+#define PUBNUB_USE_PUBLISH_QUEUE 1
+#endif
+
+#if !defined(PUBNUB_USE_PUBLISH_BATCH)
+/** If true (!=0) will enable using the batch publish API, to publish
+    an array of messages in one transaction, pipelining the (POST)
+    requests. Needs the publish queue (it shares its machinery). */
+#define PUBNUB_USE_PUBLISH_BATCH PUBNUB_USE_PUBLISH_QUEUE
+#endif
+
 
 #endif /* !defined INC_PUBNUB_CONFIG */
@@ -80,6 +80,9 @@ struct pubnub_pal {
 /** On POSIX, one can set I/O to be blocking or non-blocking */
 #define PUBNUB_BLOCKING_IO_SETTABLE 1
 
+/** On POSIX, the sync interface pubnub_await() can poll() the socket */
+#define PUBNUB_SYNC_AWAIT_ON_SOCKET 1
+
 
 #define PUBNUB_TIMERS_API 1
 
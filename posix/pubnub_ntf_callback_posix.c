@@ -6,17 +6,20 @@
 #include "pubnub_internal.h"
 #include "core/pubnub_assert.h"
 #include "core/pubnub_log.h"
-#include "core/pubnub_timer_list.h"
+#include "core/pubnub_timer_wheel.h"
+#include "core/pubnub_atomic.h"
 #include "core/pbpal.h"
 
-#include "lib/sockets/pbpal_ntf_callback_poller_poll.h"
+#include "core/pbpal_ntf_callback_poller.h"
 #include "core/pbpal_ntf_callback_queue.h"
-#include "core/pbpal_ntf_callback_handle_timer_list.h"
 
 #include <pthread.h>
+#include <sched.h>
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
 
 
 struct SocketWatcherData {
@@ -26,78 +29,203 @@ struct SocketWatcherData {
     pthread_mutex_t timerlock;
     pthread_mutex_t stoplock;
     pthread_t       thread_id;
+    /** Can the poller be woken up (from other threads)? If not, we
+        have to poll with a short timeout. */
+    bool wakeable;
+    /** Was the poller woken up since the last time we looked at the
+        queue? Used to not wake it up more than needed. */
+    pubnub_atomic_t wake_pending;
+    /** Number of threads waiting for (or holding) the lock of the
+        poller, which we hold while polling. */
+    pubnub_atomic_t poller_waiters;
 #if PUBNUB_TIMERS_API
-    pubnub_t* timer_head pubnub_guarded_by(timerlock);
+    struct pubnub_timer_wheel timers pubnub_guarded_by(timerlock);
 #endif
     struct pbpal_ntf_callback_queue queue;
 };
 
 
-static struct SocketWatcherData m_watcher;
+/** The socket watchers - each has its own thread, poller, timer list
+    and processing queue. A context is always handled by the same
+    watcher, which is selected by watcher_of().
+ */
+static struct SocketWatcherData m_watcher[PUBNUB_CALLBACK_THREADS_MAX];
 
+/** Guards the (re)configuration of the socket watchers */
+static pthread_mutex_t m_config_lock = PTHREAD_MUTEX_INITIALIZER;
 
-static int elapsed_ms(struct timespec prev_timspec, struct timespec timspec)
+/** The number of socket watchers (threads) in use. Doesn't change
+    after the watchers are started, so it's OK to read it w/out
+    locking from then on.
+ */
+static unsigned m_watcher_count = 1;
+
+/** Did we already start the socket watchers? If so, one can't
+    change the number of them any more.
+ */
+static bool m_watchers_started;
+
+
+/** Returns the socket watcher that handles the context @p pb.  It's
+    a hash of the context pointer, so, it doesn't change during the
+    lifetime of the context and no book-keeping is needed.
+ */
+static struct SocketWatcherData* watcher_of(pubnub_t const* pb)
+{
+    uint32_t h;
+
+    if (1 == m_watcher_count) {
+        return m_watcher;
+    }
+    h = (uint32_t)((uintptr_t)pb >> 4) * UINT32_C(2654435761);
+    return m_watcher + (h >> 16) % m_watcher_count;
+}
+
+
+static bool on_watcher_thread(struct SocketWatcherData const* watcher)
+{
+    return pthread_equal(pthread_self(), watcher->thread_id);
+}
+
+
+/** Wakes up the @p watcher, if it's not the one calling, so that it
+    sees the work given to it right away, rather than when the poll
+    times out.
+ */
+static void wake_watcher(struct SocketWatcherData* watcher)
+{
+    if (watcher->wakeable && !on_watcher_thread(watcher)
+        && (0 == pubnub_atomic_exchange(&watcher->wake_pending, 1))) {
+        pbpal_ntf_callback_poller_wake(watcher->poll);
+    }
+}
+
+
+/** Locks the poller of the @p watcher. As the watcher holds that
+    lock while polling, wakes it up, and makes sure it doesn't poll
+    again until we're done.
+ */
+static void lock_poller(struct SocketWatcherData* watcher)
+{
+    pubnub_atomic_add(&watcher->poller_waiters, 1);
+    wake_watcher(watcher);
+    pthread_mutex_lock(&watcher->mutw);
+}
+
+
+static void unlock_poller(struct SocketWatcherData* watcher)
 {
-    int s_diff   = timspec.tv_sec - prev_timspec.tv_sec;
-    int m_s_diff = (timspec.tv_nsec - prev_timspec.tv_nsec) / MILLI_IN_NANO;
-    return (s_diff * UNIT_IN_MILLI) + m_s_diff;
+    pthread_mutex_unlock(&watcher->mutw);
+    pubnub_atomic_add(&watcher->poller_waiters, -1);
+}
+
+
+/** Returns the monotonic time, in milliseconds */
+static uint64_t monotonic_ms(void)
+{
+    struct timespec timspec;
+    monotonic_clock_get_time(&timspec);
+    return (uint64_t)timspec.tv_sec * UNIT_IN_MILLI
+           + timspec.tv_nsec / MILLI_IN_NANO;
+}
+
+
+/** Returns how long to poll, so that we don't miss the nearest timer
+    deadline. If the poller can't be woken up, that's no longer than
+    @p max_poll_ms, otherwise, if there are no timers, it's -1 (no
+    timeout).
+ */
+static int poll_timeout_ms(struct SocketWatcherData* watcher, int max_poll_ms)
+{
+    int64_t next = -1;
+
+    if (PUBNUB_TIMERS_API) {
+        pthread_mutex_lock(&watcher->timerlock);
+        next = pubnub_timer_wheel_next_ms(&watcher->timers, monotonic_ms());
+        pthread_mutex_unlock(&watcher->timerlock);
+    }
+    if (!watcher->wakeable && ((next < 0) || (next > max_poll_ms))) {
+        return max_poll_ms;
+    }
+    return (next > INT_MAX) ? INT_MAX : (int)next;
+}
+
+
+/** Stops (with a timeout) the transactions of all the contexts whose
+    timers have expired by now.
+ */
+static void handle_expired_timers(struct SocketWatcherData* watcher)
+{
+    pubnub_t* expired;
+
+    pthread_mutex_lock(&watcher->timerlock);
+    expired = pubnub_timer_wheel_advance(&watcher->timers, monotonic_ms());
+    while (expired != NULL) {
+        pubnub_t* next;
+
+        pubnub_mutex_lock(expired->monitor);
+        next          = expired->next;
+        expired->next = NULL;
+        pbnc_stop(expired, PNR_TIMEOUT);
+        pubnub_mutex_unlock(expired->monitor);
+
+        expired = next;
+    }
+    pthread_mutex_unlock(&watcher->timerlock);
 }
 
 
 int pbntf_watch_in_events(pubnub_t* pbp)
 {
-    return pbpal_ntf_watch_in_events(m_watcher.poll, pbp);
+    struct SocketWatcherData* watcher = watcher_of(pbp);
+    int rslt = pbpal_ntf_watch_in_events(watcher->poll, pbp);
+    wake_watcher(watcher);
+    return rslt;
 }
 
 
 int pbntf_watch_out_events(pubnub_t* pbp)
 {
-    return pbpal_ntf_watch_out_events(m_watcher.poll, pbp);
+    struct SocketWatcherData* watcher = watcher_of(pbp);
+    int rslt = pbpal_ntf_watch_out_events(watcher->poll, pbp);
+    wake_watcher(watcher);
+    return rslt;
 }
 
 
 void* socket_watcher_thread(void* arg)
 {
-    const int max_poll_ms = 100;
-    struct timespec prev_timspec;
-    monotonic_clock_get_time(&prev_timspec);
+    struct SocketWatcherData* watcher     = (struct SocketWatcherData*)arg;
+    const int                 max_poll_ms = 100;
 
     for (;;) {
-        struct timespec timspec;
         bool stop_thread;
+        int  timeout_ms;
         
-        pthread_mutex_lock(&m_watcher.stoplock);
-        stop_thread = m_watcher.stop_socket_watcher_thread;
-        pthread_mutex_unlock(&m_watcher.stoplock);
+        pthread_mutex_lock(&watcher->stoplock);
+        stop_thread = watcher->stop_socket_watcher_thread;
+        pthread_mutex_unlock(&watcher->stoplock);
         if (stop_thread) {
             break;
         }
         
-        pbpal_ntf_callback_process_queue(&m_watcher.queue);
-
-        monotonic_clock_get_time(&timspec);
-
-        pthread_mutex_lock(&m_watcher.mutw);
-        pbpal_ntf_poll_away(m_watcher.poll, max_poll_ms);
-        pthread_mutex_unlock(&m_watcher.mutw);
+        /* Whoever gives us work after this will wake us up again */
+        pubnub_atomic_store(&watcher->wake_pending, 0);
+        pbpal_ntf_callback_process_queue(&watcher->queue);
+
+        timeout_ms = poll_timeout_ms(watcher, max_poll_ms);
+        if (pubnub_atomic_load(&watcher->poller_waiters) > 0) {
+            /* Let them have the poller first */
+            sched_yield();
+        }
+        else {
+            pthread_mutex_lock(&watcher->mutw);
+            pbpal_ntf_poll_away(watcher->poll, timeout_ms);
+            pthread_mutex_unlock(&watcher->mutw);
+        }
 
         if (PUBNUB_TIMERS_API) {
-            int elapsed = elapsed_ms(prev_timspec, timspec);
-            if (elapsed > 0) {
-                if (elapsed > max_poll_ms + 5) {
-                    PUBNUB_LOG_TRACE("elapsed = %d: prev_timspec={%ld, %ld}, timspec={%ld,%ld}\n",
-                                     elapsed,
-                                     prev_timspec.tv_sec, prev_timspec.tv_nsec,
-                                     timspec.tv_sec, timspec.tv_nsec
-                                     
-                        );
-                }
-                pthread_mutex_lock(&m_watcher.timerlock);
-                pbntf_handle_timer_list(elapsed, &m_watcher.timer_head);
-                pthread_mutex_unlock(&m_watcher.timerlock);
-
-                prev_timspec = timspec;
-            }
+            handle_expired_timers(watcher);
         }
     }
 
@@ -107,13 +235,43 @@ void* socket_watcher_thread(void* arg)
 
 void pubnub_stop(void)
 {
-    pthread_mutex_lock(&m_watcher.stoplock);
-    m_watcher.stop_socket_watcher_thread = true;
-    pthread_mutex_unlock(&m_watcher.stoplock);
+    unsigned i;
+    for (i = 0; i < m_watcher_count; ++i) {
+        pthread_mutex_lock(&m_watcher[i].stoplock);
+        m_watcher[i].stop_socket_watcher_thread = true;
+        pthread_mutex_unlock(&m_watcher[i].stoplock);
+        wake_watcher(&m_watcher[i]);
+    }
 }
-    
 
-int pbntf_init(void)
+
+int pubnub_set_callback_threads(unsigned n)
+{
+    int rslt = -1;
+
+    if ((0 == n) || (n > PUBNUB_CALLBACK_THREADS_MAX)) {
+        PUBNUB_LOG_ERROR("pubnub_set_callback_threads(%u): must be in [1, %d]\n",
+                         n,
+                         PUBNUB_CALLBACK_THREADS_MAX);
+        return -1;
+    }
+    pthread_mutex_lock(&m_config_lock);
+    if (!m_watchers_started) {
+        m_watcher_count = n;
+        rslt            = 0;
+    }
+    else {
+        PUBNUB_LOG_ERROR("pubnub_set_callback_threads(%u): socket watcher "
+                         "threads already started\n",
+                         n);
+    }
+    pthread_mutex_unlock(&m_config_lock);
+
+    return rslt;
+}
+
+
+static int watcher_init(struct SocketWatcherData* watcher)
 {
     int                 rslt;
     pthread_mutexattr_t attr;
@@ -131,102 +289,128 @@ int pbntf_init(void)
         pthread_mutexattr_destroy(&attr);
         return -1;
     }
-    rslt = pthread_mutex_init(&m_watcher.stoplock, &attr);
+    rslt = pthread_mutex_init(&watcher->stoplock, &attr);
     if (rslt != 0) {
         PUBNUB_LOG_ERROR("Failed to initialize 'stoplock' mutex, error code: %d", rslt);
         pthread_mutexattr_destroy(&attr);
         return -1;
     }
-    rslt = pthread_mutex_init(&m_watcher.mutw, &attr);
+    rslt = pthread_mutex_init(&watcher->mutw, &attr);
     if (rslt != 0) {
         PUBNUB_LOG_ERROR("Failed to initialize mutex, error code: %d", rslt);
         pthread_mutexattr_destroy(&attr);
-        pthread_mutex_destroy(&m_watcher.stoplock);
+        pthread_mutex_destroy(&watcher->stoplock);
         return -1;
     }
-    rslt = pthread_mutex_init(&m_watcher.timerlock, &attr);
+    rslt = pthread_mutex_init(&watcher->timerlock, &attr);
     if (rslt != 0) {
         PUBNUB_LOG_ERROR("Failed to initialize mutex for timers, error code: %d", rslt);
         pthread_mutexattr_destroy(&attr);
-        pthread_mutex_destroy(&m_watcher.mutw);
-        pthread_mutex_destroy(&m_watcher.stoplock);
+        pthread_mutex_destroy(&watcher->mutw);
+        pthread_mutex_destroy(&watcher->stoplock);
         return -1;
     }
+    pthread_mutexattr_destroy(&attr);
 
-    m_watcher.poll = pbpal_ntf_callback_poller_init();
-    if (NULL == m_watcher.poll) {
-        pthread_mutexattr_destroy(&attr);
-        pthread_mutex_destroy(&m_watcher.mutw);
-        pthread_mutex_destroy(&m_watcher.timerlock);
-        pthread_mutex_destroy(&m_watcher.stoplock);
+    watcher->poll = pbpal_ntf_callback_poller_init();
+    if (NULL == watcher->poll) {
+        pthread_mutex_destroy(&watcher->mutw);
+        pthread_mutex_destroy(&watcher->timerlock);
+        pthread_mutex_destroy(&watcher->stoplock);
         return -1;
     }
-    pbpal_ntf_callback_queue_init(&m_watcher.queue);
-    m_watcher.stop_socket_watcher_thread = false;
+    pbpal_ntf_callback_queue_init(&watcher->queue);
+    watcher->stop_socket_watcher_thread = false;
+    /* A poller that can't be woken up will tell us so */
+    watcher->wakeable = (0 == pbpal_ntf_callback_poller_wake(watcher->poll));
+    pubnub_atomic_store(&watcher->wake_pending, 1);
+    pubnub_atomic_store(&watcher->poller_waiters, 0);
+#if PUBNUB_TIMERS_API
+    pubnub_timer_wheel_init(&watcher->timers, monotonic_ms());
+#endif
+
+    return 0;
+}
+
+
+static void watcher_deinit(struct SocketWatcherData* watcher)
+{
+    pthread_mutex_destroy(&watcher->mutw);
+    pthread_mutex_destroy(&watcher->timerlock);
+    pthread_mutex_destroy(&watcher->stoplock);
+    pbpal_ntf_callback_queue_deinit(&watcher->queue);
+    pbpal_ntf_callback_poller_deinit(&watcher->poll);
+}
+
+
+static int watcher_start(struct SocketWatcherData* watcher)
+{
+    int rslt;
 
 #if defined(PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB)                              \
     && (PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB > 0)
-    {
-        pthread_attr_t thread_attr;
-
-        rslt = pthread_attr_init(&thread_attr);
-        if (rslt != 0) {
-            PUBNUB_LOG_ERROR(
-                "Failed to initialize thread attributes, error code: %d\n", rslt);
-            pthread_mutexattr_destroy(&attr);
-            pthread_mutex_destroy(&m_watcher.mutw);
-            pthread_mutex_destroy(&m_watcher.timerlock);
-            pthread_mutex_destroy(&m_watcher.stoplock);
-            pbpal_ntf_callback_queue_deinit(&m_watcher.queue);
-            pbpal_ntf_callback_poller_deinit(&m_watcher.poll);
-            return -1;
-        }
-        rslt = pthread_attr_setstacksize(
-            &thread_attr, PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB * 1024);
-        if (rslt != 0) {
-            PUBNUB_LOG_ERROR(
-                "Failed to set thread stack size to %d kb, error code: %d\n",
-                PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB,
-                rslt);
-            pthread_mutexattr_destroy(&attr);
-            pthread_mutex_destroy(&m_watcher.mutw);
-            pthread_mutex_destroy(&m_watcher.timerlock);
-            pthread_mutex_destroy(&m_watcher.stoplock);
-            pthread_attr_destroy(&thread_attr);
-            pbpal_ntf_callback_queue_deinit(&m_watcher.queue);
-            pbpal_ntf_callback_poller_deinit(&m_watcher.poll);
-            return -1;
-        }
-        rslt = pthread_create(
-            &m_watcher.thread_id, &thread_attr, socket_watcher_thread, NULL);
-        if (rslt != 0) {
-            PUBNUB_LOG_ERROR(
-                "Failed to create the polling thread, error code: %d\n", rslt);
-            pthread_mutexattr_destroy(&attr);
-            pthread_mutex_destroy(&m_watcher.mutw);
-            pthread_mutex_destroy(&m_watcher.timerlock);
-            pthread_mutex_destroy(&m_watcher.stoplock);
-            pthread_attr_destroy(&thread_attr);
-            pbpal_ntf_callback_queue_deinit(&m_watcher.queue);
-            pbpal_ntf_callback_poller_deinit(&m_watcher.poll);
-            return -1;
-        }
+    pthread_attr_t thread_attr;
+
+    rslt = pthread_attr_init(&thread_attr);
+    if (rslt != 0) {
+        PUBNUB_LOG_ERROR(
+            "Failed to initialize thread attributes, error code: %d\n", rslt);
+        return -1;
     }
+    rslt = pthread_attr_setstacksize(
+        &thread_attr, PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB * 1024);
+    if (rslt != 0) {
+        PUBNUB_LOG_ERROR(
+            "Failed to set thread stack size to %d kb, error code: %d\n",
+            PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB,
+            rslt);
+        pthread_attr_destroy(&thread_attr);
+        return -1;
+    }
+    rslt = pthread_create(
+        &watcher->thread_id, &thread_attr, socket_watcher_thread, watcher);
+    pthread_attr_destroy(&thread_attr);
 #else
-    rslt =
-        pthread_create(&m_watcher.thread_id, NULL, socket_watcher_thread, NULL);
+    rslt = pthread_create(
+        &watcher->thread_id, NULL, socket_watcher_thread, watcher);
+#endif
     if (rslt != 0) {
         PUBNUB_LOG_ERROR(
             "Failed to create the polling thread, error code: %d\n", rslt);
-        pthread_mutexattr_destroy(&attr);
-        pthread_mutex_destroy(&m_watcher.mutw);
-        pthread_mutex_destroy(&m_watcher.timerlock);
-        pthread_mutex_destroy(&m_watcher.stoplock);
-        pbpal_ntf_callback_queue_deinit(&m_watcher.queue);
-        pbpal_ntf_callback_poller_deinit(&m_watcher.poll);
         return -1;
     }
-#endif
+
+    return 0;
+}
+
+
+int pbntf_init(void)
+{
+    unsigned i;
+
+    pthread_mutex_lock(&m_config_lock);
+    for (i = 0; i < m_watcher_count; ++i) {
+        if (0 != watcher_init(&m_watcher[i])) {
+            break;
+        }
+        if (0 != watcher_start(&m_watcher[i])) {
+            watcher_deinit(&m_watcher[i]);
+            break;
+        }
+    }
+    if (i < m_watcher_count) {
+        PUBNUB_LOG_ERROR("Failed to start socket watcher %u of %u\n",
+                         i,
+                         m_watcher_count);
+        if (0 == i) {
+            pthread_mutex_unlock(&m_config_lock);
+            return -1;
+        }
+        /* Run with the watchers we managed to start */
+        m_watcher_count = i;
+    }
+    m_watchers_started = true;
+    pthread_mutex_unlock(&m_config_lock);
 
     return 0;
 }
@@ -234,28 +418,36 @@ int pbntf_init(void)
 
 int pbntf_enqueue_for_processing(pubnub_t* pb)
 {
-    return pbpal_ntf_callback_enqueue_for_processing(&m_watcher.queue, pb);
+    struct SocketWatcherData* watcher = watcher_of(pb);
+    int rslt = pbpal_ntf_callback_enqueue_for_processing(&watcher->queue, pb);
+    wake_watcher(watcher);
+    return rslt;
 }
 
 
 int pbntf_requeue_for_processing(pubnub_t* pb)
 {
-    return pbpal_ntf_callback_requeue_for_processing(&m_watcher.queue, pb);
+    struct SocketWatcherData* watcher = watcher_of(pb);
+    int rslt = pbpal_ntf_callback_requeue_for_processing(&watcher->queue, pb);
+    wake_watcher(watcher);
+    return rslt;
 }
 
 
 int pbntf_got_socket(pubnub_t* pb)
 {
-    pthread_mutex_lock(&m_watcher.mutw);
-    pbpal_ntf_callback_save_socket(m_watcher.poll, pb);
-    pthread_mutex_unlock(&m_watcher.mutw);
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    lock_poller(watcher);
+    pbpal_ntf_callback_save_socket(watcher->poll, pb);
+    unlock_poller(watcher);
 
     if (PUBNUB_TIMERS_API) {
-        pthread_mutex_lock(&m_watcher.timerlock);
-        m_watcher.timer_head = pubnub_timer_list_add(m_watcher.timer_head,
-                                                     pb,
-                                                     pb->transaction_timeout_ms);
-        pthread_mutex_unlock(&m_watcher.timerlock);
+        pthread_mutex_lock(&watcher->timerlock);
+        pubnub_timer_wheel_add(&watcher->timers,
+                               pb,
+                               monotonic_ms() + pb->transaction_timeout_ms);
+        pthread_mutex_unlock(&watcher->timerlock);
     }
 
     return +1;
@@ -264,27 +456,30 @@ int pbntf_got_socket(pubnub_t* pb)
 
 void pbntf_lost_socket(pubnub_t* pb)
 {
-    pthread_mutex_lock(&m_watcher.mutw);
-    pbpal_ntf_callback_remove_socket(m_watcher.poll, pb);
-    pthread_mutex_unlock(&m_watcher.mutw);
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    lock_poller(watcher);
+    pbpal_ntf_callback_remove_socket(watcher->poll, pb);
+    unlock_poller(watcher);
 
-    pbpal_ntf_callback_remove_from_queue(&m_watcher.queue, pb);
+    pbpal_ntf_callback_remove_from_queue(&watcher->queue, pb);
 
-    pthread_mutex_lock(&m_watcher.timerlock);
-    pbpal_remove_timer_safe(pb, &m_watcher.timer_head);
-    pthread_mutex_unlock(&m_watcher.timerlock);
+    if (PUBNUB_TIMERS_API) {
+        pthread_mutex_lock(&watcher->timerlock);
+        pubnub_timer_wheel_remove(&watcher->timers, pb);
+        pthread_mutex_unlock(&watcher->timerlock);
+    }
 }
 
 
 void pbntf_start_wait_connect_timer(pubnub_t* pb)
 {
     if (PUBNUB_TIMERS_API) {
-        pthread_mutex_lock(&m_watcher.timerlock);
-        pbpal_remove_timer_safe(pb, &m_watcher.timer_head);
-        m_watcher.timer_head = pubnub_timer_list_add(m_watcher.timer_head,
-                                                     pb,
-                                                     pb->wait_connect_timeout_ms);
-        pthread_mutex_unlock(&m_watcher.timerlock);
+        struct SocketWatcherData* watcher = watcher_of(pb);
+        pthread_mutex_lock(&watcher->timerlock);
+        pubnub_timer_wheel_add(&watcher->timers, pb, monotonic_ms() + pb->wait_connect_timeout_ms);
+        pthread_mutex_unlock(&watcher->timerlock);
+        wake_watcher(watcher);
     }
 }
 
@@ -292,19 +487,20 @@ void pbntf_start_wait_connect_timer(pubnub_t* pb)
 void pbntf_start_transaction_timer(pubnub_t* pb)
 {
     if (PUBNUB_TIMERS_API) {
-        pthread_mutex_lock(&m_watcher.timerlock);
-        pbpal_remove_timer_safe(pb, &m_watcher.timer_head);
-        m_watcher.timer_head = pubnub_timer_list_add(m_watcher.timer_head,
-                                                     pb,
-                                                     pb->transaction_timeout_ms);
-        pthread_mutex_unlock(&m_watcher.timerlock);
+        struct SocketWatcherData* watcher = watcher_of(pb);
+        pthread_mutex_lock(&watcher->timerlock);
+        pubnub_timer_wheel_add(&watcher->timers, pb, monotonic_ms() + pb->transaction_timeout_ms);
+        pthread_mutex_unlock(&watcher->timerlock);
+        wake_watcher(watcher);
     }
 }
 
 
 void pbntf_update_socket(pubnub_t* pb)
 {
-    pthread_mutex_lock(&m_watcher.mutw);
-    pbpal_ntf_callback_update_socket(m_watcher.poll, pb);
-    pthread_mutex_unlock(&m_watcher.mutw);
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    lock_poller(watcher);
+    pbpal_ntf_callback_update_socket(watcher->poll, pb);
+    unlock_poller(watcher);
 }
@@ -0,0 +1,441 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "core/pubnub_ntf_callback.h"
+#include "core/pubnub_ntf_evloop.h"
+
+#include "posix/monotonic_clock_get_time.h"
+
+#include "pubnub_internal.h"
+#include "pubnub_get_native_socket.h"
+#include "core/pubnub_assert.h"
+#include "core/pubnub_log.h"
+#include "core/pubnub_timer_wheel.h"
+#include "core/pubnub_atomic.h"
+#include "core/pbpal.h"
+
+#include "core/pbpal_ntf_callback_queue.h"
+
+#include <pthread.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+
+
+/** @file pubnub_ntf_evloop_posix.c
+
+    The notifier for the "external event loop" flavour of the
+    callback interface (see pubnub_ntf_evloop.h). It's the same as the
+    "socket watcher" notifier, except that, instead of polling the
+    sockets and waiting for timers in its own thread, it tells the
+    application's event loop what to watch and lets it call us back.
+ */
+
+
+/** A socket that the event loop watches for us */
+struct EvloopSocket {
+    pubnub_t* pb;
+    int       fd;
+    int       events;
+};
+
+
+struct EvloopData {
+    /** Set before the first pubnub_init(), so, not guarded */
+    struct pubnub_evloop_hooks hooks;
+    void*                      user_data;
+    /** Guards everything here, except the queue. It's recursive, as
+        stopping a transaction on timeout may lose its socket.
+     */
+    pthread_mutex_t      lock;
+    struct EvloopSocket* sockets pubnub_guarded_by(lock);
+    size_t               size pubnub_guarded_by(lock);
+    size_t               cap pubnub_guarded_by(lock);
+    /** Did we already ask the event loop to call us "right away"?
+        Used to not ask more than needed. */
+    pubnub_atomic_t wake_pending;
+#if PUBNUB_TIMERS_API
+    struct pubnub_timer_wheel timers pubnub_guarded_by(lock);
+#endif
+    struct pbpal_ntf_callback_queue queue;
+};
+
+
+static struct EvloopData m_evloop;
+
+
+/** Returns the monotonic time, in milliseconds */
+static uint64_t monotonic_ms(void)
+{
+    struct timespec timspec;
+    monotonic_clock_get_time(&timspec);
+    return (uint64_t)timspec.tv_sec * UNIT_IN_MILLI
+           + timspec.tv_nsec / MILLI_IN_NANO;
+}
+
+
+static struct EvloopSocket* find_socket(pubnub_t const* pb)
+{
+    size_t i;
+    for (i = 0; i < m_evloop.size; ++i) {
+        if (m_evloop.sockets[i].pb == pb) {
+            return m_evloop.sockets + i;
+        }
+    }
+    return NULL;
+}
+
+
+/** Changes the events the event loop watches for on the socket of
+    the context @p pb to @p events. Has to be called with the lock
+    held.
+ */
+static int change_events(pubnub_t const* pb, int events)
+{
+    struct EvloopSocket* s = find_socket(pb);
+
+    if (NULL == s) {
+        PUBNUB_LOG_WARNING("change_events(pb=%p): Not Found!\n", pb);
+        return -1;
+    }
+    if (s->events == events) {
+        return 0;
+    }
+    s->events = events;
+    if (m_evloop.hooks.modify_socket != NULL) {
+        return m_evloop.hooks.modify_socket(s->pb, s->fd, events, m_evloop.user_data);
+    }
+    return 0;
+}
+
+
+/** Adds the socket @p fd of the context @p pb to the ones the event
+    loop watches. Has to be called with the lock held.
+ */
+static int add_socket(pubnub_t* pb, int fd, int events)
+{
+    struct EvloopSocket* s;
+
+    PUBNUB_ASSERT_OPT(NULL == find_socket(pb));
+    if (m_evloop.size == m_evloop.cap) {
+        size_t const         newcap = m_evloop.cap * 2 + 2;
+        struct EvloopSocket* npsock = (struct EvloopSocket*)realloc(
+            m_evloop.sockets, sizeof m_evloop.sockets[0] * newcap);
+        if (NULL == npsock) {
+            PUBNUB_LOG_ERROR("add_socket(pb=%p): failed to allocate\n", pb);
+            return -1;
+        }
+        m_evloop.sockets = npsock;
+        m_evloop.cap     = newcap;
+    }
+    if ((m_evloop.hooks.add_socket != NULL)
+        && (0 != m_evloop.hooks.add_socket(pb, fd, events, m_evloop.user_data))) {
+        PUBNUB_LOG_ERROR("add_socket(pb=%p): event loop failed to add socket "
+                         "%d\n",
+                         pb,
+                         fd);
+        return -1;
+    }
+    s         = m_evloop.sockets + m_evloop.size++;
+    s->pb     = pb;
+    s->fd     = fd;
+    s->events = events;
+
+    return 0;
+}
+
+
+/** Removes the socket @p s from the ones the event loop watches. Has
+    to be called with the lock held.
+ */
+static void remove_socket(struct EvloopSocket* s)
+{
+    if (m_evloop.hooks.remove_socket != NULL) {
+        m_evloop.hooks.remove_socket(s->pb, s->fd, m_evloop.user_data);
+    }
+    *s = m_evloop.sockets[--m_evloop.size];
+}
+
+
+/** Tells the event loop to call pubnub_process_timeout() in
+    @p timeout_ms milliseconds.
+ */
+static void set_deadline(int64_t timeout_ms)
+{
+    if ((timeout_ms >= 0) && (m_evloop.hooks.set_deadline != NULL)) {
+        m_evloop.hooks.set_deadline(
+            (timeout_ms > INT_MAX) ? INT_MAX : (int)timeout_ms,
+            m_evloop.user_data);
+    }
+}
+
+
+/** Tells the event loop to call pubnub_process_timeout() right away,
+    to process the queue. Can be called from any thread.
+ */
+static void wake_evloop(void)
+{
+    if (0 == pubnub_atomic_exchange(&m_evloop.wake_pending, 1)) {
+        set_deadline(0);
+    }
+}
+
+
+static void start_timer(pubnub_t* pb, int duration_ms)
+{
+    if (PUBNUB_TIMERS_API) {
+        uint64_t const now = monotonic_ms();
+        pthread_mutex_lock(&m_evloop.lock);
+        pubnub_timer_wheel_add(&m_evloop.timers, pb, now + duration_ms);
+        set_deadline(pubnub_timer_wheel_next_ms(&m_evloop.timers, now));
+        pthread_mutex_unlock(&m_evloop.lock);
+    }
+}
+
+
+int pubnub_set_evloop_hooks(struct pubnub_evloop_hooks const* hooks, void* user_data)
+{
+    PUBNUB_ASSERT_OPT(hooks != NULL);
+    if (NULL == hooks) {
+        return -1;
+    }
+    m_evloop.hooks     = *hooks;
+    m_evloop.user_data = user_data;
+
+    return 0;
+}
+
+
+void pubnub_process_io(pubnub_t* pb, int events)
+{
+    PUBNUB_ASSERT_OPT(pb != NULL);
+    PUBNUB_LOG_TRACE("pubnub_process_io(pb=%p, events=%d)\n", pb, events);
+
+    pubnub_mutex_lock(pb->monitor);
+    /* The FSM will find out on its own what it can do */
+    if (pb->state != PBS_NULL) {
+        pbnc_fsm(pb);
+    }
+    pubnub_mutex_unlock(pb->monitor);
+}
+
+
+/** Stops (with a timeout) the transactions of all the contexts whose
+    timers have expired by now.
+ */
+static void handle_expired_timers(void)
+{
+    pubnub_t* expired;
+
+    pthread_mutex_lock(&m_evloop.lock);
+    expired = pubnub_timer_wheel_advance(&m_evloop.timers, monotonic_ms());
+    while (expired != NULL) {
+        pubnub_t* next;
+
+        pubnub_mutex_lock(expired->monitor);
+        next          = expired->next;
+        expired->next = NULL;
+        pbnc_stop(expired, PNR_TIMEOUT);
+        pubnub_mutex_unlock(expired->monitor);
+
+        expired = next;
+    }
+    pthread_mutex_unlock(&m_evloop.lock);
+}
+
+
+int pubnub_process_timeout(void)
+{
+    /* Whoever gives us work after this will ask for another call */
+    pubnub_atomic_store(&m_evloop.wake_pending, 0);
+    pbpal_ntf_callback_process_queue(&m_evloop.queue);
+    if (PUBNUB_TIMERS_API) {
+        handle_expired_timers();
+        /* Stopping puts the contexts in the queue, which we process
+           right away */
+        pubnub_atomic_store(&m_evloop.wake_pending, 0);
+        pbpal_ntf_callback_process_queue(&m_evloop.queue);
+    }
+
+    return pubnub_evloop_next_timeout_ms();
+}
+
+
+int pubnub_evloop_next_timeout_ms(void)
+{
+    int64_t next = -1;
+
+    if (pubnub_atomic_load(&m_evloop.wake_pending)) {
+        return 0;
+    }
+    if (PUBNUB_TIMERS_API) {
+        pthread_mutex_lock(&m_evloop.lock);
+        next = pubnub_timer_wheel_next_ms(&m_evloop.timers, monotonic_ms());
+        pthread_mutex_unlock(&m_evloop.lock);
+    }
+    return (next > INT_MAX) ? INT_MAX : (int)next;
+}
+
+
+int pbntf_watch_in_events(pubnub_t* pbp)
+{
+    int rslt;
+    pthread_mutex_lock(&m_evloop.lock);
+    rslt = change_events(pbp, pbevlIN);
+    pthread_mutex_unlock(&m_evloop.lock);
+    return rslt;
+}
+
+
+int pbntf_watch_out_events(pubnub_t* pbp)
+{
+    int rslt;
+    pthread_mutex_lock(&m_evloop.lock);
+    rslt = change_events(pbp, pbevlOUT);
+    pthread_mutex_unlock(&m_evloop.lock);
+    return rslt;
+}
+
+
+void pubnub_stop(void)
+{
+    /* There is no thread of ours to stop, the event loop is the
+       application's.
+     */
+}
+
+
+int pubnub_set_callback_threads(unsigned n)
+{
+    if (n != 1) {
+        PUBNUB_LOG_ERROR("pubnub_set_callback_threads(%u): with an external "
+                         "event loop, there are no threads of our own\n",
+                         n);
+        return -1;
+    }
+    return 0;
+}
+
+
+int pbntf_init(void)
+{
+    int                 rslt;
+    pthread_mutexattr_t attr;
+
+    rslt = pthread_mutexattr_init(&attr);
+    if (rslt != 0) {
+        PUBNUB_LOG_ERROR(
+            "Failed to initialize mutex attributes, error code: %d", rslt);
+        return -1;
+    }
+    rslt = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    if (rslt != 0) {
+        PUBNUB_LOG_ERROR("Failed to set mutex attribute type, error code: %d",
+                         rslt);
+        pthread_mutexattr_destroy(&attr);
+        return -1;
+    }
+    rslt = pthread_mutex_init(&m_evloop.lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    if (rslt != 0) {
+        PUBNUB_LOG_ERROR("Failed to initialize mutex, error code: %d", rslt);
+        return -1;
+    }
+    pbpal_ntf_callback_queue_init(&m_evloop.queue);
+    pubnub_atomic_store(&m_evloop.wake_pending, 0);
+#if PUBNUB_TIMERS_API
+    pubnub_timer_wheel_init(&m_evloop.timers, monotonic_ms());
+#endif
+
+    return 0;
+}
+
+
+int pbntf_enqueue_for_processing(pubnub_t* pb)
+{
+    int rslt = pbpal_ntf_callback_enqueue_for_processing(&m_evloop.queue, pb);
+    wake_evloop();
+    return rslt;
+}
+
+
+int pbntf_requeue_for_processing(pubnub_t* pb)
+{
+    int rslt = pbpal_ntf_callback_requeue_for_processing(&m_evloop.queue, pb);
+    wake_evloop();
+    return rslt;
+}
+
+
+int pbntf_got_socket(pubnub_t* pb)
+{
+    int const fd = pubnub_get_native_socket(pb);
+    int       rslt;
+
+    if (SOCKET_INVALID == fd) {
+        return +1;
+    }
+    pthread_mutex_lock(&m_evloop.lock);
+    rslt = add_socket(pb, fd, pbevlOUT);
+    pthread_mutex_unlock(&m_evloop.lock);
+    if (rslt != 0) {
+        return -1;
+    }
+    start_timer(pb, pb->transaction_timeout_ms);
+
+    return +1;
+}
+
+
+void pbntf_lost_socket(pubnub_t* pb)
+{
+    struct EvloopSocket* s;
+
+    pthread_mutex_lock(&m_evloop.lock);
+    s = find_socket(pb);
+    if (s != NULL) {
+        remove_socket(s);
+    }
+#if PUBNUB_TIMERS_API
+    pubnub_timer_wheel_remove(&m_evloop.timers, pb);
+#endif
+    pthread_mutex_unlock(&m_evloop.lock);
+
+    pbpal_ntf_callback_remove_from_queue(&m_evloop.queue, pb);
+}
+
+
+void pbntf_start_wait_connect_timer(pubnub_t* pb)
+{
+    start_timer(pb, pb->wait_connect_timeout_ms);
+}
+
+
+void pbntf_start_transaction_timer(pubnub_t* pb)
+{
+    start_timer(pb, pb->transaction_timeout_ms);
+}
+
+
+void pbntf_update_socket(pubnub_t* pb)
+{
+    int const            fd = pubnub_get_native_socket(pb);
+    struct EvloopSocket* s;
+
+    pthread_mutex_lock(&m_evloop.lock);
+    s = find_socket(pb);
+    if (NULL == s) {
+        if (fd != SOCKET_INVALID) {
+            add_socket(pb, fd, pbevlOUT);
+        }
+    }
+    else if (s->fd != fd) {
+        /* Say, from the DNS query socket to the connection socket */
+        int const events = s->events;
+        remove_socket(s);
+        if (fd != SOCKET_INVALID) {
+            add_socket(pb, fd, events);
+        }
+    }
+    pthread_mutex_unlock(&m_evloop.lock);
+}
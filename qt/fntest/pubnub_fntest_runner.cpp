@@ -66,6 +66,9 @@ static TestData m_aTest[] = {
     LIST_TEST(connect_disconnect_and_connect_again_group),
     LIST_TEST(connect_disconnect_and_connect_again_combo),
     //    LIST_TEST(wrong_api_usage),
+#if PUBNUB_USE_PUBLISH_BATCH
+    LIST_TEST(publish_batch_and_single_transaction_exclude_each_other),
+#endif
 };
 
 #define TEST_COUNT (sizeof m_aTest / sizeof m_aTest[0])
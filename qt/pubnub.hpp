@@ -78,6 +78,25 @@ namespace pubnub {
 
     class context;
 
+#if PUBNUB_USE_PUBLISH_BATCH
+    /// One message to publish in a batch. Empty @p meta means "no
+    /// meta-data".
+    struct publish_batch_item {
+        std::string channel;
+        std::string message;
+        std::string meta;
+
+        publish_batch_item(std::string const &ch,
+                           std::string const &msg,
+                           std::string const &mt = "")
+            : channel(ch)
+            , message(msg)
+            , meta(mt)
+        {
+        }
+    };
+#endif /* PUBNUB_USE_PUBLISH_BATCH */
+
     /** A future (pending) result of a Pubnub
      * transaction/operation/request.  It is somewhat similar to the
      * std::future<> from C++11.
@@ -465,6 +484,20 @@ namespace pubnub {
             return doit(d_pbqt.list_channel_group(QString::fromStdString(channel_group)));
         }
         
+#if PUBNUB_USE_PUBLISH_BATCH
+        /// Publishes all the messages from @p items in one transaction.
+        /// @see pubnub_qt::publish_batch
+        futres publish_batch(std::vector<publish_batch_item> const &items) {
+            QVector< ::publish_batch_item> qt_items(static_cast<int>(items.size()));
+            for (int i = 0; i < qt_items.size(); ++i) {
+                qt_items[i].channel = QString::fromStdString(items[i].channel);
+                qt_items[i].message = QByteArray::fromStdString(items[i].message);
+                qt_items[i].meta = QByteArray::fromStdString(items[i].meta);
+            }
+            return doit(d_pbqt.publish_batch(qt_items));
+        }
+#endif /* PUBNUB_USE_PUBLISH_BATCH */
+
         /// Return the HTTP code (result) of the last transaction.
         int last_http_code() const { return d_pbqt.last_http_code(); }
 
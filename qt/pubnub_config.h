@@ -72,6 +72,13 @@
 #define PUBNUB_USE_ACTIONS_API 1
 #endif
 
+#if !defined(PUBNUB_USE_PUBLISH_BATCH)
+/** If true (!=0) will enable using the batch publish API, to publish
+    an array of messages in one transaction. Requests are pipelined
+    by the QNetworkAccessManager. */
+#define PUBNUB_USE_PUBLISH_BATCH 1
+#endif
+
 /** Mininmal duration of the transaction timer, in milliseconds. You
  * can't set less than this.
  */
@@ -46,6 +46,10 @@ pubnub_qt::pubnub_qt(QString pubkey, QString keysub)
     , d_transaction_timed_out(false)
     , d_transactionTimer(new QTimer(this))
     , d_use_http_keep_alive(true)
+#if PUBNUB_USE_PUBLISH_BATCH
+    , d_batch_pending(0)
+    , d_batch_first_error(PNR_OK)
+#endif
     , d_mutex(QMutex::Recursive)
 {
     pbcc_init(d_context.data(), d_pubkey.data(), d_keysub.data());
@@ -94,11 +98,31 @@ static QString GetOsName()
  }
 
 
+QNetworkRequest pubnub_qt::prepRequest()
+{
+    QUrl url(d_origin
+             + QString::fromLatin1(d_context->http_buf, d_context->http_buf_len));
+    QNetworkRequest req(url);
+    QString user_agent(GetOsName() +
+                       "-Qt" +
+                       QT_VERSION_STR +
+                       "-PubNub-core/" +
+                       PUBNUB_SDK_VERSION);
+    req.setRawHeader("User-Agent", user_agent.toLatin1());
+    if (!d_use_http_keep_alive) {
+        req.setRawHeader("Connection", "Close");
+    }
+    return req;
+}
+
 pubnub_res pubnub_qt::startRequest(pubnub_res result, pubnub_trans transaction)
 {
+#if PUBNUB_USE_PUBLISH_BATCH
+    if ((PNR_STARTED == result) && !d_batch_replies.isEmpty()) {
+        return PNR_IN_PROGRESS;
+    }
+#endif
     if (PNR_STARTED == result) {
-        QUrl url(d_origin
-                 + QString::fromLatin1(d_context->http_buf, d_context->http_buf_len));
         d_trans = transaction;
 
         QNetworkReply* p = d_reply.take();
@@ -106,16 +130,7 @@ pubnub_res pubnub_qt::startRequest(pubnub_res result, pubnub_trans transaction)
             p->deleteLater();
         }
         d_transaction_timed_out = false;
-        QNetworkRequest req(url);
-        QString user_agent(GetOsName() +
-                           "-Qt" +
-                           QT_VERSION_STR +
-                           "-PubNub-core/" +
-                           PUBNUB_SDK_VERSION);
-        req.setRawHeader("User-Agent", user_agent.toLatin1());
-        if (!d_use_http_keep_alive) {
-            req.setRawHeader("Connection", "Close");
-        }
+        QNetworkRequest req(prepRequest());
         switch (transaction) {
 #if PUBNUB_USE_ACTIONS_API
         case PBTT_REMOVE_ACTION:
@@ -264,6 +279,13 @@ void pubnub_qt::cancel()
     if (d_reply) {
         d_reply->abort();
     }
+#if PUBNUB_USE_PUBLISH_BATCH
+    foreach (QNetworkReply* reply, d_batch_replies) {
+        if (reply) {
+            reply->abort();
+        }
+    }
+#endif
 }
 
 
@@ -282,6 +304,74 @@ pubnub_res pubnub_qt::publish(QString const& channel, QString const& message)
 }
 
 
+#if PUBNUB_USE_PUBLISH_BATCH
+pubnub_res pubnub_qt::publish_batch(QVector<publish_batch_item> const& items)
+{
+    QMutexLocker lk(&d_mutex);
+    if (items.isEmpty() || (items.size() > PUBNUB_PUBLISH_BATCH_MAX)) {
+        return PNR_INVALID_PARAMETERS;
+    }
+    if (!d_batch_replies.isEmpty() || (d_reply && d_reply->isRunning())) {
+        return PNR_IN_PROGRESS;
+    }
+    d_batch_arena.clear();
+    foreach (publish_batch_item const& item, items) {
+        d_batch_arena.append(item.message);
+    }
+    pubnub_publish_batch_result started;
+    started.result       = PNR_STARTED;
+    started.timetoken[0] = '\0';
+    d_batch_results.fill(started, items.size());
+    d_batch_first_error     = PNR_OK;
+    d_method                = pubnubSendViaPOST;
+    d_trans                 = PBTT_PUBLISH_BATCH;
+    d_transaction_timed_out = false;
+
+    int offset = 0;
+    foreach (publish_batch_item const& item, items) {
+        pubnub_res rslt = pbcc_publish_prep(d_context.data(),
+                                            item.channel.toLatin1().data(),
+                                            item.message.constData(),
+                                            true,
+                                            false,
+                                            item.meta.isEmpty() ? NULL : item.meta.constData(),
+                                            d_method);
+        if (rslt != PNR_STARTED) {
+            foreach (QNetworkReply* reply, d_batch_replies) {
+                disconnect(reply, 0, this, 0);
+                reply->abort();
+                reply->deleteLater();
+            }
+            d_batch_replies.clear();
+            return rslt;
+        }
+        QNetworkRequest req(prepRequest());
+        req.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+        req.setRawHeader("Content-Type", "application/json");
+        req.setRawHeader("Content-Length", QByteArray::number(item.message.size()));
+        QNetworkReply* reply = d_qnam.post(
+            req,
+            QByteArray::fromRawData(d_batch_arena.constData() + offset,
+                                    item.message.size()));
+        connect(reply, SIGNAL(finished()), this, SLOT(batchReplyFinished()));
+        d_batch_replies.append(reply);
+        offset += item.message.size();
+    }
+    d_batch_pending = d_batch_replies.size();
+    d_transactionTimer->start(d_transaction_timeout_duration_ms);
+
+    return PNR_STARTED;
+}
+
+
+QVector<pubnub_publish_batch_result> pubnub_qt::publish_batch_results() const
+{
+    KEEP_THREAD_SAFE();
+    return d_batch_results;
+}
+#endif /* PUBNUB_USE_PUBLISH_BATCH */
+
+
 pubnub_res pubnub_qt::publish_via_post(QString const&    channel,
                                        QByteArray const& message)
 {
@@ -1225,6 +1315,9 @@ pubnub_res pubnub_qt::finish(QByteArray const& data, int http_code)
         }
         break;
     case PBTT_PUBLISH:
+#if PUBNUB_USE_PUBLISH_BATCH
+    case PBTT_PUBLISH_BATCH:
+#endif
         pbres = pbcc_parse_publish_response(d_context.data());
         break;
     case PBTT_TIME:
@@ -1318,6 +1411,36 @@ void pubnub_qt::transactionTimeout()
         d_transaction_timed_out = true;
         d_reply->abort();
     }
+#if PUBNUB_USE_PUBLISH_BATCH
+    foreach (QNetworkReply* reply, d_batch_replies) {
+        if (reply) {
+            d_transaction_timed_out = true;
+            reply->abort();
+        }
+    }
+#endif
+}
+
+
+/** Returns the outcome for a transport @p error of a reply, or
+    PNR_OK if the response should be processed (parsed).
+ */
+static pubnub_res transport_error_outcome(QNetworkReply::NetworkError error,
+                                          bool                        timed_out)
+{
+    switch (error) {
+    case QNetworkReply::OperationCanceledError:
+        return timed_out ? PNR_TIMEOUT : PNR_CANCELLED;
+    case QNetworkReply::TimeoutError:
+        return PNR_CONNECTION_TIMEOUT;
+    case QNetworkReply::HostNotFoundError:
+        return PNR_ADDR_RESOLUTION_FAILED;
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::ProtocolUnknownError:
+        return PNR_CONNECT_FAILED;
+    default:
+        return PNR_OK;
+    }
 }
 
 
@@ -1337,27 +1460,10 @@ void pubnub_qt::httpFinished()
         else {
             d_context->http_reply[0] = '\0';
         }
-        switch (error) {
-        case QNetworkReply::OperationCanceledError:
-            if (d_transaction_timed_out) {
-                emit outcome(PNR_TIMEOUT);
-            }
-            else {
-                emit outcome(PNR_CANCELLED);
-            }
-            return;
-        case QNetworkReply::TimeoutError:
-            emit outcome(PNR_CONNECTION_TIMEOUT);
-            return;
-        case QNetworkReply::HostNotFoundError:
-            emit outcome(PNR_ADDR_RESOLUTION_FAILED);
+        pubnub_res pbres = transport_error_outcome(error, d_transaction_timed_out);
+        if (pbres != PNR_OK) {
+            emit outcome(pbres);
             return;
-        case QNetworkReply::ConnectionRefusedError:
-        case QNetworkReply::ProtocolUnknownError:
-            emit outcome(PNR_CONNECT_FAILED);
-            return;
-        default:
-            break;
         }
     }
 
@@ -1365,6 +1471,40 @@ void pubnub_qt::httpFinished()
 }
 
 
+#if PUBNUB_USE_PUBLISH_BATCH
+void pubnub_qt::batchReplyFinished()
+{
+    KEEP_THREAD_SAFE();
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    int            i     = d_batch_replies.indexOf(reply);
+    if ((NULL == reply) || (i < 0)) {
+        return;
+    }
+    d_batch_replies[i] = NULL;
+    reply->deleteLater();
+
+    pubnub_publish_batch_result& r = d_batch_results[i];
+    QNetworkReply::NetworkError error = reply->error();
+    r.result = transport_error_outcome(error, d_transaction_timed_out);
+    if (PNR_OK == r.result) {
+        r.result = finish(reply->readAll(), error);
+        if (PNR_OK == r.result) {
+            pbcc_publish_timetoken(d_context.data(), r.timetoken, sizeof r.timetoken);
+        }
+    }
+    if ((r.result != PNR_OK) && (PNR_OK == d_batch_first_error)) {
+        d_batch_first_error = r.result;
+    }
+
+    if (--d_batch_pending == 0) {
+        d_transactionTimer->stop();
+        d_batch_replies.clear();
+        emit outcome(d_batch_first_error);
+    }
+}
+#endif /* PUBNUB_USE_PUBLISH_BATCH */
+
+
 void pubnub_qt::sslErrors(QNetworkReply* reply, const QList<QSslError>& errors)
 {
     QString errorString;
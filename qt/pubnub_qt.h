@@ -14,6 +14,8 @@
 #include <QMutexLocker>
 #include <QMap>
 #include <QPair>
+#include <QList>
+#include <QVector>
 
 extern "C" {
 #include "core/pubnub_api_types.h"
@@ -24,6 +26,9 @@ extern "C" {
 #if PUBNUB_USE_ACTIONS_API
 #include "core/pbcc_actions_api.h"
 #endif
+#if PUBNUB_USE_PUBLISH_BATCH
+#include "core/pubnub_publish_batch.h"
+#endif
 }
 
 #include "cpp/tribool.hpp"
@@ -175,6 +180,18 @@ public:
 #endif /* PUBNUB_USE_SUBSCRIBE_V2 */
 
 
+#if PUBNUB_USE_PUBLISH_BATCH
+/** One message to publish in a batch. Empty @p meta means "no
+    meta-data".
+*/
+struct publish_batch_item {
+    QString    channel;
+    QByteArray message;
+    QByteArray meta;
+};
+#endif /* PUBNUB_USE_PUBLISH_BATCH */
+
+
 /** @mainpage Pubnub C-core for Qt
 
     This is the C-core implementation of the Pubnub client
@@ -411,6 +428,35 @@ public:
         return publish_via_post_with_gzip(channel, message.toJson());
     }
 
+#if PUBNUB_USE_PUBLISH_BATCH
+    /** Publishes all the messages from @p items in one transaction
+        (of type `PBTT_PUBLISH_BATCH`). Each message is published
+        via POST, and the requests are pipelined (on the same
+        connection, if possible). The outcome() is emitted when all
+        requests were responded to, with the first error, or #PNR_OK
+        if all messages were published. Get the result of each
+        message with publish_batch_results().
+
+        The messages are copied (to one buffer), so you don't have to
+        keep @p items after this returns.
+
+        While a batch is in progress, other transactions can't be
+        started (they return #PNR_IN_PROGRESS), and vice versa.
+
+        @param items The messages to publish, can't be more than
+        #PUBNUB_PUBLISH_BATCH_MAX of them
+        @return #PNR_STARTED on success, #PNR_IN_PROGRESS if a
+        transaction is already in progress, an error otherwise
+     */
+    pubnub_res publish_batch(QVector<publish_batch_item> const &items);
+
+    /** Returns the results of publishing the messages of the last
+        batch, in the order they were in the batch. A message not
+        (yet) responded to has the result #PNR_STARTED.
+     */
+    QVector<pubnub_publish_batch_result> publish_batch_results() const;
+#endif /* PUBNUB_USE_PUBLISH_BATCH */
+
     /** Sends a signal @p message (in JSON format) on @p channel.
         This actually means "initiate a signal transaction".
         It has similar behaviour as publish, but unlike publish transaction, signal
@@ -1835,6 +1881,9 @@ public:
 private slots:
     void httpFinished();
     void transactionTimeout();
+#if PUBNUB_USE_PUBLISH_BATCH
+    void batchReplyFinished();
+#endif
 
 #ifndef QT_NO_SSL
     void sslErrors(QNetworkReply* reply, QList<QSslError> const& errors);
@@ -1848,6 +1897,9 @@ signals:
 
 private:
 
+    /// Prepares the HTTP request for the URL in the C-core context
+    QNetworkRequest prepRequest();
+
     /// Common function that starts any of the requests
     pubnub_res startRequest(pubnub_res result, pubnub_trans transaction);
 
@@ -1904,6 +1956,25 @@ private:
     /// Message to send via POST method
     QByteArray d_message_to_send;
 
+#if PUBNUB_USE_PUBLISH_BATCH
+    /// All the messages of the current batch, back to back. Bodies
+    /// of the batch requests refer to (parts of) it.
+    QByteArray d_batch_arena;
+
+    /// Replies to the requests of the current batch, NULL for those
+    /// already finished (empty if no batch is in progress)
+    QList<QNetworkReply*> d_batch_replies;
+
+    /// Results of the messages of the last batch
+    QVector<pubnub_publish_batch_result> d_batch_results;
+
+    /// Number of requests of the current batch not yet finished
+    int d_batch_pending;
+
+    /// The first error in the current batch, PNR_OK if none
+    pubnub_res d_batch_first_error;
+#endif
+
     mutable QMutex d_mutex;
 };
 
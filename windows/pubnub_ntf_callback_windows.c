@@ -114,6 +114,19 @@ void socket_watcher_thread(void* arg)
 }
 
 
+int pubnub_set_callback_threads(unsigned n)
+{
+    /* We have only one socket watcher thread on Windows */
+    if (n != 1) {
+        PUBNUB_LOG_ERROR("pubnub_set_callback_threads(%u): only 1 thread "
+                         "supported on Windows\n",
+                         n);
+        return -1;
+    }
+    return 0;
+}
+
+
 int pbntf_init(void)
 {
     InitializeCriticalSection(&m_watcher.stoplock);